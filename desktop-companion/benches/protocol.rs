@@ -0,0 +1,185 @@
+//! Decode/encode cost of the packets the server handles per PSP
+//!
+//! Run with `cargo bench --bench protocol`.
+
+#![allow(dead_code)]
+
+#[path = "../src/protocol.rs"]
+mod protocol;
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion, Throughput};
+
+use protocol::{
+    parse_packet, GameInfo, Heartbeat, IconChunk, MessageType, StatsDelta, StatsDeltaRecord,
+    StatsUpload, TransferPoll, TransferStatus, CHUNK_DATA_SIZE, MAGIC, STATS_DELTA_MAX_RECORDS,
+    TRANSFER_MAX_CHUNKS,
+};
+
+fn packet(msg_type: MessageType, payload: &[u8]) -> Vec<u8> {
+    let mut buf = Vec::with_capacity(5 + payload.len());
+    buf.extend_from_slice(MAGIC);
+    buf.push(msg_type as u8);
+    buf.extend_from_slice(payload);
+    buf
+}
+
+fn fixed_str(buf: &mut Vec<u8>, s: &str, len: usize) {
+    let start = buf.len();
+    buf.extend_from_slice(&s.as_bytes()[..s.len().min(len - 1)]);
+    buf.resize(start + len, 0);
+}
+
+/// Heartbeat with the v1 metrics extension, as current plugins send it
+fn heartbeat_packet() -> Vec<u8> {
+    let mut payload = Vec::new();
+    payload.extend_from_slice(&3600u32.to_le_bytes());
+    payload.push(100);
+
+    let mut metrics = vec![0u8; 80];
+    metrics[0] = 1;
+    metrics[2..4].copy_from_slice(&12u16.to_le_bytes());
+    metrics[4..8].copy_from_slice(&30_000u32.to_le_bytes());
+    metrics[8..17].copy_from_slice(b"ULUS10041");
+    metrics[44..48].copy_from_slice(&40u32.to_le_bytes());
+    metrics[76..80].copy_from_slice(&(8u32 << 20).to_le_bytes());
+    payload.extend_from_slice(&metrics);
+
+    packet(MessageType::Heartbeat, &payload)
+}
+
+fn game_info_packet() -> Vec<u8> {
+    let mut payload = Vec::new();
+    fixed_str(&mut payload, "ULUS10041", 10);
+    fixed_str(&mut payload, "Grand Theft Auto: Liberty City Stories", 128);
+    payload.extend_from_slice(&1_700_000_000u32.to_le_bytes());
+    payload.extend_from_slice(&[1, 1, 0]);
+    fixed_str(&mut payload, "Bench PSP", 32);
+    payload.extend_from_slice(&0xDEAD_BEEFu32.to_le_bytes());
+    payload.extend_from_slice(&20_480u32.to_le_bytes());
+    packet(MessageType::GameInfo, &payload)
+}
+
+fn icon_chunk_packet() -> Vec<u8> {
+    let mut payload = Vec::new();
+    fixed_str(&mut payload, "ULUS10041", 10);
+    payload.extend_from_slice(&3u16.to_le_bytes());
+    payload.extend_from_slice(&20u16.to_le_bytes());
+    payload.extend_from_slice(&(CHUNK_DATA_SIZE as u16).to_le_bytes());
+    payload.extend((0..CHUNK_DATA_SIZE).map(|i| i as u8));
+    packet(MessageType::IconChunk, &payload)
+}
+
+fn stats_upload_packet() -> Vec<u8> {
+    let mut payload = Vec::new();
+    payload.extend_from_slice(&1_700_000_000u64.to_le_bytes());
+    payload.extend_from_slice(&0u16.to_le_bytes());
+    payload.extend_from_slice(&16u16.to_le_bytes());
+    payload.extend_from_slice(&(CHUNK_DATA_SIZE as u16).to_le_bytes());
+    payload.extend(std::iter::repeat(b'x').take(CHUNK_DATA_SIZE));
+    packet(MessageType::StatsUpload, &payload)
+}
+
+fn transfer_poll_packet() -> Vec<u8> {
+    let mut payload = vec![1];
+    fixed_str(&mut payload, "ULUS10041", 10);
+    payload.extend_from_slice(&20u16.to_le_bytes());
+    payload.extend_from_slice(&0xDEAD_BEEFu64.to_le_bytes());
+    packet(MessageType::TransferPoll, &payload)
+}
+
+/// A full delta, the largest a sync sends in one go
+fn full_delta() -> StatsDelta {
+    StatsDelta {
+        flags: 0,
+        version: 1000,
+        ack: 900,
+        records: (0..STATS_DELTA_MAX_RECORDS)
+            .map(|i| StatsDeltaRecord {
+                game_id: format!("BNCH{:05}", i),
+                title: format!("Benchmark Game {}", i),
+                total_seconds: 3600 * (i as u64 + 1),
+                session_count: i as u32 + 1,
+                version: 900 + i as u32,
+            })
+            .collect(),
+    }
+}
+
+fn bench_decode(c: &mut Criterion) {
+    let heartbeat = heartbeat_packet();
+    let game_info = game_info_packet();
+    let icon_chunk = icon_chunk_packet();
+    let stats_upload = stats_upload_packet();
+    let transfer_poll = transfer_poll_packet();
+    let delta = full_delta().encode();
+
+    let mut group = c.benchmark_group("decode");
+
+    group.bench_function("heartbeat_with_metrics", |b| {
+        b.iter(|| {
+            let (_, payload) = parse_packet(black_box(&heartbeat)).unwrap();
+            Heartbeat::decode(payload).unwrap()
+        })
+    });
+    group.bench_function("game_info", |b| {
+        b.iter(|| {
+            let (_, payload) = parse_packet(black_box(&game_info)).unwrap();
+            GameInfo::decode(payload).unwrap()
+        })
+    });
+    group.bench_function("transfer_poll", |b| {
+        b.iter(|| {
+            let (_, payload) = parse_packet(black_box(&transfer_poll)).unwrap();
+            TransferPoll::decode(payload).unwrap().total_chunks
+        })
+    });
+
+    group.throughput(Throughput::Bytes(icon_chunk.len() as u64));
+    group.bench_function("icon_chunk", |b| {
+        b.iter(|| {
+            let (_, payload) = parse_packet(black_box(&icon_chunk)).unwrap();
+            IconChunk::decode(payload).unwrap().data.len()
+        })
+    });
+
+    group.throughput(Throughput::Bytes(stats_upload.len() as u64));
+    group.bench_function("stats_upload", |b| {
+        b.iter(|| {
+            let (_, payload) = parse_packet(black_box(&stats_upload)).unwrap();
+            StatsUpload::decode(payload).unwrap().json_data.len()
+        })
+    });
+
+    group.throughput(Throughput::Bytes(delta.len() as u64));
+    group.bench_function("stats_delta_full", |b| {
+        b.iter(|| StatsDelta::decode(black_box(&delta)).unwrap().records.len())
+    });
+
+    group.finish();
+}
+
+fn bench_encode(c: &mut Criterion) {
+    let delta = full_delta();
+    // Every other chunk missing, the worst case for the bitmap
+    let received: Vec<bool> = (0..TRANSFER_MAX_CHUNKS).map(|i| i % 2 == 0).collect();
+
+    let mut group = c.benchmark_group("encode");
+
+    group.bench_function("stats_delta_full", |b| b.iter(|| black_box(&delta).encode()));
+    group.bench_function("transfer_status_256", |b| {
+        b.iter(|| {
+            TransferStatus {
+                kind: 1,
+                id: "ULUS10041",
+                total_chunks: TRANSFER_MAX_CHUNKS as u16,
+                received: black_box(&received),
+            }
+            .encode()
+        })
+    });
+
+    group.finish();
+}
+
+criterion_group!(benches, bench_decode, bench_encode);
+criterion_main!(benches);
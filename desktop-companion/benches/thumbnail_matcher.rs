@@ -0,0 +1,93 @@
+//! Cost of building a thumbnail index and of matching a title against it
+//!
+//! The synthetic index is about the size of the libretro PSP boxart listing.
+//! Run with `cargo bench --bench thumbnail_matcher`.
+
+#![allow(dead_code, unused_imports)]
+
+#[path = "../src/config.rs"]
+mod config;
+#[path = "../src/thumbnail_matcher.rs"]
+mod thumbnail_matcher;
+
+use criterion::{black_box, criterion_group, criterion_main, BatchSize, Criterion};
+
+use thumbnail_matcher::{normalize_title, LoadedIndex, ThumbnailMatcher};
+
+/// Thumbnails in the synthetic index
+const INDEX_SIZE: usize = 5000;
+
+const WORDS: &[&str] = &[
+    "Ace", "Armored", "Battle", "Blade", "Crisis", "Dark", "Dragon", "Dungeon", "Fantasy",
+    "Final", "Force", "Ghost", "God", "Hunter", "Legend", "Metal", "Monster", "Ninja",
+    "Portable", "Racer", "Saga", "Shadow", "Sparta", "Star", "Tactics", "Tales", "Warrior",
+    "War", "World", "Zero",
+];
+
+const REGIONS: &[&str] = &["USA", "Europe", "Japan", "USA, Europe"];
+
+/// Deterministic "Word Word Word N (Region)" names, like the listing's
+fn synthetic_names() -> Vec<String> {
+    let mut seed: u32 = 0x2545_F491;
+    let mut next = move || {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        seed as usize
+    };
+
+    (0..INDEX_SIZE)
+        .map(|i| {
+            format!(
+                "{} {} - {} {} ({})",
+                WORDS[next() % WORDS.len()],
+                WORDS[next() % WORDS.len()],
+                WORDS[next() % WORDS.len()],
+                i,
+                REGIONS[next() % REGIONS.len()]
+            )
+        })
+        .collect()
+}
+
+fn bench_index(c: &mut Criterion) {
+    let names = synthetic_names();
+
+    c.bench_function("index_build_5000", |b| {
+        b.iter_batched(
+            || names.clone(),
+            |names| LoadedIndex::new(names, "https://example.com/", "Boxarts"),
+            BatchSize::LargeInput,
+        )
+    });
+}
+
+fn bench_match(c: &mut Criterion) {
+    let names = synthetic_names();
+    // A listed game as the PSP reports it: other punctuation, no region
+    let hit = names[INDEX_SIZE / 2].replace(" - ", ": ");
+    let hit = hit[..hit.rfind(" (").unwrap()].to_string();
+    let index = LoadedIndex::new(names, "https://example.com/", "Boxarts");
+    let miss = "Qwxz Plorf Vbnm";
+
+    let mut group = c.benchmark_group("find_best_match");
+
+    let normalized = normalize_title(&hit);
+    assert!(ThumbnailMatcher::find_best_match(&normalized, &hit, &index).is_some());
+    group.bench_function("hit", |b| {
+        b.iter(|| ThumbnailMatcher::find_best_match(black_box(&normalized), &hit, &index))
+    });
+
+    let normalized = normalize_title(miss);
+    assert!(ThumbnailMatcher::find_best_match(&normalized, miss, &index).is_none());
+    group.bench_function("miss", |b| {
+        b.iter(|| ThumbnailMatcher::find_best_match(black_box(&normalized), miss, &index))
+    });
+
+    group.bench_function("normalize_title", |b| b.iter(|| normalize_title(black_box(&hit))));
+
+    group.finish();
+}
+
+criterion_group!(benches, bench_index, bench_match);
+criterion_main!(benches);
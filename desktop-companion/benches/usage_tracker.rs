@@ -0,0 +1,117 @@
+//! Cost of merging a PSP's usage upload and of building its StatsDelta
+//!
+//! Each merge starts from a tracker that already holds the PSP's library, so
+//! every record raises a total and goes through the aggregates. Writes are
+//! debounced and never reached here; the tracker points at a scratch file.
+//! Run with `cargo bench --bench usage_tracker`.
+
+#![allow(dead_code)]
+
+#[path = "../src/protocol.rs"]
+mod protocol;
+#[path = "../src/usage_tracker.rs"]
+mod usage_tracker;
+
+use std::path::PathBuf;
+
+use criterion::{black_box, criterion_group, criterion_main, BatchSize, Criterion};
+
+use protocol::{StatsDelta, StatsDeltaRecord, STATS_DELTA_MAX_RECORDS};
+use usage_tracker::UsageTracker;
+
+/// Games the PSP has played
+const LIBRARY_GAMES: usize = 500;
+
+const PSP_NAME: &str = "Bench PSP";
+
+fn scratch_path() -> PathBuf {
+    std::env::temp_dir().join(format!("psp_drp_bench_usage_{}.txt", std::process::id()))
+}
+
+/// The PSP's legacy JSON upload, `round` raising every total
+fn legacy_upload(round: u64) -> Vec<u8> {
+    let games: Vec<serde_json::Value> = (0..LIBRARY_GAMES)
+        .map(|i| {
+            serde_json::json!({
+                "game_id": format!("BNCH{:05}", i),
+                "title": format!("Benchmark Game {}", i),
+                "seconds": 3600 * (i as u64 + 1) + round * 60,
+                "sessions": i as u64 % 50 + 1 + round,
+            })
+        })
+        .collect();
+    serde_json::to_vec(&serde_json::json!({ "games": games })).unwrap()
+}
+
+/// A full StatsDelta raising the first games of the library again
+fn delta_upload() -> Vec<u8> {
+    StatsDelta {
+        flags: 0,
+        version: 2000,
+        ack: 0,
+        records: (0..STATS_DELTA_MAX_RECORDS)
+            .map(|i| StatsDeltaRecord {
+                game_id: format!("BNCH{:05}", i),
+                title: format!("Benchmark Game {}", i),
+                total_seconds: 3600 * (i as u64 + 1) + 3600,
+                session_count: i as u32 % 50 + 10,
+                version: 1000 + i as u32,
+            })
+            .collect(),
+    }
+    .encode()
+}
+
+/// A tracker holding the PSP's library, nothing on disk
+fn loaded_tracker() -> UsageTracker {
+    let path = scratch_path();
+    let _ = std::fs::remove_file(path.with_extension("json"));
+    let mut tracker = UsageTracker::new(path, true);
+    tracker.merge_from_psp(PSP_NAME, &legacy_upload(0)).unwrap();
+    tracker
+}
+
+fn bench_merge(c: &mut Criterion) {
+    let legacy = legacy_upload(1);
+    let delta = delta_upload();
+
+    let mut group = c.benchmark_group("merge_from_psp");
+
+    group.bench_function("legacy_json_500", |b| {
+        b.iter_batched(
+            loaded_tracker,
+            |mut tracker| tracker.merge_from_psp(PSP_NAME, black_box(&legacy)).unwrap(),
+            BatchSize::LargeInput,
+        )
+    });
+    group.bench_function("stats_delta_64", |b| {
+        b.iter_batched(
+            loaded_tracker,
+            |mut tracker| tracker.merge_from_psp(PSP_NAME, black_box(&delta)).unwrap(),
+            BatchSize::LargeInput,
+        )
+    });
+
+    group.finish();
+}
+
+fn bench_delta(c: &mut Criterion) {
+    let tracker = loaded_tracker();
+    let version = tracker.get_sync_version();
+
+    let mut group = c.benchmark_group("get_stats_delta_for_psp");
+
+    // A PSP that has seen nothing gets the capped first delta
+    group.bench_function("full", |b| {
+        b.iter(|| tracker.get_stats_delta_for_psp(PSP_NAME, black_box(0), 0))
+    });
+    // The steady state: nothing changed since the last sync
+    group.bench_function("empty", |b| {
+        b.iter(|| tracker.get_stats_delta_for_psp(PSP_NAME, black_box(version), 0))
+    });
+
+    group.finish();
+}
+
+criterion_group!(benches, bench_merge, bench_delta);
+criterion_main!(benches);
@@ -0,0 +1,407 @@
+//! Record and replay PSP traffic against the companion's UDP server
+//!
+//! Traces are text, one packet per line as `<offset_ms> <hex>`, with `#`
+//! starting a comment. Only the PSP -> desktop direction is kept: a replay
+//! resends it open-loop and counts what the server answers.
+//!
+//! ```text
+//! # Stand in for the companion and log what a real PSP sends; with
+//! # --forward the packets go on to a companion on another port and its
+//! # replies come back to the PSP
+//! cargo run --example udp_replay -- record session.trace --listen 0.0.0.0:9276 --forward 127.0.0.1:9277
+//!
+//! # Generate a session: game info, a 20 KB icon, heartbeats with metrics
+//! cargo run --example udp_replay -- synth session.trace --minutes 10
+//!
+//! # Replay it as 50 PSPs (one socket each) at 10x speed
+//! cargo run --example udp_replay -- replay session.trace --target 127.0.0.1:9276 --psps 50 --speed 10
+//! ```
+
+#![allow(dead_code)]
+
+#[path = "../src/protocol.rs"]
+mod protocol;
+
+use std::collections::BTreeMap;
+use std::fs::File;
+use std::io::{self, BufRead, BufReader, BufWriter, Write};
+use std::net::{SocketAddr, UdpSocket};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Mutex};
+use std::thread;
+use std::time::{Duration, Instant};
+
+use protocol::{MessageType, CHUNK_DATA_SIZE, MAGIC};
+
+/// Largest datagram either side sends
+const MAX_PACKET_SIZE: usize = 2048;
+
+/// How long a replay keeps counting replies after its last packet
+const DRAIN_TIME: Duration = Duration::from_secs(2);
+
+/// One recorded packet
+struct TracePacket {
+    offset_ms: u64,
+    data: Vec<u8>,
+}
+
+fn main() {
+    let args: Vec<String> = std::env::args().skip(1).collect();
+    let result = match args.first().map(String::as_str) {
+        Some("record") => record(&args[1..]),
+        Some("replay") => replay(&args[1..]),
+        Some("synth") => synth(&args[1..]),
+        _ => Err(io::Error::new(
+            io::ErrorKind::InvalidInput,
+            "usage: udp_replay record|replay|synth <trace> [options]",
+        )),
+    };
+
+    if let Err(e) = result {
+        eprintln!("udp_replay: {}", e);
+        std::process::exit(1);
+    }
+}
+
+/// Value of `--name` in `args`, or `default`
+fn option<T: std::str::FromStr>(args: &[String], name: &str, default: T) -> io::Result<T> {
+    match args.iter().position(|a| a == name) {
+        Some(i) => args
+            .get(i + 1)
+            .and_then(|v| v.parse().ok())
+            .ok_or_else(|| io::Error::new(io::ErrorKind::InvalidInput, format!("bad value for {}", name))),
+        None => Ok(default),
+    }
+}
+
+fn trace_path(args: &[String]) -> io::Result<&str> {
+    args.first()
+        .map(String::as_str)
+        .ok_or_else(|| io::Error::new(io::ErrorKind::InvalidInput, "missing trace file"))
+}
+
+fn to_hex(data: &[u8]) -> String {
+    data.iter().map(|b| format!("{:02x}", b)).collect()
+}
+
+fn from_hex(hex: &str) -> Option<Vec<u8>> {
+    if hex.len() % 2 != 0 {
+        return None;
+    }
+    (0..hex.len())
+        .step_by(2)
+        .map(|i| u8::from_str_radix(hex.get(i..i + 2)?, 16).ok())
+        .collect()
+}
+
+fn read_trace(path: &str) -> io::Result<Vec<TracePacket>> {
+    let mut packets = Vec::new();
+
+    for (number, line) in BufReader::new(File::open(path)?).lines().enumerate() {
+        let line = line?;
+        let line = line.trim();
+        if line.is_empty() || line.starts_with('#') {
+            continue;
+        }
+
+        let parsed = line.split_once(' ').and_then(|(offset, hex)| {
+            Some(TracePacket {
+                offset_ms: offset.parse().ok()?,
+                data: from_hex(hex.trim())?,
+            })
+        });
+        match parsed {
+            Some(packet) => packets.push(packet),
+            None => {
+                return Err(io::Error::new(
+                    io::ErrorKind::InvalidData,
+                    format!("{}:{}: expected `<offset_ms> <hex>`", path, number + 1),
+                ))
+            }
+        }
+    }
+
+    packets.sort_by_key(|p| p.offset_ms);
+    Ok(packets)
+}
+
+fn write_trace(path: &str, header: &str, packets: &[TracePacket]) -> io::Result<()> {
+    let mut out = BufWriter::new(File::create(path)?);
+    writeln!(out, "# {}", header)?;
+    for packet in packets {
+        writeln!(out, "{} {}", packet.offset_ms, to_hex(&packet.data))?;
+    }
+    out.flush()
+}
+
+/// Message type name for the summaries
+fn type_name(data: &[u8]) -> String {
+    if data.len() < 5 || &data[0..4] != MAGIC {
+        return "invalid".to_string();
+    }
+    match MessageType::try_from(data[4]) {
+        Ok(msg_type) => format!("{:?}", msg_type),
+        Err(()) => format!("unknown(0x{:02x})", data[4]),
+    }
+}
+
+fn print_counts(title: &str, counts: &BTreeMap<String, u64>) {
+    println!("{}:", title);
+    if counts.is_empty() {
+        println!("  (none)");
+    }
+    for (name, count) in counts {
+        println!("  {:<20} {}", name, count);
+    }
+}
+
+/// Log what a PSP sends until Ctrl+C, optionally relaying to a companion
+fn record(args: &[String]) -> io::Result<()> {
+    let path = trace_path(args)?.to_string();
+    let listen: SocketAddr = option(args, "--listen", "0.0.0.0:9276".parse().unwrap())?;
+    let forward: Option<SocketAddr> = if args.iter().any(|a| a == "--forward") {
+        Some(option(args, "--forward", "127.0.0.1:9277".parse().unwrap())?)
+    } else {
+        None
+    };
+
+    let socket = UdpSocket::bind(listen)?;
+    let upstream = match forward {
+        Some(addr) => {
+            let upstream = UdpSocket::bind("0.0.0.0:0")?;
+            upstream.connect(addr)?;
+            Some(upstream)
+        }
+        None => None,
+    };
+    let psp: Arc<Mutex<Option<SocketAddr>>> = Arc::new(Mutex::new(None));
+
+    // Companion replies go back to the PSP that spoke last
+    if let Some(upstream) = &upstream {
+        let upstream = upstream.try_clone()?;
+        let socket = socket.try_clone()?;
+        let psp = psp.clone();
+        thread::spawn(move || {
+            let mut buf = [0u8; MAX_PACKET_SIZE];
+            while let Ok(len) = upstream.recv(&mut buf) {
+                if let Some(addr) = *psp.lock().unwrap() {
+                    let _ = socket.send_to(&buf[..len], addr);
+                }
+            }
+        });
+    }
+
+    println!("Recording on {} into {} (Ctrl+C to stop)", listen, path);
+    let mut out = BufWriter::new(File::create(&path)?);
+    writeln!(out, "# Recorded on {}", listen)?;
+
+    let start = Instant::now();
+    let mut buf = [0u8; MAX_PACKET_SIZE];
+    loop {
+        let (len, addr) = socket.recv_from(&mut buf)?;
+        let data = &buf[..len];
+        *psp.lock().unwrap() = Some(addr);
+
+        writeln!(out, "{} {}", start.elapsed().as_millis(), to_hex(data))?;
+        out.flush()?;
+        println!("{:>8} ms  {:<20} {} bytes from {}", start.elapsed().as_millis(), type_name(data), len, addr);
+
+        if let Some(upstream) = &upstream {
+            upstream.send(data)?;
+        }
+    }
+}
+
+fn packet(msg_type: MessageType, payload: &[u8]) -> Vec<u8> {
+    let mut buf = Vec::with_capacity(5 + payload.len());
+    buf.extend_from_slice(MAGIC);
+    buf.push(msg_type as u8);
+    buf.extend_from_slice(payload);
+    buf
+}
+
+fn fixed_str(buf: &mut Vec<u8>, s: &str, len: usize) {
+    let start = buf.len();
+    buf.extend_from_slice(&s.as_bytes()[..s.len().min(len - 1)]);
+    buf.resize(start + len, 0);
+}
+
+fn heartbeat(uptime_seconds: u32, window_ms: u32) -> Vec<u8> {
+    let mut payload = Vec::new();
+    payload.extend_from_slice(&uptime_seconds.to_le_bytes());
+    payload.push(80);
+
+    // HeartbeatMetrics v1, see protocol.rs
+    let mut metrics = vec![0u8; 80];
+    metrics[0] = 1;
+    metrics[2..4].copy_from_slice(&30u16.to_le_bytes());
+    metrics[4..8].copy_from_slice(&window_ms.to_le_bytes());
+    metrics[8..17].copy_from_slice(b"ULUS10041");
+    metrics[44..48].copy_from_slice(&2u32.to_le_bytes());
+    metrics[76..80].copy_from_slice(&(8u32 << 20).to_le_bytes());
+    payload.extend_from_slice(&metrics);
+
+    packet(MessageType::Heartbeat, &payload)
+}
+
+fn game_info(psp_name: &str, start_time: u32, icon: &[u8]) -> Vec<u8> {
+    let mut payload = Vec::new();
+    fixed_str(&mut payload, "ULUS10041", 10);
+    fixed_str(&mut payload, "Grand Theft Auto: Liberty City Stories", 128);
+    payload.extend_from_slice(&start_time.to_le_bytes());
+    payload.extend_from_slice(&[1, 1, 0]); // Playing, has icon, not persistent
+    fixed_str(&mut payload, psp_name, 32);
+    payload.extend_from_slice(&crc32fast::hash(icon).to_le_bytes());
+    payload.extend_from_slice(&(icon.len() as u32).to_le_bytes());
+    packet(MessageType::GameInfo, &payload)
+}
+
+fn icon_chunk(index: u16, total: u16, data: &[u8]) -> Vec<u8> {
+    let mut payload = Vec::new();
+    fixed_str(&mut payload, "ULUS10041", 10);
+    payload.extend_from_slice(&index.to_le_bytes());
+    payload.extend_from_slice(&total.to_le_bytes());
+    payload.extend_from_slice(&(data.len() as u16).to_le_bytes());
+    payload.extend_from_slice(data);
+    packet(MessageType::IconChunk, &payload)
+}
+
+fn transfer_poll(total: u16, tag: u64) -> Vec<u8> {
+    let mut payload = vec![1]; // Icon transfer
+    fixed_str(&mut payload, "ULUS10041", 10);
+    payload.extend_from_slice(&total.to_le_bytes());
+    payload.extend_from_slice(&tag.to_le_bytes());
+    packet(MessageType::TransferPoll, &payload)
+}
+
+/// Write a plausible session: the game starts, its icon goes out chunk by
+/// chunk with a poll at the end, then heartbeats at the plugin's default
+/// interval
+fn synth(args: &[String]) -> io::Result<()> {
+    let path = trace_path(args)?;
+    let minutes: u64 = option(args, "--minutes", 10)?;
+    let icon_size: usize = option(args, "--icon-size", 20 * 1024)?;
+    let interval_ms: u64 = option(args, "--heartbeat-ms", 30_000)?;
+
+    let icon: Vec<u8> = (0..icon_size).map(|i| (i * 31 + (i >> 8)) as u8).collect();
+    let chunks: Vec<&[u8]> = icon.chunks(CHUNK_DATA_SIZE).collect();
+    let total = chunks.len() as u16;
+
+    let mut packets = vec![
+        TracePacket { offset_ms: 0, data: heartbeat(0, 0) },
+        TracePacket { offset_ms: 10, data: game_info("Replay PSP", 1_700_000_000, &icon) },
+    ];
+
+    // Chunks 2 ms apart, about what the plugin's pacing gives on a good link
+    let mut offset_ms = 50;
+    for (index, chunk) in chunks.iter().enumerate() {
+        packets.push(TracePacket { offset_ms, data: icon_chunk(index as u16, total, chunk) });
+        offset_ms += 2;
+    }
+    packets.push(TracePacket { offset_ms, data: transfer_poll(total, crc32fast::hash(&icon) as u64) });
+
+    let mut at = interval_ms;
+    while at <= minutes * 60_000 {
+        packets.push(TracePacket { offset_ms: at, data: heartbeat((at / 1000) as u32, interval_ms as u32) });
+        at += interval_ms;
+    }
+
+    write_trace(
+        path,
+        &format!("Synthetic session: {} min, {} byte icon, heartbeat every {} ms", minutes, icon_size, interval_ms),
+        &packets,
+    )?;
+    println!("Wrote {} packets to {}", packets.len(), path);
+    Ok(())
+}
+
+/// Replay a trace from `psps` sockets at once and report what came back
+fn replay(args: &[String]) -> io::Result<()> {
+    let path = trace_path(args)?;
+    let target: SocketAddr = option(args, "--target", "127.0.0.1:9276".parse().unwrap())?;
+    let psps: usize = option(args, "--psps", 1)?;
+    let speed: f64 = option(args, "--speed", 1.0)?;
+    if psps == 0 || speed <= 0.0 {
+        return Err(io::Error::new(io::ErrorKind::InvalidInput, "--psps and --speed must be positive"));
+    }
+
+    let packets = Arc::new(read_trace(path)?);
+    if packets.is_empty() {
+        return Err(io::Error::new(io::ErrorKind::InvalidData, "trace is empty"));
+    }
+    let duration_ms = packets.last().unwrap().offset_ms as f64 / speed;
+    println!(
+        "Replaying {} packets from {} as {} PSP(s) at {}x ({:.1} s) to {}",
+        packets.len(), path, psps, speed, duration_ms / 1000.0, target
+    );
+
+    let sent: Arc<Mutex<BTreeMap<String, u64>>> = Arc::new(Mutex::new(BTreeMap::new()));
+    let received: Arc<Mutex<BTreeMap<String, u64>>> = Arc::new(Mutex::new(BTreeMap::new()));
+    let done = Arc::new(AtomicBool::new(false));
+    let start = Instant::now();
+    let mut senders = Vec::new();
+    let mut receivers = Vec::new();
+    let mut max_late = Duration::ZERO;
+
+    for _ in 0..psps {
+        // One socket per PSP: the server keys its per-PSP state by address
+        let socket = UdpSocket::bind("0.0.0.0:0")?;
+        socket.connect(target)?;
+        socket.set_read_timeout(Some(Duration::from_millis(100)))?;
+
+        let reader = socket.try_clone()?;
+        let received = received.clone();
+        let done = done.clone();
+        receivers.push(thread::spawn(move || {
+            let mut buf = [0u8; MAX_PACKET_SIZE];
+            while !done.load(Ordering::Relaxed) {
+                if let Ok(len) = reader.recv(&mut buf) {
+                    *received.lock().unwrap().entry(type_name(&buf[..len])).or_default() += 1;
+                }
+            }
+        }));
+
+        let packets = packets.clone();
+        let sent = sent.clone();
+        senders.push(thread::spawn(move || -> io::Result<Duration> {
+            let mut late = Duration::ZERO;
+            for packet in packets.iter() {
+                let due = start + Duration::from_secs_f64(packet.offset_ms as f64 / 1000.0 / speed);
+                let now = Instant::now();
+                if due > now {
+                    thread::sleep(due - now);
+                } else {
+                    late = late.max(now - due);
+                }
+                socket.send(&packet.data)?;
+                *sent.lock().unwrap().entry(type_name(&packet.data)).or_default() += 1;
+            }
+            Ok(late)
+        }));
+    }
+
+    for sender in senders {
+        let late = sender
+            .join()
+            .map_err(|_| io::Error::new(io::ErrorKind::Other, "sender thread panicked"))??;
+        max_late = max_late.max(late);
+    }
+    let send_time = start.elapsed();
+    thread::sleep(DRAIN_TIME);
+    done.store(true, Ordering::Relaxed);
+    for receiver in receivers {
+        let _ = receiver.join();
+    }
+
+    let total: u64 = sent.lock().unwrap().values().sum();
+    println!(
+        "Sent {} packets in {:.2} s ({:.0}/s), latest packet {} ms behind schedule",
+        total,
+        send_time.as_secs_f64(),
+        total as f64 / send_time.as_secs_f64().max(0.001),
+        max_late.as_millis()
+    );
+    print_counts("Sent", &sent.lock().unwrap());
+    print_counts("Replies", &received.lock().unwrap());
+    Ok(())
+}
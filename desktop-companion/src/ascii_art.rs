@@ -44,6 +44,8 @@ pub struct IconManager {
     temp_dir: PathBuf,
     /// Cache of converted art (game_id -> art_string)
     art_cache: HashMap<String, String>,
+    /// CRC32 of the icon each art entry was made from (game_id -> crc)
+    icon_crcs: HashMap<String, u32>,
     /// Current game icon path (for cleanup)
     current_icon_path: Option<PathBuf>,
     /// Rendering mode
@@ -67,6 +69,7 @@ impl IconManager {
         Self {
             temp_dir,
             art_cache: HashMap::new(),
+            icon_crcs: HashMap::new(),
             current_icon_path: None,
             mode,
         }
@@ -92,6 +95,11 @@ impl IconManager {
         self.art_cache.contains_key(game_id)
     }
 
+    /// Check if we have art made from exactly this icon (matched by CRC32)
+    pub fn has_icon_crc(&self, game_id: &str, crc32: u32) -> bool {
+        self.art_cache.contains_key(game_id) && self.icon_crcs.get(game_id) == Some(&crc32)
+    }
+
     /// Get cached art for a game
     pub fn get_ascii(&self, game_id: &str) -> Option<&String> {
         self.art_cache.get(game_id)
@@ -99,6 +107,8 @@ impl IconManager {
 
     /// Store and convert icon data to art
     pub fn process_icon(&mut self, game_id: &str, data: &[u8]) -> Option<String> {
+        self.icon_crcs.insert(game_id.to_string(), crc32fast::hash(data));
+
         // Save icon to temp file
         let icon_path = self.temp_dir.join(format!("{}.png", game_id));
         
@@ -250,6 +260,7 @@ r#"╔════════════════════════
     #[allow(dead_code)]
     pub fn clear(&mut self) {
         self.art_cache.clear();
+        self.icon_crcs.clear();
         self.cleanup_temp_files();
     }
 
@@ -1,20 +1,57 @@
 use anyhow::Result;
 use discord_rich_presence::{activity, DiscordIpc, DiscordIpcClient};
+use std::collections::VecDeque;
 use std::sync::Arc;
-use std::time::{SystemTime, UNIX_EPOCH};
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
 use tokio::sync::Mutex;
 use tracing::{debug, error, info, warn};
 
 use crate::config::Config;
 use crate::protocol::{GameInfo, PspState};
 
+/// Discord allows this many SET_ACTIVITY calls per RATE_LIMIT_WINDOW
+const RATE_LIMIT_UPDATES: usize = 5;
+const RATE_LIMIT_WINDOW: Duration = Duration::from_secs(20);
+
+/// How long a change waits for follow-ups (e.g. game info, then its
+/// thumbnail) so a burst goes out as one update
+const COALESCE_DELAY: Duration = Duration::from_millis(300);
+
+const XMB_IMAGE_URL: &str = "https://qberty.com/xmb.png";
+
+/// Presence we want Discord to show, kept in plain form so it can be compared
+/// with what was last sent
+#[derive(Debug, Clone, PartialEq, Eq)]
+enum Presence {
+    Clear,
+    Activity {
+        details: String,
+        state: String,
+        start_ts: Option<i64>,
+        large_image: String,
+        large_text: String,
+    },
+}
+
 /// Discord Rich Presence manager
+///
+/// update_presence/set_idle_presence/clear_presence only record the newest
+/// wanted presence; flush_presence (called from the main loop's refresh
+/// tick) sends it once bursts have settled, skips it if Discord already
+/// shows exactly that, and holds it back while the rate limit is used up.
+/// Only the latest state is ever queued.
 pub struct DiscordManager {
     client: Arc<Mutex<Option<DiscordIpcClient>>>,
     config: Config,
     connected: bool,
     last_game_id: Option<String>,
     last_start_ts: Option<i64>,
+    /// Newest wanted presence not sent yet, and when it started waiting
+    pending: Option<(Presence, Instant)>,
+    /// What Discord currently shows (None after connecting)
+    last_sent: Option<Presence>,
+    /// Send times within the current rate limit window
+    recent_sends: VecDeque<Instant>,
 }
 
 impl DiscordManager {
@@ -25,6 +62,9 @@ impl DiscordManager {
             connected: false,
             last_game_id: None,
             last_start_ts: None,
+            pending: None,
+            last_sent: None,
+            recent_sends: VecDeque::new(),
         }
     }
     
@@ -47,6 +87,14 @@ impl DiscordManager {
                 info!("Connected to Discord successfully");
                 self.connected = true;
                 *self.client.lock().await = Some(client);
+                // A new session shows nothing, so whatever we last wanted
+                // has to be sent again
+                if self.pending.is_none() {
+                    if let Some(presence) = self.last_sent.take() {
+                        self.pending = Some((presence, Instant::now()));
+                    }
+                }
+                self.last_sent = None;
                 Ok(())
             }
             Err(e) => {
@@ -58,6 +106,12 @@ impl DiscordManager {
     
     /// Disconnect from Discord
     pub async fn disconnect(&mut self) -> Result<()> {
+        // Last chance for a queued clear; the rate limit no longer matters
+        if let Some((presence, _)) = self.pending.take() {
+            if presence != Presence::Clear || self.last_sent.is_some() {
+                self.send(&presence).await.ok();
+            }
+        }
         if let Some(mut client) = self.client.lock().await.take() {
             if let Err(e) = client.close() {
                 warn!("Error closing Discord connection: {}", e);
@@ -70,10 +124,7 @@ impl DiscordManager {
     
     /// Update presence with game info
     /// If thumbnail_url is provided, it will be used as the large image
-    pub async fn update_presence(&mut self, game_info: &GameInfo, thumbnail_url: Option<&str>) -> Result<()> {
-        let mut guard = self.client.lock().await;
-        let client = guard.as_mut().ok_or_else(|| anyhow::anyhow!("Not connected to Discord"))?;
-        
+    pub fn update_presence(&mut self, game_info: &GameInfo, thumbnail_url: Option<&str>) {
         // Build the activity
         let details = if game_info.title.is_empty() {
             game_info.state.as_str().to_string()
@@ -86,11 +137,8 @@ impl DiscordManager {
             _ => self.config.discord.state_text.clone(),
         };
         
-        let mut activity_builder = activity::Activity::new()
-            .details(&details)
-            .state(&state_text);
-        
         // Add timestamps if enabled
+        let mut start_ts = None;
         if self.config.discord.show_elapsed_time {
             let now = SystemTime::now()
                 .duration_since(UNIX_EPOCH)
@@ -102,18 +150,10 @@ impl DiscordManager {
                 self.last_start_ts = Some(now);
             }
 
-            if let Some(ts) = self.last_start_ts {
-                if ts > 0 {
-                    activity_builder = activity_builder.timestamps(
-                        activity::Timestamps::new().start(ts)
-                    );
-                }
-            }
+            start_ts = self.last_start_ts.filter(|ts| *ts > 0);
         }
         
         // Add assets - use thumbnail URL if provided, XMB image for XMB, otherwise fall back to static asset
-        const XMB_IMAGE_URL: &str = "https://qberty.com/xmb.png";
-        
         let (large_image, large_text): (&str, &str) = if game_info.state == PspState::Xmb {
             // Browsing XMB - use XMB screenshot
             (XMB_IMAGE_URL, "XrossMediaBar")
@@ -125,68 +165,135 @@ impl DiscordManager {
             ("psp_logo", "PlayStation Portable")
         };
         
-        let assets = activity::Assets::new()
-            .large_image(large_image)
-            .large_text(large_text)
-            .small_image("psp_logo")
-            .small_text("PlayStation Portable");
+        self.queue(Presence::Activity {
+            details,
+            state: state_text,
+            start_ts,
+            large_image: large_image.to_string(),
+            large_text: large_text.to_string(),
+        });
+    }
+    
+    /// Clear presence (when PSP disconnects)
+    pub fn clear_presence(&mut self) {
+        self.last_game_id = None;
+        self.last_start_ts = None;
+        self.queue(Presence::Clear);
+    }
+    
+    /// Update presence to show PSP connected but idle
+    pub fn set_idle_presence(&mut self, psp_name: &str) {
+        self.queue(Presence::Activity {
+            details: "Browsing XMB".to_string(),
+            state: format!("on {}", psp_name),
+            start_ts: None,
+            large_image: XMB_IMAGE_URL.to_string(),
+            large_text: "XrossMediaBar".to_string(),
+        });
+    }
+    
+    /// Replace whatever is waiting with the newest presence
+    fn queue(&mut self, presence: Presence) {
+        let since = match &self.pending {
+            Some((_, since)) => *since,
+            None => Instant::now(),
+        };
+        self.pending = Some((presence, since));
+    }
+    
+    /// Send the queued presence if it has settled, differs from what Discord
+    /// shows and the rate limit allows it
+    pub async fn flush_presence(&mut self) -> Result<()> {
+        let now = Instant::now();
+        let ready = match &self.pending {
+            Some((_, since)) => now.duration_since(*since) >= COALESCE_DELAY,
+            None => false,
+        };
+        if !ready || !self.connected {
+            return Ok(());
+        }
         
-        activity_builder = activity_builder.assets(assets);
+        while let Some(sent) = self.recent_sends.front() {
+            if now.duration_since(*sent) < RATE_LIMIT_WINDOW {
+                break;
+            }
+            self.recent_sends.pop_front();
+        }
         
-        // Set the activity
-        match client.set_activity(activity_builder) {
-            Ok(_) => {
-                debug!("Updated Discord presence: {}", details);
+        let presence = match self.pending.take() {
+            Some((presence, _)) => presence,
+            None => return Ok(()),
+        };
+        // Nothing to do if Discord already shows it (a clear on a fresh
+        // session included)
+        let unchanged = match &self.last_sent {
+            Some(sent) => *sent == presence,
+            None => presence == Presence::Clear,
+        };
+        if unchanged {
+            return Ok(());
+        }
+        if self.recent_sends.len() >= RATE_LIMIT_UPDATES {
+            // Keep it (latest wins) until a slot frees up
+            self.pending = Some((presence, now));
+            return Ok(());
+        }
+        
+        self.recent_sends.push_back(now);
+        match self.send(&presence).await {
+            Ok(()) => {
+                self.last_sent = Some(presence);
                 Ok(())
             }
             Err(e) => {
-                warn!("Failed to update presence: {}", e);
-                Err(anyhow::anyhow!("Failed to update presence: {}", e))
-            }
-        }
-    }
-    
-    /// Clear presence (when PSP disconnects)
-    pub async fn clear_presence(&mut self) -> Result<()> {
-        let mut guard = self.client.lock().await;
-        if let Some(client) = guard.as_mut() {
-            if let Err(e) = client.clear_activity() {
-                warn!("Failed to clear presence: {}", e);
+                // Retry later unless something newer comes along
+                self.pending = Some((presence, now));
+                Err(e)
             }
-            debug!("Cleared Discord presence");
         }
-        self.last_game_id = None;
-        self.last_start_ts = None;
-        Ok(())
     }
     
-    /// Update presence to show PSP connected but idle
-    pub async fn set_idle_presence(&mut self, psp_name: &str) -> Result<()> {
+    /// Send one presence over IPC
+    async fn send(&self, presence: &Presence) -> Result<()> {
         let mut guard = self.client.lock().await;
         let client = guard.as_mut().ok_or_else(|| anyhow::anyhow!("Not connected to Discord"))?;
         
-        const XMB_IMAGE_URL: &str = "https://qberty.com/xmb.png";
+        let (details, state, start_ts, large_image, large_text) = match presence {
+            Presence::Clear => {
+                if let Err(e) = client.clear_activity() {
+                    warn!("Failed to clear presence: {}", e);
+                }
+                debug!("Cleared Discord presence");
+                return Ok(());
+            }
+            Presence::Activity { details, state, start_ts, large_image, large_text } => {
+                (details, state, start_ts, large_image, large_text)
+            }
+        };
         
-        let state_text = format!("on {}", psp_name);
-        let activity = activity::Activity::new()
-            .details("Browsing XMB")
-            .state(&state_text)
+        let mut activity_builder = activity::Activity::new()
+            .details(details)
+            .state(state)
             .assets(
                 activity::Assets::new()
-                    .large_image(XMB_IMAGE_URL)
-                    .large_text("XrossMediaBar")
+                    .large_image(large_image)
+                    .large_text(large_text)
                     .small_image("psp_logo")
                     .small_text("PlayStation Portable")
             );
+        if let Some(ts) = start_ts {
+            activity_builder = activity_builder.timestamps(activity::Timestamps::new().start(*ts));
+        }
         
-        match client.set_activity(activity) {
+        // Set the activity
+        match client.set_activity(activity_builder) {
             Ok(_) => {
-                debug!("Set idle presence for {}", psp_name);
+                debug!("Updated Discord presence: {}", details);
                 Ok(())
             }
             Err(e) => {
-                warn!("Failed to set idle presence: {}", e);
-                Err(anyhow::anyhow!("Failed to set idle presence: {}", e))
+                warn!("Failed to update presence: {}", e);
+                Err(anyhow::anyhow!("Failed to update presence: {}", e))
             }
         }
     }
@@ -24,6 +24,7 @@ use tracing::error;
 use ascii_art::{IconManager, IconMode};
 use config::Config;
 use discord::DiscordManager;
+use protocol::StatsDelta;
 use server::{Server, ServerCommand, ServerEvent};
 use thumbnail_matcher::ThumbnailMatcher;
 use tui::{GameStats, Tui, TuiEvent, TuiState, ViewMode};
@@ -142,7 +143,14 @@ async fn main() -> Result<()> {
     // Initialize thumbnail matcher for Discord game icons
     let thumbnail_matcher = Arc::new(ThumbnailMatcher::new());
     
-    // Load thumbnail index in background
+    // Start from the cached index, if any, so lookups work right away
+    let cached_thumbnails = thumbnail_matcher.load_cache().await;
+    if cached_thumbnails > 0 {
+        let mut state = tui_state.write().await;
+        state.log_info(&format!("Loaded {} cached game thumbnails", cached_thumbnails));
+    }
+    
+    // Refresh thumbnail index in background
     {
         let matcher = thumbnail_matcher.clone();
         let tui_state_clone = tui_state.clone();
@@ -247,6 +255,7 @@ async fn main() -> Result<()> {
                     }
                     UsbEvent::Disconnected => {
                         let mut state = tui_state.write().await;
+                        state.psp_metrics.remove("usb");
                         state.psp_name = None;
                         state.psp_addr = None;
                         state.current_game = None;
@@ -254,7 +263,7 @@ async fn main() -> Result<()> {
                         state.session_start = None;
                         state.status_message = "Waiting for PSP USB connection...".to_string();
                         state.log_info("PSP USB disconnected");
-                        discord.clear_presence().await.ok();
+                        discord.clear_presence();
                     }
                     UsbEvent::GameInfo(usb_game_info) => {
                         // Convert USB game info to protocol GameInfo
@@ -267,6 +276,8 @@ async fn main() -> Result<()> {
                             start_time: usb_game_info.start_time as u32,
                             persistent: usb_game_info.persistent,
                             psp_name: usb_game_info.psp_name.clone(),
+                            icon_crc32: usb_game_info.icon_crc32,
+                            icon_size: usb_game_info.icon_size,
                         };
                         
                         // Update TUI state
@@ -285,7 +296,7 @@ async fn main() -> Result<()> {
                         
                         // Update Discord presence
                         let thumbnail_url = thumbnail_matcher.find_thumbnail(&game_info.game_id, &game_info.title).await;
-                        discord.update_presence(&game_info, thumbnail_url.as_deref()).await.ok();
+                        discord.update_presence(&game_info, thumbnail_url.as_deref());
                     }
                     UsbEvent::IconData { game_id, data } => {
                         let mut state = tui_state.write().await;
@@ -300,11 +311,16 @@ async fn main() -> Result<()> {
                             }
                         }
                     }
+                    UsbEvent::Metrics(metrics) => {
+                        let mut state = tui_state.write().await;
+                        let name = state.psp_name.clone().unwrap_or_else(|| "USB PSP".to_string());
+                        state.update_metrics("usb".to_string(), name, "USB", metrics);
+                    }
                     UsbEvent::Error(msg) => {
                         let mut state = tui_state.write().await;
                         state.log_warn(&format!("USB error: {}", msg));
                     }
-                    UsbEvent::StatsRequested { psp_name, local_timestamp: _ } => {
+                    UsbEvent::StatsRequested { psp_name, local_timestamp: _, since_version } => {
                         // PSP requested stats - send our usage data
                         let mut state = tui_state.write().await;
                         let name = if psp_name.is_empty() {
@@ -314,13 +330,25 @@ async fn main() -> Result<()> {
                         };
                         state.log_info(&format!("USB: Stats requested by {}", name));
                         
-                        // Get usage data for this PSP (returns (json_string, last_updated))
-                        let (json_data, last_updated) = usage_tracker.get_usage_for_psp_json(&name);
+                        // The USB plugin keeps our whole file for the stats app and
+                        // can't merge deltas in kernel mode, so it gets either the
+                        // full file or an empty delta meaning "yours is current"
+                        let current_version = usage_tracker.get_sync_version();
+                        let (json_data, last_updated) = match since_version {
+                            Some(v) if v != 0 && v == current_version => {
+                                let delta = StatsDelta { version: v, ..Default::default() };
+                                (delta.encode(), usage_tracker.get_last_updated())
+                            }
+                            _ => {
+                                let (json, last_updated) = usage_tracker.get_usage_for_psp_json(&name);
+                                (json.into_bytes(), last_updated)
+                            }
+                        };
                         
                         // Send stats response via command channel
                         if let Err(e) = usb_cmd_tx.send(UsbCommand::SendStatsResponse { 
                             last_updated, 
-                            json_data: json_data.clone() 
+                            data: json_data.clone() 
                         }).await {
                             state.log_warn(&format!("USB: Failed to queue stats response: {}", e));
                         } else {
@@ -328,15 +356,15 @@ async fn main() -> Result<()> {
                                                    json_data.len(), last_updated));
                         }
                     }
-                    UsbEvent::StatsUploaded { last_updated, json_data } => {
+                    UsbEvent::StatsUploaded { last_updated, data } => {
                         // PSP uploaded stats - merge them
                         let mut state = tui_state.write().await;
                         let psp_name = state.psp_name.clone().unwrap_or_else(|| "PSP".to_string());
                         state.log_info(&format!("USB: Stats uploaded (timestamp={}, {} bytes)", 
-                                               last_updated, json_data.len()));
+                                               last_updated, data.len()));
                         
                         // Merge the PSP's usage data
-                        if let Err(e) = usage_tracker.merge_from_psp(&psp_name, &json_data) {
+                        if let Err(e) = usage_tracker.merge_from_psp(&psp_name, &data) {
                             state.log_warn(&format!("USB: Failed to merge stats: {}", e));
                         } else {
                             state.log_success(&format!("USB: Merged stats for {}", psp_name));
@@ -347,6 +375,14 @@ async fn main() -> Result<()> {
 
             // Refresh TUI
             _ = refresh_interval.tick() => {
+                // Write out usage changes once they have settled
+                usage_tracker.flush_if_due();
+                
+                // Send the latest queued Discord presence, if due
+                if let Err(e) = discord.flush_presence().await {
+                    tui_state.write().await.log_warn(&format!("Discord error: {}", e));
+                }
+                
                 // Handle input (pass the state for mouse click detection)
                 let state_for_events = tui_state.read().await.clone();
                 match tui.handle_events(Duration::from_millis(INPUT_POLL_MS), &state_for_events)? {
@@ -356,7 +392,7 @@ async fn main() -> Result<()> {
                         let all_stats = usage_tracker.get_all_game_stats();
                         let play_dates = usage_tracker.get_all_play_dates();
                         let mut state = tui_state.write().await;
-                        state.all_game_stats = all_stats.into_iter()
+                        state.all_game_stats = Arc::new(all_stats.into_iter()
                             .map(|(title, game_id, seconds, sessions, last_played)| GameStats {
                                 title,
                                 game_id,
@@ -364,8 +400,8 @@ async fn main() -> Result<()> {
                                 session_count: sessions,
                                 last_played,
                             })
-                            .collect();
-                        state.play_dates = play_dates;
+                            .collect());
+                        state.play_dates = Arc::new(play_dates);
                         state.view_mode = ViewMode::Stats;
                         state.stats_scroll = 0;
                         state.selected_date = None;
@@ -423,9 +459,12 @@ async fn main() -> Result<()> {
 
     // Flush usage tracker
     usage_tracker.flush_all();
+    
+    // Save thumbnail matches still waiting on the debounce
+    thumbnail_matcher.flush_cache().await;
 
     // Clear Discord presence
-    discord.clear_presence().await?;
+    discord.clear_presence();
     discord.disconnect().await?;
 
     // Abort server
@@ -497,13 +536,12 @@ async fn handle_server_event(
             usage_tracker.register_psp(addr, name.clone());
             
             // Set idle presence
-            if let Err(e) = discord.set_idle_presence(&name).await {
-                state.log_warn(&format!("Discord error: {}", e));
-            }
+            discord.set_idle_presence(&name);
         }
 
         ServerEvent::PspDisconnected { addr, name } => {
             let mut state = tui_state.write().await;
+            state.psp_metrics.remove(&addr.to_string());
             
             // Only process if this is our current PSP
             let is_current_psp = state.psp_addr.map(|a| a == addr).unwrap_or(false);
@@ -519,9 +557,7 @@ async fn handle_server_event(
                 
                 usage_tracker.unregister_psp(addr);
                 
-                if let Err(e) = discord.clear_presence().await {
-                    state.log_warn(&format!("Discord error: {}", e));
-                }
+                discord.clear_presence();
             } else {
                 // Log but don't clear state for unknown connections
                 state.log_info(&format!("Unknown device '{}' disconnected", name));
@@ -555,8 +591,13 @@ async fn handle_server_event(
                 }
             }
 
-            // Check if we have the icon cached - request on ANY update if missing
-            if !icon_manager.has_ascii(&info.game_id) {
+            // Check if we have the icon cached - request on ANY update if missing.
+            // When the PSP advertises the icon CRC, only that exact icon counts.
+            let have_icon = match info.icon_crc32 {
+                Some(crc) => icon_manager.has_icon_crc(&info.game_id, crc),
+                None => icon_manager.has_ascii(&info.game_id),
+            };
+            if !have_icon {
                 state.ascii_art = None;
                 // Request icon from PSP (retry on every update until we get it)
                 if !info.game_id.is_empty() && info.game_id != "XMB" && info.game_id != "UNK" {
@@ -569,9 +610,19 @@ async fn handle_server_event(
                         game_id: info.game_id.clone() 
                     }).await;
                 }
-            } else if state.ascii_art.is_none() {
-                // We have it cached but haven't set it yet
-                state.ascii_art = icon_manager.get_ascii(&info.game_id).cloned();
+            } else {
+                // Let the PSP know it doesn't need to send the advertised icon
+                if let Some(crc32) = info.icon_crc32 {
+                    let _ = server_cmd_tx.send(ServerCommand::ConfirmIcon {
+                        addr,
+                        game_id: info.game_id.clone(),
+                        crc32,
+                    }).await;
+                }
+                if state.ascii_art.is_none() {
+                    // We have it cached but haven't set it yet
+                    state.ascii_art = icon_manager.get_ascii(&info.game_id).cloned();
+                }
             }
 
             state.current_game = Some(info.clone());
@@ -596,18 +647,19 @@ async fn handle_server_event(
                     state.log_info(&format!("Found thumbnail for {}", info.title));
                 }
             }
-            drop(state); // Release lock before async Discord call
             
-            if let Err(e) = discord.update_presence(&info, thumbnail_url.as_deref()).await {
-                let mut state = tui_state.write().await;
-                state.log_warn(&format!("Discord error: {}", e));
-            }
+            // Queued; the refresh tick sends it once the burst settles
+            discord.update_presence(&info, thumbnail_url.as_deref());
         }
 
-        ServerEvent::HeartbeatReceived { addr: _, heartbeat } => {
+        ServerEvent::HeartbeatReceived { addr, name, heartbeat } => {
             // Don't log heartbeats (too frequent), just update WiFi strength
+            // and the PSP's metrics
             let mut state = tui_state.write().await;
             state.wifi_strength = heartbeat.wifi_strength;
+            if let Some(metrics) = heartbeat.metrics {
+                state.update_metrics(addr.to_string(), name, "WiFi", metrics);
+            }
         }
 
         ServerEvent::IconReceived { game_id, data } => {
@@ -625,12 +677,25 @@ async fn handle_server_event(
             }
         }
 
-        ServerEvent::StatsRequested { addr, psp_name } => {
+        ServerEvent::StatsRequested { addr, psp_name, request } => {
             let mut state = tui_state.write().await;
             state.log_info(&format!("Stats requested from {} ({})", psp_name, addr));
             
-            // Get usage data for this PSP using the sync API
-            let (json_data, last_updated) = usage_tracker.get_usage_for_psp_json(&psp_name);
+            // Newer PSPs only want what changed since their last sync
+            let (json_data, last_updated) = match request {
+                Some(req) => {
+                    let delta = usage_tracker.get_stats_delta_for_psp(
+                        &psp_name,
+                        req.since_version,
+                        req.psp_version,
+                    );
+                    (delta, usage_tracker.get_sync_version() as u64)
+                }
+                None => {
+                    let (json, last_updated) = usage_tracker.get_usage_for_psp_json(&psp_name);
+                    (json.into_bytes(), last_updated)
+                }
+            };
             
             state.log_info(&format!("Sending {} bytes to PSP (last_updated: {})", 
                 json_data.len(), last_updated));
@@ -638,17 +703,17 @@ async fn handle_server_event(
             // Send stats via server command
             let _ = server_cmd_tx.send(ServerCommand::SendStats {
                 addr,
-                json_data: json_data.into_bytes(),
+                json_data,
                 last_updated,
             }).await;
         }
 
-        ServerEvent::StatsUploaded { addr, psp_name, last_updated, json_data } => {
+        ServerEvent::StatsUploaded { addr, psp_name, last_updated, data } => {
             let mut state = tui_state.write().await;
             state.log_info(&format!("Stats uploaded from {} ({}), last_updated: {}", psp_name, addr, last_updated));
             
             // Merge the uploaded data into our usage tracker
-            match usage_tracker.merge_from_psp(&psp_name, &json_data) {
+            match usage_tracker.merge_from_psp(&psp_name, &data) {
                 Ok(merge_count) => {
                     state.log_success(&format!("Merged {} games from PSP '{}'", merge_count, psp_name));
                     
@@ -1,6 +1,7 @@
 //! Protocol definitions matching the PSP plugin
 //! See shared/protocol.md for full documentation
 
+use std::borrow::Cow;
 use std::io;
 
 /// Magic bytes at the start of every packet
@@ -9,6 +10,10 @@ pub const MAGIC: &[u8; 4] = b"PSPR";
 /// Protocol version
 pub const VERSION: &str = "1.0.0";
 
+/// Data bytes in every ICON_CHUNK/STATS_UPLOAD/STATS_RESPONSE but the last
+/// of a transfer, so chunk i starts at i * CHUNK_DATA_SIZE
+pub const CHUNK_DATA_SIZE: usize = 1024;
+
 /// Message types
 #[repr(u8)]
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -20,12 +25,15 @@ pub enum MessageType {
     IconEnd = 0x04,
     StatsRequest = 0x05,  // Request usage stats from desktop
     StatsUpload = 0x06,   // Upload local usage stats to desktop
+    TransferPoll = 0x07,  // Ask which chunks of a transfer are still missing
     DiscoveryResponse = 0x21,
 
     // Desktop -> PSP
     Ack = 0x10,
     IconRequest = 0x11,  // Request icon for a game_id
     StatsResponse = 0x12,  // Send usage stats to PSP
+    IconHave = 0x13,  // Advertised icon is already cached, don't send it
+    TransferStatus = 0x14,  // Missing-chunk bitmap, reply to TransferPoll
     DiscoveryRequest = 0x20,
 }
 
@@ -40,9 +48,12 @@ impl TryFrom<u8> for MessageType {
             0x04 => Ok(Self::IconEnd),
             0x05 => Ok(Self::StatsRequest),
             0x06 => Ok(Self::StatsUpload),
+            0x07 => Ok(Self::TransferPoll),
             0x10 => Ok(Self::Ack),
             0x11 => Ok(Self::IconRequest),
             0x12 => Ok(Self::StatsResponse),
+            0x13 => Ok(Self::IconHave),
+            0x14 => Ok(Self::TransferStatus),
             0x20 => Ok(Self::DiscoveryRequest),
             0x21 => Ok(Self::DiscoveryResponse),
             _ => Err(()),
@@ -95,6 +106,8 @@ pub struct Heartbeat {
     #[allow(dead_code)]
     pub uptime_seconds: u32,
     pub wifi_strength: u8,
+    /// Metrics extension, absent from older plugins
+    pub metrics: Option<HeartbeatMetrics>,
 }
 
 impl Heartbeat {
@@ -109,8 +122,86 @@ impl Heartbeat {
         Ok(Self {
             uptime_seconds: u32::from_le_bytes([data[0], data[1], data[2], data[3]]),
             wifi_strength: data[4],
+            metrics: HeartbeatMetrics::decode(&data[5..]),
+        })
+    }
+}
+
+/// Detection time buckets in HeartbeatMetrics: < 1, 2, 4 ... 64 ms, >= 64 ms
+pub const METRICS_DETECT_BUCKETS: usize = 8;
+
+/// Plugin metrics appended to a heartbeat (network and USB alike). The
+/// counters cover `window_ms`, the time since the previous heartbeat.
+#[derive(Debug, Clone, Default)]
+pub struct HeartbeatMetrics {
+    pub window_ms: u32,
+    /// Game running when the window closed, empty if none
+    pub game_id: String,
+    pub detect_count: u16,
+    pub detect_hist: [u16; METRICS_DETECT_BUCKETS],
+    pub detect_avg_us: u32,
+    pub detect_max_us: u32,
+    pub tx_packets: u32,
+    pub tx_bytes: u32,
+    pub rx_packets: u32,
+    pub rx_bytes: u32,
+    pub send_failures: u16,
+    pub retransmits: u16,
+    pub wakeups: u16,
+    /// Cost of the last icon the PSP sent, in any window
+    pub icon_bytes: u32,
+    pub icon_packets: u16,
+    /// Last completed stats sync, 0 if none yet
+    pub sync_rtt_ms: u32,
+    pub heap_free: u32,
+}
+
+impl HeartbeatMetrics {
+    /// Size of the extension on the wire
+    pub const SIZE: usize = 80;
+
+    /// Decode the extension; None if it is missing or of an unknown version
+    pub fn decode(data: &[u8]) -> Option<Self> {
+        if data.len() < Self::SIZE || data[0] != 1 {
+            return None;
+        }
+
+        let u16_at = |i: usize| u16::from_le_bytes([data[i], data[i + 1]]);
+        let u32_at = |i: usize| u32::from_le_bytes([data[i], data[i + 1], data[i + 2], data[i + 3]]);
+
+        let mut detect_hist = [0u16; METRICS_DETECT_BUCKETS];
+        for (i, bucket) in detect_hist.iter_mut().enumerate() {
+            *bucket = u16_at(20 + i * 2);
+        }
+
+        Some(Self {
+            detect_count: u16_at(2),
+            window_ms: u32_at(4),
+            game_id: read_string(&data[8..18]),
+            send_failures: u16_at(18),
+            detect_hist,
+            detect_avg_us: u32_at(36),
+            detect_max_us: u32_at(40),
+            tx_packets: u32_at(44),
+            tx_bytes: u32_at(48),
+            rx_packets: u32_at(52),
+            rx_bytes: u32_at(56),
+            retransmits: u16_at(60),
+            wakeups: u16_at(62),
+            icon_bytes: u32_at(64),
+            icon_packets: u16_at(68),
+            sync_rtt_ms: u32_at(72),
+            heap_free: u32_at(76),
         })
     }
+
+    /// Main loop wakeups scaled to one minute
+    pub fn wakeups_per_minute(&self) -> u32 {
+        if self.window_ms == 0 {
+            return 0;
+        }
+        (self.wakeups as u64 * 60_000 / self.window_ms as u64) as u32
+    }
 }
 
 /// Game information from PSP
@@ -124,6 +215,10 @@ pub struct GameInfo {
     pub has_icon: bool,
     pub persistent: bool,
     pub psp_name: String,
+    /// CRC32 of the icon, when the PSP already knows it (icon cache hit)
+    pub icon_crc32: Option<u32>,
+    /// Icon size in bytes (0 if not advertised)
+    pub icon_size: u32,
 }
 
 impl GameInfo {
@@ -160,6 +255,15 @@ impl GameInfo {
             String::new()
         };
 
+        // Icon digest (8 bytes at offset 177), absent from older plugins
+        let (icon_crc32, icon_size) = if data.len() >= 185 {
+            let crc = u32::from_le_bytes([data[177], data[178], data[179], data[180]]);
+            let size = u32::from_le_bytes([data[181], data[182], data[183], data[184]]);
+            if size > 0 { (Some(crc), size) } else { (None, 0) }
+        } else {
+            (None, 0)
+        };
+
         // Treat SystemControl/SystemCon as XMB browsing (CFW module, not a game)
         let game_id_lower = game_id.to_lowercase();
         let title_lower = title.to_lowercase();
@@ -175,21 +279,23 @@ impl GameInfo {
             has_icon,
             persistent,
             psp_name,
+            icon_crc32,
+            icon_size,
         })
     }
 }
 
-/// Icon chunk from PSP
+/// Icon chunk from PSP (borrows the receive buffer)
 #[derive(Debug, Clone)]
-pub struct IconChunk {
-    pub game_id: String,
+pub struct IconChunk<'a> {
+    pub game_id: Cow<'a, str>,
     pub chunk_index: u16,
     pub total_chunks: u16,
-    pub data: Vec<u8>,
+    pub data: &'a [u8],
 }
 
-impl IconChunk {
-    pub fn decode(data: &[u8]) -> io::Result<Self> {
+impl<'a> IconChunk<'a> {
+    pub fn decode(data: &'a [u8]) -> io::Result<Self> {
         if data.len() < 16 {
             return Err(io::Error::new(
                 io::ErrorKind::InvalidData,
@@ -197,7 +303,7 @@ impl IconChunk {
             ));
         }
 
-        let game_id = read_string(&data[0..10]);
+        let game_id = read_str(&data[0..10]);
         let chunk_index = u16::from_le_bytes([data[10], data[11]]);
         let total_chunks = u16::from_le_bytes([data[12], data[13]]);
         let data_length = u16::from_le_bytes([data[14], data[15]]) as usize;
@@ -213,21 +319,21 @@ impl IconChunk {
             game_id,
             chunk_index,
             total_chunks,
-            data: data[16..16 + data_length].to_vec(),
+            data: &data[16..16 + data_length],
         })
     }
 }
 
-/// Icon end marker from PSP
+/// Icon end marker from PSP (borrows the receive buffer)
 #[derive(Debug, Clone)]
-pub struct IconEnd {
-    pub game_id: String,
+pub struct IconEnd<'a> {
+    pub game_id: Cow<'a, str>,
     pub total_size: u32,
     pub crc32: u32,
 }
 
-impl IconEnd {
-    pub fn decode(data: &[u8]) -> io::Result<Self> {
+impl<'a> IconEnd<'a> {
+    pub fn decode(data: &'a [u8]) -> io::Result<Self> {
         if data.len() < 18 {
             return Err(io::Error::new(
                 io::ErrorKind::InvalidData,
@@ -235,7 +341,7 @@ impl IconEnd {
             ));
         }
 
-        let game_id = read_string(&data[0..10]);
+        let game_id = read_str(&data[0..10]);
         let total_size = u32::from_le_bytes([data[10], data[11], data[12], data[13]]);
         let crc32 = u32::from_le_bytes([data[14], data[15], data[16], data[17]]);
 
@@ -247,6 +353,96 @@ impl IconEnd {
     }
 }
 
+/// Transfer kinds carried in TransferPoll/TransferStatus
+pub const TRANSFER_KIND_ICON: u8 = 1;
+pub const TRANSFER_KIND_STATS: u8 = 2;
+
+/// Largest transfer the status bitmap can describe
+pub const TRANSFER_MAX_CHUNKS: usize = 256;
+
+/// Transfer poll from PSP, sent after each window of chunks (borrows the
+/// receive buffer)
+#[derive(Debug, Clone)]
+pub struct TransferPoll<'a> {
+    pub kind: u8,
+    /// Game ID for icons, empty for stats
+    pub id: Cow<'a, str>,
+    pub total_chunks: u16,
+    /// last_updated for stats uploads, icon CRC32 for icons
+    pub tag: u64,
+}
+
+impl<'a> TransferPoll<'a> {
+    pub fn decode(data: &'a [u8]) -> io::Result<Self> {
+        if data.len() < 21 {
+            return Err(io::Error::new(
+                io::ErrorKind::InvalidData,
+                "TransferPoll too short",
+            ));
+        }
+
+        let kind = data[0];
+        let id = read_str(&data[1..11]);
+        let total_chunks = u16::from_le_bytes([data[11], data[12]]);
+        let tag = u64::from_le_bytes([
+            data[13], data[14], data[15], data[16],
+            data[17], data[18], data[19], data[20],
+        ]);
+
+        Ok(Self {
+            kind,
+            id,
+            total_chunks,
+            tag,
+        })
+    }
+}
+
+/// Transfer status (sent by desktop in reply to a TransferPoll)
+#[derive(Debug, Clone)]
+pub struct TransferStatus<'a> {
+    pub kind: u8,
+    pub id: &'a str,
+    pub total_chunks: u16,
+    /// Per-chunk received flags, index = chunk number
+    pub received: &'a [bool],
+}
+
+impl TransferStatus<'_> {
+    pub fn encode(&self) -> Vec<u8> {
+        let mut buf = Vec::with_capacity(4 + 1 + 15 + TRANSFER_MAX_CHUNKS / 8);
+
+        // Magic
+        buf.extend_from_slice(MAGIC);
+
+        // Type
+        buf.push(MessageType::TransferStatus as u8);
+
+        buf.push(self.kind);
+
+        // ID (10 bytes, null-padded)
+        let id_bytes = self.id.as_bytes();
+        let copy_len = id_bytes.len().min(9);
+        buf.extend_from_slice(&id_bytes[..copy_len]);
+        buf.resize(buf.len() + (10 - copy_len), 0);
+
+        buf.extend_from_slice(&self.total_chunks.to_le_bytes());
+        let received_count = self.received.iter().filter(|r| **r).count() as u16;
+        buf.extend_from_slice(&received_count.to_le_bytes());
+
+        // Missing bitmap: bit i set = chunk i not received yet
+        let mut missing = [0u8; TRANSFER_MAX_CHUNKS / 8];
+        for i in 0..(self.total_chunks as usize).min(TRANSFER_MAX_CHUNKS) {
+            if !self.received.get(i).copied().unwrap_or(false) {
+                missing[i / 8] |= 1 << (i % 8);
+            }
+        }
+        buf.extend_from_slice(&missing);
+
+        buf
+    }
+}
+
 /// Discovery response from PSP
 #[derive(Debug, Clone)]
 pub struct DiscoveryResponse {
@@ -312,6 +508,32 @@ impl DiscoveryRequest {
     }
 }
 
+/// Acknowledgement (sent by desktop for heartbeats, game info and uploads)
+///
+/// Carries the session of the PSP's connection. A PSP that reconnects and
+/// gets its previous session back knows the desktop kept its state (game,
+/// stats watermark) and skips the resend and full sync.
+#[derive(Debug, Clone)]
+pub struct Ack {
+    pub session: u32,
+}
+
+impl Ack {
+    pub fn encode(&self) -> Vec<u8> {
+        let mut buf = Vec::with_capacity(4 + 1 + 4);
+
+        // Magic
+        buf.extend_from_slice(MAGIC);
+
+        // Type
+        buf.push(MessageType::Ack as u8);
+
+        buf.extend_from_slice(&self.session.to_le_bytes());
+
+        buf
+    }
+}
+
 /// Icon request (sent by desktop to request icon for a game)
 #[derive(Debug, Clone)]
 pub struct IconRequest {
@@ -344,6 +566,172 @@ impl IconRequest {
     }
 }
 
+/// Icon have (sent by desktop when the icon advertised in GAME_INFO is
+/// already cached, so the PSP doesn't need to send it)
+#[derive(Debug, Clone)]
+pub struct IconHave {
+    pub game_id: String,
+    pub crc32: u32,
+}
+
+impl IconHave {
+    pub fn new(game_id: &str, crc32: u32) -> Self {
+        Self {
+            game_id: game_id.to_string(),
+            crc32,
+        }
+    }
+
+    pub fn encode(&self) -> Vec<u8> {
+        let mut buf = Vec::with_capacity(4 + 1 + 10 + 4);
+
+        // Magic
+        buf.extend_from_slice(MAGIC);
+
+        // Type
+        buf.push(MessageType::IconHave as u8);
+
+        // Game ID (10 bytes, null-padded)
+        let game_id_bytes = self.game_id.as_bytes();
+        let copy_len = game_id_bytes.len().min(9);
+        buf.extend_from_slice(&game_id_bytes[..copy_len]);
+        buf.resize(buf.len() + (10 - copy_len), 0);
+
+        // CRC32 (4 bytes)
+        buf.extend_from_slice(&self.crc32.to_le_bytes());
+
+        buf
+    }
+}
+
+/// Stats request from PSP. A bare header asks for the whole usage file; this
+/// payload asks for a StatsDelta of what changed after `since_version`.
+/// Format: [since_version:u32][psp_version:u32]
+#[derive(Debug, Clone, Copy)]
+pub struct StatsRequest {
+    pub since_version: u32,   // Highest desktop sync_version the PSP has merged
+    pub psp_version: u32,     // PSP's own sync_version
+}
+
+impl StatsRequest {
+    /// Decode the request payload, `None` for a legacy header-only request
+    pub fn decode(data: &[u8]) -> Option<Self> {
+        if data.len() < 8 {
+            return None;
+        }
+
+        Some(Self {
+            since_version: u32::from_le_bytes([data[0], data[1], data[2], data[3]]),
+            psp_version: u32::from_le_bytes([data[4], data[5], data[6], data[7]]),
+        })
+    }
+}
+
+/// Magic at the start of a StatsDelta (in place of JSON in a stats transfer)
+pub const STATS_DELTA_MAGIC: &[u8; 4] = b"PSDL";
+
+const STATS_DELTA_HEADER_SIZE: usize = 16;
+const STATS_DELTA_GAME_ID_LEN: usize = 16;
+const STATS_DELTA_TITLE_LEN: usize = 64;
+const STATS_DELTA_RECORD_SIZE: usize = STATS_DELTA_GAME_ID_LEN + STATS_DELTA_TITLE_LEN + 16;
+
+/// Most records in one StatsDelta; the rest follow in the next sync
+pub const STATS_DELTA_MAX_RECORDS: usize = 64;
+
+/// StatsDelta flag: the sender has newer changes that did not fit
+pub const STATS_DELTA_FLAG_MORE: u16 = 0x0001;
+
+/// One game in a StatsDelta
+#[derive(Debug, Clone, Default)]
+pub struct StatsDeltaRecord {
+    pub game_id: String,
+    pub title: String,
+    pub total_seconds: u64,
+    pub session_count: u32,
+    pub version: u32,         // Sender's sync_version of the last change
+}
+
+/// Games changed since the peer's last acknowledged sync_version
+/// Format: ["PSDL"][count:u16][flags:u16][version:u32][ack:u32] + count records of
+/// [game_id:16][title:64][total_seconds:u64][session_count:u32][version:u32]
+#[derive(Debug, Clone, Default)]
+pub struct StatsDelta {
+    pub flags: u16,           // STATS_DELTA_FLAG_*
+    pub version: u32,         // Newest sender sync_version covered by the delta
+    pub ack: u32,             // Highest peer sync_version the sender has merged
+    pub records: Vec<StatsDeltaRecord>,
+}
+
+impl StatsDelta {
+    /// Check whether a stats payload is a delta rather than JSON
+    pub fn is_delta(data: &[u8]) -> bool {
+        data.len() >= STATS_DELTA_HEADER_SIZE && &data[0..4] == STATS_DELTA_MAGIC
+    }
+
+    pub fn decode(data: &[u8]) -> io::Result<Self> {
+        if !Self::is_delta(data) {
+            return Err(io::Error::new(
+                io::ErrorKind::InvalidData,
+                "Not a StatsDelta",
+            ));
+        }
+
+        let count = u16::from_le_bytes([data[4], data[5]]) as usize;
+        let flags = u16::from_le_bytes([data[6], data[7]]);
+        let version = u32::from_le_bytes([data[8], data[9], data[10], data[11]]);
+        let ack = u32::from_le_bytes([data[12], data[13], data[14], data[15]]);
+
+        if data.len() < STATS_DELTA_HEADER_SIZE + count * STATS_DELTA_RECORD_SIZE {
+            return Err(io::Error::new(
+                io::ErrorKind::InvalidData,
+                "StatsDelta records incomplete",
+            ));
+        }
+
+        let records = data[STATS_DELTA_HEADER_SIZE..]
+            .chunks_exact(STATS_DELTA_RECORD_SIZE)
+            .take(count)
+            .map(|r| {
+                let nums = &r[STATS_DELTA_GAME_ID_LEN + STATS_DELTA_TITLE_LEN..];
+                StatsDeltaRecord {
+                    game_id: read_string(&r[..STATS_DELTA_GAME_ID_LEN]),
+                    title: read_string(&r[STATS_DELTA_GAME_ID_LEN..STATS_DELTA_GAME_ID_LEN + STATS_DELTA_TITLE_LEN]),
+                    total_seconds: u64::from_le_bytes([
+                        nums[0], nums[1], nums[2], nums[3],
+                        nums[4], nums[5], nums[6], nums[7],
+                    ]),
+                    session_count: u32::from_le_bytes([nums[8], nums[9], nums[10], nums[11]]),
+                    version: u32::from_le_bytes([nums[12], nums[13], nums[14], nums[15]]),
+                }
+            })
+            .collect();
+
+        Ok(Self { flags, version, ack, records })
+    }
+
+    pub fn encode(&self) -> Vec<u8> {
+        let mut buf = Vec::with_capacity(
+            STATS_DELTA_HEADER_SIZE + self.records.len() * STATS_DELTA_RECORD_SIZE,
+        );
+
+        buf.extend_from_slice(STATS_DELTA_MAGIC);
+        buf.extend_from_slice(&(self.records.len() as u16).to_le_bytes());
+        buf.extend_from_slice(&self.flags.to_le_bytes());
+        buf.extend_from_slice(&self.version.to_le_bytes());
+        buf.extend_from_slice(&self.ack.to_le_bytes());
+
+        for record in &self.records {
+            write_string(&mut buf, &record.game_id, STATS_DELTA_GAME_ID_LEN);
+            write_string(&mut buf, &record.title, STATS_DELTA_TITLE_LEN);
+            buf.extend_from_slice(&record.total_seconds.to_le_bytes());
+            buf.extend_from_slice(&record.session_count.to_le_bytes());
+            buf.extend_from_slice(&record.version.to_le_bytes());
+        }
+
+        buf
+    }
+}
+
 /// Stats response (sent by desktop to PSP with usage stats)
 /// Format: [total_bytes:u32][last_updated:u64][chunk_index:u16][total_chunks:u16][data_len:u16][json_data...]
 #[derive(Debug, Clone)]
@@ -358,7 +746,7 @@ pub struct StatsResponse {
 impl StatsResponse {
     /// Create a new stats response with chunked data
     pub fn new_chunks(json_data: &[u8], last_updated: u64) -> Vec<Self> {
-        const MAX_CHUNK_SIZE: usize = 1024;  // Keep packets under UDP MTU
+        const MAX_CHUNK_SIZE: usize = CHUNK_DATA_SIZE;  // Keep packets under UDP MTU
         
         let total_bytes = json_data.len() as u32;
         let total_chunks = ((json_data.len() + MAX_CHUNK_SIZE - 1) / MAX_CHUNK_SIZE).max(1) as u16;
@@ -422,15 +810,15 @@ impl StatsResponse {
 /// Stats upload (sent by PSP to desktop with local usage data)
 /// Format: [last_updated:u64][chunk_index:u16][total_chunks:u16][data_len:u16][json_data...]
 #[derive(Debug, Clone)]
-pub struct StatsUpload {
+pub struct StatsUpload<'a> {
     pub last_updated: u64,    // Unix timestamp of PSP's local data
     pub chunk_index: u16,
     pub total_chunks: u16,
-    pub json_data: Vec<u8>,   // Chunk of JSON usage data
+    pub json_data: &'a [u8],  // Chunk of JSON usage data (borrows the receive buffer)
 }
 
-impl StatsUpload {
-    pub fn decode(data: &[u8]) -> std::io::Result<Self> {
+impl<'a> StatsUpload<'a> {
+    pub fn decode(data: &'a [u8]) -> std::io::Result<Self> {
         // Minimum size: last_updated(8) + chunk_index(2) + total_chunks(2) + data_len(2) = 14
         if data.len() < 14 {
             return Err(std::io::Error::new(
@@ -458,7 +846,7 @@ impl StatsUpload {
             last_updated,
             chunk_index,
             total_chunks,
-            json_data: data[14..14 + data_length].to_vec(),
+            json_data: &data[14..14 + data_length],
         })
     }
 }
@@ -489,6 +877,96 @@ pub fn parse_packet(data: &[u8]) -> io::Result<(MessageType, &[u8])> {
 
 /// Helper to read a null-terminated string from fixed-size buffer
 fn read_string(data: &[u8]) -> String {
+    read_str(data).into_owned()
+}
+
+/// Like read_string, but borrows the buffer unless the bytes aren't UTF-8
+fn read_str(data: &[u8]) -> Cow<'_, str> {
     let end = data.iter().position(|&b| b == 0).unwrap_or(data.len());
-    String::from_utf8_lossy(&data[..end]).to_string()
+    String::from_utf8_lossy(&data[..end])
+}
+
+/// Helper to write a string into a fixed-size, null-terminated field
+fn write_string(buf: &mut Vec<u8>, value: &str, len: usize) {
+    let bytes = value.as_bytes();
+    let mut copy_len = bytes.len().min(len - 1);
+    // Don't split a UTF-8 sequence
+    while copy_len > 0 && !value.is_char_boundary(copy_len) {
+        copy_len -= 1;
+    }
+    buf.extend_from_slice(&bytes[..copy_len]);
+    buf.resize(buf.len() + (len - copy_len), 0);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn record(game_id: &str, title: &str, total_seconds: u64, session_count: u32, version: u32) -> StatsDeltaRecord {
+        StatsDeltaRecord {
+            game_id: game_id.to_string(),
+            title: title.to_string(),
+            total_seconds,
+            session_count,
+            version,
+        }
+    }
+
+    #[test]
+    fn test_stats_delta_round_trip() {
+        let delta = StatsDelta {
+            flags: STATS_DELTA_FLAG_MORE,
+            version: 42,
+            ack: 7,
+            records: vec![
+                record("ULUS10391", "Crisis Core: Final Fantasy VII", 36_000, 12, 40),
+                record("NPUH10117", "", u64::from(u32::MAX) + 1, 0, 42),
+            ],
+        };
+
+        let data = delta.encode();
+        assert_eq!(data.len(), STATS_DELTA_HEADER_SIZE + 2 * STATS_DELTA_RECORD_SIZE);
+        assert!(StatsDelta::is_delta(&data));
+
+        let decoded = StatsDelta::decode(&data).unwrap();
+        assert_eq!(decoded.flags, STATS_DELTA_FLAG_MORE);
+        assert_eq!(decoded.version, 42);
+        assert_eq!(decoded.ack, 7);
+        assert_eq!(decoded.records.len(), 2);
+        for (a, b) in decoded.records.iter().zip(&delta.records) {
+            assert_eq!(a.game_id, b.game_id);
+            assert_eq!(a.title, b.title);
+            assert_eq!(a.total_seconds, b.total_seconds);
+            assert_eq!(a.session_count, b.session_count);
+            assert_eq!(a.version, b.version);
+        }
+    }
+
+    #[test]
+    fn test_stats_delta_empty() {
+        let decoded = StatsDelta::decode(&StatsDelta { version: 3, ..Default::default() }.encode()).unwrap();
+        assert_eq!(decoded.version, 3);
+        assert_eq!(decoded.flags, 0);
+        assert!(decoded.records.is_empty());
+    }
+
+    #[test]
+    fn test_stats_delta_truncates_title() {
+        // Cut to the field, never in the middle of a character
+        let title = "é".repeat(40);
+        let delta = StatsDelta { records: vec![record("ULJM05500", &title, 1, 1, 1)], ..Default::default() };
+        let decoded = StatsDelta::decode(&delta.encode()).unwrap();
+        assert_eq!(decoded.records[0].title, "é".repeat(31));
+    }
+
+    #[test]
+    fn test_stats_delta_rejects_bad_input() {
+        assert!(!StatsDelta::is_delta(b"{\"games\":[]} padding"));
+        assert!(StatsDelta::decode(b"{\"games\":[]} padding").is_err());
+
+        // Header promises a record that is not there
+        let mut data = StatsDelta { records: vec![record("ULUS10391", "", 1, 1, 1)], ..Default::default() }.encode();
+        data.truncate(data.len() - 1);
+        assert!(StatsDelta::decode(&data).is_err());
+    }
 }
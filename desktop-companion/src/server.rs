@@ -1,22 +1,44 @@
+//! UDP server for PSP connections
+//!
+//! The receive loop only routes datagrams: each PSP address gets a task of
+//! its own that owns that PSP's connection state (icon and stats reassembly
+//! included) and handles its packets in order. A slow or busy PSP therefore
+//! never holds up packets from the others, and no lock is shared between
+//! them beyond the routing table.
+
 use std::collections::HashMap;
 use std::net::{IpAddr, Ipv4Addr, SocketAddr};
-use std::sync::Arc;
-use std::time::{Duration, Instant};
+use std::sync::atomic::{AtomicU32, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
 
 use anyhow::Result;
 use tokio::net::UdpSocket;
-use tokio::sync::{mpsc, RwLock};
+use tokio::sync::mpsc;
 use tracing::{debug, error, info, warn};
 
 use crate::config::Config;
 use crate::protocol::{
-    parse_packet, DiscoveryRequest, DiscoveryResponse, GameInfo, Heartbeat, IconChunk, IconEnd,
-    IconRequest, MessageType, StatsResponse, StatsUpload,
+    parse_packet, Ack, DiscoveryRequest, DiscoveryResponse, GameInfo, Heartbeat, IconChunk, IconEnd,
+    IconHave, IconRequest, MessageType, StatsRequest, StatsResponse, StatsUpload, TransferPoll,
+    TransferStatus,
+    CHUNK_DATA_SIZE, TRANSFER_KIND_ICON, TRANSFER_KIND_STATS, TRANSFER_MAX_CHUNKS,
 };
 
 /// Maximum UDP packet size
 const MAX_PACKET_SIZE: usize = 2048;
 
+/// Packets queued per PSP task before further ones are dropped (UDP
+/// semantics; the PSP's transfer polls recover anything lost)
+const PEER_QUEUE_LEN: usize = 64;
+
+/// Starting point for session IDs. Taken from the clock so that sessions
+/// from before a desktop restart are not handed out again.
+fn session_seed() -> u32 {
+    let now = SystemTime::now().duration_since(UNIX_EPOCH).unwrap_or_default();
+    (now.as_secs() as u32) ^ now.subsec_nanos().rotate_left(16)
+}
+
 /// Event from the server to main loop
 #[derive(Debug, Clone)]
 pub enum ServerEvent {
@@ -32,8 +54,9 @@ pub enum ServerEvent {
     GameInfoUpdated { addr: SocketAddr, info: GameInfo },
     /// Heartbeat received
     HeartbeatReceived {
-        #[allow(dead_code)]
         addr: SocketAddr,
+        /// PSP name as known to the connection
+        name: String,
         heartbeat: Heartbeat,
     },
     /// Icon received completely
@@ -41,52 +64,142 @@ pub enum ServerEvent {
         game_id: String,
         data: Vec<u8>,
     },
-    /// Stats requested by PSP
+    /// Stats requested by PSP (`request` is None for a legacy full-file request)
     StatsRequested {
         addr: SocketAddr,
         psp_name: String,
+        request: Option<StatsRequest>,
     },
-    /// Stats uploaded from PSP
+    /// Stats uploaded from PSP (JSON or StatsDelta)
     StatsUploaded {
         addr: SocketAddr,
         psp_name: String,
         last_updated: u64,
-        json_data: String,
+        data: Vec<u8>,
     },
 }
 
-/// Connected PSP state
+/// Connected PSP state (owned by that PSP's task)
 struct PspConnection {
     name: String,
     last_seen: Instant,
     current_game: Option<GameInfo>,
-    icon_buffer: HashMap<String, IconBuffer>,
+    /// The icon transfer in progress (one at a time; a chunk of another
+    /// icon replaces it)
+    icon_buffer: Option<IconBuffer>,
     discovery_sent: bool,
     persistent: bool,
     /// Accumulating stats upload data
     stats_upload_buffer: Option<StatsUploadBuffer>,
+    /// last_updated of the most recent completed stats upload
+    last_stats_upload: Option<u64>,
+}
+
+impl PspConnection {
+    fn new(name: String, discovery_sent: bool) -> Self {
+        Self {
+            name,
+            last_seen: Instant::now(),
+            current_game: None,
+            icon_buffer: None,
+            discovery_sent,
+            persistent: false,
+            stats_upload_buffer: None,
+            last_stats_upload: None,
+        }
+    }
+}
+
+/// Buffer for accumulating a chunked icon
+struct IconBuffer {
+    game_id: String,
+    chunks: ChunkBuffer,
 }
 
 /// Buffer for accumulating chunked stats uploads
 struct StatsUploadBuffer {
-    chunks: Vec<Option<Vec<u8>>>,
-    total_chunks: u16,
-    received_chunks: u16,
+    chunks: ChunkBuffer,
     last_updated: u64,
 }
 
-/// Buffer for receiving icon chunks
-struct IconBuffer {
-    chunks: Vec<Option<Vec<u8>>>,
-    total_chunks: u16,
+/// Reassembly buffer for a chunked transfer. Chunk i lands at
+/// i * CHUNK_DATA_SIZE, so each chunk is copied exactly once and the
+/// finished transfer is handed off without another copy. The data grows as
+/// chunks arrive, so a packet claiming a huge transfer costs nothing until
+/// its chunks do.
+struct ChunkBuffer {
+    data: Vec<u8>,
+    /// Per-chunk received flags, index = chunk number
+    received: Vec<bool>,
     received_chunks: u16,
+    /// End of the furthest chunk so far (the last chunk is usually short)
+    len: usize,
 }
 
+/// Most chunks a stats upload may have (4 MB). Polled transfers stop at
+/// TRANSFER_MAX_CHUNKS; the PSP sends larger uploads unpaced, without polls.
+/// Icons are always polled, so they stop at TRANSFER_MAX_CHUNKS.
+const STATS_BUFFER_MAX_CHUNKS: usize = 4096;
+
+impl ChunkBuffer {
+    /// None if the transfer has more than `max_chunks` chunks
+    fn new(total_chunks: u16, max_chunks: usize) -> Option<Self> {
+        let total = total_chunks as usize;
+        if total > max_chunks {
+            return None;
+        }
+        Some(Self {
+            data: Vec::new(),
+            received: vec![false; total],
+            received_chunks: 0,
+            len: 0,
+        })
+    }
+
+    fn total_chunks(&self) -> u16 {
+        self.received.len() as u16
+    }
+
+    /// Copy a chunk into place (duplicates just overwrite)
+    fn insert(&mut self, index: u16, chunk: &[u8]) {
+        let index = index as usize;
+        if index >= self.received.len() || chunk.len() > CHUNK_DATA_SIZE {
+            return;
+        }
+        let offset = index * CHUNK_DATA_SIZE;
+        if self.data.len() < offset + chunk.len() {
+            self.data.resize(offset + chunk.len(), 0);
+        }
+        self.data[offset..offset + chunk.len()].copy_from_slice(chunk);
+        if !self.received[index] {
+            self.received[index] = true;
+            self.received_chunks += 1;
+        }
+        self.len = self.len.max(offset + chunk.len());
+    }
+
+    fn is_complete(&self) -> bool {
+        !self.received.is_empty() && self.received_chunks == self.total_chunks()
+    }
+
+    /// Take the assembled data
+    fn into_data(mut self) -> Vec<u8> {
+        self.data.truncate(self.len);
+        self.data
+    }
+}
+
+/// Status bitmaps for transfers we hold nothing of, or all of
+static NONE_RECEIVED: [bool; TRANSFER_MAX_CHUNKS] = [false; TRANSFER_MAX_CHUNKS];
+static ALL_RECEIVED: [bool; TRANSFER_MAX_CHUNKS] = [true; TRANSFER_MAX_CHUNKS];
+
 /// Commands that can be sent to the server
 #[derive(Debug, Clone)]
 pub enum ServerCommand {
     /// Request an icon for a game from a specific PSP
     RequestIcon { addr: SocketAddr, game_id: String },
+    /// Tell a PSP we already have the icon it advertised
+    ConfirmIcon { addr: SocketAddr, game_id: String, crc32: u32 },
     /// Send stats response to a PSP
     SendStats { 
         addr: SocketAddr, 
@@ -95,13 +208,25 @@ pub enum ServerCommand {
     },
 }
 
+/// Routing table: PSP address -> that PSP's packet queue
+type PeerMap = Arc<Mutex<HashMap<SocketAddr, mpsc::Sender<Vec<u8>>>>>;
+
+/// What the receive loop and every PSP task share
+struct Shared {
+    config: Config,
+    socket: Arc<UdpSocket>,
+    event_tx: mpsc::Sender<ServerEvent>,
+    /// Last session handed out, see `Ack`
+    last_session: AtomicU32,
+}
+
 /// UDP server for receiving PSP data
 pub struct Server {
     config: Config,
     socket: Option<Arc<UdpSocket>>,
     discovery_socket: Option<Arc<UdpSocket>>,
     local_ipv4: Option<Ipv4Addr>,
-    connections: Arc<RwLock<HashMap<SocketAddr, PspConnection>>>,
+    peers: PeerMap,
     event_tx: mpsc::Sender<ServerEvent>,
     command_rx: Option<mpsc::Receiver<ServerCommand>>,
 }
@@ -113,7 +238,7 @@ impl Server {
             socket: None,
             discovery_socket: None,
             local_ipv4: None,
-            connections: Arc::new(RwLock::new(HashMap::new())),
+            peers: Arc::new(Mutex::new(HashMap::new())),
             event_tx,
             command_rx: None,
         }
@@ -176,41 +301,11 @@ impl Server {
     /// Run the main receive loop
     pub async fn run(&mut self) -> Result<()> {
         let socket = self.socket.as_ref().ok_or_else(|| anyhow::anyhow!("Server not started"))?.clone();
-        let connections = self.connections.clone();
-        let event_tx = self.event_tx.clone();
-        let timeout_secs = self.config.network.timeout_seconds;
-
-        // Spawn timeout checker
-        let connections_clone = connections.clone();
-        let event_tx_clone = event_tx.clone();
-        tokio::spawn(async move {
-            let mut interval = tokio::time::interval(Duration::from_secs(10));
-            loop {
-                interval.tick().await;
-                let mut conns = connections_clone.write().await;
-                let now = Instant::now();
-                let mut to_remove = Vec::new();
-
-                for (addr, conn) in conns.iter() {
-                    // Skip timeout for persistent connections (send_once mode)
-                    if conn.persistent {
-                        continue;
-                    }
-                    if now.duration_since(conn.last_seen).as_secs() > timeout_secs {
-                        to_remove.push(*addr);
-                    }
-                }
-
-                for addr in to_remove {
-                    if let Some(conn) = conns.remove(&addr) {
-                        info!("PSP {} ({}) disconnected (timeout)", conn.name, addr);
-                        let _ = event_tx_clone.send(ServerEvent::PspDisconnected { 
-                            addr, 
-                            name: conn.name 
-                        }).await;
-                    }
-                }
-            }
+        let shared = Arc::new(Shared {
+            config: self.config.clone(),
+            socket: socket.clone(),
+            event_tx: self.event_tx.clone(),
+            last_session: AtomicU32::new(session_seed()),
         });
 
         // Take the command receiver if we have one
@@ -220,14 +315,10 @@ impl Server {
         let mut buf = [0u8; MAX_PACKET_SIZE];
         loop {
             tokio::select! {
-                // Handle incoming packets
+                // Route incoming packets to their PSP's task
                 result = socket.recv_from(&mut buf) => {
                     match result {
-                        Ok((len, addr)) => {
-                            if let Err(e) = self.handle_packet(&buf[..len], addr).await {
-                                debug!("Error handling packet from {}: {}", addr, e);
-                            }
-                        }
+                        Ok((len, addr)) => self.dispatch(&shared, &buf[..len], addr),
                         Err(e) => {
                             error!("Error receiving packet: {}", e);
                         }
@@ -246,35 +337,231 @@ impl Server {
                                 warn!("Failed to request icon: {}", e);
                             }
                         }
-                        ServerCommand::SendStats { addr, json_data, last_updated } => {
-                            if let Err(e) = self.send_stats_response(addr, &json_data, last_updated).await {
-                                warn!("Failed to send stats to {}: {}", addr, e);
+                        ServerCommand::ConfirmIcon { addr, game_id, crc32 } => {
+                            if let Err(e) = self.confirm_icon(addr, &game_id, crc32).await {
+                                warn!("Failed to confirm icon: {}", e);
                             }
                         }
+                        ServerCommand::SendStats { addr, json_data, last_updated } => {
+                            // Paced over several ms per chunk, so off the receive loop
+                            let shared = shared.clone();
+                            tokio::spawn(async move {
+                                if let Err(e) = shared.send_stats_response(addr, &json_data, last_updated).await {
+                                    warn!("Failed to send stats to {}: {}", addr, e);
+                                }
+                            });
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /// Queue a packet for its PSP's task, starting the task if there is none
+    fn dispatch(&self, shared: &Arc<Shared>, data: &[u8], addr: SocketAddr) {
+        // The task only exits while holding this lock with an empty queue, so
+        // a packet queued here is never stranded
+        let mut peers = self.peers.lock().unwrap_or_else(|e| e.into_inner());
+
+        if let Some(tx) = peers.get(&addr) {
+            match tx.try_send(data.to_vec()) {
+                Ok(()) => return,
+                Err(mpsc::error::TrySendError::Full(_)) => {
+                    debug!("Queue full for {}, dropping packet", addr);
+                    return;
+                }
+                Err(mpsc::error::TrySendError::Closed(_)) => {
+                    // Task went away; start a fresh one below
+                }
+            }
+        }
+
+        let (tx, rx) = mpsc::channel(PEER_QUEUE_LEN);
+        let _ = tx.try_send(data.to_vec());
+        peers.insert(addr, tx);
+
+        let task = PeerTask {
+            addr,
+            shared: shared.clone(),
+            peers: self.peers.clone(),
+            session: shared.new_session(),
+            conn: None,
+        };
+        tokio::spawn(task.run(rx));
+    }
+
+    /// Request an icon from a connected PSP
+    pub async fn request_icon(&self, addr: SocketAddr, game_id: &str) -> Result<()> {
+        if let Some(socket) = &self.socket {
+            let request = IconRequest::new(game_id);
+            let packet = request.encode();
+            socket.send_to(&packet, addr).await?;
+            info!("Requested icon for {} from {}", game_id, addr);
+        }
+        Ok(())
+    }
+
+    /// Tell a PSP the icon it advertised is already cached
+    pub async fn confirm_icon(&self, addr: SocketAddr, game_id: &str, crc32: u32) -> Result<()> {
+        if let Some(socket) = &self.socket {
+            let packet = IconHave::new(game_id, crc32).encode();
+            socket.send_to(&packet, addr).await?;
+            debug!("Icon for {} already cached ({:08x}), told {}", game_id, crc32, addr);
+        }
+        Ok(())
+    }
+
+    /// Send discovery broadcast
+    #[allow(dead_code)]
+    pub async fn send_discovery_broadcast(&self) -> Result<()> {
+        if let Some(socket) = &self.socket {
+            let request = DiscoveryRequest::new(self.config.network.listen_port);
+            let packet = request.encode();
+
+            let mut targets = Vec::new();
+            let broadcast_addr: SocketAddr = format!("255.255.255.255:{}", self.config.network.discovery_port)
+                .parse()?;
+            targets.push(broadcast_addr);
+
+            if let Some(ip) = self.local_ipv4 {
+                let guess = Self::guess_broadcast(ip);
+                let guess_addr: SocketAddr = format!("{}:{}", guess, self.config.network.discovery_port).parse()?;
+                if guess_addr != broadcast_addr {
+                    targets.push(guess_addr);
+                }
+            }
+
+            for target in targets {
+                socket.send_to(&packet, target).await?;
+                debug!("Sent discovery broadcast to {}", target);
+            }
+        }
+        Ok(())
+    }
+}
+
+impl Shared {
+    async fn send_discovery_request(&self, addr: SocketAddr) -> Result<()> {
+        if !self.config.network.auto_discovery {
+            return Ok(());
+        }
+
+        let request = DiscoveryRequest::new(self.config.network.listen_port);
+        let packet = request.encode();
+        let target = SocketAddr::new(addr.ip(), self.config.network.discovery_port);
+        self.socket.send_to(&packet, target).await?;
+        info!("Sent discovery request to {}", target);
+
+        Ok(())
+    }
+
+    async fn send_ack(&self, addr: SocketAddr, session: u32) -> Result<()> {
+        self.socket.send_to(&Ack { session }.encode(), addr).await?;
+        Ok(())
+    }
+
+    /// Next session ID, never 0 (0 means "no session" to the PSP)
+    fn new_session(&self) -> u32 {
+        loop {
+            let session = self.last_session.fetch_add(1, Ordering::Relaxed).wrapping_add(1);
+            if session != 0 {
+                return session;
+            }
+        }
+    }
+
+    /// Send stats response to PSP (chunked if necessary)
+    async fn send_stats_response(&self, addr: SocketAddr, json_data: &[u8], last_updated: u64) -> Result<()> {
+        let chunks = StatsResponse::new_chunks(json_data, last_updated);
+        info!("Sending {} stats chunks ({} bytes) to {}", chunks.len(), json_data.len(), addr);
+        
+        for chunk in chunks {
+            let packet = chunk.encode();
+            self.socket.send_to(&packet, addr).await?;
+            // Small delay between chunks to avoid overwhelming PSP
+            tokio::time::sleep(Duration::from_millis(10)).await;
+        }
+        Ok(())
+    }
+}
+
+/// Task owning one PSP address: its connection state and its packets
+struct PeerTask {
+    addr: SocketAddr,
+    shared: Arc<Shared>,
+    peers: PeerMap,
+    /// Session ID sent in every ACK; a new task means a new session
+    session: u32,
+    /// None until the PSP says hello (heartbeat, game info or discovery)
+    conn: Option<PspConnection>,
+}
+
+impl PeerTask {
+    /// Handle packets until the PSP times out
+    async fn run(mut self, mut rx: mpsc::Receiver<Vec<u8>>) {
+        let timeout = Duration::from_secs(self.shared.config.network.timeout_seconds);
+
+        loop {
+            // Persistent connections (send_once mode) never time out
+            let packet = match &self.conn {
+                Some(conn) if conn.persistent => rx.recv().await,
+                Some(conn) => {
+                    let deadline = conn.last_seen + timeout;
+                    tokio::time::timeout_at(deadline.into(), rx.recv()).await.unwrap_or(None)
+                }
+                None => tokio::time::timeout(timeout, rx.recv()).await.unwrap_or(None),
+            };
+
+            match packet {
+                Some(data) => {
+                    if let Err(e) = self.handle_packet(&data).await {
+                        debug!("Error handling packet from {}: {}", self.addr, e);
+                    }
+                }
+                None => {
+                    // Timed out: leave the routing table, unless packets
+                    // arrived in the meantime
+                    {
+                        let mut peers = self.peers.lock().unwrap_or_else(|e| e.into_inner());
+                        if !rx.is_empty() {
+                            continue;
+                        }
+                        peers.remove(&self.addr);
                     }
+
+                    if let Some(conn) = self.conn.take() {
+                        info!("PSP {} ({}) disconnected (timeout)", conn.name, self.addr);
+                        let _ = self.shared.event_tx.send(ServerEvent::PspDisconnected {
+                            addr: self.addr,
+                            name: conn.name,
+                        }).await;
+                    }
+                    return;
                 }
             }
         }
     }
 
     /// Handle an incoming packet
-    async fn handle_packet(&self, data: &[u8], addr: SocketAddr) -> Result<()> {
+    async fn handle_packet(&mut self, data: &[u8]) -> Result<()> {
+        let addr = self.addr;
         let (msg_type, payload) = parse_packet(data)?;
 
         match msg_type {
             MessageType::Heartbeat => {
                 let heartbeat = Heartbeat::decode(payload)?;
-                if let Err(e) = self.send_ack(addr).await {
+                if let Err(e) = self.shared.send_ack(addr, self.session).await {
                     warn!("Failed to send ACK to {}: {}", addr, e);
                 }
-                let should_send = self.update_last_seen(addr).await;
+                let should_send = self.update_last_seen();
                 if should_send {
-                    if let Err(e) = self.send_discovery_request(addr).await {
+                    if let Err(e) = self.shared.send_discovery_request(addr).await {
                         warn!("Failed to send discovery request to {}: {}", addr, e);
                     }
                 }
-                self.event_tx
-                    .send(ServerEvent::HeartbeatReceived { addr, heartbeat })
+                let name = self.conn.as_ref().map(|c| c.name.clone()).unwrap_or_default();
+                self.shared.event_tx
+                    .send(ServerEvent::HeartbeatReceived { addr, name, heartbeat })
                     .await?;
             }
 
@@ -285,55 +572,51 @@ impl Server {
                     debug!("Game {} has icon data", info.game_id);
                 }
 
-                if let Err(e) = self.send_ack(addr).await {
+                if let Err(e) = self.shared.send_ack(addr, self.session).await {
                     warn!("Failed to send ACK to {}: {}", addr, e);
                 }
 
-                let should_send = self.update_last_seen(addr).await;
+                let should_send = self.update_last_seen();
                 if should_send {
-                    if let Err(e) = self.send_discovery_request(addr).await {
+                    if let Err(e) = self.shared.send_discovery_request(addr).await {
                         warn!("Failed to send discovery request to {}: {}", addr, e);
                     }
                 }
 
                 // Update connection state
-                {
-                    let mut conns = self.connections.write().await;
-                    if let Some(conn) = conns.get_mut(&addr) {
-                        conn.last_seen = Instant::now();
-                        conn.current_game = Some(info.clone());
-                        // Update connection name from GameInfo if we have a better name
-                        if !info.psp_name.is_empty() && conn.name != info.psp_name {
-                            debug!("Updating connection name from '{}' to '{}'", conn.name, info.psp_name);
-                            conn.name = info.psp_name.clone();
-                        }
-                        // If PSP sent persistent flag (send_once mode), mark connection
-                        if info.persistent {
-                            conn.persistent = true;
-                            info!("PSP {} marked as persistent (send_once mode)", conn.name);
-                        }
+                if let Some(conn) = self.conn.as_mut() {
+                    conn.last_seen = Instant::now();
+                    conn.current_game = Some(info.clone());
+                    // Update connection name from GameInfo if we have a better name
+                    if !info.psp_name.is_empty() && conn.name != info.psp_name {
+                        debug!("Updating connection name from '{}' to '{}'", conn.name, info.psp_name);
+                        conn.name = info.psp_name.clone();
+                    }
+                    // If PSP sent persistent flag (send_once mode), mark connection
+                    if info.persistent {
+                        conn.persistent = true;
+                        info!("PSP {} marked as persistent (send_once mode)", conn.name);
                     }
                 }
 
-                self.event_tx
+                self.shared.event_tx
                     .send(ServerEvent::GameInfoUpdated { addr, info })
                     .await?;
             }
 
+            // Chunks are not ACKed individually; the PSP polls for a
+            // TransferStatus after each window instead
             MessageType::IconChunk => {
                 let chunk = IconChunk::decode(payload)?;
-                if let Err(e) = self.send_ack(addr).await {
-                    warn!("Failed to send ACK to {}: {}", addr, e);
-                }
-                self.handle_icon_chunk(addr, chunk).await?;
+                self.handle_icon_chunk(chunk);
             }
 
             MessageType::IconEnd => {
                 let end = IconEnd::decode(payload)?;
-                if let Err(e) = self.send_ack(addr).await {
+                if let Err(e) = self.shared.send_ack(addr, self.session).await {
                     warn!("Failed to send ACK to {}: {}", addr, e);
                 }
-                self.handle_icon_end(addr, end).await?;
+                self.handle_icon_end(end).await?;
             }
 
             MessageType::DiscoveryResponse => {
@@ -343,30 +626,16 @@ impl Server {
                     response.psp_name, response.version, response.battery_percent
                 );
 
-                if let Err(e) = self.send_ack(addr).await {
+                if let Err(e) = self.shared.send_ack(addr, self.session).await {
                     warn!("Failed to send ACK to {}: {}", addr, e);
                 }
 
-                // Add to connections if new
-                {
-                    let mut conns = self.connections.write().await;
-                    if !conns.contains_key(&addr) {
-                        conns.insert(
-                            addr,
-                            PspConnection {
-                                name: response.psp_name.clone(),
-                                last_seen: Instant::now(),
-                                current_game: None,
-                                icon_buffer: HashMap::new(),
-                                discovery_sent: true,
-                                persistent: false,
-                                stats_upload_buffer: None,
-                            },
-                        );
-                    }
+                // Add the connection if new
+                if self.conn.is_none() {
+                    self.conn = Some(PspConnection::new(response.psp_name.clone(), true));
                 }
 
-                self.event_tx
+                self.shared.event_tx
                     .send(ServerEvent::PspConnected {
                         addr,
                         name: response.psp_name,
@@ -379,19 +648,17 @@ impl Server {
                 info!("Stats request received from {}", addr);
                 
                 // Send ACK first
-                if let Err(e) = self.send_ack(addr).await {
+                if let Err(e) = self.shared.send_ack(addr, self.session).await {
                     warn!("Failed to send ACK to {}: {}", addr, e);
                 }
                 
                 // Get PSP name for the event
-                let psp_name = {
-                    let conns = self.connections.read().await;
-                    conns.get(&addr).map(|c| c.name.clone()).unwrap_or_default()
-                };
+                let psp_name = self.conn.as_ref().map(|c| c.name.clone()).unwrap_or_default();
                 
                 // Emit event to main loop to handle stats request
-                self.event_tx
-                    .send(ServerEvent::StatsRequested { addr, psp_name })
+                let request = StatsRequest::decode(payload);
+                self.shared.event_tx
+                    .send(ServerEvent::StatsRequested { addr, psp_name, request })
                     .await?;
             }
 
@@ -399,13 +666,13 @@ impl Server {
                 let upload = StatsUpload::decode(payload)?;
                 debug!("Stats upload chunk {}/{} from {}", upload.chunk_index + 1, upload.total_chunks, addr);
                 
-                // Send ACK
-                if let Err(e) = self.send_ack(addr).await {
-                    warn!("Failed to send ACK to {}: {}", addr, e);
-                }
-                
                 // Handle the chunk and check if complete
-                self.handle_stats_upload_chunk(addr, upload).await?;
+                self.handle_stats_upload_chunk(upload).await?;
+            }
+
+            MessageType::TransferPoll => {
+                let poll = TransferPoll::decode(payload)?;
+                self.handle_transfer_poll(poll).await?;
             }
 
             _ => {
@@ -416,11 +683,11 @@ impl Server {
         Ok(())
     }
 
-    /// Update last seen time for a connection
-    async fn update_last_seen(&self, addr: SocketAddr) -> bool {
-        let mut conns = self.connections.write().await;
-        let auto = self.config.network.auto_discovery;
-        if let Some(conn) = conns.get_mut(&addr) {
+    /// Update last seen time, registering the connection if it is new.
+    /// Returns true when a discovery request should be sent.
+    fn update_last_seen(&mut self) -> bool {
+        let auto = self.shared.config.network.auto_discovery;
+        if let Some(conn) = self.conn.as_mut() {
             conn.last_seen = Instant::now();
             if auto && !conn.discovery_sent {
                 conn.discovery_sent = true;
@@ -430,115 +697,45 @@ impl Server {
         }
 
         // New connection without discovery
-        conns.insert(
-            addr,
-            PspConnection {
-                name: format!("PSP-{}", addr.port()),
-                last_seen: Instant::now(),
-                current_game: None,
-                icon_buffer: HashMap::new(),
-                discovery_sent: auto,
-                persistent: false,
-                stats_upload_buffer: None,
-            },
-        );
+        self.conn = Some(PspConnection::new(format!("PSP-{}", self.addr.port()), auto));
         auto
     }
 
-    async fn send_discovery_request(&self, addr: SocketAddr) -> Result<()> {
-        if !self.config.network.auto_discovery {
-            return Ok(());
-        }
-
-        if let Some(socket) = &self.socket {
-            let request = DiscoveryRequest::new(self.config.network.listen_port);
-            let packet = request.encode();
-            let target = SocketAddr::new(addr.ip(), self.config.network.discovery_port);
-            socket.send_to(&packet, target).await?;
-            info!("Sent discovery request to {}", target);
-        }
-
-        Ok(())
-    }
-
-    async fn send_ack(&self, addr: SocketAddr) -> Result<()> {
-        if let Some(socket) = &self.socket {
-            let mut buf = Vec::with_capacity(5);
-            buf.extend_from_slice(crate::protocol::MAGIC);
-            buf.push(crate::protocol::MessageType::Ack as u8);
-            socket.send_to(&buf, addr).await?;
-        }
-        Ok(())
-    }
-
-    /// Request an icon from a connected PSP
-    pub async fn request_icon(&self, addr: SocketAddr, game_id: &str) -> Result<()> {
-        if let Some(socket) = &self.socket {
-            let request = IconRequest::new(game_id);
-            let packet = request.encode();
-            socket.send_to(&packet, addr).await?;
-            info!("Requested icon for {} from {}", game_id, addr);
-        }
-        Ok(())
-    }
-
-    /// Send stats response to PSP (chunked if necessary)
-    pub async fn send_stats_response(&self, addr: SocketAddr, json_data: &[u8], last_updated: u64) -> Result<()> {
-        if let Some(socket) = &self.socket {
-            let chunks = StatsResponse::new_chunks(json_data, last_updated);
-            info!("Sending {} stats chunks ({} bytes) to {}", chunks.len(), json_data.len(), addr);
-            
-            for chunk in chunks {
-                let packet = chunk.encode();
-                socket.send_to(&packet, addr).await?;
-                // Small delay between chunks to avoid overwhelming PSP
-                tokio::time::sleep(Duration::from_millis(10)).await;
-            }
-        }
-        Ok(())
-    }
-
     /// Handle a stats upload chunk
-    async fn handle_stats_upload_chunk(&self, addr: SocketAddr, upload: StatsUpload) -> Result<()> {
+    async fn handle_stats_upload_chunk(&mut self, upload: StatsUpload<'_>) -> Result<()> {
         let (psp_name, completed_data) = {
-            let mut conns = self.connections.write().await;
-            if let Some(conn) = conns.get_mut(&addr) {
-                // Initialize buffer on first chunk
-                if upload.chunk_index == 0 {
-                    conn.stats_upload_buffer = Some(StatsUploadBuffer {
-                        chunks: vec![None; upload.total_chunks as usize],
-                        total_chunks: upload.total_chunks,
-                        received_chunks: 0,
-                        last_updated: upload.last_updated,
+            if let Some(conn) = self.conn.as_mut() {
+                // Start a new buffer for a new upload (chunks may arrive in any order)
+                let is_new = match &conn.stats_upload_buffer {
+                    Some(buffer) => {
+                        buffer.last_updated != upload.last_updated
+                            || buffer.chunks.total_chunks() != upload.total_chunks
+                    }
+                    None => conn.last_stats_upload != Some(upload.last_updated),
+                };
+                if is_new {
+                    conn.stats_upload_buffer = ChunkBuffer::new(upload.total_chunks, STATS_BUFFER_MAX_CHUNKS).map(|chunks| {
+                        StatsUploadBuffer {
+                            chunks,
+                            last_updated: upload.last_updated,
+                        }
                     });
                 }
                 
-                // Store chunk
-                if let Some(buffer) = &mut conn.stats_upload_buffer {
-                    if (upload.chunk_index as usize) < buffer.chunks.len() {
-                        if buffer.chunks[upload.chunk_index as usize].is_none() {
-                            buffer.received_chunks += 1;
-                        }
-                        buffer.chunks[upload.chunk_index as usize] = Some(upload.json_data);
-                        
-                        // Check if complete
-                        if buffer.received_chunks >= buffer.total_chunks {
-                            // Assemble all chunks
-                            let mut data = Vec::new();
-                            for chunk in buffer.chunks.iter().flatten() {
-                                data.extend(chunk);
-                            }
+                // Store chunk, and hand the data off once complete
+                match conn.stats_upload_buffer.as_mut() {
+                    Some(buffer) => {
+                        buffer.chunks.insert(upload.chunk_index, upload.json_data);
+                        if buffer.chunks.is_complete() {
                             let last_updated = buffer.last_updated;
-                            conn.stats_upload_buffer = None;
-                            (conn.name.clone(), Some((data, last_updated)))
+                            let data = conn.stats_upload_buffer.take().map(|b| b.chunks.into_data());
+                            conn.last_stats_upload = Some(last_updated);
+                            (conn.name.clone(), data.map(|data| (data, last_updated)))
                         } else {
                             (String::new(), None)
                         }
-                    } else {
-                        (String::new(), None)
                     }
-                } else {
-                    (String::new(), None)
+                    None => (String::new(), None),
                 }
             } else {
                 (String::new(), None)
@@ -547,14 +744,13 @@ impl Server {
         
         // If we have completed data, emit event
         if let Some((data, last_updated)) = completed_data {
-            let json_data = String::from_utf8_lossy(&data).to_string();
-            info!("Received complete stats upload from {} ({} bytes)", psp_name, json_data.len());
-            self.event_tx
+            info!("Received complete stats upload from {} ({} bytes)", psp_name, data.len());
+            self.shared.event_tx
                 .send(ServerEvent::StatsUploaded { 
-                    addr, 
+                    addr: self.addr, 
                     psp_name,
                     last_updated,
-                    json_data,
+                    data,
                 })
                 .await?;
         }
@@ -563,44 +759,92 @@ impl Server {
     }
 
     /// Handle an icon chunk
-    async fn handle_icon_chunk(&self, addr: SocketAddr, chunk: IconChunk) -> Result<()> {
-        let mut conns = self.connections.write().await;
-        if let Some(conn) = conns.get_mut(&addr) {
-            let buffer = conn
-                .icon_buffer
-                .entry(chunk.game_id.clone())
-                .or_insert_with(|| IconBuffer {
-                    chunks: vec![None; chunk.total_chunks as usize],
-                    total_chunks: chunk.total_chunks,
-                    received_chunks: 0,
-                });
-
-            if (chunk.chunk_index as usize) < buffer.chunks.len() {
-                if buffer.chunks[chunk.chunk_index as usize].is_none() {
-                    buffer.received_chunks += 1;
+    fn handle_icon_chunk(&mut self, chunk: IconChunk<'_>) {
+        if let Some(conn) = self.conn.as_mut() {
+            // First chunk, or a different icon than the one in progress
+            let fresh = match &conn.icon_buffer {
+                Some(buffer) => {
+                    buffer.game_id != chunk.game_id || buffer.chunks.total_chunks() != chunk.total_chunks
                 }
-                buffer.chunks[chunk.chunk_index as usize] = Some(chunk.data);
+                None => true,
+            };
+            if fresh {
+                conn.icon_buffer = match ChunkBuffer::new(chunk.total_chunks, TRANSFER_MAX_CHUNKS) {
+                    Some(chunks) => Some(IconBuffer {
+                        game_id: chunk.game_id.to_string(),
+                        chunks,
+                    }),
+                    None => {
+                        debug!("Icon transfer of {} chunks is too large", chunk.total_chunks);
+                        None
+                    }
+                };
+            }
+
+            if let Some(buffer) = conn.icon_buffer.as_mut() {
+                buffer.chunks.insert(chunk.chunk_index, chunk.data);
             }
         }
+    }
+
+    /// Answer a transfer poll with the chunks still missing
+    async fn handle_transfer_poll(&self, poll: TransferPoll<'_>) -> Result<()> {
+        let total = (poll.total_chunks as usize).min(TRANSFER_MAX_CHUNKS);
+        let conn = self.conn.as_ref();
+        let received: &[bool] = match poll.kind {
+            TRANSFER_KIND_ICON => conn
+                .and_then(|c| c.icon_buffer.as_ref())
+                .filter(|b| b.game_id == poll.id && b.chunks.total_chunks() == poll.total_chunks)
+                .map(|b| b.chunks.received.as_slice())
+                .unwrap_or(&NONE_RECEIVED[..total]),
+            TRANSFER_KIND_STATS => match conn {
+                // Already assembled and handed off
+                Some(c) if c.last_stats_upload == Some(poll.tag) && c.stats_upload_buffer.is_none() => {
+                    &ALL_RECEIVED[..total]
+                }
+                Some(c) => c
+                    .stats_upload_buffer
+                    .as_ref()
+                    .filter(|b| b.last_updated == poll.tag && b.chunks.total_chunks() == poll.total_chunks)
+                    .map(|b| b.chunks.received.as_slice())
+                    .unwrap_or(&NONE_RECEIVED[..total]),
+                None => &NONE_RECEIVED[..total],
+            },
+            _ => {
+                debug!("Unknown transfer kind {} from {}", poll.kind, self.addr);
+                return Ok(());
+            }
+        };
+
+        let status = TransferStatus {
+            kind: poll.kind,
+            id: &poll.id,
+            total_chunks: poll.total_chunks,
+            received,
+        };
+        self.shared.socket.send_to(&status.encode(), self.addr).await?;
         Ok(())
     }
 
     /// Handle icon end marker
-    async fn handle_icon_end(&self, addr: SocketAddr, end: IconEnd) -> Result<()> {
+    async fn handle_icon_end(&mut self, end: IconEnd<'_>) -> Result<()> {
         let icon_data = {
-            let mut conns = self.connections.write().await;
-            if let Some(conn) = conns.get_mut(&addr) {
-                if let Some(buffer) = conn.icon_buffer.remove(&end.game_id) {
-                    if buffer.received_chunks != buffer.total_chunks {
+            if let Some(conn) = self.conn.as_mut() {
+                let matching = conn.icon_buffer.as_ref().filter(|b| b.game_id == end.game_id);
+                let complete = matching.map(|b| b.chunks.is_complete()).unwrap_or(true);
+                if !complete {
+                    // Keep what we have so a later poll/retransmit can finish it
+                    if let Some(buffer) = matching {
                         warn!(
                             "Icon chunks missing for {}: {}/{}",
-                            end.game_id, buffer.received_chunks, buffer.total_chunks
+                            end.game_id, buffer.chunks.received_chunks, buffer.chunks.total_chunks()
                         );
                     }
-                    // Assemble chunks
-                    let mut data = Vec::with_capacity(end.total_size as usize);
-                    for chunk in buffer.chunks.into_iter().flatten() {
-                        data.extend(chunk);
+                    None
+                } else if matching.is_some() {
+                    let data = conn.icon_buffer.take().map(|b| b.chunks.into_data()).unwrap_or_default();
+                    if data.len() != end.total_size as usize {
+                        debug!("Icon for {} is {} bytes, expected {}", end.game_id, data.len(), end.total_size);
                     }
 
                     // Verify CRC
@@ -624,9 +868,9 @@ impl Server {
 
         if let Some(data) = icon_data {
             info!("Received complete icon for {} ({} bytes)", end.game_id, data.len());
-            self.event_tx
+            self.shared.event_tx
                 .send(ServerEvent::IconReceived {
-                    game_id: end.game_id,
+                    game_id: end.game_id.into_owned(),
                     data,
                 })
                 .await?;
@@ -634,32 +878,4 @@ impl Server {
 
         Ok(())
     }
-
-    /// Send discovery broadcast
-    #[allow(dead_code)]
-    pub async fn send_discovery_broadcast(&self) -> Result<()> {
-        if let Some(socket) = &self.socket {
-            let request = DiscoveryRequest::new(self.config.network.listen_port);
-            let packet = request.encode();
-
-            let mut targets = Vec::new();
-            let broadcast_addr: SocketAddr = format!("255.255.255.255:{}", self.config.network.discovery_port)
-                .parse()?;
-            targets.push(broadcast_addr);
-
-            if let Some(ip) = self.local_ipv4 {
-                let guess = Self::guess_broadcast(ip);
-                let guess_addr: SocketAddr = format!("{}:{}", guess, self.config.network.discovery_port).parse()?;
-                if guess_addr != broadcast_addr {
-                    targets.push(guess_addr);
-                }
-            }
-
-            for target in targets {
-                socket.send_to(&packet, target).await?;
-                debug!("Sent discovery broadcast to {}", target);
-            }
-        }
-        Ok(())
-    }
 }
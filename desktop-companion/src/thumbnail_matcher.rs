@@ -3,12 +3,25 @@
 //! This module fetches the list of available PSP thumbnails from the libretro
 //! thumbnails repository and uses fuzzy matching to find the best match for
 //! a given game title. It supports multiple thumbnail sources with fallback.
+//!
+//! Names are normalized once when an index is loaded, and a trigram index
+//! narrows each lookup to a few dozen candidates before Jaro-Winkler scoring.
+//!
+//! The parsed indexes are kept in thumbnail_cache.json beside the config, so
+//! startup works offline, and match results in thumbnail_cache.matches.json.
+//! Refreshing sends the cached ETag/Last-Modified and only re-parses a
+//! listing that actually changed. Both files are written by one background
+//! task, at most once per SAVE_DEBOUNCE, and only when their part changed.
 
 use anyhow::Result;
+use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::Arc;
+use std::time::Duration;
 use strsim::jaro_winkler;
-use tokio::sync::RwLock;
+use tokio::sync::{Mutex, Notify, RwLock};
 use tracing::{debug, info, warn};
 
 /// Thumbnail source configuration
@@ -38,64 +51,332 @@ const THUMBNAIL_SOURCES: &[ThumbnailSource] = &[
 /// Minimum similarity threshold for a match (0.0 to 1.0)
 const MIN_SIMILARITY_THRESHOLD: f64 = 0.6;
 
+/// Candidates (most shared trigrams first) scored per lookup
+const MAX_CANDIDATES: usize = 64;
+
 /// Cache for matched thumbnails (game_id -> thumbnail URL)
 type ThumbnailCache = HashMap<String, Option<String>>;
 
-/// A loaded thumbnail index with its source info
-struct LoadedIndex {
-    /// Thumbnail filenames (without .png extension)
+/// Bumped when the cache file layout changes
+const CACHE_FILE_VERSION: u32 = 1;
+
+/// Bumped when the matches file layout or the meaning of its matches changes
+const MATCHES_FILE_VERSION: u32 = 1;
+
+/// How long the writer waits after a change before saving, so a burst of
+/// lookups costs one write
+const SAVE_DEBOUNCE: Duration = Duration::from_secs(2);
+
+/// On-disk index cache (thumbnail_cache.json)
+#[derive(Debug, Default, Serialize, Deserialize)]
+struct CacheFile {
+    version: u32,
+    sources: Vec<CachedSource>,
+}
+
+/// On-disk match results (thumbnail_cache.matches.json)
+#[derive(Debug, Default, Serialize, Deserialize)]
+struct MatchesFile {
+    version: u32,
+    /// listing_key() of the indexes the matches were made against
+    listing: String,
+    matches: ThumbnailCache,
+}
+
+/// One source's listing as last fetched
+#[derive(Debug, Serialize, Deserialize)]
+struct CachedSource {
+    name: String,
+    etag: Option<String>,
+    last_modified: Option<String>,
     thumbnails: Vec<String>,
+}
+
+/// One thumbnail with its precomputed match key
+struct IndexEntry {
+    /// Thumbnail filename (without .png extension)
+    name: String,
+    /// normalize_title(extract_game_name(name))
+    normalized: String,
+}
+
+/// A loaded thumbnail index with its source info
+pub(crate) struct LoadedIndex {
+    /// Thumbnails in listing order
+    entries: Vec<IndexEntry>,
+    /// Trigram -> indexes of the entries containing it
+    trigrams: HashMap<u32, Vec<u32>>,
     /// Base URL for constructing raw image URLs
     raw_base_url: &'static str,
-    /// Source name for logging
-    #[allow(dead_code)]
+    /// Source name (also the key in the cache file)
     source_name: &'static str,
+    /// Validators from the response the listing came from
+    etag: Option<String>,
+    last_modified: Option<String>,
+}
+
+impl LoadedIndex {
+    /// Normalize every thumbnail name and build the trigram index
+    pub(crate) fn new(thumbnails: Vec<String>, raw_base_url: &'static str, source_name: &'static str) -> Self {
+        let mut trigrams: HashMap<u32, Vec<u32>> = HashMap::new();
+        let mut entries = Vec::with_capacity(thumbnails.len());
+        let mut keys = Vec::new();
+
+        for (i, name) in thumbnails.into_iter().enumerate() {
+            let normalized = normalize_title(&extract_game_name(&name));
+
+            keys.clear();
+            keys.extend(trigram_keys(&normalized));
+            keys.sort_unstable();
+            keys.dedup();
+            for &key in &keys {
+                trigrams.entry(key).or_default().push(i as u32);
+            }
+
+            entries.push(IndexEntry { name, normalized });
+        }
+
+        Self {
+            entries,
+            trigrams,
+            raw_base_url,
+            source_name,
+            etag: None,
+            last_modified: None,
+        }
+    }
+
+    /// Entries sharing the most trigrams with a normalized title
+    fn candidates(&self, normalized_title: &str) -> Vec<u32> {
+        let mut keys: Vec<u32> = trigram_keys(normalized_title).collect();
+        keys.sort_unstable();
+        keys.dedup();
+
+        let mut shared: HashMap<u32, u16> = HashMap::new();
+        for key in keys {
+            if let Some(postings) = self.trigrams.get(&key) {
+                for &entry in postings {
+                    *shared.entry(entry).or_insert(0) += 1;
+                }
+            }
+        }
+
+        let mut ranked: Vec<(u16, u32)> = shared.into_iter().map(|(entry, n)| (n, entry)).collect();
+        // Most shared first; listing order breaks ties so results are stable
+        ranked.sort_unstable_by(|a, b| b.0.cmp(&a.0).then(a.1.cmp(&b.1)));
+        ranked.truncate(MAX_CANDIDATES);
+        ranked.into_iter().map(|(_, entry)| entry).collect()
+    }
+}
+
+/// Persists indexes and matches for a matcher. Changes mark a part dirty
+/// and wake one writer task, which waits SAVE_DEBOUNCE and then writes the
+/// dirty parts, so saves never run concurrently or once per lookup.
+struct CacheWriter {
+    indexes: Arc<RwLock<Vec<Arc<LoadedIndex>>>>,
+    cache: Arc<RwLock<ThumbnailCache>>,
+    /// Where the indexes are persisted
+    cache_path: PathBuf,
+    /// Where the match results are persisted
+    matches_path: PathBuf,
+    index_dirty: AtomicBool,
+    matches_dirty: AtomicBool,
+    /// Set once the writer task has been spawned
+    started: AtomicBool,
+    wake: Notify,
+    /// Held while writing, so flush() and the task never overlap
+    write_lock: Mutex<()>,
+}
+
+impl CacheWriter {
+    /// Mark parts dirty and make sure the writer task will save them
+    fn schedule(self: &Arc<Self>, index: bool, matches: bool) {
+        if index {
+            self.index_dirty.store(true, Ordering::Release);
+        }
+        if matches {
+            self.matches_dirty.store(true, Ordering::Release);
+        }
+
+        if !self.started.swap(true, Ordering::AcqRel) {
+            let writer = self.clone();
+            tokio::spawn(async move {
+                loop {
+                    writer.wake.notified().await;
+                    tokio::time::sleep(SAVE_DEBOUNCE).await;
+                    writer.write_dirty().await;
+                }
+            });
+        }
+        // Stores a permit if the task is busy, so no change is missed
+        self.wake.notify_one();
+    }
+
+    /// Write whichever parts are dirty
+    async fn write_dirty(&self) {
+        let _guard = self.write_lock.lock().await;
+
+        if self.index_dirty.swap(false, Ordering::AcqRel) {
+            let file = {
+                let indexes = self.indexes.read().await;
+                CacheFile {
+                    version: CACHE_FILE_VERSION,
+                    sources: indexes
+                        .iter()
+                        .map(|index| CachedSource {
+                            name: index.source_name.to_string(),
+                            etag: index.etag.clone(),
+                            last_modified: index.last_modified.clone(),
+                            thumbnails: index.entries.iter().map(|e| e.name.clone()).collect(),
+                        })
+                        .collect(),
+                }
+            };
+            write_in_background(self.cache_path.clone(), file, "thumbnail cache").await;
+        }
+
+        if self.matches_dirty.swap(false, Ordering::AcqRel) {
+            let file = MatchesFile {
+                version: MATCHES_FILE_VERSION,
+                listing: listing_key(&self.indexes.read().await),
+                matches: self.cache.read().await.clone(),
+            };
+            write_in_background(self.matches_path.clone(), file, "thumbnail matches").await;
+        }
+    }
 }
 
 /// Thumbnail matcher that caches results
 pub struct ThumbnailMatcher {
     /// Loaded thumbnail indexes (priority order: boxarts, snaps)
-    indexes: Arc<RwLock<Vec<LoadedIndex>>>,
+    indexes: Arc<RwLock<Vec<Arc<LoadedIndex>>>>,
     /// Cache of game_id -> matched thumbnail URL
     cache: Arc<RwLock<ThumbnailCache>>,
     /// Whether the indexes have been loaded
     loaded: Arc<RwLock<bool>>,
+    /// Saves indexes and matches in the background
+    writer: Arc<CacheWriter>,
 }
 
 impl ThumbnailMatcher {
     pub fn new() -> Self {
+        Self::with_cache_path(Self::default_cache_path())
+    }
+
+    /// Create a matcher persisting to a specific cache file (matches go
+    /// beside it, with a .matches.json extension)
+    pub fn with_cache_path(cache_path: PathBuf) -> Self {
+        let indexes = Arc::new(RwLock::new(Vec::new()));
+        let cache = Arc::new(RwLock::new(HashMap::new()));
+        let writer = Arc::new(CacheWriter {
+            indexes: indexes.clone(),
+            cache: cache.clone(),
+            matches_path: cache_path.with_extension("matches.json"),
+            cache_path,
+            index_dirty: AtomicBool::new(false),
+            matches_dirty: AtomicBool::new(false),
+            started: AtomicBool::new(false),
+            wake: Notify::new(),
+            write_lock: Mutex::new(()),
+        });
         Self {
-            indexes: Arc::new(RwLock::new(Vec::new())),
-            cache: Arc::new(RwLock::new(HashMap::new())),
+            indexes,
+            cache,
             loaded: Arc::new(RwLock::new(false)),
+            writer,
         }
     }
 
-    /// Load all thumbnail indexes from libretro
+    /// Get the default cache path (beside the config file)
+    pub fn default_cache_path() -> PathBuf {
+        crate::config::Config::config_path().with_file_name("thumbnail_cache.json")
+    }
+
+    /// Load indexes and match results saved by an earlier run
+    /// Returns the number of thumbnails loaded (0 if there is no usable cache)
+    pub async fn load_cache(&self) -> usize {
+        let path = self.writer.cache_path.clone();
+        let matches_path = self.writer.matches_path.clone();
+        let (file, matches) = match tokio::task::spawn_blocking(move || {
+            (read_cache_file(&path), read_matches_file(&matches_path))
+        })
+        .await
+        {
+            Ok((Some(file), matches)) => (file, matches),
+            _ => return 0,
+        };
+
+        let mut loaded_indexes = Vec::new();
+        let mut total_count = 0;
+        // Keep source priority order, whatever order the file has
+        for source in THUMBNAIL_SOURCES {
+            if let Some(cached) = file.sources.iter().find(|c| c.name == source.name) {
+                total_count += cached.thumbnails.len();
+
+                let mut index = LoadedIndex::new(cached.thumbnails.clone(), source.raw_base_url, source.name);
+                index.etag = cached.etag.clone();
+                index.last_modified = cached.last_modified.clone();
+                loaded_indexes.push(Arc::new(index));
+            }
+        }
+
+        if loaded_indexes.is_empty() {
+            return 0;
+        }
+
+        // Matches made against other listings would be stale
+        if let Some(matches) = matches.filter(|m| m.listing == listing_key(&loaded_indexes)) {
+            *self.cache.write().await = matches.matches;
+        }
+        *self.indexes.write().await = loaded_indexes;
+        *self.loaded.write().await = true;
+
+        info!("Loaded {} cached thumbnails", total_count);
+        total_count
+    }
+
+    /// Load (or refresh) all thumbnail indexes from libretro
+    ///
+    /// Listings that have not changed since they were cached answer 304 and
+    /// are kept as they are. A source that fails to fetch keeps its cached
+    /// listing, if any.
     pub async fn load_index(&self) -> Result<usize> {
         info!("Fetching libretro thumbnail indexes...");
 
+        let client = reqwest::Client::new();
+        let current: Vec<Arc<LoadedIndex>> = self.indexes.read().await.clone();
         let mut loaded_indexes = Vec::new();
         let mut total_count = 0;
+        let mut changed = false;
 
         for source in THUMBNAIL_SOURCES {
-            match Self::fetch_index(source).await {
-                Ok(thumbnails) => {
-                    let count = thumbnails.len();
-                    info!("Loaded {} {} thumbnails", count, source.name);
-                    total_count += count;
-                    
-                    loaded_indexes.push(LoadedIndex {
-                        thumbnails,
-                        raw_base_url: source.raw_base_url,
-                        source_name: source.name,
-                    });
+            let previous = current.iter().find(|i| i.source_name == source.name);
+
+            let index = match Self::fetch_index(&client, source, previous.map(|p| p.as_ref())).await {
+                Ok(Some(index)) => {
+                    info!("Loaded {} {} thumbnails", index.entries.len(), source.name);
+                    changed = true;
+                    Arc::new(index)
+                }
+                Ok(None) => {
+                    debug!("{} index not modified", source.name);
+                    match previous {
+                        Some(previous) => previous.clone(),
+                        None => continue,
+                    }
                 }
                 Err(e) => {
                     warn!("Failed to load {} index: {}", source.name, e);
                     // Continue with other sources
+                    match previous {
+                        Some(previous) => previous.clone(),
+                        None => continue,
+                    }
                 }
-            }
+            };
+
+            total_count += index.entries.len();
+            loaded_indexes.push(index);
         }
 
         if loaded_indexes.is_empty() {
@@ -105,6 +386,12 @@ impl ThumbnailMatcher {
         *self.indexes.write().await = loaded_indexes;
         *self.loaded.write().await = true;
 
+        if changed {
+            // Earlier matches (and misses) were against the old listings
+            self.cache.write().await.clear();
+            self.writer.schedule(true, true);
+        }
+
         info!("Total: {} thumbnails loaded from {} sources", 
             total_count, 
             THUMBNAIL_SOURCES.len()
@@ -114,8 +401,37 @@ impl ThumbnailMatcher {
     }
 
     /// Fetch a single thumbnail index
-    async fn fetch_index(source: &ThumbnailSource) -> Result<Vec<String>> {
-        let response = reqwest::get(source.index_url).await?;
+    /// Returns Ok(None) when the server says `previous` is still current
+    async fn fetch_index(
+        client: &reqwest::Client,
+        source: &ThumbnailSource,
+        previous: Option<&LoadedIndex>,
+    ) -> Result<Option<LoadedIndex>> {
+        let mut request = client.get(source.index_url);
+        if let Some(previous) = previous {
+            if let Some(etag) = &previous.etag {
+                request = request.header(reqwest::header::IF_NONE_MATCH, etag.as_str());
+            }
+            if let Some(last_modified) = &previous.last_modified {
+                request = request.header(reqwest::header::IF_MODIFIED_SINCE, last_modified.as_str());
+            }
+        }
+
+        let response = request.send().await?;
+        if response.status() == reqwest::StatusCode::NOT_MODIFIED {
+            return Ok(None);
+        }
+        let response = response.error_for_status()?;
+
+        let header = |name| {
+            response
+                .headers()
+                .get(name)
+                .and_then(|v: &reqwest::header::HeaderValue| v.to_str().ok())
+                .map(String::from)
+        };
+        let etag = header(reqwest::header::ETAG);
+        let last_modified = header(reqwest::header::LAST_MODIFIED);
         let html = response.text().await?;
 
         // Parse the HTML to extract .png filenames
@@ -138,7 +454,15 @@ impl ThumbnailMatcher {
             }
         }
 
-        Ok(thumbnails)
+        let mut index = LoadedIndex::new(thumbnails, source.raw_base_url, source.name);
+        index.etag = etag;
+        index.last_modified = last_modified;
+        Ok(Some(index))
+    }
+
+    /// Write any pending index or match changes now (e.g. before exiting)
+    pub async fn flush_cache(&self) {
+        self.writer.write_dirty().await;
     }
 
     /// Check if the indexes are loaded
@@ -182,29 +506,29 @@ impl ThumbnailMatcher {
             }
         }
 
+        drop(indexes);
+
         // Cache the result (even if None, to avoid repeated lookups)
         {
             let mut cache = self.cache.write().await;
             cache.insert(game_id.to_string(), result.clone());
         }
+        self.writer.schedule(false, true);
 
         result
     }
 
     /// Find the best match in a single index
-    fn find_best_match(normalized_title: &str, original_title: &str, index: &LoadedIndex) -> Option<String> {
+    pub(crate) fn find_best_match(normalized_title: &str, original_title: &str, index: &LoadedIndex) -> Option<String> {
         let mut best_match: Option<(f64, &str)> = None;
         
-        for thumbnail_name in index.thumbnails.iter() {
-            // Extract just the game name part (before region info in parentheses)
-            let thumbnail_title = extract_game_name(thumbnail_name);
-            let normalized_thumbnail = normalize_title(&thumbnail_title);
-            
-            let similarity = jaro_winkler(normalized_title, &normalized_thumbnail);
+        for entry_idx in index.candidates(normalized_title) {
+            let entry = &index.entries[entry_idx as usize];
+            let similarity = jaro_winkler(normalized_title, &entry.normalized);
             
             if similarity >= MIN_SIMILARITY_THRESHOLD {
                 if best_match.is_none() || similarity > best_match.unwrap().0 {
-                    best_match = Some((similarity, thumbnail_name));
+                    best_match = Some((similarity, &entry.name));
                 }
             }
         }
@@ -236,8 +560,72 @@ impl Default for ThumbnailMatcher {
     }
 }
 
+/// Read the cache file, None if it is missing, unreadable or from another
+/// version
+fn read_cache_file(path: &Path) -> Option<CacheFile> {
+    let bytes = std::fs::read(path).ok()?;
+    match serde_json::from_slice::<CacheFile>(&bytes) {
+        Ok(file) if file.version == CACHE_FILE_VERSION => Some(file),
+        Ok(_) => None,
+        Err(e) => {
+            warn!("Ignoring unreadable thumbnail cache: {}", e);
+            None
+        }
+    }
+}
+
+/// Read the matches file, None if it is missing, unreadable or from another
+/// version
+fn read_matches_file(path: &Path) -> Option<MatchesFile> {
+    let bytes = std::fs::read(path).ok()?;
+    match serde_json::from_slice::<MatchesFile>(&bytes) {
+        Ok(file) if file.version == MATCHES_FILE_VERSION => Some(file),
+        Ok(_) => None,
+        Err(e) => {
+            warn!("Ignoring unreadable thumbnail matches: {}", e);
+            None
+        }
+    }
+}
+
+/// Write a JSON file via a temp file, so a crash never leaves half of one
+fn write_json_file<T: Serialize>(path: &Path, value: &T) -> Result<()> {
+    let tmp = path.with_extension("json.tmp");
+    std::fs::write(&tmp, serde_json::to_vec(value)?)?;
+    std::fs::rename(&tmp, path)?;
+    Ok(())
+}
+
+/// Write a JSON file on the blocking pool and wait for it
+async fn write_in_background<T: Serialize + Send + 'static>(path: PathBuf, value: T, what: &'static str) {
+    let result = tokio::task::spawn_blocking(move || write_json_file(&path, &value)).await;
+    match result {
+        Ok(Err(e)) => warn!("Failed to save {}: {}", what, e),
+        Err(e) => warn!("Failed to save {}: {}", what, e),
+        Ok(Ok(())) => {}
+    }
+}
+
+/// Identifies a set of listings: matches are only valid against the
+/// listings they were made with
+fn listing_key(indexes: &[Arc<LoadedIndex>]) -> String {
+    indexes
+        .iter()
+        .map(|index| {
+            format!(
+                "{}:{}:{}:{}",
+                index.source_name,
+                index.etag.as_deref().unwrap_or(""),
+                index.last_modified.as_deref().unwrap_or(""),
+                index.entries.len()
+            )
+        })
+        .collect::<Vec<_>>()
+        .join("|")
+}
+
 /// Normalize a game title for comparison
-fn normalize_title(title: &str) -> String {
+pub(crate) fn normalize_title(title: &str) -> String {
     title
         .to_lowercase()
         // Remove common punctuation
@@ -248,6 +636,22 @@ fn normalize_title(title: &str) -> String {
         .join(" ")
 }
 
+/// Trigram keys of a normalized title, padded so short titles and word
+/// starts get trigrams too
+fn trigram_keys(normalized: &str) -> impl Iterator<Item = u32> + '_ {
+    let bytes = normalized.as_bytes();
+    let padded_len = bytes.len() + 3;
+    // Two leading spaces and one trailing, without building a new string
+    let at = move |i: usize| -> u32 {
+        match i {
+            0 | 1 => b' ' as u32,
+            i if i - 2 < bytes.len() => bytes[i - 2] as u32,
+            _ => b' ' as u32,
+        }
+    };
+    (0..padded_len.saturating_sub(2)).map(move |i| (at(i) << 16) | (at(i + 1) << 8) | at(i + 2))
+}
+
 /// Extract the game name from a thumbnail filename (before region info)
 /// E.g., "God of War - Chains of Olympus (USA)" -> "God of War - Chains of Olympus"
 fn extract_game_name(filename: &str) -> String {
@@ -329,6 +733,26 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_indexed_match() {
+        let index = LoadedIndex::new(
+            vec![
+                "Ape Escape - On the Loose (USA)".to_string(),
+                "God of War - Chains of Olympus (USA)".to_string(),
+                "God of War - Ghost of Sparta (Europe)".to_string(),
+                "Monster Hunter Freedom Unite (USA)".to_string(),
+            ],
+            "https://example.com/",
+            "Boxarts",
+        );
+        let title = "God of War: Ghost of Sparta";
+        assert_eq!(
+            ThumbnailMatcher::find_best_match(&normalize_title(title), title, &index).as_deref(),
+            Some("https://example.com/God%20of%20War%20-%20Ghost%20of%20Sparta%20%28Europe%29.png")
+        );
+        assert_eq!(ThumbnailMatcher::find_best_match("zzzz", "zzzz", &index), None);
+    }
+
     #[test]
     fn test_urlencoding() {
         assert_eq!(urlencoding_decode("God%20of%20War"), "God of War");
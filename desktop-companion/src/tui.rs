@@ -3,8 +3,10 @@
 //! Provides a real-time terminal interface for monitoring PSP status,
 //! Discord connection, and displaying game icons as ASCII art.
 
+use std::collections::BTreeMap;
 use std::io::{self, Stdout};
 use std::net::SocketAddr;
+use std::sync::Arc;
 use std::time::{Duration, Instant};
 
 use crossterm::{
@@ -22,7 +24,7 @@ use ratatui::{
 };
 use chrono::Datelike;
 
-use crate::protocol::{GameInfo, PspState};
+use crate::protocol::{GameInfo, HeartbeatMetrics, PspState};
 
 /// Maximum number of log messages to keep
 const MAX_LOG_MESSAGES: usize = 50;
@@ -59,6 +61,16 @@ pub struct GameStats {
     pub last_played: String,
 }
 
+/// Latest heartbeat metrics of one PSP
+#[derive(Debug, Clone)]
+pub struct PspMetrics {
+    /// PSP name at the time of the heartbeat
+    pub name: String,
+    /// "WiFi" or "USB"
+    pub transport: &'static str,
+    pub metrics: HeartbeatMetrics,
+}
+
 /// State shared between the server and TUI
 #[derive(Debug, Clone, Default)]
 pub struct TuiState {
@@ -86,16 +98,19 @@ pub struct TuiState {
     pub top_played: Vec<(String, String)>,
     /// Current view mode
     pub view_mode: ViewMode,
-    /// All game stats for the stats view
-    pub all_game_stats: Vec<GameStats>,
+    /// All game stats for the stats view (shared, so cloning the state for
+    /// each frame doesn't copy them)
+    pub all_game_stats: Arc<Vec<GameStats>>,
     /// Scroll offset for stats view
     pub stats_scroll: usize,
     /// All dates when games were played, mapping date (YYYY-MM-DD) to game titles
-    pub play_dates: std::collections::HashMap<String, Vec<String>>,
+    pub play_dates: Arc<std::collections::HashMap<String, Vec<String>>>,
     /// Currently selected date in calendar (YYYY-MM-DD format), None means show all-time stats
     pub selected_date: Option<String>,
     /// Game stats for the selected date (title, seconds_on_that_day), sorted by playtime
     pub daily_game_stats: Vec<(String, u64)>,
+    /// Latest heartbeat metrics per PSP, keyed by address ("usb" for the USB link)
+    pub psp_metrics: BTreeMap<String, PspMetrics>,
 }
 
 /// A log entry with timestamp and content
@@ -159,6 +174,12 @@ impl TuiState {
         self.log(LogLevel::Success, message);
     }
 
+    /// Store the metrics from a PSP's heartbeat
+    pub fn update_metrics(&mut self, key: String, name: String, transport: &'static str,
+                          metrics: HeartbeatMetrics) {
+        self.psp_metrics.insert(key, PspMetrics { name, transport, metrics });
+    }
+
     /// Get formatted session duration
     pub fn get_session_duration(&self) -> String {
         if let Some(start) = self.session_start {
@@ -443,22 +464,34 @@ fn render_main_view(frame: &mut Frame, state: &TuiState) {
     frame.render_widget(outer_block.clone(), area);
     let inner_area = outer_block.inner(area);
 
+    // Metrics panel: borders, column header and one row per PSP (hidden until
+    // a PSP reports metrics)
+    let metrics_height = if state.psp_metrics.is_empty() {
+        0
+    } else {
+        state.psp_metrics.len() as u16 + 3
+    };
+
     // Main vertical layout
     let main_chunks = Layout::default()
         .direction(Direction::Vertical)
         .constraints([
-            Constraint::Length(2),   // Header
-            Constraint::Length(15),  // Content (fixed)
-            Constraint::Min(8),      // Logs (grows with window)
-            Constraint::Length(1),   // Footer
+            Constraint::Length(2),               // Header
+            Constraint::Length(15),              // Content (fixed)
+            Constraint::Length(metrics_height),  // Metrics
+            Constraint::Min(8),                  // Logs (grows with window)
+            Constraint::Length(1),               // Footer
         ])
         .split(inner_area);
 
     // Render sections
     render_header(frame, main_chunks[0], state);
     render_content(frame, main_chunks[1], state);
-    render_logs(frame, main_chunks[2], state);
-    render_footer(frame, main_chunks[3], state);
+    if metrics_height > 0 {
+        render_metrics(frame, main_chunks[2], state);
+    }
+    render_logs(frame, main_chunks[3], state);
+    render_footer(frame, main_chunks[4], state);
 }
 
 /// Render the header bar
@@ -836,6 +869,94 @@ fn render_logs(frame: &mut Frame, area: Rect, state: &TuiState) {
     frame.render_widget(list, inner);
 }
 
+/// Render the per-PSP metrics from the latest heartbeats
+fn render_metrics(frame: &mut Frame, area: Rect, state: &TuiState) {
+    let block = Block::default()
+        .title(Span::styled(" PSP Metrics ", Style::default().fg(Color::Cyan).bold()))
+        .title_alignment(Alignment::Left)
+        .borders(Borders::ALL)
+        .border_style(Style::default().fg(Color::Rgb(50, 50, 70)))
+        .padding(Padding::horizontal(1));
+
+    let inner = block.inner(area);
+    frame.render_widget(block, area);
+
+    let header = format!(
+        "{:<16} {:<4} {:<10} {:>13} {:<8} {:>12} {:>12} {:>4} {:>4} {:>6} {:>10} {:>7} {:>6}",
+        "PSP", "Link", "Game", "Detect ms", "Detect", "Tx pkt/B", "Rx pkt/B", "Fail", "Retx",
+        "Wake/m", "Icon pkt/B", "Sync", "Heap",
+    );
+    let mut lines = vec![Line::from(Span::styled(header, Style::default().fg(Color::DarkGray)))];
+
+    for entry in state.psp_metrics.values() {
+        let m = &entry.metrics;
+        let name: String = entry.name.chars().take(16).collect();
+        let detect = format!(
+            "{:.1}/{:.1}",
+            m.detect_avg_us as f64 / 1000.0,
+            m.detect_max_us as f64 / 1000.0,
+        );
+        let sync = if m.sync_rtt_ms > 0 { format!("{}ms", m.sync_rtt_ms) } else { "-".to_string() };
+        let problem = m.send_failures > 0 || m.retransmits > 0;
+
+        lines.push(Line::from(vec![
+            Span::styled(format!("{:<16} ", name), Style::default().fg(Color::White).bold()),
+            Span::styled(format!("{:<4} ", entry.transport), Style::default().fg(Color::DarkGray)),
+            Span::styled(format!("{:<10} ", m.game_id), Style::default().fg(Color::Cyan)),
+            Span::styled(format!("{:>13} ", detect), Style::default().fg(Color::Green)),
+            Span::styled(format!("{:<8} ", detect_sparkline(&m.detect_hist)), Style::default().fg(Color::Green)),
+            Span::styled(
+                format!("{:>12} ", format!("{}/{}", m.tx_packets, format_bytes(m.tx_bytes))),
+                Style::default().fg(Color::Gray),
+            ),
+            Span::styled(
+                format!("{:>12} ", format!("{}/{}", m.rx_packets, format_bytes(m.rx_bytes))),
+                Style::default().fg(Color::Gray),
+            ),
+            Span::styled(
+                format!("{:>4} {:>4} ", m.send_failures, m.retransmits),
+                Style::default().fg(if problem { Color::Red } else { Color::DarkGray }),
+            ),
+            Span::styled(format!("{:>6} ", m.wakeups_per_minute()), Style::default().fg(Color::Yellow)),
+            Span::styled(
+                format!("{:>10} ", format!("{}/{}", m.icon_packets, format_bytes(m.icon_bytes))),
+                Style::default().fg(Color::Gray),
+            ),
+            Span::styled(format!("{:>7} ", sync), Style::default().fg(Color::Magenta)),
+            Span::styled(format!("{:>6}", format_bytes(m.heap_free)), Style::default().fg(Color::Gray)),
+        ]));
+    }
+
+    frame.render_widget(Paragraph::new(lines), inner);
+}
+
+/// Detection time histogram as one bar character per bucket
+fn detect_sparkline(hist: &[u16]) -> String {
+    const LEVELS: [char; 8] = ['▁', '▂', '▃', '▄', '▅', '▆', '▇', '█'];
+    let max = hist.iter().copied().max().unwrap_or(0) as usize;
+
+    hist.iter()
+        .map(|&n| {
+            if n == 0 || max == 0 {
+                ' '
+            } else {
+                LEVELS[(n as usize * (LEVELS.len() - 1) + max - 1) / max]
+            }
+        })
+        .collect()
+}
+
+/// Format a byte count compactly (e.g., "512B", "3.4K", "12.1M")
+fn format_bytes(bytes: u32) -> String {
+    if bytes < 1024 {
+        format!("{}B", bytes)
+    } else if bytes < 1024 * 1024 {
+        format!("{:.1}K", bytes as f64 / 1024.0)
+    } else {
+        format!("{:.1}M", bytes as f64 / (1024.0 * 1024.0))
+    }
+}
+
 /// Render footer
 fn render_footer(frame: &mut Frame, area: Rect, state: &TuiState) {
     let footer_content = Line::from(vec![
@@ -2,19 +2,28 @@
 //!
 //! Tracks and logs game/app usage sessions to a JSON file.
 //! Sessions accumulate playtime and are updated on each game update.
+//!
+//! The in-memory UsageData is authoritative. Changes are written back on a
+//! debounce (see `flush_if_due`) via a temp file and rename, and the file is
+//! only re-read when its mtime shows someone else changed it.
+//!
+//! The per-title views the TUI shows (totals, ranking, date index) are kept
+//! in UsageAggregates and updated game by game as sessions are saved and
+//! merged, so reading them never walks the whole data set.
 
 use std::collections::HashMap;
-use std::fs::{self, OpenOptions};
-use std::io::{Read, Write};
+use std::fs;
 use std::net::SocketAddr;
 use std::path::PathBuf;
-use std::time::{Duration, Instant};
+use std::time::{Duration, Instant, SystemTime};
 
 use chrono::Local;
 use serde::{Deserialize, Serialize};
 use tracing::{debug, info, warn};
 
-use crate::protocol::{GameInfo, PspState};
+use crate::protocol::{
+    GameInfo, PspState, StatsDelta, StatsDeltaRecord, STATS_DELTA_FLAG_MORE, STATS_DELTA_MAX_RECORDS,
+};
 
 /// A tracked game/app with cumulative playtime
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -41,6 +50,9 @@ struct TrackedGame {
     /// Whether this game is hidden from stats display
     #[serde(default)]
     hidden: bool,
+    /// UsageData::sync_version of the last change to this game
+    #[serde(default)]
+    sync_version: u32,
 }
 
 /// Per-PSP usage data
@@ -50,6 +62,9 @@ struct PspUsageData {
     psp_name: String,
     /// Games/apps tracked for this PSP
     games: HashMap<String, TrackedGame>,
+    /// Highest PSP sync_version merged from this PSP's deltas
+    #[serde(default)]
+    psp_watermark: u32,
 }
 
 /// In-memory session tracking
@@ -73,6 +88,10 @@ struct PspTracker {
 /// Usage data file structure
 #[derive(Debug, Clone, Serialize, Deserialize, Default)]
 struct UsageData {
+    /// Change counter for delta sync, bumped whenever any game changes.
+    /// Kept first so the USB plugin finds it at the start of the file.
+    #[serde(default)]
+    sync_version: u32,
     /// Per-PSP usage data, keyed by PSP name
     psps: HashMap<String, PspUsageData>,
     /// Unix timestamp of last modification (for sync)
@@ -80,6 +99,139 @@ struct UsageData {
     last_updated: Option<u64>,
 }
 
+/// One title's totals across every PSP and state
+#[derive(Debug, Default)]
+struct TitleTotals {
+    /// game_id of the first visible entry seen
+    game_id: String,
+    /// Playtime of all entries, hidden ones included
+    total_seconds: u64,
+    /// Totals of the entries that are not hidden
+    visible_seconds: u64,
+    visible_sessions: u32,
+    visible_entries: u32,
+    /// Most recent last_played of the visible entries
+    last_played: String,
+}
+
+/// Aggregated views over UsageData, maintained incrementally
+#[derive(Debug, Default)]
+struct UsageAggregates {
+    /// Title -> totals
+    titles: HashMap<String, TitleTotals>,
+    /// Date -> title -> seconds played that day
+    daily: HashMap<String, HashMap<String, u64>>,
+    /// Date -> title -> number of entries that place the title on that date
+    dates: HashMap<String, HashMap<String, u32>>,
+    /// (title, total_seconds), most played first
+    ranking: Vec<(String, u64)>,
+}
+
+impl UsageAggregates {
+    /// Build from scratch (on load and reload)
+    fn build(data: &UsageData) -> Self {
+        let mut aggregates = Self::default();
+        for game in data.psps.values().flat_map(|p| p.games.values()) {
+            aggregates.apply(game, true);
+        }
+        aggregates.rank();
+        aggregates
+    }
+
+    /// Swap a game's old contribution for its new one. Call `rank` once the
+    /// batch of changes is done.
+    fn replace(&mut self, before: Option<&TrackedGame>, after: &TrackedGame) {
+        if let Some(before) = before {
+            self.apply(before, false);
+        }
+        self.apply(after, true);
+    }
+
+    /// Add (or remove) one game entry's contribution. last_played is a
+    /// running maximum and is not wound back on removal; it only grows
+    /// between rebuilds.
+    fn apply(&mut self, game: &TrackedGame, add: bool) {
+        if game.title.is_empty() {
+            return;
+        }
+        let title = game.title.as_str();
+
+        let totals = self.titles.entry(title.to_string()).or_default();
+        let step = |value: &mut u64, by: u64| {
+            *value = if add { *value + by } else { value.saturating_sub(by) }
+        };
+        step(&mut totals.total_seconds, game.total_seconds);
+        if !game.hidden {
+            step(&mut totals.visible_seconds, game.total_seconds);
+            let mut sessions = totals.visible_sessions as u64;
+            step(&mut sessions, game.session_count as u64);
+            totals.visible_sessions = sessions as u32;
+            let mut entries = totals.visible_entries as u64;
+            step(&mut entries, 1);
+            totals.visible_entries = entries as u32;
+            if add {
+                if totals.game_id.is_empty() {
+                    totals.game_id = game.game_id.clone();
+                }
+                if game.last_played > totals.last_played {
+                    totals.last_played = game.last_played.clone();
+                }
+            }
+        }
+
+        for (date, &seconds) in &game.daily_playtime {
+            let day = self.daily.entry(date.clone()).or_default();
+            let value = day.entry(title.to_string()).or_insert(0);
+            step(value, seconds);
+            if !add && *value == 0 {
+                day.remove(title);
+                if day.is_empty() {
+                    self.daily.remove(date);
+                }
+            }
+        }
+
+        // Same dates the stats calendar always used: play_dates plus the
+        // first/last played days of older files
+        let extra = [&game.first_played, &game.last_played]
+            .into_iter()
+            .filter(|t| t.len() >= 10)
+            .map(|t| &t[..10]);
+        for date in game.play_dates.iter().map(String::as_str).chain(extra) {
+            let day = self.dates.entry(date.to_string()).or_default();
+            let count = day.entry(title.to_string()).or_insert(0);
+            if add {
+                *count += 1;
+            } else {
+                *count = count.saturating_sub(1);
+                if *count == 0 {
+                    day.remove(title);
+                    if day.is_empty() {
+                        self.dates.remove(date);
+                    }
+                }
+            }
+        }
+    }
+
+    /// Re-sort the ranking after a batch of changes (O(titles))
+    fn rank(&mut self) {
+        self.titles.retain(|_, t| t.total_seconds > 0 || t.visible_entries > 0);
+        self.ranking = self
+            .titles
+            .iter()
+            .map(|(title, t)| (title.clone(), t.total_seconds))
+            .collect();
+        self.ranking.sort_by(|a, b| b.1.cmp(&a.1).then_with(|| a.0.cmp(&b.0)));
+    }
+}
+
+/// How long changes may sit in memory before they are written
+const SAVE_DEBOUNCE: Duration = Duration::from_secs(5);
+
+/// How often the file's mtime is checked for outside changes
+const MTIME_CHECK_INTERVAL: Duration = Duration::from_secs(1);
+
 /// Usage tracker that records game sessions
 pub struct UsageTracker {
     /// Per-PSP tracking state (in-memory, by socket address)
@@ -90,6 +242,16 @@ pub struct UsageTracker {
     enabled: bool,
     /// Minimum session duration to track (avoids spam on quick switches)
     min_session_seconds: u64,
+    /// Usage data (authoritative; the file trails it by up to SAVE_DEBOUNCE)
+    data: UsageData,
+    /// Views over `data` for the TUI
+    aggregates: UsageAggregates,
+    /// When the oldest unsaved change was made, None if nothing is unsaved
+    dirty_since: Option<Instant>,
+    /// mtime of the file as we last read or wrote it
+    file_mtime: Option<SystemTime>,
+    /// When the mtime was last checked
+    last_mtime_check: Instant,
 }
 
 impl UsageTracker {
@@ -98,12 +260,20 @@ impl UsageTracker {
         // Change extension to .json for the new format
         let data_path = log_path.with_extension("json");
         
-        Self {
+        let mut tracker = Self {
             trackers: HashMap::new(),
             data_path,
             enabled,
             min_session_seconds: 1,
-        }
+            data: UsageData::default(),
+            aggregates: UsageAggregates::default(),
+            dirty_since: None,
+            file_mtime: None,
+            last_mtime_check: Instant::now(),
+        };
+        tracker.data = tracker.load_data();
+        tracker.aggregates = UsageAggregates::build(&tracker.data);
+        tracker
     }
 
     /// Get the default log path (beside the executable)
@@ -114,38 +284,84 @@ impl UsageTracker {
             .unwrap_or_else(|| PathBuf::from("usage_log.txt"))
     }
 
-    /// Load usage data from file
-    fn load_data(&self) -> UsageData {
-        if let Ok(mut file) = fs::File::open(&self.data_path) {
-            let mut contents = String::new();
-            if file.read_to_string(&mut contents).is_ok() {
-                if let Ok(data) = serde_json::from_str(&contents) {
-                    return data;
-                }
+    /// mtime of the data file, None if it doesn't exist
+    fn current_mtime(&self) -> Option<SystemTime> {
+        fs::metadata(&self.data_path).and_then(|m| m.modified()).ok()
+    }
+
+    /// Load usage data from file (and remember its mtime)
+    fn load_data(&mut self) -> UsageData {
+        self.file_mtime = self.current_mtime();
+        if let Ok(contents) = fs::read(&self.data_path) {
+            if let Ok(data) = serde_json::from_slice(&contents) {
+                return data;
             }
         }
         UsageData::default()
     }
 
-    /// Save usage data to file
-    fn save_data(&self, data: &UsageData) {
-        match OpenOptions::new()
-            .create(true)
-            .write(true)
-            .truncate(true)
-            .open(&self.data_path)
-        {
-            Ok(mut file) => {
-                if let Ok(json) = serde_json::to_string_pretty(data) {
-                    if let Err(e) = file.write_all(json.as_bytes()) {
-                        warn!("Usage tracker: failed to write data: {}", e);
-                    }
-                }
-            }
+    /// Re-read the file if something else changed it since we last read or
+    /// wrote it
+    fn reload_if_changed(&mut self) {
+        self.last_mtime_check = Instant::now();
+        let mtime = self.current_mtime();
+        if mtime == self.file_mtime {
+            return;
+        }
+
+        if self.dirty_since.take().is_some() {
+            warn!("Usage tracker: data file changed externally, discarding unsaved changes");
+        } else {
+            debug!("Usage tracker: data file changed externally, reloading");
+        }
+        self.data = self.load_data();
+        self.aggregates = UsageAggregates::build(&self.data);
+    }
+
+    /// Take the usage data out for changing (put it back with `store_data`)
+    fn take_data(&mut self) -> UsageData {
+        self.reload_if_changed();
+        std::mem::take(&mut self.data)
+    }
+
+    /// Put changed usage data back; it is written on the next due flush.
+    /// Changed games must already have gone through `aggregates.replace`.
+    fn store_data(&mut self, data: UsageData) {
+        self.data = data;
+        self.aggregates.rank();
+        self.dirty_since.get_or_insert_with(Instant::now);
+    }
+
+    /// Write unsaved changes once they are SAVE_DEBOUNCE old, and pick up
+    /// outside changes to the file. Call regularly (cheap when idle).
+    pub fn flush_if_due(&mut self) {
+        match self.dirty_since {
+            Some(since) if since.elapsed() >= SAVE_DEBOUNCE => self.save_now(),
+            Some(_) => {}
+            None if self.last_mtime_check.elapsed() >= MTIME_CHECK_INTERVAL => self.reload_if_changed(),
+            None => {}
+        }
+    }
+
+    /// Write the usage data now: compact JSON to a temp file, then renamed
+    /// over the real one so readers never see a partial file
+    fn save_now(&mut self) {
+        self.dirty_since = None;
+
+        let json = match serde_json::to_vec(&self.data) {
+            Ok(json) => json,
             Err(e) => {
-                warn!("Usage tracker: failed to open data file: {}", e);
+                warn!("Usage tracker: failed to serialize data: {}", e);
+                return;
             }
+        };
+
+        let tmp_path = self.data_path.with_extension("json.tmp");
+        if let Err(e) = fs::write(&tmp_path, &json).and_then(|_| fs::rename(&tmp_path, &self.data_path)) {
+            warn!("Usage tracker: failed to write data: {}", e);
+            return;
         }
+        self.file_mtime = self.current_mtime();
     }
 
     /// Register a PSP connection or update its name if already registered
@@ -292,7 +508,7 @@ impl UsageTracker {
 
     /// Save a session's playtime delta to the usage data file
     /// Returns the new total saved_seconds for this session
-    fn save_session(&self, psp_name: &str, session: &ActiveSession) -> u64 {
+    fn save_session(&mut self, psp_name: &str, session: &ActiveSession) -> u64 {
         let total_elapsed = session.start_time.elapsed().as_secs();
         
         // Calculate delta (time since last save)
@@ -303,13 +519,16 @@ impl UsageTracker {
             return session.saved_seconds;
         }
 
-        let mut data = self.load_data();
+        let mut data = self.take_data();
+        data.sync_version += 1;
+        let version = data.sync_version;
 
         // Get or create PSP entry
         let psp_data = data.psps.entry(psp_name.to_string()).or_insert_with(|| {
             PspUsageData {
                 psp_name: psp_name.to_string(),
                 games: HashMap::new(),
+                psp_watermark: 0,
             }
         });
 
@@ -317,6 +536,7 @@ impl UsageTracker {
         let game_key = format!("{}:{}", session.game_id, session.state as u8);
         let now = Local::now().format("%Y-%m-%d %H:%M:%S").to_string();
         let today = Local::now().format("%Y-%m-%d").to_string();
+        let before = psp_data.games.get(&game_key).cloned();
         let game_data = psp_data.games.entry(game_key.clone()).or_insert_with(|| {
             TrackedGame {
                 game_id: session.game_id.clone(),
@@ -328,18 +548,21 @@ impl UsageTracker {
                 play_dates: std::collections::HashSet::new(),
                 daily_playtime: HashMap::new(),
                 hidden: false,
+                sync_version: 0,
             }
         });
 
         // Add delta to total (not replace)
         game_data.total_seconds += delta;
+        game_data.sync_version = version;
         game_data.last_played = now;
         game_data.play_dates.insert(today.clone());
         // Track per-day playtime
         *game_data.daily_playtime.entry(today).or_insert(0) += delta;
         let total_for_log = game_data.total_seconds;
+        self.aggregates.replace(before.as_ref(), game_data);
 
-        self.save_data(&data);
+        self.store_data(data);
 
         debug!(
             "Usage tracker: saved +{} (total {}) for '{}' on {}",
@@ -353,7 +576,7 @@ impl UsageTracker {
     }
 
     /// Finish a session and increment the session count
-    fn finish_session(&self, psp_name: &str, session: &ActiveSession) {
+    fn finish_session(&mut self, psp_name: &str, session: &ActiveSession) {
         let total_elapsed = session.start_time.elapsed().as_secs();
         
         // Calculate remaining unsaved time
@@ -364,18 +587,22 @@ impl UsageTracker {
             return;
         }
 
-        let mut data = self.load_data();
+        let mut data = self.take_data();
+        data.sync_version += 1;
+        let version = data.sync_version;
 
         let psp_data = data.psps.entry(psp_name.to_string()).or_insert_with(|| {
             PspUsageData {
                 psp_name: psp_name.to_string(),
                 games: HashMap::new(),
+                psp_watermark: 0,
             }
         });
 
         let game_key = format!("{}:{}", session.game_id, session.state as u8);
         let now = Local::now().format("%Y-%m-%d %H:%M:%S").to_string();
         let today = Local::now().format("%Y-%m-%d").to_string();
+        let before = psp_data.games.get(&game_key).cloned();
         let game_data = psp_data.games.entry(game_key).or_insert_with(|| {
             TrackedGame {
                 game_id: session.game_id.clone(),
@@ -387,19 +614,22 @@ impl UsageTracker {
                 play_dates: std::collections::HashSet::new(),
                 daily_playtime: HashMap::new(),
                 hidden: false,
+                sync_version: 0,
             }
         });
 
         // Add only the remaining delta (unsaved time) to total
         game_data.total_seconds += delta;
+        game_data.sync_version = version;
         game_data.last_played = now;
         game_data.session_count += 1;
         game_data.play_dates.insert(today.clone());
         // Track per-day playtime
         *game_data.daily_playtime.entry(today).or_insert(0) += delta;
         let total_for_log = game_data.total_seconds;
+        self.aggregates.replace(before.as_ref(), game_data);
 
-        self.save_data(&data);
+        self.store_data(data);
 
         info!(
             "Usage tracker: finished session for '{}' (+{}, session: {}) - Total: {}",
@@ -424,83 +654,29 @@ impl UsageTracker {
                 }
             }
         }
+        if self.dirty_since.is_some() {
+            self.save_now();
+        }
         info!("Usage tracker: flushed all sessions");
     }
 
     /// Get the top N most played games across all PSPs
     /// Returns a vector of (title, total_seconds), sorted by playtime descending
     pub fn get_top_played(&self, count: usize) -> Vec<(String, u64)> {
-        let data = self.load_data();
-        
-        // Collect all games with their playtimes
-        let mut all_games: Vec<(String, u64)> = Vec::new();
-        
-        for psp_data in data.psps.values() {
-            for game in psp_data.games.values() {
-                // Skip entries with no title
-                if game.title.is_empty() {
-                    continue;
-                }
-                
-                // Check if we already have this title (aggregate across PSPs)
-                if let Some(existing) = all_games.iter_mut().find(|(t, _)| t == &game.title) {
-                    existing.1 += game.total_seconds;
-                } else {
-                    all_games.push((game.title.clone(), game.total_seconds));
-                }
-            }
-        }
-        
-        // Sort by playtime descending
-        all_games.sort_by(|a, b| b.1.cmp(&a.1));
-        
-        // Take top N
-        all_games.truncate(count);
-        
-        all_games
+        self.aggregates.ranking.iter().take(count).cloned().collect()
     }
 
     /// Get all game stats across all PSPs
     /// Returns a vector of detailed game stats, sorted by playtime descending
     /// Hidden games are filtered out
     pub fn get_all_game_stats(&self) -> Vec<(String, String, u64, u32, String)> {
-        let data = self.load_data();
-        
-        // Use a hashmap to aggregate by title
-        use std::collections::HashMap;
-        let mut game_map: HashMap<String, (String, u64, u32, String)> = HashMap::new();
-        
-        for psp_data in data.psps.values() {
-            for game in psp_data.games.values() {
-                // Skip entries with no title or hidden games
-                if game.title.is_empty() || game.hidden {
-                    continue;
-                }
-                
-                // Aggregate by title
-                if let Some(existing) = game_map.get_mut(&game.title) {
-                    existing.1 += game.total_seconds;
-                    existing.2 += game.session_count;
-                    // Keep the most recent last_played
-                    if game.last_played > existing.3 {
-                        existing.3 = game.last_played.clone();
-                    }
-                } else {
-                    game_map.insert(game.title.clone(), (
-                        game.game_id.clone(),
-                        game.total_seconds,
-                        game.session_count,
-                        game.last_played.clone(),
-                    ));
-                }
-            }
-        }
-        
-        // Convert to vector and sort by playtime descending
-        let mut all_games: Vec<(String, String, u64, u32, String)> = game_map
-            .into_iter()
-            .map(|(title, (game_id, seconds, sessions, last_played))| {
-                (title, game_id, seconds, sessions, last_played)
+        let mut all_games: Vec<(String, String, u64, u32, String)> = self
+            .aggregates
+            .titles
+            .iter()
+            .filter(|(_, t)| t.visible_entries > 0)
+            .map(|(title, t)| {
+                (title.clone(), t.game_id.clone(), t.visible_seconds, t.visible_sessions, t.last_played.clone())
             })
             .collect();
         
@@ -512,65 +688,22 @@ impl UsageTracker {
     /// Get all play dates with the games played on each date
     /// Returns a HashMap mapping date (YYYY-MM-DD) to list of game titles played that day
     pub fn get_all_play_dates(&self) -> std::collections::HashMap<String, Vec<String>> {
-        let data = self.load_data();
-        let mut date_games: std::collections::HashMap<String, Vec<String>> = std::collections::HashMap::new();
-        
-        for psp_data in data.psps.values() {
-            for game in psp_data.games.values() {
-                // Skip entries with no title
-                if game.title.is_empty() {
-                    continue;
-                }
-                
-                for date in &game.play_dates {
-                    date_games.entry(date.clone())
-                        .or_insert_with(Vec::new)
-                        .push(game.title.clone());
-                }
-                
-                // Also extract dates from first_played and last_played for backwards compatibility
-                if game.first_played.len() >= 10 {
-                    let date = game.first_played[..10].to_string();
-                    date_games.entry(date)
-                        .or_insert_with(Vec::new)
-                        .push(game.title.clone());
-                }
-                if game.last_played.len() >= 10 {
-                    let date = game.last_played[..10].to_string();
-                    date_games.entry(date)
-                        .or_insert_with(Vec::new)
-                        .push(game.title.clone());
-                }
-            }
-        }
-        
-        date_games
+        self.aggregates
+            .dates
+            .iter()
+            .map(|(date, titles)| (date.clone(), titles.keys().cloned().collect()))
+            .collect()
     }
     
     /// Get game stats for a specific date
     /// Returns a vector of (title, seconds_on_that_day), sorted by playtime descending
     pub fn get_game_stats_for_date(&self, date: &str) -> Vec<(String, u64)> {
-        let data = self.load_data();
-        
-        // Aggregate by title for this specific date
-        let mut game_map: HashMap<String, u64> = HashMap::new();
-        
-        for psp_data in data.psps.values() {
-            for game in psp_data.games.values() {
-                // Skip entries with no title
-                if game.title.is_empty() {
-                    continue;
-                }
-                
-                // Check if game was played on this date
-                if let Some(&seconds) = game.daily_playtime.get(date) {
-                    *game_map.entry(game.title.clone()).or_insert(0) += seconds;
-                }
-            }
-        }
-        
-        // Convert to vector and sort by playtime descending
-        let mut result: Vec<(String, u64)> = game_map.into_iter().collect();
+        let mut result: Vec<(String, u64)> = self
+            .aggregates
+            .daily
+            .get(date)
+            .map(|day| day.iter().map(|(title, &secs)| (title.clone(), secs)).collect())
+            .unwrap_or_default();
         result.sort_by(|a, b| b.1.cmp(&a.1));
         
         result
@@ -580,7 +713,7 @@ impl UsageTracker {
 
     /// Get the last_updated timestamp for sync comparison
     pub fn get_last_updated(&self) -> u64 {
-        let data = self.load_data();
+        let data = &self.data;
         data.last_updated.unwrap_or(0)
     }
 
@@ -595,40 +728,106 @@ impl UsageTracker {
     }
 
     /// Get usage data as JSON (for sending to PSP)
-    /// Returns the entire raw JSON file content and the last_updated timestamp
+    /// Returns the whole usage file as it stands in memory and the
+    /// last_updated timestamp
     pub fn get_usage_for_psp_json(&self, _psp_name: &str) -> (String, u64) {
-        // Just read and return the raw file content
-        if let Ok(mut file) = std::fs::File::open(&self.data_path) {
-            let mut contents = String::new();
-            if file.read_to_string(&mut contents).is_ok() {
-                // Parse to get last_updated timestamp
-                if let Ok(data) = serde_json::from_str::<serde_json::Value>(&contents) {
-                    let last_updated = data.get("last_updated")
-                        .and_then(|v| v.as_u64())
-                        .unwrap_or(0);
-                    return (contents, last_updated);
+        match serde_json::to_string(&self.data) {
+            Ok(json) => (json, self.data.last_updated.unwrap_or(0)),
+            Err(_) => (String::from("{}"), 0),
+        }
+    }
+
+    /// Get the current sync_version (what a PSP holding the current file has seen)
+    pub fn get_sync_version(&self) -> u32 {
+        self.data.sync_version
+    }
+
+    /// Build a StatsDelta for a PSP: every game of that PSP changed after
+    /// `since_version`. Entries for the same game under different states are
+    /// folded together by taking the higher values, like the PSP would.
+    pub fn get_stats_delta_for_psp(&self, psp_name: &str, since_version: u32, psp_version: u32) -> Vec<u8> {
+        let data = &self.data;
+
+        // A watermark from the future means our file was reset - send everything
+        let since = if since_version > data.sync_version { 0 } else { since_version };
+
+        let mut delta = StatsDelta {
+            version: data.sync_version,
+            ..Default::default()
+        };
+
+        if let Some(psp_data) = data.psps.get(psp_name) {
+            // Same for the PSP's side: an ack past its version means it was reset
+            if psp_data.psp_watermark <= psp_version {
+                delta.ack = psp_data.psp_watermark;
+            }
+
+            let mut by_id: HashMap<&str, StatsDeltaRecord> = HashMap::new();
+            for game in psp_data.games.values() {
+                let record = by_id.entry(game.game_id.as_str()).or_insert_with(|| StatsDeltaRecord {
+                    game_id: game.game_id.clone(),
+                    ..Default::default()
+                });
+                record.total_seconds = record.total_seconds.max(game.total_seconds);
+                record.session_count = record.session_count.max(game.session_count);
+                record.version = record.version.max(game.sync_version);
+                if record.title.is_empty() {
+                    record.title = game.title.clone();
+                }
+            }
+            let mut records: Vec<StatsDeltaRecord> = by_id
+                .into_values()
+                .filter(|r| r.version > since && !r.game_id.is_empty())
+                .collect();
+
+            // Oldest changes first; anything past the cap goes in the next
+            // sync, which the PSP starts right away on seeing the MORE flag
+            records.sort_by_key(|r| r.version);
+            if records.len() > STATS_DELTA_MAX_RECORDS {
+                let next = records[STATS_DELTA_MAX_RECORDS].version;
+                records.retain(|r| r.version < next);
+                if let Some(last) = records.last() {
+                    delta.version = last.version;
+                    delta.flags |= STATS_DELTA_FLAG_MORE;
+                } else {
+                    // Only possible with versions from before per-game stamping
+                    records = Vec::new();
                 }
             }
+            delta.records = records;
         }
-        // Return empty if file doesn't exist
-        (String::from("{}"), 0)
+
+        debug!(
+            "Usage tracker: delta for '{}' since {}: {} games (version {}, ack {})",
+            psp_name, since, delta.records.len(), delta.version, delta.ack
+        );
+        delta.encode()
     }
 
     /// Merge usage data received from PSP (high-water-mark strategy)
-    /// Takes higher values for playtime/sessions, unions daily playtime entries
-    pub fn merge_from_psp(&self, psp_name: &str, json_data: &str) -> anyhow::Result<u32> {
+    /// Takes higher values for playtime/sessions, unions daily playtime entries.
+    /// Accepts either a StatsDelta or the PSP's legacy JSON upload.
+    pub fn merge_from_psp(&mut self, psp_name: &str, upload: &[u8]) -> anyhow::Result<u32> {
         use serde_json::Value;
+
+        if StatsDelta::is_delta(upload) {
+            return self.merge_delta_from_psp(psp_name, &StatsDelta::decode(upload)?);
+        }
         
-        let mut data = self.load_data();
-        let mut merge_count = 0u32;
+        let remote: Value = serde_json::from_slice(upload)?;
         
-        let remote: Value = serde_json::from_str(json_data)?;
+        let mut data = self.take_data();
+        let mut merge_count = 0u32;
+        // Every changed game gets a version of its own, so a delta can stop
+        // between any two of them
+        let base_version = data.sync_version;
         
         // Get or create PSP entry
         let psp_data = data.psps.entry(psp_name.to_string()).or_insert_with(|| {
             PspUsageData {
                 psp_name: psp_name.to_string(),
                 games: HashMap::new(),
+                psp_watermark: 0,
             }
         });
         
@@ -659,6 +858,7 @@ impl UsageTracker {
                 // Use game_id as key (without state suffix since PSP doesn't track states)
                 let game_key = game_id.to_string();
                 
+                let before = psp_data.games.get(&game_key).cloned();
                 let game_data = psp_data.games.entry(game_key).or_insert_with(|| {
                     TrackedGame {
                         game_id: game_id.to_string(),
@@ -670,6 +870,7 @@ impl UsageTracker {
                         play_dates: std::collections::HashSet::new(),
                         daily_playtime: HashMap::new(),
                         hidden: false,
+                        sync_version: 0,
                     }
                 });
                 
@@ -677,6 +878,7 @@ impl UsageTracker {
                 if remote_seconds > game_data.total_seconds {
                     game_data.total_seconds = remote_seconds;
                     merge_count += 1;
+                    game_data.sync_version = base_version + merge_count;
                 }
                 if remote_sessions > game_data.session_count {
                     game_data.session_count = remote_sessions;
@@ -705,16 +907,88 @@ impl UsageTracker {
                         }
                     }
                 }
+                self.aggregates.replace(before.as_ref(), game_data);
             }
         }
         
         // Update timestamp and save
+        if merge_count > 0 {
+            data.sync_version = base_version + merge_count;
+        }
         self.set_updated_now(&mut data);
-        self.save_data(&data);
+        self.store_data(data);
         
         info!("Usage tracker: merged {} games from PSP '{}'", merge_count, psp_name);
         Ok(merge_count)
     }
+
+    /// Merge a StatsDelta uploaded by a PSP and remember how far we've seen
+    fn merge_delta_from_psp(&mut self, psp_name: &str, delta: &StatsDelta) -> anyhow::Result<u32> {
+        let mut data = self.take_data();
+        let mut merge_count = 0u32;
+        // Every changed game gets a version of its own, so a delta can stop
+        // between any two of them
+        let base_version = data.sync_version;
+
+        let psp_data = data.psps.entry(psp_name.to_string()).or_insert_with(|| {
+            PspUsageData {
+                psp_name: psp_name.to_string(),
+                games: HashMap::new(),
+                psp_watermark: 0,
+            }
+        });
+
+        for record in delta.records.iter().filter(|r| !r.game_id.is_empty()) {
+            // Keyed by game_id alone, the same as the JSON merge
+            let before = psp_data.games.get(&record.game_id).cloned();
+            let game_data = psp_data.games.entry(record.game_id.clone()).or_insert_with(|| {
+                TrackedGame {
+                    game_id: record.game_id.clone(),
+                    title: record.title.clone(),
+                    total_seconds: 0,
+                    first_played: String::new(),
+                    last_played: String::new(),
+                    session_count: 0,
+                    play_dates: std::collections::HashSet::new(),
+                    daily_playtime: HashMap::new(),
+                    hidden: false,
+                    sync_version: 0,
+                }
+            });
+
+            // High-water-mark: take higher values
+            let mut changed = false;
+            if record.total_seconds > game_data.total_seconds {
+                game_data.total_seconds = record.total_seconds;
+                changed = true;
+            }
+            if record.session_count > game_data.session_count {
+                game_data.session_count = record.session_count;
+                changed = true;
+            }
+            if game_data.title.is_empty() && !record.title.is_empty() {
+                game_data.title = record.title.clone();
+            }
+            if changed {
+                merge_count += 1;
+                game_data.sync_version = base_version + merge_count;
+            }
+            self.aggregates.replace(before.as_ref(), game_data);
+        }
+        psp_data.psp_watermark = delta.version;
+
+        if merge_count > 0 {
+            data.sync_version = base_version + merge_count;
+        }
+        self.set_updated_now(&mut data);
+        self.store_data(data);
+
+        info!(
+            "Usage tracker: merged delta of {} games ({} changed) from PSP '{}' up to version {}",
+            delta.records.len(), merge_count, psp_name, delta.version
+        );
+        Ok(merge_count)
+    }
 }
 
 /// Format a duration as human-readable string
@@ -732,3 +1006,97 @@ fn format_duration(duration: Duration) -> String {
         format!("{}s", secs)
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const PSP: &str = "PSP-3000";
+
+    /// Tracker over a file no test writes (saves are debounced and never flushed)
+    fn tracker(name: &str) -> UsageTracker {
+        let path = std::env::temp_dir().join(format!("pspdrp_test_{}_{}.txt", name, std::process::id()));
+        let _ = fs::remove_file(path.with_extension("json"));
+        UsageTracker::new(path, true)
+    }
+
+    fn record(game_id: &str, total_seconds: u64, session_count: u32, version: u32) -> StatsDeltaRecord {
+        StatsDeltaRecord {
+            game_id: game_id.to_string(),
+            title: format!("Title {}", game_id),
+            total_seconds,
+            session_count,
+            version,
+        }
+    }
+
+    fn upload(tracker: &mut UsageTracker, version: u32, records: Vec<StatsDeltaRecord>) -> u32 {
+        let delta = StatsDelta { version, records, ..Default::default() };
+        tracker.merge_from_psp(PSP, &delta.encode()).unwrap()
+    }
+
+    fn delta_for(tracker: &UsageTracker, since_version: u32, psp_version: u32) -> StatsDelta {
+        StatsDelta::decode(&tracker.get_stats_delta_for_psp(PSP, since_version, psp_version)).unwrap()
+    }
+
+    #[test]
+    fn test_merge_delta_high_water_mark() {
+        let mut tracker = tracker("high_water");
+        assert_eq!(upload(&mut tracker, 2, vec![record("ULUS10391", 600, 2, 1), record("ULUS10336", 60, 1, 2)]), 2);
+        assert_eq!(tracker.get_sync_version(), 2);
+
+        // Less playtime but more sessions: only the higher of each is kept,
+        // and a game with nothing higher is not a change
+        assert_eq!(upload(&mut tracker, 3, vec![record("ULUS10391", 300, 5, 3), record("ULUS10336", 60, 1, 3)]), 1);
+        assert_eq!(tracker.get_sync_version(), 3);
+
+        let delta = delta_for(&tracker, 0, 3);
+        assert_eq!(delta.version, 3);
+        assert_eq!(delta.ack, 3);
+        let crisis = delta.records.iter().find(|r| r.game_id == "ULUS10391").unwrap();
+        assert_eq!((crisis.total_seconds, crisis.session_count, crisis.version), (600, 5, 3));
+        let other = delta.records.iter().find(|r| r.game_id == "ULUS10336").unwrap();
+        assert_eq!((other.total_seconds, other.session_count, other.version), (60, 1, 2));
+
+        // Only what changed after the watermark goes back
+        let delta = delta_for(&tracker, 2, 3);
+        assert_eq!(delta.records.len(), 1);
+        assert_eq!(delta.records[0].game_id, "ULUS10391");
+        assert!(delta_for(&tracker, 3, 3).records.is_empty());
+    }
+
+    #[test]
+    fn test_delta_after_reset() {
+        let mut tracker = tracker("reset");
+        upload(&mut tracker, 5, vec![record("ULUS10391", 600, 2, 5), record("ULUS10336", 60, 1, 4)]);
+
+        // A watermark past our version means our file was reset: send everything
+        assert_eq!(delta_for(&tracker, 100, 5).records.len(), 2);
+
+        // An ack past the PSP's version means the PSP was reset: ack nothing
+        assert_eq!(delta_for(&tracker, 0, 5).ack, 5);
+        assert_eq!(delta_for(&tracker, 0, 1).ack, 0);
+    }
+
+    #[test]
+    fn test_delta_more_paging() {
+        let mut tracker = tracker("paging");
+        let total = STATS_DELTA_MAX_RECORDS as u32 + 6;
+        let records = (1..=total).map(|i| record(&format!("ULUS{:05}", i), u64::from(i), 1, i)).collect();
+        assert_eq!(upload(&mut tracker, total, records), total);
+
+        // Oldest first, up to the cap, with MORE and the version it stopped at
+        let first = delta_for(&tracker, 0, total);
+        assert_eq!(first.records.len(), STATS_DELTA_MAX_RECORDS);
+        assert_ne!(first.flags & STATS_DELTA_FLAG_MORE, 0);
+        assert_eq!(first.version, STATS_DELTA_MAX_RECORDS as u32);
+        assert!(first.records.windows(2).all(|w| w[0].version < w[1].version));
+
+        // The next page picks up from there and ends the sync
+        let second = delta_for(&tracker, first.version, total);
+        assert_eq!(second.records.len(), 6);
+        assert_eq!(second.flags & STATS_DELTA_FLAG_MORE, 0);
+        assert_eq!(second.version, total);
+        assert!(second.records.iter().all(|r| r.version > first.version));
+    }
+}
@@ -2,8 +2,12 @@
 //!
 //! Implements USBHostFS-style communication with the PSP using rusb.
 //! The PSP acts as a custom USB device with bulk endpoints for
-//! bidirectional data transfer.
+//! bidirectional data transfer. All libusb calls happen on dedicated OS
+//! threads that talk to the async side through channels.
 
+use std::borrow::Cow;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{mpsc as std_mpsc, Arc, Mutex};
 use std::time::Duration;
 
 use anyhow::{Context, Result};
@@ -12,6 +16,7 @@ use tokio::sync::mpsc;
 use tracing::{debug, error, info, warn};
 
 use crate::config::UsbConfig;
+use crate::protocol::HeartbeatMetrics;
 
 /// USB Vendor/Product IDs - Sony PSP Type B (compatible with USBHostFS driver)
 pub const USB_VENDOR_ID: u16 = 0x054C;   // Sony
@@ -24,15 +29,39 @@ const EP_BULK_OUT: u8 = 0x02; // PC -> PSP
 /// USB Interface number
 const USB_INTERFACE: u8 = 0;
 
-/// Transfer timeout (short to avoid blocking the async runtime)
+/// Write timeout
 const USB_TIMEOUT: Duration = Duration::from_millis(100);
 
+/// Read timeout on the I/O thread. Only bounds how long a stop request or
+/// closed event channel goes unnoticed; data is returned as soon as it lands.
+const READ_TIMEOUT: Duration = Duration::from_millis(500);
+
+/// How long a stats response waits for each ACK
+const ACK_TIMEOUT: Duration = Duration::from_secs(2);
+
 /// Packet magic header for PSP DRP protocol
 const PACKET_MAGIC: u32 = 0x50535044; // "PSPD"
 
-/// Maximum packet size for USB transfers
+/// Maximum v1 packet size
 const MAX_PACKET_SIZE: usize = 512;
 
+/// Largest v2 frame (header included). Reads use this size, so one
+/// `read_bulk` returns one whole frame.
+const MAX_FRAME_SIZE: usize = 4096;
+
+/// v2 frame header: packet header(8) + id[10] + reserved(2) + total_size(4) +
+/// offset(4) + tag(8)
+const FRAME_HEADER_SIZE: usize = 36;
+
+/// Data bytes in every v2 frame but the last of a transfer
+const FRAME_DATA_SIZE: usize = 4000;
+
+/// Largest transfer accepted from frames (sanity bound for total_size)
+const MAX_FRAME_TRANSFER: usize = 16 * 1024 * 1024;
+
+/// Header flag: sender understands v2 frames
+const FLAG_FRAMES: u8 = 0x01;
+
 /// Packet types matching PSP side
 #[repr(u8)]
 #[derive(Debug, Clone, Copy, PartialEq)]
@@ -42,9 +71,12 @@ pub enum PacketType {
     Icon = 0x03,
     StatsRequest = 0x05,
     StatsUpload = 0x06,
+    IconFrame = 0x08,
+    StatsUploadFrame = 0x09,
     Ack = 0x10,
     IconRequest = 0x11,
     StatsResponse = 0x12,
+    StatsResponseFrame = 0x15,
 }
 
 /// USB Transport events sent to the main application
@@ -56,34 +88,104 @@ pub enum UsbEvent {
     Disconnected,
     /// Received game info from PSP
     GameInfo(GameInfoPacket),
+    /// Heartbeat metrics from PSP (plugins that send them)
+    Metrics(HeartbeatMetrics),
     /// Received icon data from PSP (complete)
     IconData { game_id: String, data: Vec<u8> },
-    /// PSP requested stats sync
-    StatsRequested { psp_name: String, local_timestamp: u64 },
-    /// PSP uploaded stats data
-    StatsUploaded { last_updated: u64, json_data: String },
+    /// PSP requested stats sync (`since_version` is the sync_version of the
+    /// usage file it already holds, None for older plugins)
+    StatsRequested { psp_name: String, local_timestamp: u64, since_version: Option<u32> },
+    /// PSP uploaded stats data (JSON or StatsDelta)
+    StatsUploaded { last_updated: u64, data: Vec<u8> },
     /// Error occurred
     Error(String),
 }
 
-/// Internal icon chunk for accumulation
+/// Internal icon chunk for accumulation (borrows the read buffer)
 #[derive(Debug, Clone)]
-pub struct IconChunk {
-    pub game_id: String,
+pub struct IconChunk<'a> {
+    pub game_id: Cow<'a, str>,
     pub total_size: usize,
     pub chunk_offset: usize,
-    pub chunk_data: Vec<u8>,
+    pub chunk_data: &'a [u8],
     pub chunk_num: u8,
     pub total_chunks: u8,
 }
 
+/// One v2 frame: a piece of an icon or stats transfer at a 32-bit offset
+/// (borrows the read buffer)
+#[derive(Debug, Clone)]
+pub struct Frame<'a> {
+    pub packet_type: u8,
+    /// Game ID for icons, empty for stats
+    pub id: Cow<'a, str>,
+    pub total_size: usize,
+    pub offset: usize,
+    /// Icons: CRC32 of the whole icon; stats: last_updated
+    pub tag: u64,
+    pub data: &'a [u8],
+}
+
+/// Reassembly state for one frame transfer. Bulk transfers arrive in
+/// order, so frames are appended and anything out of sequence restarts it.
+#[derive(Debug)]
+struct FrameAssembly {
+    packet_type: u8,
+    id: String,
+    total_size: usize,
+    tag: u64,
+    data: Vec<u8>,
+}
+
+impl FrameAssembly {
+    fn new(frame: &Frame) -> Self {
+        Self {
+            packet_type: frame.packet_type,
+            id: frame.id.to_string(),
+            total_size: 0,
+            tag: 0,
+            data: Vec::new(),
+        }
+    }
+
+    fn is_for(&self, frame: &Frame) -> bool {
+        self.packet_type == frame.packet_type && self.id == frame.id
+    }
+
+    /// Add a frame, returning true once the transfer is complete
+    fn push(&mut self, frame: &Frame) -> bool {
+        if frame.offset == 0 {
+            self.total_size = frame.total_size;
+            self.tag = frame.tag;
+            self.data.clear();
+            self.data.reserve(frame.total_size);
+        } else if frame.offset != self.data.len()
+            || frame.total_size != self.total_size
+            || frame.tag != self.tag
+        {
+            debug!("USB: Frame out of sequence at offset {}, dropping transfer", frame.offset);
+            self.data.clear();
+            self.total_size = 0;
+            return false;
+        }
+
+        if self.data.len() + frame.data.len() > self.total_size {
+            self.data.clear();
+            self.total_size = 0;
+            return false;
+        }
+        self.data.extend_from_slice(frame.data);
+        self.total_size > 0 && self.data.len() == self.total_size
+    }
+}
+
 /// USB Transport commands from main application
 #[derive(Debug, Clone)]
 pub enum UsbCommand {
     /// Request icon for a game
     RequestIcon { game_id: String },
     /// Send stats response to PSP
-    SendStatsResponse { last_updated: u64, json_data: String },
+    SendStatsResponse { last_updated: u64, data: Vec<u8> },
 }
 
 /// Game info packet received from PSP
@@ -96,12 +198,18 @@ pub struct GameInfoPacket {
     pub start_time: u64,
     pub persistent: bool,
     pub psp_name: String,
+    /// CRC32 of the icon, when the PSP already knows it (icon cache hit)
+    pub icon_crc32: Option<u32>,
+    /// Icon size in bytes (0 if not advertised)
+    pub icon_size: u32,
 }
 
 /// USB Transport handle for communicating with PSP
 pub struct UsbTransport {
     handle: DeviceHandle<GlobalContext>,
     config: UsbConfig,
+    /// Set once the PSP flags a packet with FLAG_FRAMES
+    peer_frames: AtomicBool,
 }
 
 impl UsbTransport {
@@ -143,6 +251,7 @@ impl UsbTransport {
                 return Ok(Some(Self {
                     handle,
                     config: UsbConfig::default(),
+                    peer_frames: AtomicBool::new(false),
                 }));
             }
         }
@@ -162,8 +271,8 @@ impl UsbTransport {
     
     /// Receive data from PSP via bulk IN endpoint
     /// Returns Ok(Some(len)) on success, Ok(None) on timeout, Err on real error
-    pub fn recv_with_timeout(&self, buffer: &mut [u8]) -> Result<Option<usize>> {
-        match self.handle.read_bulk(EP_BULK_IN, buffer, USB_TIMEOUT) {
+    pub fn recv_with_timeout(&self, buffer: &mut [u8], timeout: Duration) -> Result<Option<usize>> {
+        match self.handle.read_bulk(EP_BULK_IN, buffer, timeout) {
             Ok(len) => {
                 if len > 0 {
                     debug!("USB: Received {} bytes", len);
@@ -189,8 +298,9 @@ impl UsbTransport {
         packet[0..4].copy_from_slice(&PACKET_MAGIC.to_le_bytes());
         // Packet type
         packet[4] = PacketType::Ack as u8;
-        // Reserved
-        packet[5..8].fill(0);
+        // Flags: tells the PSP it may send frames
+        packet[5] = FLAG_FRAMES;
+        packet[6..8].fill(0);
         
         self.send(&packet)?;
         Ok(())
@@ -205,8 +315,9 @@ impl UsbTransport {
         packet[0..4].copy_from_slice(&PACKET_MAGIC.to_le_bytes());
         // Packet type
         packet[4] = PacketType::IconRequest as u8;
-        // Reserved
-        packet[5..8].fill(0);
+        // Flags: tells the PSP it may send the icon as frames
+        packet[5] = FLAG_FRAMES;
+        packet[6..8].fill(0);
         // Game ID (10 chars, null-padded)
         let game_id_bytes = game_id.as_bytes();
         let len = game_id_bytes.len().min(10);
@@ -217,23 +328,38 @@ impl UsbTransport {
         Ok(())
     }
     
-    /// Send stats response to PSP (chunked with ACK flow control)
-    pub fn send_stats_response(&self, last_updated: u64, json_data: &str) -> Result<()> {
+    /// Remember whether the PSP speaks v2 frames (from any packet's flags)
+    pub fn note_flags(&self, data: &[u8]) {
+        if data.len() >= 8 && data[5] & FLAG_FRAMES != 0 && !self.peer_frames.swap(true, Ordering::Relaxed) {
+            info!("USB: PSP supports frames");
+        }
+    }
+    
+    /// Send stats response to PSP (as frames when the PSP supports them,
+    /// v1 chunks otherwise; ACK flow control either way). ACKs are read by
+    /// the I/O thread and arrive on `acks`.
+    pub fn send_stats_response(&self, last_updated: u64, data: &[u8], acks: &std_mpsc::Receiver<()>) -> Result<()> {
+        // Drop ACKs left over from an earlier response that timed out
+        while acks.try_recv().is_ok() {}
+        
+        if self.peer_frames.load(Ordering::Relaxed) {
+            return self.send_stats_response_frames(last_updated, data, acks);
+        }
+        
         const CHUNK_SIZE: usize = 480;
-        let data = json_data.as_bytes();
         let total_bytes = data.len() as u32;
         let total_chunks = (data.len() + CHUNK_SIZE - 1) / CHUNK_SIZE;
         
         for (chunk_idx, chunk) in data.chunks(CHUNK_SIZE).enumerate() {
             // UsbStatsResponsePacket layout:
-            // Header (8 bytes): magic(4), type(1), reserved(1), length(2)
+            // Header (8 bytes): magic(4), type(1), flags(1), length(2)
             // last_updated(8), total_bytes(4), chunk_index(2), total_chunks(2), data_length(2), data[480]
-            let mut packet = [0u8; 512];
+            let mut packet = [0u8; MAX_PACKET_SIZE];
             
             // Header
             packet[0..4].copy_from_slice(&PACKET_MAGIC.to_le_bytes());
             packet[4] = PacketType::StatsResponse as u8;
-            packet[5] = 0; // reserved
+            packet[5] = 0; // flags
             packet[6..8].copy_from_slice(&(504u16).to_le_bytes()); // payload length
             
             // Payload
@@ -247,33 +373,43 @@ impl UsbTransport {
             self.send(&packet)?;
             
             // Wait for ACK from PSP before sending next chunk
-            let mut ack_buf = [0u8; 64];
-            let start = std::time::Instant::now();
-            loop {
-                if let Ok(Some(size)) = self.recv_with_timeout(&mut ack_buf) {
-                    if size >= 8 {
-                        let magic = u32::from_le_bytes([ack_buf[0], ack_buf[1], ack_buf[2], ack_buf[3]]);
-                        let pkt_type = ack_buf[4];
-                        if magic == PACKET_MAGIC && pkt_type == PacketType::Ack as u8 {
-                            debug!("USB: Got ACK for chunk {}/{}", chunk_idx + 1, total_chunks);
-                            break;
-                        }
-                    }
-                }
-                // Timeout after 2 seconds
-                if start.elapsed() > Duration::from_secs(2) {
-                    warn!("USB: ACK timeout for chunk {}, continuing anyway", chunk_idx);
-                    break;
-                }
-                // Small sleep to avoid busy-loop
-                std::thread::sleep(Duration::from_millis(10));
-            }
+            wait_for_ack(acks, chunk_idx, total_chunks);
         }
         
         info!("USB: Sent stats response ({} bytes, {} chunks)", data.len(), total_chunks);
         Ok(())
     }
     
+    /// Send stats response as v2 frames, one bulk write per frame
+    fn send_stats_response_frames(&self, last_updated: u64, data: &[u8], acks: &std_mpsc::Receiver<()>) -> Result<()> {
+        let total_frames = (data.len() + FRAME_DATA_SIZE - 1) / FRAME_DATA_SIZE;
+        let mut packet = Vec::with_capacity(MAX_FRAME_SIZE);
+        
+        for (frame_idx, chunk) in data.chunks(FRAME_DATA_SIZE).enumerate() {
+            packet.clear();
+            packet.extend_from_slice(&PACKET_MAGIC.to_le_bytes());
+            packet.push(PacketType::StatsResponseFrame as u8);
+            packet.push(FLAG_FRAMES);
+            packet.extend_from_slice(&((FRAME_HEADER_SIZE - 8 + chunk.len()) as u16).to_le_bytes());
+            packet.extend_from_slice(&[0u8; 12]); // id[10] (unused for stats) + reserved
+            packet.extend_from_slice(&(data.len() as u32).to_le_bytes());
+            packet.extend_from_slice(&((frame_idx * FRAME_DATA_SIZE) as u32).to_le_bytes());
+            packet.extend_from_slice(&last_updated.to_le_bytes());
+            packet.extend_from_slice(chunk);
+            // A transfer that ends on a full max-packet needs a zero-length
+            // packet to finish; pad one byte instead (header.length is exact)
+            if packet.len() % 64 == 0 {
+                packet.push(0);
+            }
+            
+            self.send(&packet)?;
+            wait_for_ack(acks, frame_idx, total_frames);
+        }
+        
+        info!("USB: Sent stats response ({} bytes, {} frames)", data.len(), total_frames);
+        Ok(())
+    }
+    
     /// Parse a received packet
     pub fn parse_packet(&self, data: &[u8]) -> Result<Option<UsbEvent>> {
         if data.len() < 8 {
@@ -291,14 +427,16 @@ impl UsbTransport {
         
         match packet_type {
             0x01 => {
-                // Heartbeat
+                // Heartbeat: header(8), uptime(4), battery(1), padding[3],
+                // then the metrics extension from newer plugins
                 debug!("USB: Received heartbeat");
-                Ok(None)
+                Ok(data.get(16..).and_then(HeartbeatMetrics::decode).map(UsbEvent::Metrics))
             }
             0x02 => {
                 // Game info packet:
                 // Header (8 bytes): magic(4), type(1), reserved(1), length(2)
-                // Payload: game_id[10], title[64], state(1), has_icon(1), start_time(4), persistent(1), psp_name[32], padding[7]
+                // Payload: game_id[10], title[64], state(1), has_icon(1), start_time(4), persistent(1), psp_name[32],
+                //          icon_crc32(4), icon_size(2), padding[1]
                 if data.len() < 128 {
                     return Ok(None);
                 }
@@ -311,6 +449,10 @@ impl UsbTransport {
                 let start_time = u32::from_le_bytes([data[84], data[85], data[86], data[87]]) as u64;  // bytes 84-87
                 let persistent = data[88] != 0;                   // byte 88
                 let psp_name = extract_string(&data[89..121]);    // bytes 89-120 (32 chars)
+                let icon_crc32 = u32::from_le_bytes([data[121], data[122], data[123], data[124]]);  // bytes 121-124
+                let icon_size = u16::from_le_bytes([data[125], data[126]]) as u32;  // bytes 125-126
+                // Older plugins leave these as padding (zero)
+                let icon_crc32 = if icon_size > 0 { Some(icon_crc32) } else { None };
                 
                 info!("USB: Received game info: {} - {}", game_id, title);
                 
@@ -322,6 +464,8 @@ impl UsbTransport {
                     start_time,
                     persistent,
                     psp_name,
+                    icon_crc32,
+                    icon_size,
                 })))
             }
             0x03 => {
@@ -365,7 +509,8 @@ impl UsbTransport {
                 Ok(None)
             }
             0x05 => {
-                // Stats request packet: header(8) + local_timestamp(8) = 16 bytes
+                // Stats request packet: header(8) + local_timestamp(8) = 16 bytes,
+                // followed by since_version(4) + psp_version(4) on newer plugins
                 if data.len() < 16 {
                     return Ok(None);
                 }
@@ -374,13 +519,17 @@ impl UsbTransport {
                     data[8], data[9], data[10], data[11],
                     data[12], data[13], data[14], data[15]
                 ]);
+                let since_version = (data.len() >= 24)
+                    .then(|| u32::from_le_bytes([data[16], data[17], data[18], data[19]]));
                 
-                info!("USB: Stats request received (timestamp={})", local_timestamp);
+                info!("USB: Stats request received (timestamp={}, since={:?})",
+                      local_timestamp, since_version);
                 
                 // PSP name not included in this packet, use empty string
                 Ok(Some(UsbEvent::StatsRequested {
                     psp_name: String::new(),
                     local_timestamp,
+                    since_version,
                 }))
             }
             0x06 => {
@@ -402,11 +551,10 @@ impl UsbTransport {
                 
                 // For single chunk, emit directly
                 if total_chunks == 1 && data.len() >= 22 + data_length {
-                    let json_data = String::from_utf8_lossy(&data[22..22 + data_length]).to_string();
                     info!("USB: Stats upload complete ({} bytes)", data_length);
                     return Ok(Some(UsbEvent::StatsUploaded {
                         last_updated,
-                        json_data,
+                        data: data[22..22 + data_length].to_vec(),
                     }));
                 }
                 
@@ -422,15 +570,57 @@ impl UsbTransport {
     }
     
     /// Close the USB transport
-    pub fn close(self) {
+    pub fn close(&self) {
         if let Err(e) = self.handle.release_interface(USB_INTERFACE) {
             warn!("Failed to release USB interface: {}", e);
         }
         info!("USB transport closed");
     }
     
+    /// Try to parse a v2 frame from raw data (returns None if not a frame)
+    pub fn try_parse_frame(data: &[u8]) -> Option<Frame<'_>> {
+        if data.len() < FRAME_HEADER_SIZE {
+            return None;
+        }
+        
+        let magic = u32::from_le_bytes([data[0], data[1], data[2], data[3]]);
+        let packet_type = data[4];
+        if magic != PACKET_MAGIC
+            || (packet_type != PacketType::IconFrame as u8
+                && packet_type != PacketType::StatsUploadFrame as u8)
+        {
+            return None;
+        }
+        
+        // header.length counts the frame fields plus data; anything past it
+        // is the one-byte pad
+        let length = u16::from_le_bytes([data[6], data[7]]) as usize;
+        let end = 8 + length;
+        if end < FRAME_HEADER_SIZE || end > data.len() {
+            return None;
+        }
+        
+        let total_size = u32::from_le_bytes([data[20], data[21], data[22], data[23]]) as usize;
+        if total_size > MAX_FRAME_TRANSFER {
+            warn!("USB: Frame transfer too large ({} bytes)", total_size);
+            return None;
+        }
+        
+        Some(Frame {
+            packet_type,
+            id: extract_str(&data[8..18]),
+            total_size,
+            offset: u32::from_le_bytes([data[24], data[25], data[26], data[27]]) as usize,
+            tag: u64::from_le_bytes([
+                data[28], data[29], data[30], data[31],
+                data[32], data[33], data[34], data[35]
+            ]),
+            data: &data[FRAME_HEADER_SIZE..end],
+        })
+    }
+    
     /// Try to parse an icon chunk from raw data (returns None if not an icon chunk)
-    pub fn try_parse_icon_chunk(data: &[u8]) -> Option<IconChunk> {
+    pub fn try_parse_icon_chunk(data: &[u8]) -> Option<IconChunk<'_>> {
         if data.len() < 26 {
             return None;
         }
@@ -446,7 +636,7 @@ impl UsbTransport {
             return None;
         }
         
-        let game_id = extract_string(&data[8..18]);
+        let game_id = extract_str(&data[8..18]);
         let total_size = u16::from_le_bytes([data[18], data[19]]) as usize;
         let chunk_offset = u16::from_le_bytes([data[20], data[21]]) as usize;
         let chunk_size = u16::from_le_bytes([data[22], data[23]]) as usize;
@@ -461,175 +651,313 @@ impl UsbTransport {
             game_id,
             total_size,
             chunk_offset,
-            chunk_data: data[26..26 + chunk_size].to_vec(),
+            chunk_data: &data[26..26 + chunk_size],
             chunk_num,
             total_chunks,
         })
     }
 }
 
+/// Wait for the PSP to ACK one stats response piece
+fn wait_for_ack(acks: &std_mpsc::Receiver<()>, index: usize, total: usize) {
+    match acks.recv_timeout(ACK_TIMEOUT) {
+        Ok(()) => debug!("USB: Got ACK for chunk {}/{}", index + 1, total),
+        Err(_) => warn!("USB: ACK timeout for chunk {}, continuing anyway", index),
+    }
+}
+
 /// Extract a null-terminated string from bytes
 fn extract_string(data: &[u8]) -> String {
+    extract_str(data).into_owned()
+}
+
+/// Like extract_string, but borrows the bytes unless they aren't UTF-8
+fn extract_str(data: &[u8]) -> Cow<'_, str> {
     let end = data.iter().position(|&b| b == 0).unwrap_or(data.len());
-    String::from_utf8_lossy(&data[..end]).to_string()
+    String::from_utf8_lossy(&data[..end])
+}
+/// Handle to the USB transport threads
+pub struct UsbTaskHandle {
+    stop: Arc<AtomicBool>,
+}
+
+impl UsbTaskHandle {
+    /// Ask the I/O thread to close the device and exit. The command thread
+    /// exits on its own once the command channel is dropped.
+    pub fn abort(&self) {
+        self.stop.store(true, Ordering::Relaxed);
+    }
 }
-/// Spawn USB transport task
+
+/// Spawn USB transport threads
+///
+/// USB I/O runs on two OS threads so blocking libusb calls never hold a tokio
+/// worker: the I/O thread owns the device and keeps a read posted at all
+/// times, the command thread writes each command as soon as it arrives.
+/// The I/O thread hands ACKs to the command thread for stats responses.
 pub async fn spawn_usb_task(
     config: UsbConfig,
     event_tx: mpsc::Sender<UsbEvent>,
+    command_rx: mpsc::Receiver<UsbCommand>,
+) -> Result<UsbTaskHandle> {
+    let stop = Arc::new(AtomicBool::new(false));
+    let current: Arc<Mutex<Option<Arc<UsbTransport>>>> = Arc::new(Mutex::new(None));
+    let (ack_tx, ack_rx) = std_mpsc::channel::<()>();
+    
+    {
+        let stop = stop.clone();
+        let current = current.clone();
+        std::thread::Builder::new()
+            .name("usb-io".into())
+            .spawn(move || run_io_thread(config, event_tx, current, ack_tx, stop))
+            .context("Failed to spawn USB I/O thread")?;
+    }
+    
+    std::thread::Builder::new()
+        .name("usb-cmd".into())
+        .spawn(move || run_command_thread(command_rx, current, ack_rx))
+        .context("Failed to spawn USB command thread")?;
+    
+    Ok(UsbTaskHandle { stop })
+}
+
+/// Command thread: write each command to the connected PSP right away
+fn run_command_thread(
     mut command_rx: mpsc::Receiver<UsbCommand>,
-) -> Result<tokio::task::JoinHandle<()>> {
-    let handle = tokio::task::spawn(async move {
-        info!("USB transport task started");
-        
-        let mut connected = false;
-        let mut current_transport: Option<UsbTransport> = None;
-        
-        loop {
-            // Try to find device if not connected
-            if !connected {
-                match UsbTransport::find_device() {
-                    Ok(Some(transport)) => {
-                        info!("PSP DRP USB device connected");
-                        if let Err(e) = event_tx.send(UsbEvent::Connected).await {
-                            error!("Failed to send connected event: {}", e);
-                            break;
-                        }
-                        connected = true;
-                        
-                        // Send ACK
-                        if let Err(e) = transport.send_ack() {
-                            error!("Failed to send ACK: {}", e);
-                        }
-                        
-                        current_transport = Some(transport);
-                    }
-                    Ok(None) => {
-                        // No device found, wait and retry
-                        tokio::time::sleep(config.poll_interval()).await;
-                    }
-                    Err(e) => {
-                        warn!("USB device search error: {}", e);
-                        tokio::time::sleep(config.poll_interval()).await;
-                    }
+    current: Arc<Mutex<Option<Arc<UsbTransport>>>>,
+    acks: std_mpsc::Receiver<()>,
+) {
+    while let Some(cmd) = command_rx.blocking_recv() {
+        let transport = match current.lock().ok().and_then(|t| t.clone()) {
+            Some(transport) => transport,
+            None => {
+                debug!("USB: Not connected, dropping command");
+                continue;
+            }
+        };
+        
+        match cmd {
+            UsbCommand::RequestIcon { game_id } => {
+                debug!("USB: Icon request command for {}", game_id);
+                if let Err(e) = transport.request_icon(&game_id) {
+                    warn!("Failed to request icon: {}", e);
+                }
+            }
+            UsbCommand::SendStatsResponse { last_updated, data } => {
+                info!("USB: Sending stats response ({} bytes)", data.len());
+                if let Err(e) = transport.send_stats_response(last_updated, &data, &acks) {
+                    warn!("Failed to send stats response: {}", e);
                 }
             }
+        }
+    }
+    
+    info!("USB command channel closed");
+}
+
+/// I/O thread: find the device, then read and dispatch packets until it
+/// goes away
+fn run_io_thread(
+    config: UsbConfig,
+    event_tx: mpsc::Sender<UsbEvent>,
+    current: Arc<Mutex<Option<Arc<UsbTransport>>>>,
+    ack_tx: std_mpsc::Sender<()>,
+    stop: Arc<AtomicBool>,
+) {
+    info!("USB transport task started");
+    
+    // CRC32 of every icon received so far (game_id -> crc), kept across reconnects
+    let mut known_icons: std::collections::HashMap<String, u32> = std::collections::HashMap::new();
+    
+    while !stop.load(Ordering::Relaxed) && !event_tx.is_closed() {
+        // Try to find device
+        let transport = match UsbTransport::find_device() {
+            Ok(Some(transport)) => Arc::new(transport),
+            Ok(None) => {
+                // No device found, wait and retry
+                std::thread::sleep(config.poll_interval());
+                continue;
+            }
+            Err(e) => {
+                warn!("USB device search error: {}", e);
+                std::thread::sleep(config.poll_interval());
+                continue;
+            }
+        };
+        
+        info!("PSP DRP USB device connected");
+        if let Err(e) = event_tx.blocking_send(UsbEvent::Connected) {
+            error!("Failed to send connected event: {}", e);
+            break;
+        }
+        
+        // Send ACK
+        if let Err(e) = transport.send_ack() {
+            error!("Failed to send ACK: {}", e);
+        }
+        
+        if let Ok(mut slot) = current.lock() {
+            *slot = Some(transport.clone());
+        }
+        
+        let disconnected = read_loop(&transport, &event_tx, &ack_tx, &stop, &mut known_icons);
+        
+        if let Ok(mut slot) = current.lock() {
+            *slot = None;
+        }
+        transport.close();
+        
+        if disconnected {
+            let _ = event_tx.blocking_send(UsbEvent::Disconnected);
+        }
+        
+        std::thread::sleep(Duration::from_millis(100));
+    }
+    
+    info!("USB transport task ended");
+}
+
+/// Read packets from a connected PSP. Returns true if the device went
+/// away, false if the thread was asked to stop.
+fn read_loop(
+    transport: &UsbTransport,
+    event_tx: &mpsc::Sender<UsbEvent>,
+    ack_tx: &std_mpsc::Sender<()>,
+    stop: &AtomicBool,
+    known_icons: &mut std::collections::HashMap<String, u32>,
+) -> bool {
+    // Sized for a whole frame; v1 packets fit with room to spare
+    let mut buffer = vec![0u8; MAX_FRAME_SIZE];
+    // Icon chunk accumulator: game_id -> (total_size, chunks_received, data)
+    let mut icon_buffer: std::collections::HashMap<String, (usize, u8, Vec<u8>)> = std::collections::HashMap::new();
+    // Frame transfers in progress, one per (packet type, id); rarely more than one
+    let mut frame_buffer: Vec<FrameAssembly> = Vec::new();
+    
+    while !stop.load(Ordering::Relaxed) {
+        let len = match transport.recv_with_timeout(&mut buffer, READ_TIMEOUT) {
+            Ok(Some(len)) if len > 0 => len,
+            Ok(_) => {
+                // Timeout or empty read - device still connected
+                if event_tx.is_closed() {
+                    return false;
+                }
+                continue;
+            }
+            Err(e) => {
+                // Actual error - device disconnected or I/O failure
+                info!("USB read error: {} - reconnecting...", e);
+                return true;
+            }
+        };
+        
+        let packet = &buffer[..len];
+        transport.note_flags(packet);
+        
+        // ACKs belong to a stats response being sent on the command thread
+        if len >= 8 && packet[4] == PacketType::Ack as u8 {
+            let _ = ack_tx.send(());
+            continue;
+        }
+        
+        // v2 frames are reassembled here
+        if let Some(frame) = UsbTransport::try_parse_frame(packet) {
+            let index = match frame_buffer.iter().position(|a| a.is_for(&frame)) {
+                Some(index) => index,
+                // Only the first frame starts a transfer
+                None if frame.offset == 0 => {
+                    frame_buffer.push(FrameAssembly::new(&frame));
+                    frame_buffer.len() - 1
+                }
+                None => continue,
+            };
+            if !frame_buffer[index].push(&frame) {
+                continue;
+            }
+            let assembly = frame_buffer.swap_remove(index);
             
-            // Connected - run read/command loop
-            if let Some(ref transport) = current_transport {
-                let mut buffer = [0u8; MAX_PACKET_SIZE];
-                // Icon chunk accumulator: game_id -> (total_size, chunks_received, data)
-                let mut icon_buffer: std::collections::HashMap<String, (usize, u8, Vec<u8>)> = std::collections::HashMap::new();
+            let event = if assembly.packet_type == PacketType::IconFrame as u8 {
+                let crc = crc32fast::hash(&assembly.data);
+                if crc as u64 != assembly.tag {
+                    warn!("USB: Icon for {} failed CRC check, dropping", assembly.id);
+                    continue;
+                }
+                info!("USB: Received complete icon for {} ({} bytes)", assembly.id, assembly.data.len());
+                known_icons.insert(assembly.id.clone(), crc);
+                UsbEvent::IconData { game_id: assembly.id, data: assembly.data }
+            } else {
+                info!("USB: Stats upload complete ({} bytes)", assembly.data.len());
+                UsbEvent::StatsUploaded { last_updated: assembly.tag, data: assembly.data }
+            };
+            
+            if let Err(e) = event_tx.blocking_send(event) {
+                error!("Failed to send frame event: {}", e);
+                return false;
+            }
+            continue;
+        }
+        
+        // Then check if this is an icon chunk that needs accumulation
+        if let Some(chunk) = UsbTransport::try_parse_icon_chunk(packet) {
+            // Accumulate chunk into a buffer preallocated at the full icon size
+            if !icon_buffer.contains_key(chunk.game_id.as_ref()) {
+                icon_buffer.insert(chunk.game_id.to_string(), (chunk.total_size, 0, vec![0u8; chunk.total_size]));
+            }
+            let entry = match icon_buffer.get_mut(chunk.game_id.as_ref()) {
+                Some(entry) => entry,
+                None => continue,
+            };
+            
+            // Copy chunk data to correct offset
+            if chunk.chunk_offset + chunk.chunk_data.len() <= entry.2.len() {
+                entry.2[chunk.chunk_offset..chunk.chunk_offset + chunk.chunk_data.len()]
+                    .copy_from_slice(chunk.chunk_data);
+                entry.1 += 1;
                 
-                loop {
-                    // Non-blocking check for commands
-                    match command_rx.try_recv() {
-                        Ok(cmd) => {
-                            match cmd {
-                                UsbCommand::RequestIcon { game_id } => {
-                                    debug!("USB: Icon request command for {}", game_id);
-                                    if let Err(e) = transport.request_icon(&game_id) {
-                                        warn!("Failed to request icon: {}", e);
-                                    }
-                                }
-                                UsbCommand::SendStatsResponse { last_updated, json_data } => {
-                                    info!("USB: Sending stats response ({} bytes)", json_data.len());
-                                    if let Err(e) = transport.send_stats_response(last_updated, &json_data) {
-                                        warn!("Failed to send stats response: {}", e);
-                                    }
-                                }
-                            }
-                        }
-                        Err(mpsc::error::TryRecvError::Empty) => {
-                            // No commands, continue
-                        }
-                        Err(mpsc::error::TryRecvError::Disconnected) => {
-                            info!("USB command channel closed");
-                            break;
-                        }
-                    }
+                debug!("USB: Accumulated chunk {}/{} for {}", entry.1, chunk.total_chunks, chunk.game_id);
+                
+                // Check if complete; the buffer moves into the event as is
+                if entry.1 >= chunk.total_chunks {
+                    info!("USB: Received complete icon for {} ({} bytes)", chunk.game_id, entry.0);
+                    let (game_id, (_, _, icon_data)) = match icon_buffer.remove_entry(chunk.game_id.as_ref()) {
+                        Some(done) => done,
+                        None => continue,
+                    };
+                    known_icons.insert(game_id.clone(), crc32fast::hash(&icon_data));
                     
-                    // Try to read from USB
-                    match transport.recv_with_timeout(&mut buffer) {
-                        Ok(Some(len)) if len > 0 => {
-                            debug!("USB: Received {} bytes", len);
-                            
-                            // First check if this is an icon chunk that needs accumulation
-                            if let Some(chunk) = UsbTransport::try_parse_icon_chunk(&buffer[..len]) {
-                                // Accumulate chunk
-                                let entry = icon_buffer.entry(chunk.game_id.clone())
-                                    .or_insert_with(|| (chunk.total_size, 0, vec![0u8; chunk.total_size]));
-                                
-                                // Copy chunk data to correct offset
-                                if chunk.chunk_offset + chunk.chunk_data.len() <= entry.2.len() {
-                                    entry.2[chunk.chunk_offset..chunk.chunk_offset + chunk.chunk_data.len()]
-                                        .copy_from_slice(&chunk.chunk_data);
-                                    entry.1 += 1;
-                                    
-                                    debug!("USB: Accumulated chunk {}/{} for {}", entry.1, chunk.total_chunks, chunk.game_id);
-                                    
-                                    // Check if complete
-                                    if entry.1 >= chunk.total_chunks {
-                                        info!("USB: Received complete icon for {} ({} bytes)", chunk.game_id, entry.0);
-                                        let icon_data = entry.2.clone();
-                                        let game_id = chunk.game_id.clone();
-                                        icon_buffer.remove(&chunk.game_id);
-                                        
-                                        if let Err(e) = event_tx.send(UsbEvent::IconData { game_id, data: icon_data }).await {
-                                            error!("Failed to send icon event: {}", e);
-                                            break;
-                                        }
-                                    }
-                                }
-                                continue; // Don't process as regular packet
-                            }
-                            
-                            if let Ok(Some(event)) = transport.parse_packet(&buffer[..len]) {
-                                // Check if this is GameInfo with has_icon - request icon automatically
-                                if let UsbEvent::GameInfo(ref game_info) = event {
-                                    if game_info.has_icon && !game_info.game_id.is_empty() && game_info.game_id != "XMB" {
-                                        debug!("USB: Game has icon, requesting it...");
-                                        if let Err(e) = transport.request_icon(&game_info.game_id) {
-                                            warn!("Failed to request icon: {}", e);
-                                        }
-                                    }
-                                }
-                                
-                                if let Err(e) = event_tx.send(event).await {
-                                    error!("Failed to send event: {}", e);
-                                    break;
-                                }
-                            }
-                        }
-                        Ok(Some(_)) => {
-                            // Empty read, continue
-                        }
-                        Ok(None) => {
-                            // Timeout - no data available, but device still connected
-                            // Yield to let other async tasks run
-                            tokio::task::yield_now().await;
-                        }
-                        Err(e) => {
-                            // Actual error - device disconnected or I/O failure
-                            info!("USB read error: {} - reconnecting...", e);
-                            let _ = event_tx.send(UsbEvent::Disconnected).await;
-                            connected = false;
-                            break;
-                        }
+                    if let Err(e) = event_tx.blocking_send(UsbEvent::IconData { game_id, data: icon_data }) {
+                        error!("Failed to send icon event: {}", e);
+                        return false;
                     }
                 }
-                
-                if let Some(t) = current_transport.take() {
-                    t.close();
+            }
+            continue; // Don't process as regular packet
+        }
+        
+        if let Ok(Some(event)) = transport.parse_packet(packet) {
+            // Check if this is GameInfo with has_icon - request icon automatically,
+            // unless we already have it (same CRC when the PSP advertises one)
+            if let UsbEvent::GameInfo(ref game_info) = event {
+                let known = known_icons.get(&game_info.game_id);
+                let have_icon = match game_info.icon_crc32 {
+                    Some(crc) => known == Some(&crc),
+                    None => known.is_some(),
+                };
+                if have_icon {
+                    debug!("USB: Icon for {} already received, skipping request", game_info.game_id);
+                } else if game_info.has_icon && !game_info.game_id.is_empty() && game_info.game_id != "XMB" {
+                    debug!("USB: Game has icon, requesting it...");
+                    if let Err(e) = transport.request_icon(&game_info.game_id) {
+                        warn!("Failed to request icon: {}", e);
+                    }
                 }
             }
             
-            tokio::time::sleep(Duration::from_millis(100)).await;
+            if let Err(e) = event_tx.blocking_send(event) {
+                error!("Failed to send event: {}", e);
+                return false;
+            }
         }
-        
-        info!("USB transport task ended");
-    });
+    }
     
-    Ok(handle)
+    false
 }
-
@@ -0,0 +1,263 @@
+/**
+ * Host Benchmarks - runner and baseline check
+ *
+ * Usage: psp_drp_bench [-c baseline] [-w baseline] [-t trace] [suite...]
+ *
+ *   -c FILE  Fail if any counter is above its value in FILE
+ *   -w FILE  Write the counters of this run to FILE
+ *   -t FILE  Also run the network suite over a recorded loss trace
+ *   suite    sfo, usage, net or usb (default: all)
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <ftw.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <pspkernel.h>
+
+#include "bench.h"
+
+#define MAX_COUNTERS 256
+
+typedef struct {
+  char name[48];
+  char key[24];
+  uint64_t value;
+} Counter;
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+} Suite;
+
+static const Suite g_suites[] = {
+    {"sfo", bench_sfo},
+    {"usage", bench_usage},
+    {"net", bench_net},
+    {"usb", bench_usb},
+};
+
+#define SUITE_COUNT (int)(sizeof(g_suites) / sizeof(g_suites[0]))
+
+static Counter g_counters[MAX_COUNTERS];
+static int g_counter_count = 0;
+static char g_scratch[64];
+
+const char *g_bench_trace = NULL;
+
+/* The plugin's logger, silent here */
+void net_log(const char *fmt, ...) { (void)fmt; }
+
+uint64_t bench_clock_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void bench_time(const char *name, uint32_t iterations, uint64_t elapsed_ns) {
+  printf("%-32s %8u ops %12.1f ns/op\n", name, (unsigned int)iterations,
+         iterations > 0 ? (double)elapsed_ns / iterations : 0.0);
+}
+
+void bench_counter(const char *name, const char *key, uint64_t value) {
+  Counter *c;
+
+  printf("  %-30s %14llu\n", key, (unsigned long long)value);
+  if (g_counter_count == MAX_COUNTERS) {
+    bench_fail(name, "too many counters");
+  }
+  c = &g_counters[g_counter_count++];
+  snprintf(c->name, sizeof(c->name), "%s", name);
+  snprintf(c->key, sizeof(c->key), "%s", key);
+  c->value = value;
+}
+
+void bench_fail(const char *name, const char *what) {
+  fprintf(stderr, "FAIL %s: %s\n", name, what);
+  exit(1);
+}
+
+static const Counter *find_counter(const char *name, const char *key) {
+  int i;
+
+  for (i = 0; i < g_counter_count; i++) {
+    if (strcmp(g_counters[i].name, name) == 0 &&
+        strcmp(g_counters[i].key, key) == 0) {
+      return &g_counters[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Compare the counters with a baseline. Counters of suites that did not
+ * run are skipped; a counter above its baseline is a regression.
+ *
+ * @return Number of regressions
+ */
+static int check_baseline(const char *path, const int *ran) {
+  FILE *f = fopen(path, "r");
+  char line[160];
+  int regressions = 0;
+
+  if (f == NULL) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 1;
+  }
+
+  while (fgets(line, sizeof(line), f) != NULL) {
+    char name[48];
+    char key[24];
+    unsigned long long limit;
+    const Counter *c;
+    int s;
+    int suite_ran = 0;
+
+    if (line[0] == '#' ||
+        sscanf(line, "%47s %23s %llu", name, key, &limit) != 3) {
+      continue;
+    }
+    for (s = 0; s < SUITE_COUNT; s++) {
+      size_t len = strlen(g_suites[s].name);
+      if (ran[s] && strncmp(name, g_suites[s].name, len) == 0 &&
+          name[len] == '.') {
+        suite_ran = 1;
+      }
+    }
+    if (!suite_ran) {
+      continue;
+    }
+
+    c = find_counter(name, key);
+    if (c == NULL) {
+      printf("MISSING %s %s\n", name, key);
+      regressions++;
+    } else if (c->value > limit) {
+      printf("REGRESSION %s %s: %llu > %llu\n", name, key,
+             (unsigned long long)c->value, limit);
+      regressions++;
+    } else if (c->value < limit) {
+      printf("improved %s %s: %llu < %llu\n", name, key,
+             (unsigned long long)c->value, limit);
+    }
+  }
+
+  fclose(f);
+  return regressions;
+}
+
+static int write_baseline(const char *path) {
+  FILE *f = fopen(path, "w");
+  int i;
+
+  if (f == NULL) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return -1;
+  }
+  fprintf(f, "# Upper bounds for the psp_drp_bench counters (bench.h)\n"
+             "# Regenerate with: make baseline\n");
+  for (i = 0; i < g_counter_count; i++) {
+    fprintf(f, "%s %s %llu\n", g_counters[i].name, g_counters[i].key,
+            (unsigned long long)g_counters[i].value);
+  }
+  fclose(f);
+  return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag,
+                        struct FTW *ftw) {
+  (void)st;
+  (void)flag;
+  (void)ftw;
+  return remove(path);
+}
+
+/* Fresh Memory Stick for the run */
+static int make_scratch(void) {
+  char path[128];
+
+  snprintf(g_scratch, sizeof(g_scratch), "/tmp/psp_drp_bench.XXXXXX");
+  if (mkdtemp(g_scratch) == NULL) {
+    return -1;
+  }
+  shim_set_root(g_scratch);
+
+  snprintf(path, sizeof(path), "%s/seplugins", g_scratch);
+  mkdir(path, 0777);
+  snprintf(path, sizeof(path), "%s/seplugins/pspdrp", g_scratch);
+  return mkdir(path, 0777);
+}
+
+int main(int argc, char **argv) {
+  const char *check_path = NULL;
+  const char *write_path = NULL;
+  int ran[SUITE_COUNT] = {0};
+  int selected = 0;
+  int regressions = 0;
+  int opt;
+  int i;
+  int s;
+
+  while ((opt = getopt(argc, argv, "c:w:t:")) != -1) {
+    switch (opt) {
+    case 'c':
+      check_path = optarg;
+      break;
+    case 'w':
+      write_path = optarg;
+      break;
+    case 't':
+      g_bench_trace = optarg;
+      break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-c baseline] [-w baseline] [-t trace] [suite...]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  for (i = optind; i < argc; i++) {
+    for (s = 0; s < SUITE_COUNT; s++) {
+      if (strcmp(argv[i], g_suites[s].name) == 0) {
+        ran[s] = 1;
+        selected = 1;
+      }
+    }
+  }
+  if (!selected) {
+    for (s = 0; s < SUITE_COUNT; s++) {
+      ran[s] = 1;
+    }
+  }
+
+  if (make_scratch() < 0) {
+    fprintf(stderr, "cannot create scratch directory\n");
+    return 1;
+  }
+
+  for (s = 0; s < SUITE_COUNT; s++) {
+    if (ran[s]) {
+      g_suites[s].run();
+    }
+  }
+
+  nftw(g_scratch, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+
+  if (write_path != NULL && write_baseline(write_path) < 0) {
+    return 1;
+  }
+  if (check_path != NULL) {
+    regressions = check_baseline(check_path, ran);
+    printf("%d regression(s) against %s\n", regressions, check_path);
+  }
+  return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * Host Benchmarks
+ *
+ * Runs the plugin's SFO parser, usage tracker and packet paths on the host
+ * against the sce* shim. Each benchmark reports host time per operation
+ * and a set of counters (packets, bytes, file writes, simulated link time).
+ * The counters only depend on the code and the seeded inputs, so they are
+ * what baseline.txt pins down; host time is printed for comparing runs on
+ * one machine.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+/* Loss trace for the network benchmarks ("0"/"1" per packet), or NULL */
+extern const char *g_bench_trace;
+
+/* Monotonic host time in nanoseconds */
+uint64_t bench_clock_ns(void);
+
+/**
+ * Report the host time of one benchmark
+ *
+ * @param name Benchmark name, "<suite>.<case>"
+ * @param iterations Operations timed
+ * @param elapsed_ns Time all of them took
+ */
+void bench_time(const char *name, uint32_t iterations, uint64_t elapsed_ns);
+
+/**
+ * Report a counter of a benchmark, checked against the baseline. Counters
+ * are per operation unless the key says otherwise.
+ */
+void bench_counter(const char *name, const char *key, uint64_t value);
+
+/* Abort the run, the code under test misbehaved */
+void bench_fail(const char *name, const char *what);
+
+/* Suites */
+void bench_sfo(void);
+void bench_usage(void);
+void bench_net(void);
+void bench_usb(void);
+
+#endif /* BENCH_H */
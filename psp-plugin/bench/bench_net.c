@@ -0,0 +1,402 @@
+/**
+ * Network benchmarks: reliable chunked transfers (icons, stats uploads)
+ * against a simulated desktop over a lossy link
+ *
+ * network.c is compiled into this file so the benchmark can point its
+ * socket at the simulated desktop without the WiFi bring-up. The desktop
+ * answers each MSG_TRANSFER_POLL with a MSG_TRANSFER_STATUS after one
+ * round-trip, and sends one MSG_ICON_HAVE in the middle of every transfer
+ * that network_poll_message must still hand out afterwards. Packets in both
+ * directions are dropped by a seeded generator or by a loss trace (-t).
+ */
+
+#include "../net/src/network.c"
+
+#include <stdlib.h>
+
+#include "bench.h"
+
+#define SIM_RTT_US (20 * 1000)
+#define SIM_SOCKET 3
+
+/* Longest loss trace read */
+#define TRACE_MAX 65536
+
+/* Largest transfer the desktop side tracks, past TRANSFER_MAX_CHUNKS for
+ * the unpaced sends */
+#define SIM_MAX_CHUNKS 512
+
+/* Replies in flight at once */
+#define SIM_REPLIES 4
+
+typedef struct {
+  uint8_t data[sizeof(PacketHeader) + sizeof(TransferStatusPacket)];
+  int len;
+  SceUInt64 at;
+} SimReply;
+
+typedef struct {
+  /* Loss */
+  uint32_t loss_permille;
+  uint32_t rng;
+  const char *trace;
+  uint32_t trace_len;
+  uint32_t trace_pos;
+
+  /* Transfer state on the desktop side */
+  uint8_t have[SIM_MAX_CHUNKS / 8];
+  uint16_t received;
+
+  /* Replies in flight, delivered in order */
+  SimReply replies[SIM_REPLIES];
+  int reply_count;
+  int have_tried; /* MSG_ICON_HAVE of this transfer went out */
+  int have_sent;  /* ... and was not lost */
+} SimDesktop;
+
+static SimDesktop g_sim;
+static char g_trace[TRACE_MAX];
+
+/* network.c's config write after a discovery, unused here */
+int config_save(const PluginConfig *config) {
+  (void)config;
+  return 0;
+}
+
+/* xorshift32, so a loss rate gives the same drops on every host */
+static int sim_drop(void) {
+  if (g_sim.trace != NULL) {
+    char c = g_sim.trace[g_sim.trace_pos];
+    g_sim.trace_pos = (g_sim.trace_pos + 1) % g_sim.trace_len;
+    return c == '1';
+  }
+
+  g_sim.rng ^= g_sim.rng << 13;
+  g_sim.rng ^= g_sim.rng >> 17;
+  g_sim.rng ^= g_sim.rng << 5;
+  return g_sim.rng % 1000 < g_sim.loss_permille;
+}
+
+static int sim_has(uint16_t index) {
+  return (g_sim.have[index >> 3] >> (index & 7)) & 1;
+}
+
+static void sim_mark(uint16_t index) {
+  if (index < SIM_MAX_CHUNKS && !sim_has(index)) {
+    g_sim.have[index >> 3] |= (uint8_t)(1 << (index & 7));
+    g_sim.received++;
+  }
+}
+
+/**
+ * Queue a reply for delivery after one round-trip, unless it is lost
+ *
+ * @return 1 if it will arrive
+ */
+static int sim_reply(uint8_t type, const void *payload, size_t len) {
+  SimReply *reply;
+  PacketHeader header;
+
+  if (sim_drop() || g_sim.reply_count == SIM_REPLIES) {
+    return 0;
+  }
+
+  reply = &g_sim.replies[g_sim.reply_count++];
+  memcpy(header.magic, PROTOCOL_MAGIC, 4);
+  header.type = type;
+  memcpy(reply->data, &header, sizeof(header));
+  memcpy(reply->data + sizeof(header), payload, len);
+  reply->len = (int)(sizeof(header) + len);
+  reply->at = shim_now_us() + SIM_RTT_US;
+  return 1;
+}
+
+static void sim_answer_poll(const uint8_t *payload) {
+  TransferPollPacket poll;
+  TransferStatusPacket status;
+  uint16_t i;
+
+  memcpy(&poll, payload, sizeof(poll));
+
+  /* Something unrelated arrives while the PSP waits for the first status */
+  if (!g_sim.have_tried) {
+    IconHavePacket have;
+
+    memset(&have, 0, sizeof(have));
+    memcpy(have.game_id, "ULUS10041", 9);
+    g_sim.have_sent = sim_reply(MSG_ICON_HAVE, &have, sizeof(have));
+    g_sim.have_tried = 1;
+  }
+
+  memset(&status, 0, sizeof(status));
+  status.kind = poll.kind;
+  memcpy(status.id, poll.id, sizeof(status.id));
+  status.total_chunks = poll.total_chunks;
+  status.received_chunks = g_sim.received;
+  for (i = 0; i < poll.total_chunks && i < TRANSFER_MAX_CHUNKS; i++) {
+    if (!sim_has(i)) {
+      status.missing[i >> 3] |= (uint8_t)(1 << (i & 7));
+    }
+  }
+  sim_reply(MSG_TRANSFER_STATUS, &status, sizeof(status));
+}
+
+int sceNetInetSendto(int s, const void *buf, size_t len, int flags,
+                     const struct sockaddr *to, socklen_t tolen) {
+  const uint8_t *packet = (const uint8_t *)buf;
+  const uint8_t *payload = packet + sizeof(PacketHeader);
+  size_t payload_len = len - sizeof(PacketHeader);
+
+  (void)s;
+  (void)flags;
+  (void)to;
+  (void)tolen;
+
+  if (sim_drop() || len < sizeof(PacketHeader)) {
+    return (int)len;
+  }
+
+  switch (packet[4]) {
+  case MSG_ICON_CHUNK: {
+    IconChunkPacket chunk;
+    memcpy(&chunk, payload,
+           payload_len < sizeof(chunk) ? payload_len : sizeof(chunk));
+    sim_mark(chunk.chunk_index);
+    break;
+  }
+  case MSG_STATS_UPLOAD: {
+    StatsUploadPacket chunk;
+    memcpy(&chunk, payload,
+           payload_len < sizeof(chunk) ? payload_len : sizeof(chunk));
+    sim_mark(chunk.chunk_index);
+    break;
+  }
+  case MSG_TRANSFER_POLL:
+    if (len >= sizeof(PacketHeader) + sizeof(TransferPollPacket)) {
+      sim_answer_poll(payload);
+    }
+    break;
+  default:
+    break;
+  }
+
+  return (int)len;
+}
+
+int sceNetInetRecvfrom(int s, void *buf, size_t len, int flags,
+                       struct sockaddr *from, socklen_t *fromlen) {
+  SimReply reply;
+
+  (void)s;
+  (void)flags;
+
+  if (g_sim.reply_count == 0 || shim_now_us() < g_sim.replies[0].at ||
+      len < (size_t)g_sim.replies[0].len) {
+    return -1;
+  }
+
+  reply = g_sim.replies[0];
+  g_sim.reply_count--;
+  memmove(&g_sim.replies[0], &g_sim.replies[1],
+          (size_t)g_sim.reply_count * sizeof(SimReply));
+
+  memcpy(buf, reply.data, (size_t)reply.len);
+  if (from != NULL && fromlen != NULL && *fromlen >= sizeof(g_desktop_addr)) {
+    memcpy(from, &g_desktop_addr, sizeof(g_desktop_addr));
+    *fromlen = sizeof(g_desktop_addr);
+  }
+  return reply.len;
+}
+
+/* Sleeps until the next reply is due, or for the whole timeout */
+int sceNetInetSelect(int n, fd_set *readfds, fd_set *writefds,
+                     fd_set *exceptfds, struct timeval *timeout) {
+  SceUInt64 until;
+
+  (void)n;
+  (void)writefds;
+  (void)exceptfds;
+
+  if (timeout == NULL) {
+    return -1;
+  }
+  until = shim_now_us() + (SceUInt64)timeout->tv_sec * 1000000 +
+          (SceUInt64)timeout->tv_usec;
+
+  if (g_sim.reply_count > 0 && g_sim.replies[0].at <= until) {
+    if (g_sim.replies[0].at > shim_now_us()) {
+      shim_advance_us(g_sim.replies[0].at - shim_now_us());
+    }
+    return 1;
+  }
+
+  shim_advance_us(until - shim_now_us());
+  if (readfds != NULL) {
+    FD_ZERO(readfds);
+  }
+  return 0;
+}
+
+static void sim_connect(void) {
+  g_socket = SIM_SOCKET;
+  memset(&g_desktop_addr, 0, sizeof(g_desktop_addr));
+  g_desktop_addr.sin_family = AF_INET;
+  g_desktop_addr.sin_port = htons(DEFAULT_PORT);
+  g_desktop_addr.sin_addr.s_addr = htonl(0x7F000001);
+}
+
+/* Start a case with a fresh RTT estimate and metrics window */
+static void sim_reset(uint32_t loss_permille, const char *trace,
+                      uint32_t trace_len) {
+  HeartbeatMetrics discard;
+
+  memset(&g_sim, 0, sizeof(g_sim));
+  g_sim.loss_permille = loss_permille;
+  g_sim.rng = 0x2545F491;
+  g_sim.trace = trace;
+  g_sim.trace_len = trace_len;
+  g_transfer_srtt_us = TRANSFER_RTT_INIT_US;
+  drp_metrics_report(&discard, NULL, shim_now_us());
+}
+
+static void sim_new_transfer(void) {
+  memset(g_sim.have, 0, sizeof(g_sim.have));
+  g_sim.received = 0;
+  g_sim.reply_count = 0;
+  g_sim.have_tried = 0;
+  g_sim.have_sent = 0;
+}
+
+/* Hand out what the transfer queued; 1 if the MSG_ICON_HAVE was among it */
+static int sim_drain(void) {
+  char game_id[10];
+  int have = 0;
+  int msg;
+
+  while ((msg = network_poll_message(game_id)) != 0) {
+    if (msg == 4 && strcmp(game_id, "ULUS10041") == 0) {
+      have = 1;
+    }
+  }
+  return have;
+}
+
+typedef int (*TransferFn)(const uint8_t *data, uint32_t size);
+
+static int send_icon(const uint8_t *data, uint32_t size) {
+  return network_send_icon("ULUS10041", data, size);
+}
+
+static int send_stats(const uint8_t *data, uint32_t size) {
+  return network_send_stats_upload((const char *)data, size, 1700000000ULL);
+}
+
+/**
+ * Run one transfer case and report what it cost on the wire. With
+ * must_complete set, any transfer that fails or loses chunks fails the run,
+ * whatever the baseline says.
+ */
+static void transfer_case(const char *name, TransferFn send, uint32_t size,
+                          uint32_t chunk_size, uint32_t loss_permille,
+                          const char *trace, uint32_t trace_len,
+                          uint32_t iters, int must_complete) {
+  static uint8_t data[SIM_MAX_CHUNKS * ICON_CHUNK_SIZE];
+  HeartbeatMetrics metrics;
+  uint32_t chunks = (size + chunk_size - 1) / chunk_size;
+  uint32_t failed = 0;
+  uint32_t incomplete = 0;
+  uint32_t handed_out = 0;
+  uint32_t have_sent = 0;
+  SceUInt64 link_start;
+  uint64_t start;
+  uint32_t i;
+
+  for (i = 0; i < size; i++) {
+    data[i] = (uint8_t)(i * 31 + (i >> 8));
+  }
+
+  sim_reset(loss_permille, trace, trace_len);
+  link_start = shim_now_us();
+  start = bench_clock_ns();
+  for (i = 0; i < iters; i++) {
+    sim_new_transfer();
+    if (send(data, size) < 0) {
+      failed++;
+    } else if (g_sim.received != chunks) {
+      incomplete++; /* Best-effort fallback lost chunks */
+    }
+    have_sent += g_sim.have_sent;
+    handed_out += (uint32_t)sim_drain();
+  }
+  bench_time(name, iters, bench_clock_ns() - start);
+
+  drp_metrics_report(&metrics, NULL, shim_now_us());
+  bench_counter(name, "packets", metrics.tx_packets / iters);
+  bench_counter(name, "bytes", metrics.tx_bytes / iters);
+  bench_counter(name, "retransmits_total", metrics.retransmits);
+  bench_counter(name, "link_ms", (shim_now_us() - link_start) / 1000 / iters);
+  bench_counter(name, "failed_total", failed);
+  bench_counter(name, "incomplete_total", incomplete);
+  bench_counter(name, "lost_messages_total", have_sent - handed_out);
+
+  if (must_complete && (failed > 0 || incomplete > 0)) {
+    bench_fail(name, "transfers failed or arrived incomplete");
+  }
+}
+
+/* One digit per packet, 1 = dropped; lines starting with '#' are comments */
+static uint32_t load_trace(void) {
+  FILE *f = fopen(g_bench_trace, "r");
+  char line[256];
+  uint32_t len = 0;
+  char *p;
+
+  if (f == NULL) {
+    bench_fail("net.trace", "cannot read the loss trace");
+  }
+  while (len < TRACE_MAX && fgets(line, sizeof(line), f) != NULL) {
+    if (line[0] == '#') {
+      continue;
+    }
+    for (p = line; *p != '\0' && len < TRACE_MAX; p++) {
+      if (*p == '0' || *p == '1') {
+        g_trace[len++] = *p;
+      }
+    }
+  }
+  fclose(f);
+
+  if (len == 0) {
+    bench_fail("net.trace", "loss trace is empty");
+  }
+  return len;
+}
+
+void bench_net(void) {
+  sim_connect();
+
+  transfer_case("net.icon.20k.loss0", send_icon, 20 * 1024, ICON_CHUNK_SIZE,
+                0, NULL, 0, 200, 1);
+  transfer_case("net.icon.20k.loss5", send_icon, 20 * 1024, ICON_CHUNK_SIZE,
+                50, NULL, 0, 200, 1);
+  /* Stress: at 20% each way a poll and its status both get through only
+   * 64% of the time, so now and then TRANSFER_MAX_TIMEOUTS polls in a row
+   * go unanswered and the transfer gives up. failed_total is expected to be
+   * non-zero here; the baseline keeps it from growing. */
+  transfer_case("net.icon.20k.loss20", send_icon, 20 * 1024, ICON_CHUNK_SIZE,
+                200, NULL, 0, 200, 0);
+  transfer_case("net.icon.128k.loss5", send_icon, 128 * 1024,
+                ICON_CHUNK_SIZE, 50, NULL, 0, 50, 1);
+  transfer_case("net.stats_upload.16k.loss5", send_stats, 16 * 1024,
+                STATS_CHUNK_SIZE, 50, NULL, 0, 200, 1);
+  /* Past TRANSFER_MAX_CHUNKS: one unpaced pass */
+  transfer_case("net.stats_upload.300k.loss0", send_stats, 300 * 1024,
+                STATS_CHUNK_SIZE, 0, NULL, 0, 20, 1);
+
+  /* A recorded link, e.g. traces/wifi_burst.txt */
+  if (g_bench_trace != NULL) {
+    uint32_t len = load_trace();
+    transfer_case("net.trace.icon.20k", send_icon, 20 * 1024,
+                  ICON_CHUNK_SIZE, 0, g_trace, len, 200, 1);
+  }
+}
@@ -0,0 +1,192 @@
+/**
+ * SFO parser benchmarks over synthetic PARAM.SFO files
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <pspiofilemgr.h>
+#include <pspkernel.h>
+
+#include "bench.h"
+#include "sfo.h"
+
+#define SFO_BENCH_PATH "ms0:/PSP/GAME/BENCH00001/PARAM.SFO"
+#define SFO_TITLE "Benchmark Portable: Extended Edition"
+
+/* Keys of a typical UMD game, in the sorted order real SFOs use */
+static const char *const g_game_keys[] = {
+    "APP_VER",      "BOOTABLE",   "CATEGORY",     "DISC_ID",
+    "DISC_NUMBER",  "DISC_TOTAL", "DISC_VERSION", "PARENTAL_LEVEL",
+    "PSP_SYSTEM_VER", "REGION",   "TITLE",
+};
+
+#define GAME_KEY_COUNT (int)(sizeof(g_game_keys) / sizeof(g_game_keys[0]))
+
+static void put32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static const char *key_value(const char *key) {
+  if (strcmp(key, "TITLE") == 0) {
+    return SFO_TITLE;
+  }
+  if (strcmp(key, "DISC_ID") == 0) {
+    return "ULUS10041";
+  }
+  if (strcmp(key, "CATEGORY") == 0) {
+    return "UG";
+  }
+  return "01.00";
+}
+
+/**
+ * Build a PARAM.SFO with the game keys and `extra` additional string keys
+ * in front of them (homebrew and updates carry many more)
+ *
+ * @return SFO size, 0 if it does not fit
+ */
+static uint32_t build_sfo(uint8_t *buf, uint32_t size, int extra) {
+  int count = GAME_KEY_COUNT + extra;
+  uint32_t entries = 20;
+  uint32_t key_offset = entries + 16 * (uint32_t)count;
+  uint32_t key_len = 0;
+  uint32_t val_len = 0;
+  uint32_t val_offset;
+  char key[24];
+  int i;
+
+  /* Key table size first, the value table starts after it (aligned) */
+  for (i = 0; i < count; i++) {
+    if (i < extra) {
+      snprintf(key, sizeof(key), "ADDITIONAL_%02d", i);
+    } else {
+      snprintf(key, sizeof(key), "%s", g_game_keys[i - extra]);
+    }
+    key_len += (uint32_t)strlen(key) + 1;
+  }
+  val_offset = (key_offset + key_len + 3) & ~3u;
+  if (val_offset > size) {
+    return 0;
+  }
+
+  memset(buf, 0, size);
+  put32(buf, 0x46535000);
+  put32(buf + 4, 0x00000101);
+  put32(buf + 8, key_offset);
+  put32(buf + 12, val_offset);
+  put32(buf + 16, (uint32_t)count);
+
+  key_len = 0;
+  for (i = 0; i < count; i++) {
+    uint8_t *entry = buf + entries + 16 * i;
+    const char *value;
+    uint32_t length;
+    uint32_t slot;
+
+    if (i < extra) {
+      snprintf(key, sizeof(key), "ADDITIONAL_%02d", i);
+    } else {
+      snprintf(key, sizeof(key), "%s", g_game_keys[i - extra]);
+    }
+    value = key_value(key);
+    length = (uint32_t)strlen(value) + 1;
+    slot = (length + 3) & ~3u;
+    if (val_offset + val_len + slot > size) {
+      return 0;
+    }
+
+    entry[0] = (uint8_t)key_len;
+    entry[1] = (uint8_t)(key_len >> 8);
+    entry[2] = 0x04;
+    entry[3] = 0x02; /* UTF-8 string */
+    put32(entry + 4, length);
+    put32(entry + 8, slot);
+    put32(entry + 12, val_len);
+
+    memcpy(buf + key_offset + key_len, key, strlen(key) + 1);
+    memcpy(buf + val_offset + val_len, value, length);
+    key_len += (uint32_t)strlen(key) + 1;
+    val_len += slot;
+  }
+
+  return val_offset + val_len;
+}
+
+static void check_parsed(const char *name, const SfoData *data) {
+  if (strcmp(data->title, SFO_TITLE) != 0 ||
+      strcmp(data->disc_id, "ULUS10041") != 0 ||
+      data->category != (('U' << 8) | 'G')) {
+    bench_fail(name, "parsed the wrong values");
+  }
+}
+
+static void parse_buffer_case(const char *name, int extra, uint32_t iters) {
+  static uint8_t sfo[4096];
+  SfoData data;
+  uint32_t size = build_sfo(sfo, sizeof(sfo), extra);
+  uint64_t start;
+  uint32_t i;
+
+  if (size == 0) {
+    bench_fail(name, "SFO does not fit");
+  }
+
+  start = bench_clock_ns();
+  for (i = 0; i < iters; i++) {
+    if (sfo_parse_buffer(sfo, size, &data) != 0) {
+      bench_fail(name, "parse failed");
+    }
+  }
+  bench_time(name, iters, bench_clock_ns() - start);
+  check_parsed(name, &data);
+  bench_counter(name, "sfo_bytes", size);
+}
+
+static void parse_file_case(void) {
+  const char *name = "sfo.parse_file";
+  const uint32_t iters = 20000;
+  uint8_t sfo[1024];
+  char path[512];
+  SfoData data;
+  uint32_t size = build_sfo(sfo, sizeof(sfo), 0);
+  uint64_t start;
+  uint32_t i;
+  FILE *f;
+
+  /* Real directory layout, created on the host side */
+  shim_host_path("ms0:/PSP", path, sizeof(path));
+  mkdir(path, 0777);
+  shim_host_path("ms0:/PSP/GAME", path, sizeof(path));
+  mkdir(path, 0777);
+  shim_host_path("ms0:/PSP/GAME/BENCH00001", path, sizeof(path));
+  mkdir(path, 0777);
+  shim_host_path(SFO_BENCH_PATH, path, sizeof(path));
+  f = fopen(path, "wb");
+  if (f == NULL || fwrite(sfo, 1, size, f) != size) {
+    bench_fail(name, "cannot write the SFO");
+  }
+  fclose(f);
+
+  shim_io_reset();
+  start = bench_clock_ns();
+  for (i = 0; i < iters; i++) {
+    if (sfo_parse_file(SFO_BENCH_PATH, &data) != 0) {
+      bench_fail(name, "parse failed");
+    }
+  }
+  bench_time(name, iters, bench_clock_ns() - start);
+  check_parsed(name, &data);
+  bench_counter(name, "io_opens", shim_io_stats()->opens / iters);
+  bench_counter(name, "io_reads", shim_io_stats()->reads / iters);
+}
+
+void bench_sfo(void) {
+  parse_buffer_case("sfo.parse_buffer.game", 0, 500000);
+  parse_buffer_case("sfo.parse_buffer.large", 48, 200000);
+  parse_file_case();
+}
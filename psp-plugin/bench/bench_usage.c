@@ -0,0 +1,262 @@
+/**
+ * Usage tracker benchmarks: first-run JSON import, delta merges, sessions,
+ * delta building and JSON export over a large library
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <pspiofilemgr.h>
+#include <pspkernel.h>
+
+#include "bench.h"
+#include "discord_rpc.h"
+#include "usage_tracker.h"
+
+/* Games in the legacy usage_log.json (it must fit the 8 KB import buffer) */
+#define LEGACY_GAMES 48
+
+/* Games the desktop sends, on top of the legacy ones */
+#define REMOTE_GAMES 512
+
+/* Times the desktop resends every game with higher totals */
+#define MERGE_ROUNDS 4
+
+#define SESSION_ITERS 2000
+#define DELTA_ITERS 2000
+#define SERIALIZE_ITERS 200
+#define EXPORT_ITERS 50
+
+#define DELTA_SIZE                                                             \
+  (sizeof(StatsDeltaHeader) + STATS_DELTA_MAX_RECORDS * sizeof(StatsDeltaRecord))
+
+static char g_json[256 * 1024];
+static char g_delta[DELTA_SIZE];
+
+static void counters_io(const char *name, uint32_t iters) {
+  const ShimIoStats *io = shim_io_stats();
+
+  bench_counter(name, "io_writes", io->writes / iters);
+  bench_counter(name, "io_bytes_written", io->bytes_written / iters);
+}
+
+static void write_legacy_json(void) {
+  char path[512];
+  size_t len = 0;
+  FILE *f;
+  int i;
+
+  len += (size_t)snprintf(g_json + len, sizeof(g_json) - len,
+                          "{\"psps\":{\"PSP\":{\"psp_name\":\"PSP\","
+                          "\"games\":{");
+  for (i = 0; i < LEGACY_GAMES; i++) {
+    len += (size_t)snprintf(g_json + len, sizeof(g_json) - len,
+                            "%s\"LEGC%05d:3\":{\"game_id\":\"LEGC%05d\","
+                            "\"title\":\"Legacy Game %d\","
+                            "\"total_seconds\":%d,\"session_count\":3}",
+                            i == 0 ? "" : ",", i, i, i, 600 * (i + 1));
+  }
+  len += (size_t)snprintf(g_json + len, sizeof(g_json) - len,
+                          "}}},\"psp_sync_version\":0,\"peer_version\":0}");
+
+  if (len >= 8192) {
+    bench_fail("usage.import_json", "legacy JSON larger than the import");
+  }
+  shim_host_path(USAGE_JSON_PATH, path, sizeof(path));
+  f = fopen(path, "wb");
+  if (f == NULL || fwrite(g_json, 1, len, f) != len) {
+    bench_fail("usage.import_json", "cannot write usage_log.json");
+  }
+  fclose(f);
+}
+
+/* First run: no store yet, so usage_init() imports the JSON and writes the
+ * whole store. Runs once per process. */
+static void import_case(void) {
+  const char *name = "usage.import_json";
+  uint64_t start;
+
+  write_legacy_json();
+  shim_io_reset();
+  start = bench_clock_ns();
+  usage_init();
+  bench_time(name, 1, bench_clock_ns() - start);
+
+  if (usage_get_data()->total_games != LEGACY_GAMES) {
+    bench_fail(name, "imported the wrong number of games");
+  }
+  bench_counter(name, "io_reads", shim_io_stats()->reads);
+  counters_io(name, 1);
+}
+
+/* One StatsDelta the way the desktop builds it */
+static size_t build_remote_delta(uint32_t first, uint32_t count,
+                                 uint32_t round, uint32_t version) {
+  StatsDeltaHeader header;
+  StatsDeltaRecord record;
+  size_t len = sizeof(header);
+  uint32_t i;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, STATS_DELTA_MAGIC, 4);
+  header.count = (uint16_t)count;
+  header.version = version;
+
+  for (i = first; i < first + count; i++) {
+    memset(&record, 0, sizeof(record));
+    snprintf(record.game_id, sizeof(record.game_id), "BNCH%05u",
+             (unsigned int)i);
+    snprintf(record.title, sizeof(record.title), "Benchmark Game %u",
+             (unsigned int)i);
+    record.total_seconds = 3600ULL * (i + 1) + round * 60;
+    record.session_count = i % 50 + 1 + round;
+    record.version = version;
+    memcpy(g_delta + len, &record, sizeof(record));
+    len += sizeof(record);
+  }
+
+  memcpy(g_delta, &header, sizeof(header));
+  return len;
+}
+
+static void merge_case(void) {
+  const char *name = "usage.merge_remote";
+  uint32_t merges = 0;
+  uint64_t elapsed = 0;
+  uint32_t round;
+  uint32_t first;
+
+  shim_io_reset();
+  for (round = 0; round < MERGE_ROUNDS; round++) {
+    for (first = 0; first < REMOTE_GAMES; first += STATS_DELTA_MAX_RECORDS) {
+      size_t len = build_remote_delta(first, STATS_DELTA_MAX_RECORDS, round,
+                                      ++merges);
+      uint64_t start = bench_clock_ns();
+
+      if (usage_merge_remote(g_delta, len) != STATS_DELTA_MAX_RECORDS) {
+        bench_fail(name, "delta not merged");
+      }
+      elapsed += bench_clock_ns() - start;
+    }
+  }
+  bench_time(name, merges, elapsed);
+
+  if (usage_get_data()->total_games != LEGACY_GAMES + REMOTE_GAMES) {
+    bench_fail(name, "wrong number of games after merging");
+  }
+  counters_io(name, merges);
+}
+
+/* Half-hour sessions across the whole library */
+static void session_case(void) {
+  const char *name = "usage.session";
+  uint32_t games = usage_get_data()->total_games;
+  uint64_t elapsed = 0;
+  uint32_t i;
+
+  shim_io_reset();
+  for (i = 0; i < SESSION_ITERS; i++) {
+    const GameUsage *game = usage_get_game(i % games);
+    uint64_t start;
+
+    usage_start_session(game->game_id, game->title);
+    shim_advance_us(30ULL * 60 * 1000000);
+    start = bench_clock_ns();
+    usage_end_session();
+    elapsed += bench_clock_ns() - start;
+  }
+  bench_time(name, SESSION_ITERS, elapsed);
+  counters_io(name, SESSION_ITERS);
+}
+
+/* Every game changed since the last ack: the delta is capped and the cut
+ * is searched for */
+static void delta_case(void) {
+  const char *name = "usage.build_delta";
+  uint64_t start;
+  int len = 0;
+  uint32_t i;
+
+  start = bench_clock_ns();
+  for (i = 0; i < DELTA_ITERS; i++) {
+    len = usage_build_delta(g_delta, sizeof(g_delta));
+  }
+  bench_time(name, DELTA_ITERS, bench_clock_ns() - start);
+
+  if (len != (int)DELTA_SIZE) {
+    bench_fail(name, "delta not full");
+  }
+  bench_counter(name, "delta_bytes", (uint64_t)len);
+}
+
+static void serialize_case(void) {
+  const char *name = "usage.serialize_json";
+  uint64_t start;
+  int len = 0;
+  uint32_t i;
+
+  start = bench_clock_ns();
+  for (i = 0; i < SERIALIZE_ITERS; i++) {
+    len = usage_serialize_json(g_json, sizeof(g_json));
+  }
+  bench_time(name, SERIALIZE_ITERS, bench_clock_ns() - start);
+
+  if (len <= 0 || (size_t)len >= sizeof(g_json)) {
+    bench_fail(name, "serialization failed");
+  }
+  bench_counter(name, "json_bytes", (uint64_t)len);
+}
+
+/* The legacy upload's 4 KB buffer holds a fraction of the library: the
+ * JSON must stop at a whole entry and stay inside the buffer */
+static void serialize_small_case(void) {
+  const char *name = "usage.serialize_json.4k";
+  static char buffer[4096 + 16];
+  uint64_t start;
+  int len = 0;
+  uint32_t i;
+
+  memset(buffer, 0x5A, sizeof(buffer));
+  start = bench_clock_ns();
+  for (i = 0; i < SERIALIZE_ITERS; i++) {
+    len = usage_serialize_json(buffer, 4096);
+  }
+  bench_time(name, SERIALIZE_ITERS, bench_clock_ns() - start);
+
+  if (len <= 0 || len >= 4096 || buffer[len] != '\0' ||
+      strcmp(buffer + len - 3, "}]}") != 0) {
+    bench_fail(name, "JSON not closed inside the buffer");
+  }
+  for (i = 4096; i < sizeof(buffer); i++) {
+    if (buffer[i] != 0x5A) {
+      bench_fail(name, "wrote past the buffer");
+    }
+  }
+  bench_counter(name, "json_bytes", (uint64_t)len);
+}
+
+static void export_case(void) {
+  const char *name = "usage.export_json";
+  uint64_t start;
+  uint32_t i;
+
+  shim_io_reset();
+  start = bench_clock_ns();
+  for (i = 0; i < EXPORT_ITERS; i++) {
+    if (usage_export_json() != 0) {
+      bench_fail(name, "export failed");
+    }
+  }
+  bench_time(name, EXPORT_ITERS, bench_clock_ns() - start);
+  counters_io(name, EXPORT_ITERS);
+}
+
+void bench_usage(void) {
+  import_case();
+  merge_case();
+  session_case();
+  delta_case();
+  serialize_case();
+  serialize_small_case();
+  export_case();
+}
@@ -0,0 +1,173 @@
+/**
+ * USB protocol benchmarks: v2 frame and v1 chunk sends and stats response
+ * reassembly over a fake bulk driver that counts what crosses the cable
+ */
+
+#include <string.h>
+
+#include <pspkernel.h>
+
+#include "bench.h"
+#include "usb_driver.h"
+#include "usb_protocol.h"
+
+/* Frames queued for usb_driver_receive */
+#define INBOX_FRAMES 8
+
+static struct {
+  uint32_t frames;
+  uint64_t bytes;
+} g_sent;
+
+static struct {
+  uint8_t data[INBOX_FRAMES][USB_MAX_FRAME];
+  int len[INBOX_FRAMES];
+  int head;
+  int count;
+} g_inbox;
+
+/* What usb_driver_peer_frames reports (0 = v1 desktop) */
+static int g_peer_frames = 1;
+
+int g_logging_enabled = 0;
+
+void usb_log_str(const char *msg) { (void)msg; }
+
+void usb_log_hex(const char *prefix, int val) {
+  (void)prefix;
+  (void)val;
+}
+
+int usb_driver_is_connected(void) { return 1; }
+
+int usb_driver_peer_frames(void) { return g_peer_frames; }
+
+int usb_driver_send(const void *data, int len) {
+  (void)data;
+  g_sent.frames++;
+  g_sent.bytes += (uint64_t)len;
+  return len;
+}
+
+int usb_driver_receive(void *data, int len, int timeout_ms) {
+  int n;
+
+  (void)timeout_ms;
+  if (g_inbox.count == 0) {
+    return 0;
+  }
+
+  n = g_inbox.len[g_inbox.head];
+  if (n > len) {
+    n = len;
+  }
+  memcpy(data, g_inbox.data[g_inbox.head], (size_t)n);
+  g_inbox.head = (g_inbox.head + 1) % INBOX_FRAMES;
+  g_inbox.count--;
+  return n;
+}
+
+/* Queue a stats response the way the desktop frames it */
+static void queue_stats_response(const uint8_t *json, uint32_t size,
+                                 uint64_t tag) {
+  uint32_t offset;
+
+  for (offset = 0; offset < size; offset += USB_FRAME_DATA_SIZE) {
+    int slot = (g_inbox.head + g_inbox.count) % INBOX_FRAMES;
+    UsbFrameHeader frame;
+    uint32_t length = size - offset;
+
+    if (length > USB_FRAME_DATA_SIZE) {
+      length = USB_FRAME_DATA_SIZE;
+    }
+    memset(&frame, 0, sizeof(frame));
+    frame.header.magic = USB_PACKET_MAGIC;
+    frame.header.type = USB_PKT_STATS_RESPONSE_FRAME;
+    frame.header.flags = USB_FLAG_FRAMES;
+    frame.header.length = (uint16_t)(USB_FRAME_FIELDS_SIZE + length);
+    frame.total_size = size;
+    frame.offset = offset;
+    frame.tag = tag;
+
+    memcpy(g_inbox.data[slot], &frame, sizeof(frame));
+    memcpy(g_inbox.data[slot] + sizeof(frame), json + offset, length);
+    g_inbox.len[slot] = (int)(sizeof(frame) + length);
+    g_inbox.count++;
+  }
+}
+
+static void fill(uint8_t *data, uint32_t size) {
+  uint32_t i;
+
+  for (i = 0; i < size; i++) {
+    data[i] = (uint8_t)('a' + i % 26);
+  }
+}
+
+static void send_case(const char *name, int icon, int frames, uint32_t size,
+                      uint32_t iters) {
+  static uint8_t data[128 * 1024];
+  uint64_t start;
+  uint32_t i;
+
+  fill(data, size);
+  memset(&g_sent, 0, sizeof(g_sent));
+  g_peer_frames = frames;
+  start = bench_clock_ns();
+  for (i = 0; i < iters; i++) {
+    int ret = icon ? usb_send_icon("ULUS10041", data, size)
+                   : usb_send_stats_upload((const char *)data, size,
+                                           1700000000ULL);
+    if (ret < 0) {
+      bench_fail(name, "send failed");
+    }
+  }
+  bench_time(name, iters, bench_clock_ns() - start);
+  bench_counter(name, "frames", g_sent.frames / iters);
+  bench_counter(name, "bytes", g_sent.bytes / iters);
+  g_peer_frames = 1;
+}
+
+/* Receive a full usage_log.json and commit it to the Memory Stick */
+static void stats_response_case(void) {
+  const char *name = "usb.stats_response.12k";
+  const uint32_t size = 12 * 1024;
+  const uint32_t iters = 2000;
+  static uint8_t json[12 * 1024];
+  uint64_t elapsed = 0;
+  uint32_t i;
+
+  fill(json, size);
+  memset(&g_sent, 0, sizeof(g_sent));
+  shim_io_reset();
+  for (i = 0; i < iters; i++) {
+    uint64_t remote = 0;
+    size_t len = 0;
+    uint64_t start;
+
+    queue_stats_response(json, size, 1700000000ULL + i);
+    start = bench_clock_ns();
+    while (g_inbox.count > 0) {
+      usb_poll_message(NULL);
+    }
+    if (usb_poll_stats_response(&remote, NULL, 0, &len) != 1 ||
+        len != size) {
+      bench_fail(name, "response not committed");
+    }
+    elapsed += bench_clock_ns() - start;
+  }
+  bench_time(name, iters, elapsed);
+  bench_counter(name, "acks", g_sent.frames / iters);
+  bench_counter(name, "io_writes", shim_io_stats()->writes / iters);
+  bench_counter(name, "io_bytes_written",
+                shim_io_stats()->bytes_written / iters);
+}
+
+void bench_usb(void) {
+  send_case("usb.icon.20k", 1, 1, 20 * 1024, 2000);
+  send_case("usb.icon.128k", 1, 1, 128 * 1024, 200);
+  send_case("usb.stats_upload.16k", 0, 1, 16 * 1024, 20000);
+  send_case("usb.icon.20k.v1", 1, 0, 20 * 1024, 2000);
+  send_case("usb.stats_upload.16k.v1", 0, 0, 16 * 1024, 2000);
+  stats_response_case();
+}
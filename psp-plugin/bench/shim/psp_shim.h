@@ -0,0 +1,198 @@
+/**
+ * Host sce* Shim
+ *
+ * Just enough of the PSPSDK API to build the plugin's protocol, SFO and
+ * usage tracker sources on the host for the benchmarks. Every psp*.h in
+ * this directory includes this header. The clock is virtual and only moves
+ * on sceKernelDelayThread, so a run does the same work every time;
+ * ms0:/ and disc0:/ map to a scratch directory (shim_set_root) and every
+ * file operation is counted.
+ */
+
+#ifndef PSP_SHIM_H
+#define PSP_SHIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+typedef int SceUID;
+typedef unsigned int SceUInt;
+typedef unsigned int SceSize;
+typedef int SceMode;
+typedef int64_t SceOff;
+typedef uint64_t SceUInt64;
+
+/*============================================================================
+ * Kernel
+ *============================================================================*/
+
+typedef struct {
+  SceUInt low;
+  SceUInt hi;
+} SceKernelSysClock;
+
+int sceKernelGetSystemTime(SceKernelSysClock *clock);
+int sceKernelDelayThread(SceUInt delay);
+
+#define PSP_MEMORY_PARTITION_USER 2
+#define PSP_SMEM_Low 0
+
+SceUID sceKernelAllocPartitionMemory(SceUID partition, const char *name,
+                                     int type, SceSize size, void *addr);
+void *sceKernelGetBlockHeadAddr(SceUID blockid);
+int sceKernelFreePartitionMemory(SceUID blockid);
+SceSize sceKernelTotalFreeMemSize(void);
+
+/*============================================================================
+ * File I/O
+ *============================================================================*/
+
+#define PSP_O_RDONLY 0x0001
+#define PSP_O_WRONLY 0x0002
+#define PSP_O_RDWR 0x0003
+#define PSP_O_APPEND 0x0100
+#define PSP_O_CREAT 0x0200
+#define PSP_O_TRUNC 0x0400
+
+#define PSP_SEEK_SET 0
+#define PSP_SEEK_CUR 1
+#define PSP_SEEK_END 2
+
+typedef struct {
+  SceMode st_mode;
+  unsigned int st_attr;
+  SceOff st_size;
+} SceIoStat;
+
+SceUID sceIoOpen(const char *file, int flags, SceMode mode);
+int sceIoClose(SceUID fd);
+int sceIoRead(SceUID fd, void *data, SceSize size);
+int sceIoWrite(SceUID fd, const void *data, SceSize size);
+int sceIoLseek32(SceUID fd, int offset, int whence);
+int sceIoGetstat(const char *file, SceIoStat *stat);
+int sceIoRemove(const char *file);
+int sceIoRename(const char *oldname, const char *newname);
+
+/*============================================================================
+ * RTC, display, power
+ *============================================================================*/
+
+typedef struct {
+  unsigned short year;
+  unsigned short month;
+  unsigned short day;
+  unsigned short hour;
+  unsigned short minute;
+  unsigned short second;
+  unsigned int microsecond;
+} ScePspDateTime;
+
+int sceRtcGetCurrentClockLocalTime(ScePspDateTime *time);
+int sceDisplayWaitVblankStart(void);
+int scePowerGetBatteryLifePercent(void);
+
+/*============================================================================
+ * Networking and utility dialogs
+ *============================================================================*/
+
+#define PSP_NET_MODULE_COMMON 1
+#define PSP_NET_MODULE_INET 3
+#define PSP_NET_APCTL_STATE_DISCONNECTED 0
+#define PSP_NET_APCTL_STATE_GOT_IP 4
+
+#define PSP_SYSTEMPARAM_ID_STRING_NICKNAME 1
+#define PSP_SYSTEMPARAM_ID_INT_LANGUAGE 8
+
+#define PSP_UTILITY_DIALOG_NONE 0
+#define PSP_UTILITY_DIALOG_VISIBLE 2
+#define PSP_UTILITY_DIALOG_FINISHED 4
+
+#define PSP_NETCONF_ACTION_CONNECTAP 0
+
+typedef struct {
+  unsigned int size;
+  int language;
+  int buttonSwap;
+  int graphicsThread;
+  int accessThread;
+  int fontThread;
+  int soundThread;
+  int result;
+  int reserved[4];
+} pspUtilityDialogCommon;
+
+typedef struct {
+  pspUtilityDialogCommon base;
+  int action;
+} pspUtilityNetconfData;
+
+int sceNetInit(int poolsize, int calloutprio, int calloutstack,
+               int netintrprio, int netintrstack);
+int sceNetTerm(void);
+int sceNetInetInit(void);
+int sceNetInetTerm(void);
+int sceNetApctlInit(int stackSize, int initPriority);
+int sceNetApctlTerm(void);
+int sceNetApctlGetState(int *state);
+int sceNetApctlConnect(int profile);
+int sceNetApctlDisconnect(void);
+
+int sceNetInetSocket(int domain, int type, int protocol);
+int sceNetInetBind(int s, const struct sockaddr *addr, socklen_t len);
+int sceNetInetClose(int s);
+int sceNetInetSetsockopt(int s, int level, int name, const void *value,
+                         socklen_t len);
+
+/* Supplied by the benchmark that drives the socket (bench_net.c) */
+int sceNetInetSelect(int n, fd_set *readfds, fd_set *writefds,
+                     fd_set *exceptfds, struct timeval *timeout);
+int sceNetInetSendto(int s, const void *buf, size_t len, int flags,
+                     const struct sockaddr *to, socklen_t tolen);
+int sceNetInetRecvfrom(int s, void *buf, size_t len, int flags,
+                       struct sockaddr *from, socklen_t *fromlen);
+
+int sceUtilityLoadNetModule(int module);
+int sceUtilityUnloadNetModule(int module);
+int sceUtilityGetSystemParamInt(int id, int *value);
+int sceUtilityGetSystemParamString(int id, char *str, int len);
+int sceUtilityNetconfInitStart(pspUtilityNetconfData *data);
+int sceUtilityNetconfGetStatus(void);
+int sceUtilityNetconfUpdate(int n);
+int sceUtilityNetconfShutdownStart(void);
+
+/*============================================================================
+ * Shim control
+ *============================================================================*/
+
+/* File operations since the last shim_io_reset() */
+typedef struct {
+  uint32_t opens;
+  uint32_t reads;
+  uint32_t writes;
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+} ShimIoStats;
+
+/**
+ * Map ms0:/ and disc0:/ paths into a host directory. Paths are lowercased
+ * below the root, the Memory Stick is case-insensitive.
+ */
+void shim_set_root(const char *dir);
+
+/**
+ * Host path of a PSP path
+ *
+ * @return 0 on success, -1 if it does not fit
+ */
+int shim_host_path(const char *psp_path, char *out, size_t out_size);
+
+/* Virtual clock in microseconds */
+uint64_t shim_now_us(void);
+void shim_advance_us(uint64_t us);
+
+const ShimIoStats *shim_io_stats(void);
+void shim_io_reset(void);
+
+#endif /* PSP_SHIM_H */
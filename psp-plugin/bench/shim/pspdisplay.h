@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPDISPLAY_H
+#define SHIM_PSPDISPLAY_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPDISPLAY_H */
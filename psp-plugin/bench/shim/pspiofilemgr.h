@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPIOFILEMGR_H
+#define SHIM_PSPIOFILEMGR_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPIOFILEMGR_H */
@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPKERNEL_H
+#define SHIM_PSPKERNEL_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPKERNEL_H */
@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPNET_INET_H
+#define SHIM_PSPNET_INET_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPNET_INET_H */
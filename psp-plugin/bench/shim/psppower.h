@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPPOWER_H
+#define SHIM_PSPPOWER_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPPOWER_H */
@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPRTC_H
+#define SHIM_PSPRTC_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPRTC_H */
@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPSYSMEM_H
+#define SHIM_PSPSYSMEM_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPSYSMEM_H */
@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPUTILITY_H
+#define SHIM_PSPUTILITY_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPUTILITY_H */
@@ -0,0 +1,8 @@
+/* Host shim, see psp_shim.h */
+
+#ifndef SHIM_PSPWLAN_H
+#define SHIM_PSPWLAN_H
+
+#include "psp_shim.h"
+
+#endif /* SHIM_PSPWLAN_H */
@@ -0,0 +1,343 @@
+/**
+ * Host sce* Shim Implementation
+ */
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "psp_shim.h"
+
+/* Partition blocks handed out at once */
+#define SHIM_MAX_BLOCKS 256
+
+/* Reported by sceKernelTotalFreeMemSize */
+#define SHIM_FREE_MEM (16 * 1024 * 1024)
+
+static char g_root[256] = ".";
+static uint64_t g_now_us = 1000000; /* Boot + 1 s, 0 means "never" */
+static ShimIoStats g_io;
+static void *g_blocks[SHIM_MAX_BLOCKS];
+
+/*============================================================================
+ * Shim control
+ *============================================================================*/
+
+void shim_set_root(const char *dir) {
+  snprintf(g_root, sizeof(g_root), "%s", dir);
+}
+
+int shim_host_path(const char *psp_path, char *out, size_t out_size) {
+  const char *rest = strchr(psp_path, ':');
+  size_t len;
+  int n;
+
+  rest = (rest != NULL) ? rest + 1 : psp_path;
+  while (*rest == '/') {
+    rest++;
+  }
+
+  n = snprintf(out, out_size, "%s/", g_root);
+  if (n < 0 || (size_t)n >= out_size) {
+    return -1;
+  }
+  len = (size_t)n;
+  for (; *rest != '\0'; rest++) {
+    if (len + 1 >= out_size) {
+      return -1;
+    }
+    out[len++] = (char)tolower((unsigned char)*rest);
+  }
+  out[len] = '\0';
+  return 0;
+}
+
+uint64_t shim_now_us(void) { return g_now_us; }
+
+void shim_advance_us(uint64_t us) { g_now_us += us; }
+
+const ShimIoStats *shim_io_stats(void) { return &g_io; }
+
+void shim_io_reset(void) { memset(&g_io, 0, sizeof(g_io)); }
+
+/*============================================================================
+ * Kernel
+ *============================================================================*/
+
+int sceKernelGetSystemTime(SceKernelSysClock *clock) {
+  clock->low = (SceUInt)g_now_us;
+  clock->hi = (SceUInt)(g_now_us >> 32);
+  return 0;
+}
+
+int sceKernelDelayThread(SceUInt delay) {
+  g_now_us += delay;
+  return 0;
+}
+
+SceUID sceKernelAllocPartitionMemory(SceUID partition, const char *name,
+                                     int type, SceSize size, void *addr) {
+  int i;
+
+  (void)partition;
+  (void)name;
+  (void)type;
+  (void)addr;
+
+  for (i = 0; i < SHIM_MAX_BLOCKS; i++) {
+    if (g_blocks[i] == NULL) {
+      g_blocks[i] = malloc(size > 0 ? size : 1);
+      return (g_blocks[i] != NULL) ? i : -1;
+    }
+  }
+  return -1;
+}
+
+void *sceKernelGetBlockHeadAddr(SceUID blockid) {
+  if (blockid < 0 || blockid >= SHIM_MAX_BLOCKS) {
+    return NULL;
+  }
+  return g_blocks[blockid];
+}
+
+int sceKernelFreePartitionMemory(SceUID blockid) {
+  if (blockid < 0 || blockid >= SHIM_MAX_BLOCKS || g_blocks[blockid] == NULL) {
+    return -1;
+  }
+  free(g_blocks[blockid]);
+  g_blocks[blockid] = NULL;
+  return 0;
+}
+
+SceSize sceKernelTotalFreeMemSize(void) { return SHIM_FREE_MEM; }
+
+/*============================================================================
+ * File I/O
+ *============================================================================*/
+
+SceUID sceIoOpen(const char *file, int flags, SceMode mode) {
+  char path[512];
+  int host_flags;
+
+  if (shim_host_path(file, path, sizeof(path)) < 0) {
+    return -1;
+  }
+
+  switch (flags & PSP_O_RDWR) {
+  case PSP_O_WRONLY:
+    host_flags = O_WRONLY;
+    break;
+  case PSP_O_RDWR:
+    host_flags = O_RDWR;
+    break;
+  default:
+    host_flags = O_RDONLY;
+    break;
+  }
+  if (flags & PSP_O_APPEND) {
+    host_flags |= O_APPEND;
+  }
+  if (flags & PSP_O_CREAT) {
+    host_flags |= O_CREAT;
+  }
+  if (flags & PSP_O_TRUNC) {
+    host_flags |= O_TRUNC;
+  }
+
+  g_io.opens++;
+  return open(path, host_flags, mode & 0777);
+}
+
+int sceIoClose(SceUID fd) { return close(fd); }
+
+int sceIoRead(SceUID fd, void *data, SceSize size) {
+  ssize_t n = read(fd, data, size);
+
+  g_io.reads++;
+  if (n > 0) {
+    g_io.bytes_read += (uint64_t)n;
+  }
+  return (int)n;
+}
+
+int sceIoWrite(SceUID fd, const void *data, SceSize size) {
+  ssize_t n = write(fd, data, size);
+
+  g_io.writes++;
+  if (n > 0) {
+    g_io.bytes_written += (uint64_t)n;
+  }
+  return (int)n;
+}
+
+int sceIoLseek32(SceUID fd, int offset, int whence) {
+  return (int)lseek(fd, offset, whence);
+}
+
+int sceIoGetstat(const char *file, SceIoStat *stat_out) {
+  char path[512];
+  struct stat st;
+
+  if (shim_host_path(file, path, sizeof(path)) < 0 || stat(path, &st) < 0) {
+    return -1;
+  }
+  memset(stat_out, 0, sizeof(*stat_out));
+  stat_out->st_mode = (SceMode)st.st_mode;
+  stat_out->st_size = (SceOff)st.st_size;
+  return 0;
+}
+
+int sceIoRemove(const char *file) {
+  char path[512];
+
+  if (shim_host_path(file, path, sizeof(path)) < 0) {
+    return -1;
+  }
+  return unlink(path);
+}
+
+int sceIoRename(const char *oldname, const char *newname) {
+  char from[512];
+  char to[512];
+
+  if (shim_host_path(oldname, from, sizeof(from)) < 0 ||
+      shim_host_path(newname, to, sizeof(to)) < 0) {
+    return -1;
+  }
+  return rename(from, to);
+}
+
+/*============================================================================
+ * RTC, display, power
+ *============================================================================*/
+
+/* A fixed date that advances with the virtual clock */
+int sceRtcGetCurrentClockLocalTime(ScePspDateTime *time) {
+  uint64_t s = g_now_us / 1000000;
+
+  memset(time, 0, sizeof(*time));
+  time->year = 2026;
+  time->month = 1;
+  time->day = (unsigned short)(1 + (s / 86400) % 28);
+  time->hour = (unsigned short)((s / 3600) % 24);
+  time->minute = (unsigned short)((s / 60) % 60);
+  time->second = (unsigned short)(s % 60);
+  return 0;
+}
+
+int sceDisplayWaitVblankStart(void) {
+  g_now_us += 16667;
+  return 0;
+}
+
+int scePowerGetBatteryLifePercent(void) { return 100; }
+
+/*============================================================================
+ * Networking and utility dialogs. The link is always up; the socket itself
+ * is driven by the benchmark.
+ *============================================================================*/
+
+int sceNetInit(int poolsize, int calloutprio, int calloutstack,
+               int netintrprio, int netintrstack) {
+  (void)poolsize;
+  (void)calloutprio;
+  (void)calloutstack;
+  (void)netintrprio;
+  (void)netintrstack;
+  return 0;
+}
+
+int sceNetTerm(void) { return 0; }
+int sceNetInetInit(void) { return 0; }
+int sceNetInetTerm(void) { return 0; }
+
+int sceNetApctlInit(int stackSize, int initPriority) {
+  (void)stackSize;
+  (void)initPriority;
+  return 0;
+}
+
+int sceNetApctlTerm(void) { return 0; }
+
+int sceNetApctlGetState(int *state) {
+  *state = PSP_NET_APCTL_STATE_GOT_IP;
+  return 0;
+}
+
+int sceNetApctlConnect(int profile) {
+  (void)profile;
+  return 0;
+}
+
+int sceNetApctlDisconnect(void) { return 0; }
+
+int sceNetInetSocket(int domain, int type, int protocol) {
+  (void)domain;
+  (void)type;
+  (void)protocol;
+  return 3;
+}
+
+int sceNetInetBind(int s, const struct sockaddr *addr, socklen_t len) {
+  (void)s;
+  (void)addr;
+  (void)len;
+  return 0;
+}
+
+int sceNetInetClose(int s) {
+  (void)s;
+  return 0;
+}
+
+int sceNetInetSetsockopt(int s, int level, int name, const void *value,
+                         socklen_t len) {
+  (void)s;
+  (void)level;
+  (void)name;
+  (void)value;
+  (void)len;
+  return 0;
+}
+
+/* Nothing arrives while waiting: the simulated desktop answers on the
+ * next receive */
+int sceUtilityLoadNetModule(int module) {
+  (void)module;
+  return 0;
+}
+
+int sceUtilityUnloadNetModule(int module) {
+  (void)module;
+  return 0;
+}
+
+int sceUtilityGetSystemParamInt(int id, int *value) {
+  (void)id;
+  *value = 1;
+  return 0;
+}
+
+int sceUtilityGetSystemParamString(int id, char *str, int len) {
+  (void)id;
+  snprintf(str, (size_t)len, "bench");
+  return 0;
+}
+
+int sceUtilityNetconfInitStart(pspUtilityNetconfData *data) {
+  (void)data;
+  return -1;
+}
+
+int sceUtilityNetconfGetStatus(void) { return PSP_UTILITY_DIALOG_NONE; }
+
+int sceUtilityNetconfUpdate(int n) {
+  (void)n;
+  return 0;
+}
+
+int sceUtilityNetconfShutdownStart(void) { return 0; }
@@ -21,9 +21,12 @@
 #define MSG_ICON_END 0x04
 #define MSG_STATS_REQUEST 0x05
 #define MSG_STATS_UPLOAD 0x06
+#define MSG_TRANSFER_POLL 0x07
 #define MSG_ACK 0x10
 #define MSG_ICON_REQUEST 0x11
 #define MSG_STATS_RESPONSE 0x12
+#define MSG_ICON_HAVE 0x13
+#define MSG_TRANSFER_STATUS 0x14
 #define MSG_DISCOVERY_REQUEST 0x20
 #define MSG_DISCOVERY_RESPONSE 0x21
 
@@ -49,7 +52,7 @@ typedef struct {
   char psp_name[32]; /* PSP name from config */
 } GameInfo;
 
-/* Heartbeat packet */
+/* Heartbeat packet, followed by HeartbeatMetrics (drp_metrics.h) */
 typedef struct {
   uint32_t uptime_seconds;
   uint8_t wifi_strength;
@@ -63,7 +66,9 @@ typedef struct {
   uint8_t state;
   uint8_t has_icon;
   uint8_t persistent;
-  char psp_name[32]; /* PSP name from config */
+  char psp_name[32];   /* PSP name from config */
+  uint32_t icon_crc32; /* CRC32 of ICON0.PNG (0 if not known yet) */
+  uint32_t icon_size;  /* Icon size in bytes (0 if not known yet) */
 } __attribute__((packed)) GameInfoPacket;
 
 /* Icon chunk packet */
@@ -100,6 +105,42 @@ typedef struct {
   char game_id[10];
 } __attribute__((packed)) IconRequestPacket;
 
+/* ACK packet (from desktop). The session stays the same for as long as the
+ * desktop keeps the PSP's state; older desktops send no payload. */
+typedef struct {
+  uint32_t session;
+} __attribute__((packed)) AckPacket;
+
+/* Icon have packet (from desktop): the advertised icon is already cached */
+typedef struct {
+  char game_id[10];
+  uint32_t crc32;
+} __attribute__((packed)) IconHavePacket;
+
+/* Reliable chunked transfers (icons, stats uploads) */
+#define TRANSFER_KIND_ICON 1
+#define TRANSFER_KIND_STATS 2
+
+/* Largest transfer tracked by the status bitmap */
+#define TRANSFER_MAX_CHUNKS 256
+
+/* Transfer poll packet (PSP -> Desktop): "which chunks are you missing?" */
+typedef struct {
+  uint8_t kind;          /* TRANSFER_KIND_* */
+  char id[10];           /* Game ID for icons, empty for stats */
+  uint16_t total_chunks; /* Chunks in the transfer */
+  uint64_t tag;          /* last_updated for stats, icon CRC32 for icons */
+} __attribute__((packed)) TransferPollPacket;
+
+/* Transfer status packet (Desktop -> PSP), reply to TransferPollPacket */
+typedef struct {
+  uint8_t kind;
+  char id[10];
+  uint16_t total_chunks;
+  uint16_t received_chunks;
+  uint8_t missing[TRANSFER_MAX_CHUNKS / 8]; /* Bit i set = chunk i missing */
+} __attribute__((packed)) TransferStatusPacket;
+
 /* Packet header */
 typedef struct {
   char magic[4];
@@ -109,8 +150,44 @@ typedef struct {
 /* Stats sync chunk size */
 #define STATS_CHUNK_SIZE 1024
 
-/* Stats request packet (PSP -> Desktop) */
-/* Empty - just header with type MSG_STATS_REQUEST */
+/* Stats request packet (PSP -> Desktop). A header-only request asks for the
+ * desktop's whole usage_log.json; with this payload the desktop answers with
+ * a StatsDelta instead. */
+typedef struct {
+  uint32_t since_version; /* Highest desktop sync_version already merged */
+  uint32_t psp_version;   /* PSP's own sync_version */
+} __attribute__((packed)) StatsRequestPacket;
+
+/*
+ * Stats delta, carried as the payload of a STATS_RESPONSE or STATS_UPLOAD
+ * transfer in place of JSON. Each side numbers its changes with its own
+ * sync_version counter and only sends games changed after the version the
+ * peer last acknowledged; the receiver keeps the higher of each value.
+ */
+#define STATS_DELTA_MAGIC "PSDL"
+#define STATS_DELTA_TITLE_LEN 64
+
+/* Most records in one delta; the rest follow in the next sync */
+#define STATS_DELTA_MAX_RECORDS 64
+
+/* StatsDeltaHeader flags */
+#define STATS_DELTA_FLAG_MORE 0x0001 /* Sender has newer changes queued */
+
+typedef struct {
+  char magic[4];    /* STATS_DELTA_MAGIC */
+  uint16_t count;   /* StatsDeltaRecord entries that follow */
+  uint16_t flags;   /* STATS_DELTA_FLAG_* */
+  uint32_t version; /* Newest sender sync_version covered by the delta */
+  uint32_t ack;     /* Highest peer sync_version the sender has merged */
+} __attribute__((packed)) StatsDeltaHeader;
+
+typedef struct {
+  char game_id[16];
+  char title[STATS_DELTA_TITLE_LEN];
+  uint64_t total_seconds;
+  uint32_t session_count;
+  uint32_t version; /* Sender's sync_version of the last change */
+} __attribute__((packed)) StatsDeltaRecord;
 
 /* Stats upload packet (PSP -> Desktop) */
 typedef struct {
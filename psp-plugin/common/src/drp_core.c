@@ -0,0 +1,355 @@
+/**
+ * Plugin Core - shared main loop steps for the net and USB plugins
+ */
+
+#include <pspkernel.h>
+#include <string.h>
+
+#include "drp_core.h"
+#include "drp_metrics.h"
+#include "game_detect.h"
+#include "icon_cache.h"
+
+/* Limits applied to the configured intervals */
+#define MIN_DETECT_INTERVAL_US 500000ULL
+#define MIN_HEARTBEAT_INTERVAL_US 1000000ULL
+#define MAX_HEARTBEAT_INTERVAL_US 300000000ULL
+#define MIN_RESEND_INTERVAL_US 1000000ULL
+#define MAX_RESEND_INTERVAL_US 3600000000ULL
+
+static void core_log(DrpCore *core, const char *msg) {
+  if (core->transport->log != NULL) {
+    core->transport->log(msg);
+  }
+}
+
+static uint64_t clamp_us(uint32_t ms, uint64_t min_us, uint64_t max_us) {
+  uint64_t us = (uint64_t)ms * 1000;
+
+  if (us < min_us) {
+    return min_us;
+  }
+  if (us > max_us) {
+    return max_us;
+  }
+  return us;
+}
+
+/* Configured detection interval; in event mode also the module check
+ * interval */
+static uint64_t detect_interval_us(const DrpCore *core) {
+  uint64_t interval = (uint64_t)core->settings.poll_interval_ms * 1000;
+
+  if (interval < MIN_DETECT_INTERVAL_US) {
+    interval = MIN_DETECT_INTERVAL_US;
+  }
+  return interval;
+}
+
+static uint64_t heartbeat_interval_us(const DrpCore *core) {
+  return clamp_us(core->settings.heartbeat_interval_ms,
+                  MIN_HEARTBEAT_INTERVAL_US, MAX_HEARTBEAT_INTERVAL_US);
+}
+
+static uint64_t resend_interval_us(const DrpCore *core) {
+  return clamp_us(core->settings.game_update_interval_ms,
+                  MIN_RESEND_INTERVAL_US, MAX_RESEND_INTERVAL_US);
+}
+
+static void earliest(uint64_t *due, uint64_t t) {
+  if (t < *due) {
+    *due = t;
+  }
+}
+
+/**
+ * Report the XMB (and the CFW SystemControl module) under one ID
+ */
+static void normalize_game(GameInfo *game) {
+  if (strncmp(game->game_id, "Xmb", 3) == 0 ||
+      strcmp(game->game_id, "XMB") == 0 ||
+      strncmp(game->game_id, "SystemCon", 9) == 0) {
+    strcpy(game->game_id, "XMB");
+    strcpy(game->title, "Browsing XMB");
+    game->state = STATE_XMB;
+  }
+}
+
+/**
+ * Load a new game's icon once so the icon cache can supply its CRC for
+ * GAME_INFO; the desktop then only asks for icons it doesn't have
+ */
+static void prefetch_icon(DrpCore *core) {
+  uint32_t icon_size = 0;
+
+  if (!core->settings.send_icons || !core->game.has_icon ||
+      core->icon_buffer == NULL ||
+      icon_cache_lookup(core->game.game_id, NULL) == 0) {
+    return;
+  }
+
+  if (game_detect_get_icon(core->game.game_id, core->icon_buffer,
+                           core->icon_buffer_size, &icon_size) != 0) {
+    core_log(core, "Icon load failed");
+  }
+}
+
+static void send_requested_icon(DrpCore *core, const char *game_id) {
+  uint32_t icon_size = 0;
+
+  if (core->icon_buffer == NULL ||
+      game_detect_get_icon(game_id, core->icon_buffer, core->icon_buffer_size,
+                           &icon_size) != 0 ||
+      icon_size == 0) {
+    core_log(core, "Icon load failed for request");
+    return;
+  }
+
+  drp_metrics_icon_begin();
+  if (core->transport->send_icon(game_id, core->icon_buffer, icon_size) >= 0) {
+    core_log(core, "Icon sent on request");
+  } else {
+    core_log(core, "Icon send failed for request");
+  }
+  drp_metrics_icon_end();
+}
+
+static void finish_sync(DrpCore *core, int result, uint64_t now) {
+  switch (result) {
+  case DRP_SYNC_WAITING:
+    return;
+
+  case DRP_SYNC_DONE:
+    core_log(core, "Stats sync complete");
+    drp_metrics_sync(now - core->stats_sync_started);
+    core->next_stats_sync = now + DRP_STATS_SYNC_INTERVAL_US;
+    break;
+
+  case DRP_SYNC_AGAIN:
+    /* More than one delta's worth on either side - go again now */
+    core_log(core, "Stats sync has more queued, syncing again");
+    drp_metrics_sync(now - core->stats_sync_started);
+    core->next_stats_sync = now;
+    break;
+
+  default:
+    /* The previous usage_log.json is kept */
+    core_log(core, "Stats sync failed, will retry");
+    core->next_stats_sync = now + DRP_STATS_SYNC_INTERVAL_US;
+    break;
+  }
+
+  core->stats_sync_pending = 0;
+}
+
+uint64_t drp_time_us(void) {
+  SceKernelSysClock clock;
+
+  sceKernelGetSystemTime(&clock);
+  return clock.low + ((uint64_t)clock.hi << 32);
+}
+
+void drp_core_init(DrpCore *core, const DrpTransport *transport,
+                   const DrpSettings *settings, uint8_t *icon_buffer,
+                   uint32_t icon_buffer_size) {
+  memset(core, 0, sizeof(*core));
+  core->transport = transport;
+  memcpy(&core->settings, settings, sizeof(core->settings));
+  core->icon_buffer = icon_buffer;
+  core->icon_buffer_size = icon_buffer_size;
+}
+
+void drp_core_set_game(DrpCore *core, const GameInfo *game) {
+  memcpy(&core->game, game, sizeof(core->game));
+  normalize_game(&core->game);
+  core->game_changed = 1;
+}
+
+int drp_core_detect(DrpCore *core, uint64_t now, int hint) {
+  GameInfo game;
+  uint64_t interval = detect_interval_us(core);
+  uint64_t started;
+  int ret;
+
+  if (core->settings.event_detect) {
+    /* Module set changes trigger detection; the interval is a fallback */
+    if (!hint && now - core->last_module_check >= interval) {
+      core->last_module_check = now;
+      if (game_detect_modules_changed()) {
+        core_log(core, "Module set changed, re-detecting game");
+        hint = 1;
+      }
+    }
+    interval *= DETECT_EVENT_FALLBACK_FACTOR;
+  }
+
+  if (!hint && now - core->last_detect < interval) {
+    return 0;
+  }
+  core->last_detect = now;
+
+  started = drp_time_us();
+  ret = game_detect_current(&game);
+  drp_metrics_detect((uint32_t)(drp_time_us() - started));
+  if (ret != 0 || game.game_id[0] == '\0') {
+    return 0;
+  }
+  normalize_game(&game);
+
+  if (strcmp(game.game_id, core->game.game_id) == 0 &&
+      game.state == core->game.state) {
+    return 0;
+  }
+
+  core_log(core, "Game changed");
+  memcpy(&core->game, &game, sizeof(core->game));
+  core->game_changed = 1;
+  return 1;
+}
+
+void drp_core_heartbeat(DrpCore *core, uint64_t now) {
+  HeartbeatMetrics metrics;
+
+  if (core->last_heartbeat != 0 &&
+      now - core->last_heartbeat < heartbeat_interval_us(core)) {
+    return;
+  }
+  core->last_heartbeat = now;
+  drp_metrics_report(&metrics, core->game.game_id, now);
+  core->transport->send_heartbeat(now, &metrics);
+}
+
+int drp_core_send_game(DrpCore *core, uint64_t now) {
+  int due = core->game_changed;
+  int ret;
+
+  if (core->game.game_id[0] == '\0') {
+    return 0;
+  }
+
+  if (!due && core->settings.game_update_interval_ms > 0) {
+    due = (now - core->last_game_send >= resend_interval_us(core));
+  }
+  if (!due) {
+    return 0;
+  }
+
+  core->game.persistent = core->settings.persistent ? 1 : 0;
+  if (core->settings.psp_name != NULL) {
+    strncpy(core->game.psp_name, core->settings.psp_name,
+            sizeof(core->game.psp_name) - 1);
+    core->game.psp_name[sizeof(core->game.psp_name) - 1] = '\0';
+  }
+  if (core->game_changed) {
+    prefetch_icon(core);
+  }
+
+  ret = core->transport->send_game_info(&core->game);
+  if (ret < 0) {
+    core_log(core, "Failed to send game info");
+    return ret;
+  }
+
+  core->game_changed = 0;
+  core->last_game_send = now;
+  return 1;
+}
+
+int drp_core_poll(DrpCore *core) {
+  char game_id[10] = {0};
+  int msg = core->transport->poll(game_id);
+
+  switch (msg) {
+  case DRP_MSG_ICON_REQUEST:
+    if (core->settings.send_icons && game_id[0] != '\0') {
+      send_requested_icon(core, game_id);
+    }
+    break;
+
+  case DRP_MSG_ICON_HAVE:
+    /* Desktop matched the advertised CRC, nothing to send */
+    core_log(core, "Desktop already has the icon");
+    break;
+
+  case DRP_MSG_STATS_RESPONSE:
+    if (core->stats_sync_pending) {
+      finish_sync(core, core->transport->poll_stats(), drp_time_us());
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  return msg;
+}
+
+void drp_core_sync(DrpCore *core, uint64_t now) {
+  if (core->stats_sync_pending) {
+    if (now - core->stats_sync_started > DRP_STATS_SYNC_TIMEOUT_US) {
+      core_log(core, "Stats sync timeout, giving up");
+      core->stats_sync_pending = 0;
+      core->next_stats_sync = now + DRP_STATS_SYNC_INTERVAL_US;
+    }
+    return;
+  }
+
+  if (now < core->next_stats_sync) {
+    return;
+  }
+
+  if (core->transport->send_stats_request() < 0) {
+    core_log(core, "Stats request failed");
+    return;
+  }
+
+  core->stats_sync_pending = 1;
+  core->stats_sync_started = now;
+  core_log(core, "Stats request sent");
+}
+
+void drp_core_heartbeat_now(DrpCore *core) { core->last_heartbeat = 0; }
+
+void drp_core_resend_game(DrpCore *core) { core->game_changed = 1; }
+
+void drp_core_resync(DrpCore *core) {
+  core->stats_sync_pending = 0;
+  core->next_stats_sync = 0;
+}
+
+uint64_t drp_core_next_due(const DrpCore *core, int tasks) {
+  uint64_t due = UINT64_MAX;
+
+  if (tasks & DRP_TASK_DETECT) {
+    uint64_t interval = detect_interval_us(core);
+
+    if (core->settings.event_detect) {
+      earliest(&due, core->last_module_check + interval);
+      interval *= DETECT_EVENT_FALLBACK_FACTOR;
+    }
+    earliest(&due, core->last_detect + interval);
+  }
+
+  if (tasks & DRP_TASK_HEARTBEAT) {
+    earliest(&due, core->last_heartbeat == 0
+                       ? 0
+                       : core->last_heartbeat + heartbeat_interval_us(core));
+  }
+
+  if ((tasks & DRP_TASK_GAME) && core->game.game_id[0] != '\0') {
+    if (core->game_changed) {
+      due = 0;
+    } else if (core->settings.game_update_interval_ms > 0) {
+      earliest(&due, core->last_game_send + resend_interval_us(core));
+    }
+  }
+
+  if (tasks & DRP_TASK_SYNC) {
+    /* A pending sync also finishes on packets, which wake the caller */
+    earliest(&due, core->stats_sync_pending
+                       ? core->stats_sync_started + DRP_STATS_SYNC_TIMEOUT_US
+                       : core->next_stats_sync);
+  }
+
+  return due;
+}
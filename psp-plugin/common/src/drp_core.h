@@ -0,0 +1,193 @@
+/**
+ * Plugin Core
+ *
+ * The transport-agnostic half of the plugin main loop, linked into both the
+ * net and the USB plugin: game change detection, game info resends,
+ * heartbeats, icon requests and the stats sync state machine. Each plugin
+ * supplies a DrpTransport with its packet functions and calls the
+ * drp_core_* steps from its own thread. All timing is on one 64-bit
+ * microsecond clock (drp_time_us).
+ */
+
+#ifndef DRP_CORE_H
+#define DRP_CORE_H
+
+#include <stdint.h>
+
+#include "discord_rpc.h"
+#include "drp_metrics.h"
+
+/* Messages reported by DrpTransport.poll (the net plugin's
+ * network_poll_message() uses the same values) */
+#define DRP_MSG_NONE 0
+#define DRP_MSG_ACK 1
+#define DRP_MSG_ICON_REQUEST 2
+#define DRP_MSG_STATS_RESPONSE 3
+#define DRP_MSG_ICON_HAVE 4
+#define DRP_MSG_OTHER 5 /* Handled inside the transport */
+
+/* Results of DrpTransport.poll_stats */
+#define DRP_SYNC_WAITING 0 /* Response still arriving */
+#define DRP_SYNC_DONE 1    /* Response complete */
+#define DRP_SYNC_AGAIN 2   /* Complete, but a side has more queued */
+#define DRP_SYNC_FAILED -1 /* Incomplete or not committed */
+
+/* Steps for drp_core_next_due */
+#define DRP_TASK_DETECT 0x01
+#define DRP_TASK_HEARTBEAT 0x02
+#define DRP_TASK_GAME 0x04
+#define DRP_TASK_SYNC 0x08
+
+/* Stats sync cadence */
+#define DRP_STATS_SYNC_INTERVAL_US (5 * 60 * 1000 * 1000ULL) /* 5 minutes */
+#define DRP_STATS_SYNC_TIMEOUT_US (30 * 1000 * 1000ULL)      /* 30 seconds */
+
+/**
+ * Packet functions of one transport. Every function returns negative on
+ * error unless noted otherwise.
+ */
+typedef struct {
+  /* Log a fixed message */
+  void (*log)(const char *msg);
+
+  int (*send_game_info)(const GameInfo *game);
+
+  /* Send a heartbeat carrying the metrics window that just closed */
+  int (*send_heartbeat)(uint64_t now_us, const HeartbeatMetrics *metrics);
+
+  /* Send an icon as a (chunked) transfer */
+  int (*send_icon)(const char *game_id, const uint8_t *data, uint32_t size);
+
+  /* Handle the next message from the desktop, if any. Returns DRP_MSG_*;
+   * game_id_out (10 bytes) receives the game of an icon request/have */
+  int (*poll)(char *game_id_out);
+
+  int (*send_stats_request)(void);
+
+  /* Check on the stats response after a DRP_MSG_STATS_RESPONSE, merging
+   * or committing it once complete. Returns DRP_SYNC_* */
+  int (*poll_stats)(void);
+} DrpTransport;
+
+/**
+ * Settings the core needs from the plugin config
+ */
+typedef struct {
+  uint32_t poll_interval_ms;        /* Game detection interval */
+  uint32_t heartbeat_interval_ms;   /* Clamped to 1 s .. 5 min */
+  uint32_t game_update_interval_ms; /* Resend unchanged game info, 0 = off */
+  int event_detect;                 /* Detection driven by module events */
+  int send_icons;
+  int persistent; /* Sent in GAME_INFO (send_once mode) */
+  const char *psp_name;
+} DrpSettings;
+
+/**
+ * Core state. Owned by the plugin's main thread.
+ */
+typedef struct {
+  const DrpTransport *transport;
+  DrpSettings settings;
+
+  /* Icon scratch buffer (icon requests and CRC prefetch) */
+  uint8_t *icon_buffer;
+  uint32_t icon_buffer_size;
+
+  GameInfo game;    /* Current game */
+  int game_changed; /* game not sent to the desktop yet */
+
+  uint64_t last_detect;
+  uint64_t last_module_check; /* event_detect only */
+  uint64_t last_game_send;
+  uint64_t last_heartbeat;
+
+  int stats_sync_pending;      /* Waiting for a stats response */
+  uint64_t stats_sync_started; /* When the pending request went out */
+  uint64_t next_stats_sync;    /* Next sync is due at this time */
+} DrpCore;
+
+/**
+ * Current time in microseconds (64-bit, does not wrap)
+ */
+uint64_t drp_time_us(void);
+
+/**
+ * Initialize the core
+ *
+ * @param core Core state
+ * @param transport Packet functions (must stay valid)
+ * @param settings Settings, copied (psp_name must stay valid)
+ * @param icon_buffer Scratch buffer for icons, can be NULL
+ * @param icon_buffer_size Size of icon_buffer
+ */
+void drp_core_init(DrpCore *core, const DrpTransport *transport,
+                   const DrpSettings *settings, uint8_t *icon_buffer,
+                   uint32_t icon_buffer_size);
+
+/**
+ * Set the current game directly (e.g. from the loader), to be sent on the
+ * next drp_core_send_game()
+ */
+void drp_core_set_game(DrpCore *core, const GameInfo *game);
+
+/**
+ * Re-detect the running game when due
+ *
+ * @param now Current drp_time_us()
+ * @param hint Nonzero if the plugin saw a module change, forcing detection
+ * @return 1 if the game changed, 0 otherwise
+ */
+int drp_core_detect(DrpCore *core, uint64_t now, int hint);
+
+/**
+ * Send a heartbeat when due, closing the metrics window (drp_metrics.h)
+ */
+void drp_core_heartbeat(DrpCore *core, uint64_t now);
+
+/**
+ * Send game info if the game changed or the resend interval passed
+ *
+ * @return 1 if sent, 0 if nothing was due, negative on send error
+ */
+int drp_core_send_game(DrpCore *core, uint64_t now);
+
+/**
+ * Handle one message from the desktop. Icon requests and stats responses
+ * are dealt with here; the rest is up to the caller.
+ *
+ * @return DRP_MSG_* of the message, DRP_MSG_NONE if there was none
+ */
+int drp_core_poll(DrpCore *core);
+
+/**
+ * Start a stats sync when due and give up on one that timed out
+ */
+void drp_core_sync(DrpCore *core, uint64_t now);
+
+/**
+ * When the next of the given steps is due, so the caller can sleep until
+ * then instead of ticking
+ *
+ * @param tasks DRP_TASK_* of the steps the caller is running
+ * @return drp_time_us() deadline, 0 if due now, UINT64_MAX if none
+ */
+uint64_t drp_core_next_due(const DrpCore *core, int tasks);
+
+/**
+ * Send a heartbeat on the next drp_core_heartbeat(), e.g. as the first
+ * packet after a reconnect
+ */
+void drp_core_heartbeat_now(DrpCore *core);
+
+/**
+ * Send the current game again on the next drp_core_send_game() (the
+ * desktop lost it)
+ */
+void drp_core_resend_game(DrpCore *core);
+
+/**
+ * Sync stats again right away, abandoning a sync in flight (new connection)
+ */
+void drp_core_resync(DrpCore *core);
+
+#endif /* DRP_CORE_H */
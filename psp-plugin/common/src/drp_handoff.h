@@ -0,0 +1,45 @@
+/**
+ * Loader Handoff
+ *
+ * What the loader already found out at boot, passed to the net or USB
+ * plugin after its own start args so the plugin doesn't read the ini and
+ * probe the game a second time. Every part is optional; the plugin falls
+ * back to its own config_load / game_detect_current for anything not
+ * flagged.
+ */
+
+#ifndef DRP_HANDOFF_H
+#define DRP_HANDOFF_H
+
+#include <stdint.h>
+
+#define DRP_HANDOFF_MAGIC 0x46444E48 /* "HNDF" */
+#define DRP_HANDOFF_VERSION 2 /* 2: title grew to GameInfo size */
+
+/* DrpHandoff.flags */
+#define DRP_HANDOFF_GAME 0x01   /* game_id, title and game_path are valid */
+#define DRP_HANDOFF_ICON 0x02   /* game_path holds an ICON0.PNG */
+#define DRP_HANDOFF_CONFIG 0x04 /* config holds the complete ini */
+
+/* The whole ini must fit, otherwise the plugin reads the file itself */
+#define DRP_HANDOFF_CONFIG_MAX 2048
+
+typedef struct {
+  uint32_t magic;   /* DRP_HANDOFF_MAGIC */
+  uint32_t version; /* DRP_HANDOFF_VERSION */
+  uint32_t flags;   /* DRP_HANDOFF_* */
+
+  char game_id[16];
+  char title[128]; /* Same size as GameInfo.title */
+  char game_path[64]; /* Directory of PARAM.SFO/ICON0.PNG, no trailing '/' */
+
+  uint32_t config_len;                 /* Bytes in config */
+  char config[DRP_HANDOFF_CONFIG_MAX]; /* psp_drp.ini, NUL-terminated */
+} DrpHandoff;
+
+/* Check a received block before using any of it */
+#define DRP_HANDOFF_VALID(h)                                                   \
+  ((h)->magic == DRP_HANDOFF_MAGIC && (h)->version == DRP_HANDOFF_VERSION &&   \
+   (h)->config_len < DRP_HANDOFF_CONFIG_MAX)
+
+#endif /* DRP_HANDOFF_H */
@@ -0,0 +1,133 @@
+/**
+ * Plugin Metrics - counters reported with each heartbeat
+ */
+
+#include <pspkernel.h>
+#include <pspsysmem.h>
+#include <string.h>
+
+#include "drp_metrics.h"
+
+/* Current window, restarted by drp_metrics_report(). Kept unpacked and at
+ * full width; HeartbeatMetrics is only the wire format. */
+typedef struct {
+  uint64_t start_us; /* The first window runs from boot */
+  uint32_t detect_count;
+  uint32_t detect_hist[METRICS_DETECT_BUCKETS];
+  uint64_t detect_total_us;
+  uint32_t detect_max_us;
+  uint32_t tx_packets;
+  uint32_t tx_bytes;
+  uint32_t rx_packets;
+  uint32_t rx_bytes;
+  uint32_t send_failures;
+  uint32_t retransmits;
+  uint32_t wakeups;
+} MetricsWindow;
+
+static MetricsWindow g_window;
+
+/* Sent packets since boot, for the icon cost */
+static uint32_t g_tx_packets_total;
+static uint32_t g_tx_bytes_total;
+static uint32_t g_icon_start_packets;
+static uint32_t g_icon_start_bytes;
+
+/* Kept across windows */
+static uint32_t g_icon_packets;
+static uint32_t g_icon_bytes;
+static uint32_t g_sync_rtt_ms;
+
+static uint16_t sat16(uint32_t n) {
+  return (uint16_t)(n > 0xFFFF ? 0xFFFF : n);
+}
+
+void drp_metrics_tx(int result, uint32_t bytes) {
+  if (result < 0) {
+    g_window.send_failures++;
+    return;
+  }
+
+  g_window.tx_packets++;
+  g_window.tx_bytes += bytes;
+  g_tx_packets_total++;
+  g_tx_bytes_total += bytes;
+}
+
+void drp_metrics_rx(uint32_t bytes) {
+  g_window.rx_packets++;
+  g_window.rx_bytes += bytes;
+}
+
+void drp_metrics_retransmit(void) { g_window.retransmits++; }
+
+void drp_metrics_wakeup(void) { g_window.wakeups++; }
+
+void drp_metrics_detect(uint32_t us) {
+  uint32_t ms = us / 1000;
+  int bucket = 0;
+
+  while (ms > 0 && bucket < METRICS_DETECT_BUCKETS - 1) {
+    ms >>= 1;
+    bucket++;
+  }
+
+  g_window.detect_hist[bucket]++;
+  g_window.detect_count++;
+  g_window.detect_total_us += us;
+  if (us > g_window.detect_max_us) {
+    g_window.detect_max_us = us;
+  }
+}
+
+void drp_metrics_icon_begin(void) {
+  g_icon_start_packets = g_tx_packets_total;
+  g_icon_start_bytes = g_tx_bytes_total;
+}
+
+void drp_metrics_icon_end(void) {
+  g_icon_packets = g_tx_packets_total - g_icon_start_packets;
+  g_icon_bytes = g_tx_bytes_total - g_icon_start_bytes;
+}
+
+void drp_metrics_sync(uint64_t rtt_us) {
+  g_sync_rtt_ms = (uint32_t)(rtt_us / 1000);
+}
+
+void drp_metrics_report(HeartbeatMetrics *out, const char *game_id,
+                        uint64_t now_us) {
+  int i;
+
+  memset(out, 0, sizeof(*out));
+  out->version = METRICS_VERSION;
+  out->window_ms = (uint32_t)((now_us - g_window.start_us) / 1000);
+  if (game_id != NULL) {
+    strncpy(out->game_id, game_id, sizeof(out->game_id) - 1);
+  }
+
+  out->detect_count = sat16(g_window.detect_count);
+  for (i = 0; i < METRICS_DETECT_BUCKETS; i++) {
+    out->detect_hist[i] = sat16(g_window.detect_hist[i]);
+  }
+  if (g_window.detect_count > 0) {
+    out->detect_avg_us =
+        (uint32_t)(g_window.detect_total_us / g_window.detect_count);
+  }
+  out->detect_max_us = g_window.detect_max_us;
+
+  out->tx_packets = g_window.tx_packets;
+  out->tx_bytes = g_window.tx_bytes;
+  out->rx_packets = g_window.rx_packets;
+  out->rx_bytes = g_window.rx_bytes;
+  out->send_failures = sat16(g_window.send_failures);
+  out->retransmits = sat16(g_window.retransmits);
+  out->wakeups = sat16(g_window.wakeups);
+
+  out->icon_bytes = g_icon_bytes;
+  out->icon_packets = sat16(g_icon_packets);
+  out->sync_rtt_ms = g_sync_rtt_ms;
+  out->heap_free = (uint32_t)sceKernelTotalFreeMemSize();
+
+  memset(&g_window, 0, sizeof(g_window));
+  g_window.start_us = now_us;
+}
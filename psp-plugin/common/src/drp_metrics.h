@@ -0,0 +1,103 @@
+/**
+ * Plugin Metrics
+ *
+ * Counters and a detection-time histogram kept by the shared core and the
+ * transports, reported to the desktop as an extension of every heartbeat.
+ * Counters cover the window since the previous heartbeat and restart after
+ * each report; desktops that predate the extension ignore the extra bytes.
+ */
+
+#ifndef DRP_METRICS_H
+#define DRP_METRICS_H
+
+#include <stdint.h>
+
+#define METRICS_VERSION 1
+
+/* Detection time buckets: < 1, 2, 4, 8, 16, 32, 64 ms, and >= 64 ms */
+#define METRICS_DETECT_BUCKETS 8
+
+/* Heartbeat metrics extension, appended to the heartbeat payload */
+typedef struct {
+  uint8_t version; /* METRICS_VERSION */
+  uint8_t reserved;
+  uint16_t detect_count; /* Game detections */
+  uint32_t window_ms;    /* Time covered by the window counters */
+  char game_id[10];      /* Game running when the window closed */
+  uint16_t send_failures;
+  uint16_t detect_hist[METRICS_DETECT_BUCKETS];
+  uint32_t detect_avg_us;
+  uint32_t detect_max_us;
+
+  /* Transport */
+  uint32_t tx_packets;
+  uint32_t tx_bytes;
+  uint32_t rx_packets;
+  uint32_t rx_bytes;
+  uint16_t retransmits; /* Chunks sent again after loss */
+  uint16_t wakeups;     /* Main loop iterations */
+
+  /* Cost of the last icon sent (any window) */
+  uint32_t icon_bytes;
+  uint16_t icon_packets;
+  uint16_t reserved2;
+
+  uint32_t sync_rtt_ms; /* Last completed stats sync, 0 = none yet */
+  uint32_t heap_free;   /* sceKernelTotalFreeMemSize() */
+} __attribute__((packed)) HeartbeatMetrics;
+
+/**
+ * Count one packet sent
+ *
+ * @param result Send result, negative counts as a failure
+ * @param bytes Packet size
+ */
+void drp_metrics_tx(int result, uint32_t bytes);
+
+/**
+ * Count one packet received
+ */
+void drp_metrics_rx(uint32_t bytes);
+
+/**
+ * Count a chunk sent again after it was lost
+ */
+void drp_metrics_retransmit(void);
+
+/**
+ * Count a main loop wakeup
+ */
+void drp_metrics_wakeup(void);
+
+/**
+ * Record one game detection
+ *
+ * @param us Time game_detect_current() took
+ */
+void drp_metrics_detect(uint32_t us);
+
+/**
+ * Bracket an icon transfer; the packets and bytes sent in between become
+ * the reported icon cost
+ */
+void drp_metrics_icon_begin(void);
+void drp_metrics_icon_end(void);
+
+/**
+ * Record a completed stats sync
+ *
+ * @param rtt_us Time from the request to the complete response
+ */
+void drp_metrics_sync(uint64_t rtt_us);
+
+/**
+ * Fill a heartbeat extension with the current window and start a new one
+ *
+ * @param out Extension to fill
+ * @param game_id Current game, can be empty
+ * @param now_us Current drp_time_us()
+ */
+void drp_metrics_report(HeartbeatMetrics *out, const char *game_id,
+                        uint64_t now_us);
+
+#endif /* DRP_METRICS_H */
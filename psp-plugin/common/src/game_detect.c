@@ -11,7 +11,8 @@
 #include <string.h>
 
 #include "game_detect.h"
-#include "network.h"
+#include "icon_cache.h"
+#include "plugin_log.h"
 #include "sfo.h"
 
 /* Path to running game's directory */
@@ -20,6 +21,32 @@ static char g_game_path[256] = {0};
 /* Start time of current game */
 static uint32_t g_game_start_time = 0;
 
+/* Maximum modules tracked for the change signature. A game with its
+ * plugins loads well over 64; a longer list counts as changed on every
+ * check rather than hiding changes past the cut. */
+#define DETECT_MAX_MODULES 256
+
+/*
+ * Detection cache. A full probe (UMD -> ISO -> EBOOT -> modules) costs
+ * several sceIoGetstat/sceIoOpen calls plus SFO parsing, and the disc0:
+ * path retries with sleeps. Between polls nothing normally changes, so the
+ * last result is reused until one of the cheap signals below differs.
+ */
+typedef struct {
+  int valid;
+  int umd_present;         /* sceUmdCheckMedium() at detection time */
+  int module_count;        /* Number of loaded modules */
+  uint32_t module_hash;    /* Hash of the sorted module ID list */
+  char sfo_path[256];      /* PARAM.SFO the result came from ("" if none) */
+  SceIoStat sfo_stat;      /* Stat of sfo_path (size/mtime) when cached */
+  GameInfo info;           /* Cached result */
+} DetectCache;
+
+static DetectCache g_detect_cache;
+
+/* PARAM.SFO used by the most recent successful probe */
+static char g_detect_sfo_path[256] = {0};
+
 /* Forward declarations */
 static int detect_umd_game(GameInfo *info);
 static int detect_iso_game(GameInfo *info);
@@ -32,6 +59,12 @@ static int build_path(char *out, size_t out_size, const char *base,
                       const char *name, const char *suffix);
 static int is_umd_game_id(const char *id);
 static int try_read_sfo_with_diag(const char *path, SfoData *sfo);
+static int read_signature(int *umd_present, int *module_count,
+                          uint32_t *module_hash);
+static int cache_still_valid(int umd_present, int module_count,
+                             uint32_t module_hash);
+static void cache_store(const GameInfo *info, int umd_present,
+                        int module_count, uint32_t module_hash);
 
 /**
  * Initialize game detection
@@ -39,6 +72,15 @@ static int try_read_sfo_with_diag(const char *path, SfoData *sfo);
 void game_detect_init(void) {
   memset(g_game_path, 0, sizeof(g_game_path));
   g_game_start_time = 0;
+  game_detect_invalidate();
+}
+
+/**
+ * Drop the cached detection result
+ */
+void game_detect_invalidate(void) {
+  memset(&g_detect_cache, 0, sizeof(g_detect_cache));
+  g_detect_sfo_path[0] = '\0';
 }
 
 /**
@@ -46,9 +88,22 @@ void game_detect_init(void) {
  */
 int game_detect_current(GameInfo *info) {
   int result;
+  int umd_present;
+  int module_count;
+  uint32_t module_hash;
 
   memset(info, 0, sizeof(GameInfo));
 
+  /* Cheap change check before doing any file I/O */
+  if (read_signature(&umd_present, &module_count, &module_hash) == 0 &&
+      cache_still_valid(umd_present, module_count, module_hash)) {
+    memcpy(info, &g_detect_cache.info, sizeof(GameInfo));
+    return 0;
+  }
+
+  net_log("detect: signature changed, probing");
+  g_detect_sfo_path[0] = '\0';
+
   /* Try UMD first */
   result = detect_umd_game(info);
   if (result == 0 && info->game_id[0] != '\0') {
@@ -80,6 +135,7 @@ int game_detect_current(GameInfo *info) {
   info->start_time = 0;
   info->has_icon = 0;
 
+  cache_store(info, umd_present, module_count, module_hash);
   return 0;
 
 found:
@@ -92,9 +148,170 @@ found:
   }
   info->start_time = g_game_start_time;
 
+  cache_store(info, umd_present, module_count, module_hash);
   return 0;
 }
 
+/**
+ * Adopt a detection result from the loader as the cached probe
+ */
+void game_detect_seed(GameInfo *info, const char *game_path) {
+  int umd_present;
+  int module_count;
+  uint32_t module_hash;
+
+  info->state = determine_state(info->game_id);
+  if (g_game_start_time == 0) {
+    g_game_start_time = get_unix_time();
+  }
+  info->start_time = g_game_start_time;
+
+  copy_str(g_game_path, sizeof(g_game_path), game_path);
+  build_path(g_detect_sfo_path, sizeof(g_detect_sfo_path), game_path, NULL,
+             "PARAM.SFO");
+
+  read_signature(&umd_present, &module_count, &module_hash);
+  cache_store(info, umd_present, module_count, module_hash);
+}
+
+/**
+ * Cheap check for a change in the loaded module set or UMD state since the
+ * previous call. No file I/O - safe to call on every loop iteration.
+ */
+int game_detect_modules_changed(void) {
+  static int s_valid = 0;
+  static int s_umd_present = 0;
+  static int s_module_count = 0;
+  static uint32_t s_module_hash = 0;
+  int umd_present;
+  int module_count;
+  uint32_t module_hash;
+  int changed;
+
+  changed = read_signature(&umd_present, &module_count, &module_hash) != 0;
+  changed = changed || !s_valid || umd_present != s_umd_present ||
+            module_count != s_module_count || module_hash != s_module_hash;
+
+  s_valid = 1;
+  s_umd_present = umd_present;
+  s_module_count = module_count;
+  s_module_hash = module_hash;
+
+  return changed;
+}
+
+/**
+ * Collect the cheap change signals: UMD presence and the loaded module list.
+ * The module ID list is sorted before hashing so enumeration order does not
+ * matter. Any module load/unload yields a new UID and therefore a new hash.
+ *
+ * @return 0, or 1 if the module list did not fit and the signature cannot
+ *         be trusted
+ */
+static int read_signature(int *umd_present, int *module_count,
+                          uint32_t *module_hash) {
+  static SceUID mod_ids[DETECT_MAX_MODULES]; /* Too big for the stack */
+  int count = 0;
+  int truncated = 0;
+  uint32_t hash = 2166136261u; /* FNV-1a offset basis */
+  int i;
+  int j;
+
+  *umd_present = sceUmdCheckMedium();
+
+  if (sceKernelGetModuleIdList(mod_ids, sizeof(mod_ids), &count) < 0) {
+    count = 0;
+  }
+  if (count > DETECT_MAX_MODULES) {
+    count = DETECT_MAX_MODULES;
+    truncated = 1;
+  }
+
+  /* Insertion sort - the list is short and mostly sorted already */
+  for (i = 1; i < count; i++) {
+    SceUID key = mod_ids[i];
+    j = i - 1;
+    while (j >= 0 && mod_ids[j] > key) {
+      mod_ids[j + 1] = mod_ids[j];
+      j--;
+    }
+    mod_ids[j + 1] = key;
+  }
+
+  for (i = 0; i < count; i++) {
+    uint32_t id = (uint32_t)mod_ids[i];
+    for (j = 0; j < 4; j++) {
+      hash ^= (id >> (j * 8)) & 0xFF;
+      hash *= 16777619u; /* FNV-1a prime */
+    }
+  }
+
+  *module_count = count;
+  *module_hash = hash;
+  return truncated;
+}
+
+/**
+ * Check whether the cached result still matches the current system state.
+ * Costs at most one sceIoGetstat (the mtime of the SFO the result came from).
+ */
+static int cache_still_valid(int umd_present, int module_count,
+                             uint32_t module_hash) {
+  SceIoStat stat;
+
+  if (!g_detect_cache.valid) {
+    return 0;
+  }
+
+  if (g_detect_cache.umd_present != umd_present ||
+      g_detect_cache.module_count != module_count ||
+      g_detect_cache.module_hash != module_hash) {
+    return 0;
+  }
+
+  /*
+   * Same modules: make sure the mount behind the result was not swapped.
+   * The whole stat is compared so this works whatever the SDK calls the
+   * mtime field; a mounted ISO is read-only so nothing else moves.
+   */
+  if (g_detect_cache.sfo_path[0] != '\0') {
+    memset(&stat, 0, sizeof(stat));
+    if (sceIoGetstat(g_detect_cache.sfo_path, &stat) < 0) {
+      return 0;
+    }
+    if (memcmp(&stat, &g_detect_cache.sfo_stat, sizeof(stat)) != 0) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/**
+ * Remember a probe result together with the signals it was taken under
+ */
+static void cache_store(const GameInfo *info, int umd_present,
+                        int module_count, uint32_t module_hash) {
+  SceIoStat stat;
+
+  memset(&g_detect_cache, 0, sizeof(g_detect_cache));
+  memcpy(&g_detect_cache.info, info, sizeof(GameInfo));
+  g_detect_cache.umd_present = umd_present;
+  g_detect_cache.module_count = module_count;
+  g_detect_cache.module_hash = module_hash;
+
+  if (g_detect_sfo_path[0] != '\0') {
+    memset(&stat, 0, sizeof(stat));
+    if (sceIoGetstat(g_detect_sfo_path, &stat) >= 0) {
+      copy_str(g_detect_cache.sfo_path, sizeof(g_detect_cache.sfo_path),
+               g_detect_sfo_path);
+      memcpy(&g_detect_cache.sfo_stat, &stat, sizeof(stat));
+    }
+  }
+
+  g_detect_cache.valid = 1;
+}
+
 /**
  * Safe string copy with null termination
  */
@@ -189,6 +406,7 @@ static int detect_umd_game(GameInfo *info) {
   if (sfo_parse_file(path, &sfo) < 0) {
     return -1;
   }
+  copy_str(g_detect_sfo_path, sizeof(g_detect_sfo_path), path);
 
   /* Use disc_id if available, otherwise fall back to title_id */
   if (sfo.disc_id[0] != '\0') {
@@ -234,6 +452,8 @@ static int detect_iso_game(GameInfo *info) {
       /* Prefer title_id for UMD/ISO games (format XXXX#####) */
       const char *game_id = NULL;
 
+      copy_str(g_detect_sfo_path, sizeof(g_detect_sfo_path), iso_mounts[i]);
+
       /* Check title_id first - UMD games always have this in proper format */
       if (sfo.title_id[0] != '\0' && is_umd_game_id(sfo.title_id)) {
         game_id = sfo.title_id;
@@ -306,6 +526,7 @@ static int detect_eboot_game(GameInfo *info) {
                                 : (sfo.title_id[0] != '\0') ? sfo.title_id
                                                             : "";
       net_log("detect_eboot: found! id=%s title=%s", game_id_src, sfo.title);
+      copy_str(g_detect_sfo_path, sizeof(g_detect_sfo_path), eboot_mounts[i]);
       copy_str(info->game_id, sizeof(info->game_id), game_id_src);
       copy_str(info->title, sizeof(info->title), sfo.title);
 
@@ -414,6 +635,7 @@ static int detect_module_game(GameInfo *info) {
 
     if (sfo_parse_file(sfo_path, &sfo) == 0) {
       net_log("detect_module: found! id=%s title=%s", sfo.disc_id, sfo.title);
+      copy_str(g_detect_sfo_path, sizeof(g_detect_sfo_path), sfo_path);
       copy_str(info->game_id, sizeof(info->game_id), sfo.disc_id);
       copy_str(info->title, sizeof(info->title), sfo.title);
 
@@ -437,6 +659,7 @@ static int detect_module_game(GameInfo *info) {
     if (sfo_parse_file(sfo_path, &sfo) == 0) {
       net_log("detect_module: found on ef0! id=%s title=%s", sfo.disc_id,
               sfo.title);
+      copy_str(g_detect_sfo_path, sizeof(g_detect_sfo_path), sfo_path);
       copy_str(info->game_id, sizeof(info->game_id), sfo.disc_id);
       copy_str(info->title, sizeof(info->title), sfo.title);
 
@@ -469,6 +692,9 @@ static int detect_module_game(GameInfo *info) {
     if (try_read_sfo_with_diag("disc0:/PSP_GAME/PARAM.SFO", &sfo) == 0) {
       /* Use title_id for UMD/ISO games (format XXXX#####) */
       const char *game_id = NULL;
+
+      copy_str(g_detect_sfo_path, sizeof(g_detect_sfo_path),
+               "disc0:/PSP_GAME/PARAM.SFO");
       if (sfo.title_id[0] != '\0' && is_umd_game_id(sfo.title_id)) {
         game_id = sfo.title_id;
       } else if (sfo.disc_id[0] != '\0') {
@@ -502,6 +728,9 @@ static int detect_module_game(GameInfo *info) {
     net_log("detect_module: trying umd0 for ISO game info");
     if (try_read_sfo_with_diag("umd0:/PSP_GAME/PARAM.SFO", &sfo) == 0) {
       const char *game_id = NULL;
+
+      copy_str(g_detect_sfo_path, sizeof(g_detect_sfo_path),
+               "umd0:/PSP_GAME/PARAM.SFO");
       if (sfo.title_id[0] != '\0' && is_umd_game_id(sfo.title_id)) {
         game_id = sfo.title_id;
       } else if (sfo.disc_id[0] != '\0') {
@@ -577,6 +806,7 @@ static int detect_module_game(GameInfo *info) {
 
           /* Use this game if it has a valid title */
           if (sfo.title[0] != '\0') {
+            copy_str(g_detect_sfo_path, sizeof(g_detect_sfo_path), sfo_path);
             /* Use folder name as ID if disc_id is empty */
             if (sfo.disc_id[0] != '\0') {
               copy_str(info->game_id, sizeof(info->game_id), sfo.disc_id);
@@ -686,8 +916,13 @@ int game_detect_get_icon(const char *game_id, uint8_t *buffer,
   char icon_path[256];
   SceUID fd;
   SceIoStat stat;
+  int ret;
 
-  (void)game_id; /* Use stored path instead */
+  /* Served from the Memory Stick copy when we've sent this icon before */
+  ret = icon_cache_read(game_id, buffer, buffer_size, icon_size);
+  if (ret == 0 || ret == -2) {
+    return ret;
+  }
 
   if (g_game_path[0] == '\0') {
     return -1;
@@ -714,10 +949,25 @@ int game_detect_get_icon(const char *game_id, uint8_t *buffer,
     return -1;
   }
 
-  *icon_size = sceIoRead(fd, buffer, stat.st_size);
+  ret = sceIoRead(fd, buffer, stat.st_size);
   sceIoClose(fd);
 
-  return (*icon_size > 0) ? 0 : -1;
+  if (ret <= 0) {
+    return -1;
+  }
+  *icon_size = (uint32_t)ret;
+
+  /* g_game_path belongs to the current game, so cache under its ID */
+  if (g_detect_cache.valid && g_detect_cache.info.game_id[0] != '\0') {
+    ret = icon_cache_store(g_detect_cache.info.game_id,
+                           g_detect_cache.info.title,
+                           g_detect_cache.info.state, buffer, *icon_size);
+    if (ret < 0) {
+      net_log("icon_cache: store %s failed", g_detect_cache.info.game_id);
+    }
+  }
+
+  return 0;
 }
 
 /**
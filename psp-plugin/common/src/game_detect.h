@@ -0,0 +1,64 @@
+/**
+ * Game Detection Module
+ */
+
+#ifndef GAME_DETECT_H
+#define GAME_DETECT_H
+
+#include "discord_rpc.h"
+
+/**
+ * Initialize game detection
+ */
+void game_detect_init(void);
+
+/**
+ * Invalidate the cached detection result so the next
+ * game_detect_current() call performs a full probe
+ */
+void game_detect_invalidate(void);
+
+/* In event-driven mode, poll_interval_ms is stretched by this factor and
+ * only used as a fallback for changes the module signature can't see */
+#define DETECT_EVENT_FALLBACK_FACTOR 6
+
+/**
+ * Check whether the loaded module set or UMD state changed since the last
+ * call. Costs one module list query, no Memory Stick access.
+ *
+ * @return 1 if changed (or first call), 0 otherwise
+ */
+int game_detect_modules_changed(void);
+
+/**
+ * Detect the currently running game/application
+ * 
+ * @param info Output structure for game information
+ * @return 0 on success, negative on error
+ */
+int game_detect_current(GameInfo *info);
+
+/**
+ * Take a game detected elsewhere (the loader's handoff) as the current
+ * result, so game_detect_current() only probes again once the module set
+ * or the game's PARAM.SFO changes
+ *
+ * @param info Game ID, title and has_icon; state and start_time are set here
+ * @param game_path Directory holding the game's PARAM.SFO and ICON0.PNG
+ */
+void game_detect_seed(GameInfo *info, const char *game_path);
+
+/**
+ * Extract icon data for the current game. Icons sent before are read
+ * from the on-Memory-Stick cache (icon_cache.h) instead of the game media.
+ * 
+ * @param game_id Game ID to get icon for
+ * @param buffer Output buffer for icon data
+ * @param buffer_size Size of output buffer
+ * @param icon_size Output: actual icon size
+ * @return 0 on success, negative on error
+ */
+int game_detect_get_icon(const char *game_id, uint8_t *buffer, 
+                         uint32_t buffer_size, uint32_t *icon_size);
+
+#endif /* GAME_DETECT_H */
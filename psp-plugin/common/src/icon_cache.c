@@ -0,0 +1,307 @@
+/**
+ * Icon Cache Implementation
+ *
+ * The index is small enough to keep in RAM once loaded; it is rewritten as a
+ * whole after every change. Icon bytes are only ever appended to the blob,
+ * and the index is written after the blob, so an interrupted write leaves
+ * the previous index pointing at data that is still intact.
+ */
+
+#include <pspiofilemgr.h>
+#include <pspkernel.h>
+#include <string.h>
+
+#include "icon_cache.h"
+
+static IconCacheHeader g_header;
+static IconCacheEntry g_entries[ICON_CACHE_MAX_ENTRIES];
+static int g_loaded = 0;
+
+/**
+ * Compare a stored game ID against a caller-supplied one
+ */
+static int id_matches(const char *stored, const char *game_id) {
+  return strncmp(stored, game_id, sizeof(((IconCacheEntry *)0)->game_id)) ==
+         0;
+}
+
+/**
+ * Safe string copy with null termination
+ */
+static void copy_str(char *dst, size_t dst_size, const char *src) {
+  size_t len;
+  if (dst == NULL || dst_size == 0) {
+    return;
+  }
+  if (src == NULL) {
+    dst[0] = '\0';
+    return;
+  }
+  len = strlen(src);
+  if (len >= dst_size) {
+    len = dst_size - 1;
+  }
+  memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+static void reset_index(void) {
+  memset(&g_header, 0, sizeof(g_header));
+  memcpy(g_header.magic, ICON_CACHE_MAGIC, 4);
+  g_header.version = ICON_CACHE_VERSION;
+  memset(g_entries, 0, sizeof(g_entries));
+}
+
+/**
+ * Load the index from the Memory Stick on first use. A missing or damaged
+ * index just means an empty cache.
+ */
+static void load_index(void) {
+  SceUID fd;
+  int i;
+  int count;
+  int valid = 0;
+
+  if (g_loaded) {
+    return;
+  }
+  g_loaded = 1;
+  reset_index();
+
+  fd = sceIoOpen(ICON_CACHE_INDEX_PATH, PSP_O_RDONLY, 0);
+  if (fd < 0) {
+    return;
+  }
+
+  if (sceIoRead(fd, &g_header, sizeof(g_header)) == sizeof(g_header) &&
+      memcmp(g_header.magic, ICON_CACHE_MAGIC, 4) == 0 &&
+      g_header.version == ICON_CACHE_VERSION &&
+      g_header.count <= ICON_CACHE_MAX_ENTRIES) {
+    int bytes = (int)(g_header.count * sizeof(IconCacheEntry));
+    valid = (sceIoRead(fd, g_entries, bytes) == bytes);
+  }
+  sceIoClose(fd);
+
+  if (!valid) {
+    reset_index();
+    return;
+  }
+
+  /* Drop entries that point past the end of the blob */
+  count = 0;
+  for (i = 0; i < g_header.count; i++) {
+    IconCacheEntry *e = &g_entries[i];
+    if (e->icon_size == 0 || e->blob_offset > g_header.blob_size ||
+        e->icon_size > g_header.blob_size - e->blob_offset) {
+      continue;
+    }
+    e->game_id[sizeof(e->game_id) - 1] = '\0';
+    e->title[sizeof(e->title) - 1] = '\0';
+    if (count != i) {
+      memcpy(&g_entries[count], e, sizeof(IconCacheEntry));
+    }
+    count++;
+  }
+  g_header.count = (uint16_t)count;
+}
+
+static int save_index(void) {
+  SceUID fd;
+  int bytes = (int)(g_header.count * sizeof(IconCacheEntry));
+  int ok;
+
+  fd = sceIoOpen(ICON_CACHE_INDEX_PATH,
+                 PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC, 0777);
+  if (fd < 0) {
+    return -1;
+  }
+
+  ok = (sceIoWrite(fd, &g_header, sizeof(g_header)) == sizeof(g_header));
+  if (ok && bytes > 0) {
+    ok = (sceIoWrite(fd, g_entries, bytes) == bytes);
+  }
+  sceIoClose(fd);
+
+  return ok ? 0 : -1;
+}
+
+static int find_entry(const char *game_id) {
+  int i;
+
+  if (game_id == NULL || game_id[0] == '\0') {
+    return -1;
+  }
+
+  load_index();
+  for (i = 0; i < g_header.count; i++) {
+    if (id_matches(g_entries[i].game_id, game_id)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Calculate the CRC32 used for cached icons
+ */
+uint32_t icon_cache_crc32(const uint8_t *data, uint32_t len) {
+  uint32_t crc = 0xFFFFFFFF;
+  uint32_t i;
+  uint32_t j;
+  if (data == NULL) {
+    return 0;
+  }
+  for (i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (j = 0; j < 8; j++) {
+      if (crc & 1) {
+        crc = (crc >> 1) ^ 0xEDB88320;
+      } else {
+        crc >>= 1;
+      }
+    }
+  }
+  return crc ^ 0xFFFFFFFF;
+}
+
+/**
+ * Look up a cached game without reading the icon
+ */
+int icon_cache_lookup(const char *game_id, IconCacheEntry *entry) {
+  int idx = find_entry(game_id);
+
+  if (idx < 0) {
+    return -1;
+  }
+  if (entry != NULL) {
+    memcpy(entry, &g_entries[idx], sizeof(IconCacheEntry));
+  }
+  return 0;
+}
+
+/**
+ * Read a cached icon
+ */
+int icon_cache_read(const char *game_id, uint8_t *buffer,
+                    uint32_t buffer_size, uint32_t *icon_size) {
+  IconCacheEntry *e;
+  SceUID fd;
+  int idx;
+  int read;
+
+  idx = find_entry(game_id);
+  if (idx < 0) {
+    return -1;
+  }
+  e = &g_entries[idx];
+
+  if (e->icon_size > buffer_size) {
+    *icon_size = e->icon_size;
+    return -2; /* Buffer too small */
+  }
+
+  fd = sceIoOpen(ICON_CACHE_BLOB_PATH, PSP_O_RDONLY, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  read = -1;
+  if (sceIoLseek32(fd, (int)e->blob_offset, PSP_SEEK_SET) ==
+      (int)e->blob_offset) {
+    read = sceIoRead(fd, buffer, e->icon_size);
+  }
+  sceIoClose(fd);
+
+  if (read != (int)e->icon_size ||
+      icon_cache_crc32(buffer, e->icon_size) != e->icon_crc32) {
+    return -1; /* Caller falls back to the original ICON0.PNG */
+  }
+
+  *icon_size = e->icon_size;
+  return 0;
+}
+
+/**
+ * Add or refresh a cached icon
+ */
+int icon_cache_store(const char *game_id, const char *title, uint8_t state,
+                     const uint8_t *icon, uint32_t icon_size) {
+  IconCacheEntry *e;
+  SceUID fd;
+  uint32_t crc;
+  uint32_t offset;
+  int idx;
+  int written;
+
+  if (game_id == NULL || game_id[0] == '\0' || icon == NULL ||
+      icon_size == 0 || icon_size > ICON_CACHE_BLOB_MAX) {
+    return -1;
+  }
+
+  crc = icon_cache_crc32(icon, icon_size);
+  idx = find_entry(game_id);
+
+  if (idx >= 0 && g_entries[idx].icon_size == icon_size &&
+      g_entries[idx].icon_crc32 == crc) {
+    /* Same icon - only the metadata can have changed */
+    e = &g_entries[idx];
+    if (e->state == state &&
+        (title == NULL || strncmp(e->title, title, sizeof(e->title)) == 0)) {
+      return 0;
+    }
+    e->state = state;
+    if (title != NULL) {
+      copy_str(e->title, sizeof(e->title), title);
+    }
+    return save_index();
+  }
+
+  /* Start over rather than let the blob grow without bound */
+  if (g_header.blob_size + icon_size > ICON_CACHE_BLOB_MAX) {
+    reset_index();
+    idx = -1;
+  }
+
+  fd = sceIoOpen(ICON_CACHE_BLOB_PATH,
+                 PSP_O_WRONLY | PSP_O_CREAT |
+                     (g_header.blob_size == 0 ? PSP_O_TRUNC : 0),
+                 0777);
+  if (fd < 0) {
+    return -1;
+  }
+
+  /* Append at the end the index knows about, overwriting any tail left by
+   * an interrupted store */
+  offset = g_header.blob_size;
+  written = -1;
+  if (sceIoLseek32(fd, (int)offset, PSP_SEEK_SET) == (int)offset) {
+    written = sceIoWrite(fd, icon, icon_size);
+  }
+  sceIoClose(fd);
+
+  if (written != (int)icon_size) {
+    return -1;
+  }
+  g_header.blob_size = offset + icon_size;
+
+  if (idx < 0) {
+    if (g_header.count == ICON_CACHE_MAX_ENTRIES) {
+      /* Evict the oldest entry; its bytes are reclaimed on the next reset */
+      memmove(&g_entries[0], &g_entries[1],
+              (ICON_CACHE_MAX_ENTRIES - 1) * sizeof(IconCacheEntry));
+      g_header.count--;
+    }
+    idx = g_header.count++;
+  }
+
+  e = &g_entries[idx];
+  memset(e, 0, sizeof(IconCacheEntry));
+  copy_str(e->game_id, sizeof(e->game_id), game_id);
+  copy_str(e->title, sizeof(e->title), title);
+  e->state = state;
+  e->icon_size = icon_size;
+  e->icon_crc32 = crc;
+  e->blob_offset = offset;
+
+  return save_index();
+}
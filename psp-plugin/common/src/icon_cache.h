@@ -0,0 +1,90 @@
+/**
+ * Icon Cache Module
+ *
+ * Keeps a copy of every ICON0.PNG sent so far on the Memory Stick, keyed by
+ * game ID. Later requests for the same game are served from ms0: instead of
+ * spinning up the UMD or re-reading the ISO, and the stored CRC32 lets the
+ * caller describe the icon without touching the data at all.
+ *
+ * On-disk layout (both files under SEPLUGINS/pspdrp/):
+ *   icons.idx  IconCacheHeader followed by `count` IconCacheEntry records
+ *   icons.bin  Icon bytes, appended; entries point into it by offset
+ */
+
+#ifndef ICON_CACHE_H
+#define ICON_CACHE_H
+
+#include <stdint.h>
+
+#define ICON_CACHE_INDEX_PATH "ms0:/SEPLUGINS/pspdrp/icons.idx"
+#define ICON_CACHE_BLOB_PATH "ms0:/SEPLUGINS/pspdrp/icons.bin"
+
+#define ICON_CACHE_MAGIC "PDIC"
+#define ICON_CACHE_VERSION 1
+
+/* Entries kept in the index (oldest is evicted when full) */
+#define ICON_CACHE_MAX_ENTRIES 64
+
+/* The blob is started over once it would grow past this */
+#define ICON_CACHE_BLOB_MAX (1024 * 1024)
+
+/* Index file header */
+typedef struct {
+  char magic[4];      /* ICON_CACHE_MAGIC */
+  uint16_t version;   /* ICON_CACHE_VERSION */
+  uint16_t count;     /* Number of entries that follow */
+  uint32_t blob_size; /* Bytes of icons.bin covered by the index */
+} __attribute__((packed)) IconCacheHeader;
+
+/* Index entry, one per game */
+typedef struct {
+  char game_id[10];     /* Game ID (e.g., "UCUS98632") */
+  char title[128];      /* Title from PARAM.SFO */
+  uint8_t state;        /* STATE_* the game was detected with */
+  uint8_t reserved;
+  uint32_t icon_size;   /* ICON0.PNG size in bytes */
+  uint32_t icon_crc32;  /* CRC32 of the icon bytes */
+  uint32_t blob_offset; /* Offset of the icon in icons.bin */
+} __attribute__((packed)) IconCacheEntry;
+
+/**
+ * Calculate the CRC32 used for cached icons (same as MSG_ICON_END)
+ */
+uint32_t icon_cache_crc32(const uint8_t *data, uint32_t len);
+
+/**
+ * Look up a cached game without reading the icon
+ *
+ * @param game_id Game ID to look up
+ * @param entry Output: copy of the index entry, can be NULL
+ * @return 0 if cached, -1 if not
+ */
+int icon_cache_lookup(const char *game_id, IconCacheEntry *entry);
+
+/**
+ * Read a cached icon
+ *
+ * @param game_id Game ID to read the icon for
+ * @param buffer Output buffer for icon data
+ * @param buffer_size Size of output buffer
+ * @param icon_size Output: icon size
+ * @return 0 on success, -1 if not cached or unreadable, -2 if buffer too small
+ */
+int icon_cache_read(const char *game_id, uint8_t *buffer,
+                    uint32_t buffer_size, uint32_t *icon_size);
+
+/**
+ * Add or refresh a cached icon. Nothing is written if the same icon is
+ * already cached with the same title and state.
+ *
+ * @param game_id Game ID
+ * @param title Game title, can be NULL
+ * @param state STATE_* value
+ * @param icon Icon bytes
+ * @param icon_size Icon size
+ * @return 0 on success, negative on error
+ */
+int icon_cache_store(const char *game_id, const char *title, uint8_t state,
+                     const uint8_t *icon, uint32_t icon_size);
+
+#endif /* ICON_CACHE_H */
@@ -0,0 +1,18 @@
+/**
+ * Logging for sources shared by the net and USB plugins
+ *
+ * The net plugin provides net_log() (logger.c). The USB plugin runs in
+ * kernel mode without a printf-style formatter, so there the calls compile
+ * away; its Makefile defines PSP_DRP_KERNEL.
+ */
+
+#ifndef PLUGIN_LOG_H
+#define PLUGIN_LOG_H
+
+#ifdef PSP_DRP_KERNEL
+#define net_log(...) ((void)0)
+#else
+void net_log(const char *fmt, ...);
+#endif
+
+#endif /* PLUGIN_LOG_H */
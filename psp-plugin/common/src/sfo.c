@@ -6,6 +6,7 @@
 #include <pspkernel.h>
 #include <string.h>
 
+#include "plugin_log.h"
 #include "sfo.h"
 
 /* SFO file format structures */
@@ -138,7 +139,8 @@ int sfo_parse_file(const char *path, SfoData *data) {
     }
 
     /* Sanity check size - must fit in our static buffer */
-    if (stat.st_size < sizeof(SfoHeader) || stat.st_size > sizeof(buffer)) {
+    if (stat.st_size < (SceOff)sizeof(SfoHeader) ||
+        stat.st_size > (SceOff)sizeof(buffer)) {
       return -1;
     }
 
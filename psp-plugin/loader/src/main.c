@@ -4,6 +4,8 @@
 #include <stdarg.h>
 #include <string.h>
 
+#include "drp_handoff.h"
+
 #ifndef LOADER_MODULE_NAME
 #define LOADER_MODULE_NAME "PSPDRP_Loader"
 #endif
@@ -273,6 +275,7 @@ typedef struct {
   unsigned int flags;
   char game_id[16];
   char game_title[64];
+  DrpHandoff handoff; /* Copy of g_handoff */
 } RpcStartArgs;
 
 #define RPC_START_FLAG_FROM_UI 0x01
@@ -408,119 +411,6 @@ static unsigned int parse_skip_button(const char *value) {
   return DEFAULT_SKIP_BUTTON;
 }
 
-static unsigned int load_skip_button(void) {
-  char buf[2048];
-  int len;
-  char *line;
-  char *next;
-  SceUID fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
-  if (fd < 0) {
-    return DEFAULT_SKIP_BUTTON;
-  }
-  len = sceIoRead(fd, buf, sizeof(buf) - 1);
-  sceIoClose(fd);
-  if (len <= 0) {
-    return DEFAULT_SKIP_BUTTON;
-  }
-  buf[len] = '\0';
-  line = buf;
-  while (*line != '\0') {
-    char *p = line;
-    char *eq = NULL;
-    next = strchr(line, '\n');
-    if (next != NULL) {
-      *next = '\0';
-      next++;
-    }
-
-    while (*p == ' ' || *p == '\t' || *p == '\r') {
-      p++;
-    }
-    if (*p == '#' || *p == ';' || *p == '\0') {
-      line = (next != NULL) ? next : (line + strlen(line));
-      continue;
-    }
-
-    eq = strchr(p, '=');
-    if (eq != NULL) {
-      char *key_end = eq - 1;
-      char *val = eq + 1;
-      while (key_end > p && (*key_end == ' ' || *key_end == '\t')) {
-        *key_end-- = '\0';
-      }
-      *eq = '\0';
-      while (*val == ' ' || *val == '\t') {
-        val++;
-      }
-      if (token_equals(p, "SKIP_BUTTON")) {
-        return parse_skip_button(val);
-      }
-    }
-
-    line = (next != NULL) ? next : (line + strlen(line));
-  }
-
-  return DEFAULT_SKIP_BUTTON;
-}
-
-static void load_logging_enabled(void) {
-  char buf[2048];
-  int len;
-  char *line;
-  char *next;
-  SceUID fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
-  if (fd < 0) {
-    g_logging_enabled = 0;
-    return;
-  }
-  len = sceIoRead(fd, buf, sizeof(buf) - 1);
-  sceIoClose(fd);
-  if (len <= 0) {
-    g_logging_enabled = 0;
-    return;
-  }
-  buf[len] = '\0';
-  line = buf;
-  while (*line != '\0') {
-    char *p = line;
-    char *eq = NULL;
-    next = strchr(line, '\n');
-    if (next != NULL) {
-      *next = '\0';
-      next++;
-    }
-
-    while (*p == ' ' || *p == '\t' || *p == '\r') {
-      p++;
-    }
-    if (*p == '#' || *p == ';' || *p == '\0') {
-      line = (next != NULL) ? next : (line + strlen(line));
-      continue;
-    }
-
-    eq = strchr(p, '=');
-    if (eq != NULL) {
-      char *key_end = eq - 1;
-      char *val = eq + 1;
-      while (key_end > p && (*key_end == ' ' || *key_end == '\t')) {
-        *key_end-- = '\0';
-      }
-      *eq = '\0';
-      while (*val == ' ' || *val == '\t') {
-        val++;
-      }
-      if (token_equals(p, "ENABLE_LOGGING")) {
-        g_logging_enabled = (*val == '1') ? 1 : 0;
-        return;
-      }
-    }
-
-    line = (next != NULL) ? next : (line + strlen(line));
-  }
-
-  g_logging_enabled = 0;
-}
-
 static int parse_int(const char *val) {
   int result = 0;
   int negative = 0;
@@ -541,118 +431,127 @@ static int parse_int(const char *val) {
   return negative ? -result : result;
 }
 
-static int load_startup_delay(void) {
-  char buf[2048];
-  int len;
-  char *line;
-  char *next;
-  SceUID fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
-  if (fd < 0) {
-    return AUTO_START_DELAY_MS;
-  }
-  len = sceIoRead(fd, buf, sizeof(buf) - 1);
-  sceIoClose(fd);
-  if (len <= 0) {
-    return AUTO_START_DELAY_MS;
-  }
-  buf[len] = '\0';
-  line = buf;
-  while (*line != '\0') {
-    char *p = line;
-    char *eq = NULL;
-    next = strchr(line, '\n');
-    if (next != NULL) {
-      *next = '\0';
-      next++;
-    }
+/**
+ * Loader settings from psp_drp.ini
+ */
+typedef struct {
+  unsigned int skip_button;
+  int startup_delay_ms;
+  int usb_mode;
+} LoaderConfig;
 
-    while (*p == ' ' || *p == '\t' || *p == '\r') {
-      p++;
-    }
-    if (*p == '#' || *p == ';' || *p == '\0') {
-      line = (next != NULL) ? next : (line + strlen(line));
-      continue;
-    }
+static LoaderConfig g_loader_config;
 
-    eq = strchr(p, '=');
-    if (eq != NULL) {
-      char *key_end = eq - 1;
-      char *val = eq + 1;
-      while (key_end > p && (*key_end == ' ' || *key_end == '\t')) {
-        *key_end-- = '\0';
-      }
-      *eq = '\0';
-      while (*val == ' ' || *val == '\t') {
-        val++;
-      }
-      if (token_equals(p, "STARTUP_DELAY_MS")) {
-        int delay = parse_int(val);
-        if (delay >= 0) {
-          return delay;
-        }
-        return AUTO_START_DELAY_MS;
-      }
-    }
+/*
+ * Handed to the plugin with its start args. Filled while the loader reads
+ * the ini and the game's PARAM.SFO anyway; static because it doesn't fit
+ * the auto-start thread's stack.
+ */
+static DrpHandoff g_handoff;
+
+static void parse_config_line(char *line) {
+  char *p = line;
+  char *eq;
+  char *key_end;
+  char *val;
+
+  while (*p == ' ' || *p == '\t' || *p == '\r') {
+    p++;
+  }
+  if (*p == '#' || *p == ';' || *p == '\0') {
+    return;
+  }
 
-    line = (next != NULL) ? next : (line + strlen(line));
+  eq = strchr(p, '=');
+  if (eq == NULL) {
+    return;
+  }
+  key_end = eq - 1;
+  val = eq + 1;
+  while (key_end > p && (*key_end == ' ' || *key_end == '\t')) {
+    *key_end-- = '\0';
+  }
+  *eq = '\0';
+  while (*val == ' ' || *val == '\t') {
+    val++;
   }
 
-  return AUTO_START_DELAY_MS;
+  if (token_equals(p, "SKIP_BUTTON")) {
+    g_loader_config.skip_button = parse_skip_button(val);
+  } else if (token_equals(p, "ENABLE_LOGGING")) {
+    g_logging_enabled = (*val == '1') ? 1 : 0;
+  } else if (token_equals(p, "STARTUP_DELAY_MS")) {
+    int delay = parse_int(val);
+    g_loader_config.startup_delay_ms =
+        (delay >= 0) ? delay : AUTO_START_DELAY_MS;
+  } else if (token_equals(p, "USB_MODE")) {
+    g_loader_config.usb_mode = (*val == '1') ? 1 : 0;
+  }
 }
 
-static int load_usb_mode(void) {
-  char buf[2048];
+/**
+ * Read psp_drp.ini once: parse the loader's own settings and keep the text
+ * for the plugin (DRP_HANDOFF_CONFIG) when the whole file fits.
+ */
+static void load_loader_config(void) {
+  char line[128];
+  char *text = g_handoff.config;
   int len;
-  char *line;
-  char *next;
-  SceUID fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
+  int i;
+  int j;
+  SceUID fd;
+
+  g_loader_config.skip_button = DEFAULT_SKIP_BUTTON;
+  g_loader_config.startup_delay_ms = AUTO_START_DELAY_MS;
+  g_loader_config.usb_mode = 0; /* Default: USB mode disabled */
+  g_logging_enabled = 0;
+
+  memset(&g_handoff, 0, sizeof(g_handoff));
+  g_handoff.magic = DRP_HANDOFF_MAGIC;
+  g_handoff.version = DRP_HANDOFF_VERSION;
+
+  fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
   if (fd < 0) {
-    return 0; /* Default: USB mode disabled */
+    return;
   }
-  len = sceIoRead(fd, buf, sizeof(buf) - 1);
+  /* One byte more than is kept tells a complete file from a cut-off one */
+  len = sceIoRead(fd, text, DRP_HANDOFF_CONFIG_MAX);
   sceIoClose(fd);
   if (len <= 0) {
-    return 0;
+    return;
   }
-  buf[len] = '\0';
-  line = buf;
-  while (*line != '\0') {
-    char *p = line;
-    char *eq = NULL;
-    next = strchr(line, '\n');
-    if (next != NULL) {
-      *next = '\0';
-      next++;
-    }
+  if (len < DRP_HANDOFF_CONFIG_MAX) {
+    g_handoff.flags |= DRP_HANDOFF_CONFIG;
+    g_handoff.config_len = (unsigned int)len;
+  } else {
+    len = DRP_HANDOFF_CONFIG_MAX - 1;
+  }
+  text[len] = '\0';
 
-    while (*p == ' ' || *p == '\t' || *p == '\r') {
-      p++;
-    }
-    if (*p == '#' || *p == ';' || *p == '\0') {
-      line = (next != NULL) ? next : (line + strlen(line));
-      continue;
+  j = 0;
+  for (i = 0; i <= len; i++) {
+    if (text[i] == '\n' || text[i] == '\0') {
+      line[j] = '\0';
+      parse_config_line(line);
+      j = 0;
+    } else if (j < (int)sizeof(line) - 1) {
+      line[j++] = text[i];
     }
+  }
+}
 
-    eq = strchr(p, '=');
-    if (eq != NULL) {
-      char *key_end = eq - 1;
-      char *val = eq + 1;
-      while (key_end > p && (*key_end == ' ' || *key_end == '\t')) {
-        *key_end-- = '\0';
-      }
-      *eq = '\0';
-      while (*val == ' ' || *val == '\t') {
-        val++;
-      }
-      if (token_equals(p, "USB_MODE")) {
-        return (*val == '1') ? 1 : 0;
-      }
-    }
+/**
+ * Record the detected game in the handoff. Only disc0: is probed, so the
+ * SFO and icon live in its PSP_GAME directory.
+ */
+static void handoff_set_game(void) {
+  SceIoStat stat;
 
-    line = (next != NULL) ? next : (line + strlen(line));
+  g_handoff.flags |= DRP_HANDOFF_GAME;
+  strcpy(g_handoff.game_path, "disc0:/PSP_GAME");
+  if (sceIoGetstat("disc0:/PSP_GAME/ICON0.PNG", &stat) >= 0) {
+    g_handoff.flags |= DRP_HANDOFF_ICON;
   }
-
-  return 0; /* Default: USB mode disabled */
 }
 
 /* USB Module startup args magic - must match USB module's USB_STARTUP_MAGIC */
@@ -662,6 +561,7 @@ typedef struct {
   unsigned int magic;
   char game_id[16];
   char game_title[64];
+  DrpHandoff handoff; /* Copy of g_handoff */
 } UsbStartupArgs;
 
 static int load_usb_plugin(const char *game_id, const char *game_title) {
@@ -688,7 +588,7 @@ static int load_usb_plugin(const char *game_id, const char *game_title) {
   }
   {
     int start_res;
-    UsbStartupArgs startup_args;
+    static UsbStartupArgs startup_args;
 
     /* Prepare startup args with game ID and title */
     memset(&startup_args, 0, sizeof(startup_args));
@@ -709,6 +609,7 @@ static int load_usb_plugin(const char *game_id, const char *game_title) {
       startup_args.game_title[j] = '\0';
       loader_log_raw("Passing game title to USB PRX");
     }
+    memcpy(&startup_args.handoff, &g_handoff, sizeof(g_handoff));
 
     start_res = sceKernelStartModule(modid, sizeof(startup_args), &startup_args,
                                      NULL, NULL);
@@ -756,7 +657,7 @@ static int load_net_plugin(const char *game_id, const char *game_title) {
     return -1;
   }
   {
-    RpcStartArgs args;
+    static RpcStartArgs args;
     int start_res;
 
     memset(&args, 0, sizeof(args));
@@ -781,6 +682,7 @@ static int load_net_plugin(const char *game_id, const char *game_title) {
       args.game_title[j] = '\0';
       loader_log_raw("Passing game title to NET PRX");
     }
+    memcpy(&args.handoff, &g_handoff, sizeof(g_handoff));
 
     start_res = sceKernelStartModule(modid, sizeof(args), &args, NULL, NULL);
     if (start_res < 0) {
@@ -823,9 +725,9 @@ static int auto_start_thread(SceSize args, void *argp) {
   SceCtrlData pad;
   int attempts = 0;
   int max_attempts = AUTO_START_MAX_ATTEMPTS;
-  int startup_delay = load_startup_delay();
-  char game_id[16] = {0};
-  char game_title[64] = {0};
+  int startup_delay = g_loader_config.startup_delay_ms;
+  char *game_id = g_handoff.game_id;
+  char *game_title = g_handoff.title;
 
   sceCtrlSetSamplingCycle(0);
   sceCtrlSetSamplingMode(PSP_CTRL_MODE_DIGITAL);
@@ -835,8 +737,9 @@ static int auto_start_thread(SceSize args, void *argp) {
 
   /* Check for incompatible games BEFORE loading net PRX */
   /* Also get game title for USB mode */
-  if (get_current_game_info(game_id, sizeof(game_id), game_title,
-                            sizeof(game_title)) == 0) {
+  if (get_current_game_info(game_id, sizeof(g_handoff.game_id), game_title,
+                            sizeof(g_handoff.title)) == 0) {
+    handoff_set_game();
     loader_log_raw("Detected game:");
     loader_log_raw(game_id);
     if (game_title[0] != '\0') {
@@ -849,7 +752,7 @@ static int auto_start_thread(SceSize args, void *argp) {
   }
 
   {
-    unsigned int skip_button = load_skip_button();
+    unsigned int skip_button = g_loader_config.skip_button;
     if (sceCtrlPeekBufferPositive(&pad, 1) > 0) {
       if (skip_button != 0 && (pad.Buttons & skip_button)) {
         loader_log_raw("Auto-start skipped (skip button held)");
@@ -870,7 +773,7 @@ static int auto_start_thread(SceSize args, void *argp) {
     }
   }
   /* Check USB mode setting */
-  int usb_mode = load_usb_mode();
+  int usb_mode = g_loader_config.usb_mode;
 
   while (attempts < max_attempts) {
     loader_log_raw("Auto-start attempt");
@@ -911,7 +814,7 @@ int module_start(SceSize args, void *argp) {
   (void)args;
   (void)argp;
 
-  load_logging_enabled();
+  load_loader_config();
   loader_log_raw("module_start called");
 
 #ifdef AUTO_START_NET
@@ -10,6 +10,7 @@
 
 #include "config.h"
 #include "discord_rpc.h"
+#include "logger.h"
 
 /* INI parsing helpers */
 static void trim_whitespace(char *str);
@@ -17,6 +18,82 @@ static int parse_bool(const char *value);
 static void parse_line(const char *line, PluginConfig *config);
 static void copy_str(char *dst, size_t dst_size, const char *src);
 
+/*
+ * Compiled config cache. psp_drp.ini is parsed once into PluginConfig plus
+ * a table of per-game overrides sorted by game ID, and both are written to
+ * CONFIG_CACHE_PATH together with the ini's stat. Later loads take the
+ * cache in a single read while the stat is unchanged; the ini stays the
+ * file users edit.
+ */
+#define CONFIG_CACHE_MAGIC 0x47464344 /* "DCFG" */
+#define CONFIG_CACHE_VERSION 1
+
+/* GameOverride.flags */
+#define GAME_OVERRIDE_INCOMPATIBLE 0x01
+
+/* Per-game keys: GAMEID_vblank_wait, GAMEID_incompatible */
+#define KEY_SUFFIX_VBLANK "_vblank_wait"
+#define KEY_SUFFIX_INCOMPATIBLE "_incompatible"
+
+#define GAME_OVERRIDE_ID_LEN 12
+
+/* config_save writes here first, then renames it over the ini */
+#define CONFIG_TMP_PATH CONFIG_PATH ".tmp"
+
+/* Keys config_save writes itself; any other line of the old ini is copied
+ * through (offline_mode, the loader's usb_mode, overrides past
+ * MAX_GAME_OVERRIDES, ...) */
+static const char *const g_saved_keys[] = {
+    "enabled",          "desktop_ip",
+    "port",             "auto_discovery",
+    "send_icons",       "psp_name",
+    "vblank_wait",      "enable_logging",
+    "poll_interval_ms", "heartbeat_interval_ms",
+    "game_update_interval_ms", "connect_timeout_s",
+    "send_once",        "event_detect"};
+
+typedef struct {
+  char game_id[GAME_OVERRIDE_ID_LEN];
+  int32_t vblank_wait; /* -1 = use the global vblank_wait */
+  uint32_t flags;      /* GAME_OVERRIDE_* */
+} GameOverride;
+
+typedef struct {
+  uint32_t magic;   /* CONFIG_CACHE_MAGIC */
+  uint32_t version; /* CONFIG_CACHE_VERSION */
+  uint32_t size;    /* sizeof(ConfigCache), catches layout changes */
+  SceIoStat ini_stat;
+  PluginConfig config;
+  uint32_t override_count;
+  GameOverride overrides[MAX_GAME_OVERRIDES]; /* Sorted by game_id */
+} ConfigCache;
+
+/* Current cache contents; the override table is looked up from here */
+static ConfigCache g_cache;
+
+/* Per-game lines that did not fit the table on the last load */
+static int g_overrides_dropped = 0;
+
+/* Line being assembled while streaming the ini */
+typedef struct {
+  PluginConfig *config;
+  char line[128];
+  int len;
+} IniParser;
+
+static void parse_chars(IniParser *parser, const char *text, int len);
+static void finish_line(IniParser *parser);
+static int parse_game_key(const char *line);
+static const char *split_game_key(const char *p, const char *eq,
+                                  char *game_id);
+static int old_line_is_saved(const char *line);
+static void copy_unsaved_lines(SceUID out);
+static int find_override(const char *game_id, int *pos);
+static GameOverride *add_override(const char *game_id);
+static void clear_overrides(void);
+static int cache_read(const SceIoStat *ini_stat, PluginConfig *config);
+static void cache_write(const PluginConfig *config);
+
 /**
  * Set default configuration values
  */
@@ -37,6 +114,7 @@ void config_set_defaults(PluginConfig *config) {
   config->enable_logging = 0;
   config->vblank_wait = 300; /* Default: ~5 seconds at 60fps */
   config->offline_mode = 0;  /* Default: online mode */
+  config->event_detect = 1;
   /* NOTE: USB mode is handled by loader (USB_MODE in psp_drp.ini) */
 }
 
@@ -45,52 +123,93 @@ void config_set_defaults(PluginConfig *config) {
  */
 int config_load(PluginConfig *config) {
   SceUID fd;
-  char buffer[2048];
-  char line[128];
+  SceIoStat stat;
+  IniParser parser;
+  char buffer[512];
   int bytes_read;
-  int i, j;
+  int total = 0;
 
   /* Set defaults first */
   config_set_defaults(config);
+  clear_overrides();
 
-  /* Open config file */
-  fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
-  if (fd < 0) {
+  if (sceIoGetstat(CONFIG_PATH, &stat) < 0) {
     /* Config doesn't exist, create with defaults */
     config_save(config);
     return 0;
   }
 
-  /* Read entire file */
-  bytes_read = sceIoRead(fd, buffer, sizeof(buffer) - 1);
+  /* Unchanged since it was last compiled */
+  if (cache_read(&stat, config) == 0) {
+    return 0;
+  }
+
+  fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  /* Stream the whole file so overrides past the first few KB count too */
+  memset(&parser, 0, sizeof(parser));
+  parser.config = config;
+  while ((bytes_read = sceIoRead(fd, buffer, sizeof(buffer))) > 0) {
+    parse_chars(&parser, buffer, bytes_read);
+    total += bytes_read;
+  }
   sceIoClose(fd);
+  finish_line(&parser);
 
-  if (bytes_read <= 0) {
+  if (total <= 0) {
     return -1;
   }
 
-  buffer[bytes_read] = '\0';
+  memcpy(&g_cache.ini_stat, &stat, sizeof(stat));
+  cache_write(config);
+  return 0;
+}
 
-  /* Parse line by line */
-  j = 0;
-  for (i = 0; i <= bytes_read; i++) {
-    if (buffer[i] == '\n' || buffer[i] == '\r' || buffer[i] == '\0') {
-      line[j] = '\0';
-      if (j > 0) {
-        parse_line(line, config);
-      }
-      j = 0;
+/**
+ * Load configuration from ini text already in memory
+ */
+int config_load_text(PluginConfig *config, const char *text) {
+  IniParser parser;
 
-      /* Skip \r\n sequences */
-      if (buffer[i] == '\r' && buffer[i + 1] == '\n') {
-        i++;
-      }
-    } else if (j < (int)sizeof(line) - 1) {
-      line[j++] = buffer[i];
+  config_set_defaults(config);
+  clear_overrides();
+
+  memset(&parser, 0, sizeof(parser));
+  parser.config = config;
+  parse_chars(&parser, text, (int)strlen(text));
+  finish_line(&parser);
+  return 0;
+}
+
+/**
+ * Feed ini text to the parser; lines may span calls
+ */
+static void parse_chars(IniParser *parser, const char *text, int len) {
+  int i;
+
+  for (i = 0; i < len; i++) {
+    if (text[i] == '\n' || text[i] == '\r' || text[i] == '\0') {
+      finish_line(parser);
+    } else if (parser->len < (int)sizeof(parser->line) - 1) {
+      parser->line[parser->len++] = text[i];
     }
   }
+}
 
-  return 0;
+/**
+ * Parse the line collected so far, if any
+ */
+static void finish_line(IniParser *parser) {
+  if (parser->len > 0) {
+    parser->line[parser->len] = '\0';
+    if (!parse_game_key(parser->line)) {
+      parse_line(parser->line, parser->config);
+    }
+  }
+  parser->len = 0;
 }
 
 /**
@@ -100,8 +219,10 @@ int config_save(const PluginConfig *config) {
   SceUID fd;
   char buffer[2048];
   int len;
+  int i;
 
-  fd = sceIoOpen(CONFIG_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC, 0777);
+  fd = sceIoOpen(CONFIG_TMP_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC,
+                 0777);
   if (fd < 0) {
     return fd;
   }
@@ -155,17 +276,55 @@ int config_save(const PluginConfig *config) {
       "\n"
       "; Send once mode (1 = enabled, 0 = disabled)\n"
       "; When enabled, sends one update on plugin load then unloads network\n"
-      "send_once = %d\n",
+      "send_once = %d\n"
+      "\n"
+      "; Detect game changes when modules load (1) or on poll_interval_ms (0)\n"
+      "event_detect = %d\n",
       config->enabled, config->desktop_ip, config->port, config->auto_discovery,
       config->send_icons, config->psp_name, (unsigned long)config->vblank_wait,
       config->enable_logging, (unsigned long)config->poll_interval_ms,
       (unsigned long)config->heartbeat_interval_ms,
       (unsigned long)config->game_update_interval_ms,
-      (unsigned long)config->connect_timeout_s, config->send_once);
+      (unsigned long)config->connect_timeout_s, config->send_once,
+      config->event_detect);
 
   sceIoWrite(fd, buffer, len);
+
+  /* Write the per-game overrides back from the table */
+  if (g_cache.override_count > 0) {
+    len = snprintf(buffer, sizeof(buffer), "\n; === Per-Game Overrides ===\n");
+    sceIoWrite(fd, buffer, len);
+  }
+  for (i = 0; i < (int)g_cache.override_count; i++) {
+    const GameOverride *entry = &g_cache.overrides[i];
+    if (entry->vblank_wait >= 0) {
+      len = snprintf(buffer, sizeof(buffer), "%s%s = %ld\n", entry->game_id,
+                     KEY_SUFFIX_VBLANK, (long)entry->vblank_wait);
+      sceIoWrite(fd, buffer, len);
+    }
+    if (entry->flags & GAME_OVERRIDE_INCOMPATIBLE) {
+      len = snprintf(buffer, sizeof(buffer), "%s%s = 1\n", entry->game_id,
+                     KEY_SUFFIX_INCOMPATIBLE);
+      sceIoWrite(fd, buffer, len);
+    }
+  }
+
+  /* Everything else the user had stays, overrides the table dropped too */
+  copy_unsaved_lines(fd);
   sceIoClose(fd);
 
+  /* FAT rename won't replace an existing file */
+  sceIoRemove(CONFIG_PATH);
+  if (sceIoRename(CONFIG_TMP_PATH, CONFIG_PATH) < 0) {
+    net_log("config: rename failed");
+    return -1;
+  }
+
+  /* Recompile against the new stat so the next load still hits the cache */
+  if (sceIoGetstat(CONFIG_PATH, &g_cache.ini_stat) >= 0) {
+    cache_write(config);
+  }
+
   return 0;
 }
 
@@ -261,6 +420,8 @@ static void parse_line(const char *line, PluginConfig *config) {
     }
   } else if (strcmp(key, "offline_mode") == 0) {
     config->offline_mode = parse_bool(value);
+  } else if (strcmp(key, "event_detect") == 0) {
+    config->event_detect = parse_bool(value);
   }
   /* NOTE: usb_mode is parsed by the loader, not the net plugin */
 }
@@ -321,97 +482,324 @@ static int parse_bool(const char *value) {
 }
 
 /**
- * Get game-specific vblank wait from config.
- * Looks for GAMEID_vblank_wait = VALUE in the INI file.
- * Returns the value if found, or -1 if not found.
+ * Get game-specific vblank wait from the override table
  */
 int config_get_game_vblank_wait(const char *game_id) {
-  SceUID fd;
-  char buffer[4096];
-  char target_key[32];
-  int bytes_read;
-  char *found;
-  char *eq;
-  char *val_start;
-  char *line_start;
-  int value;
+  int pos;
 
-  if (game_id == NULL || game_id[0] == '\0') {
+  if (find_override(game_id, &pos) != 0) {
     return -1;
   }
+  return g_cache.overrides[pos].vblank_wait;
+}
 
-  /* Build the key we're looking for: GAMEID_vblank_wait */
-  snprintf(target_key, sizeof(target_key), "%s_vblank_wait", game_id);
+/**
+ * Check the override table for GAMEID_incompatible
+ */
+int config_is_game_incompatible(const char *game_id) {
+  int pos;
 
-  fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
-  if (fd < 0) {
-    return -1;
+  if (find_override(game_id, &pos) != 0) {
+    return 0;
   }
+  return (g_cache.overrides[pos].flags & GAME_OVERRIDE_INCOMPATIBLE) ? 1 : 0;
+}
 
-  bytes_read = sceIoRead(fd, buffer, sizeof(buffer) - 1);
-  sceIoClose(fd);
+/**
+ * Handle GAMEID_vblank_wait / GAMEID_incompatible lines
+ * Returns 1 if the line was a per-game key, 0 otherwise
+ */
+static int parse_game_key(const char *line) {
+  char game_id[GAME_OVERRIDE_ID_LEN];
+  const char *p = line;
+  const char *eq;
+  const char *id_end;
+  const char *value;
+  GameOverride *entry;
+  int vblank;
 
-  if (bytes_read <= 0) {
-    return -1;
+  while (*p == ' ' || *p == '\t') {
+    p++;
+  }
+  if (*p == ';' || *p == '#') {
+    return 0;
   }
 
-  buffer[bytes_read] = '\0';
+  eq = strchr(p, '=');
+  if (eq == NULL) {
+    return 0;
+  }
 
-  /* Search for the key in the buffer */
-  found = strstr(buffer, target_key);
-  while (found != NULL) {
-    /* Check if this occurrence is at the start of a line (not a comment) */
-    line_start = found;
+  id_end = split_game_key(p, eq, game_id);
+  if (id_end == NULL) {
+    return 0;
+  }
 
-    /* Walk backwards to find line start */
-    while (line_start > buffer && *(line_start - 1) != '\n' &&
-           *(line_start - 1) != '\r') {
-      line_start--;
-    }
+  value = eq + 1;
+  while (*value == ' ' || *value == '\t') {
+    value++;
+  }
 
-    /* Skip whitespace at line start */
-    while (*line_start == ' ' || *line_start == '\t') {
-      line_start++;
+  entry = add_override(game_id);
+  if (entry == NULL) {
+    /* Table full: ignored here, but config_save copies the line through */
+    if (g_overrides_dropped++ == 0) {
+      net_log("config: over %d per-game overrides, ignoring %s and later",
+              MAX_GAME_OVERRIDES, game_id);
     }
+    return 1;
+  }
 
-    /* If line starts with ; or #, it's a comment - skip */
-    if (*line_start == ';' || *line_start == '#') {
-      found = strstr(found + 1, target_key);
-      continue;
+  if (strncmp(id_end, KEY_SUFFIX_VBLANK, strlen(KEY_SUFFIX_VBLANK)) == 0) {
+    /* Empty or negative keeps the global value */
+    if (*value == '\0' || *value == ';' || *value == '#') {
+      return 1;
     }
+    vblank = atoi(value);
+    entry->vblank_wait = (vblank >= 0) ? vblank : -1;
+  } else if (*value == '1') {
+    entry->flags |= GAME_OVERRIDE_INCOMPATIBLE;
+  }
+  return 1;
+}
 
-    /* Make sure the key starts at the beginning of the non-comment part */
-    if (line_start != found) {
-      found = strstr(found + 1, target_key);
-      continue;
+/**
+ * Find the per-game suffix in the key of a line (p at the key, eq at its
+ * '=') and copy the game ID before it
+ * Returns the suffix, or NULL if the key is not a per-game one
+ */
+static const char *split_game_key(const char *p, const char *eq,
+                                  char *game_id) {
+  const char *id_end;
+  int id_len;
+
+  id_end = strstr(p, KEY_SUFFIX_VBLANK);
+  if (id_end == NULL || id_end > eq) {
+    id_end = strstr(p, KEY_SUFFIX_INCOMPATIBLE);
+    if (id_end == NULL || id_end > eq) {
+      return NULL;
     }
+  }
+  id_len = id_end - p;
+  if (id_len <= 0 || id_len >= GAME_OVERRIDE_ID_LEN) {
+    return NULL;
+  }
+  memcpy(game_id, p, id_len);
+  game_id[id_len] = '\0';
+  return id_end;
+}
 
-    /* Find the = after the key */
-    eq = strchr(found, '=');
-    if (eq == NULL) {
-      found = strstr(found + 1, target_key);
-      continue;
-    }
+/**
+ * Check whether config_save already writes what a line of the old ini says:
+ * blank lines and comments (the template has its own), the keys in
+ * g_saved_keys, and per-game keys of games in the override table
+ */
+static int old_line_is_saved(const char *line) {
+  char key[32];
+  char game_id[GAME_OVERRIDE_ID_LEN];
+  const char *p = line;
+  const char *eq;
+  int key_len;
+  int pos;
+  size_t i;
 
-    /* Get the value after = */
-    val_start = eq + 1;
-    while (*val_start == ' ' || *val_start == '\t') {
-      val_start++;
-    }
+  while (*p == ' ' || *p == '\t') {
+    p++;
+  }
+  if (*p == '\0' || *p == ';' || *p == '#') {
+    return 1;
+  }
 
-    /* Check for empty value */
-    if (*val_start == '\0' || *val_start == '\n' || *val_start == '\r' ||
-        *val_start == ';') {
-      return -1;
+  eq = strchr(p, '=');
+  if (eq == NULL) {
+    return 0;
+  }
+
+  if (split_game_key(p, eq, game_id) != NULL) {
+    return find_override(game_id, &pos) == 0;
+  }
+
+  key_len = eq - p;
+  if (key_len >= (int)sizeof(key)) {
+    return 0;
+  }
+  memcpy(key, p, key_len);
+  key[key_len] = '\0';
+  trim_whitespace(key);
+  for (i = 0; i < sizeof(g_saved_keys) / sizeof(g_saved_keys[0]); i++) {
+    if (strcmp(key, g_saved_keys[i]) == 0) {
+      return 1;
     }
+  }
+  return 0;
+}
+
+/**
+ * Append the lines of the current ini that config_save does not write
+ * itself, so a save never loses settings it does not know about
+ */
+static void copy_unsaved_lines(SceUID out) {
+  char buffer[512];
+  char line[128];
+  int line_len = 0;
+  int header = 0;
+  int bytes_read;
+  SceUID in;
+  int i;
+
+  in = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
+  if (in < 0) {
+    return;
+  }
+
+  /* One past the end stands for the end of a last line without '\n' */
+  do {
+    bytes_read = sceIoRead(in, buffer, sizeof(buffer));
+    for (i = 0; i < bytes_read || (bytes_read <= 0 && i == 0); i++) {
+      char c = (bytes_read > 0) ? buffer[i] : '\n';
+
+      if (c != '\n' && c != '\r') {
+        if (line_len < (int)sizeof(line) - 1) {
+          line[line_len++] = c;
+        }
+        continue;
+      }
+      if (line_len == 0) {
+        continue;
+      }
+      line[line_len] = '\0';
+      line_len = 0;
+      if (old_line_is_saved(line)) {
+        continue;
+      }
 
-    /* Parse the vblank count */
-    value = atoi(val_start);
-    if (value >= 0) {
-      return value;
+      if (!header) {
+        static const char kept[] = "\n; === Kept from the previous file ===\n";
+        sceIoWrite(out, kept, sizeof(kept) - 1);
+        header = 1;
+      }
+      sceIoWrite(out, line, (int)strlen(line));
+      sceIoWrite(out, "\n", 1);
     }
+  } while (bytes_read > 0);
+
+  sceIoClose(in);
+}
+
+/**
+ * Binary search the override table
+ * Returns 0 with pos at the entry if found, -1 with pos where it would go
+ */
+static int find_override(const char *game_id, int *pos) {
+  int lo = 0;
+  int hi = (int)g_cache.override_count;
+
+  if (game_id == NULL || game_id[0] == '\0') {
+    *pos = 0;
     return -1;
   }
 
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    int cmp = strcmp(game_id, g_cache.overrides[mid].game_id);
+    if (cmp == 0) {
+      *pos = mid;
+      return 0;
+    }
+    if (cmp < 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+
+  *pos = lo;
   return -1;
 }
+
+/**
+ * Get the entry for a game, inserting it in order if new
+ * Returns NULL if the table is full
+ */
+static GameOverride *add_override(const char *game_id) {
+  GameOverride *entry;
+  int pos;
+
+  if (find_override(game_id, &pos) == 0) {
+    return &g_cache.overrides[pos];
+  }
+  if (g_cache.override_count >= MAX_GAME_OVERRIDES) {
+    return NULL;
+  }
+
+  memmove(&g_cache.overrides[pos + 1], &g_cache.overrides[pos],
+          (g_cache.override_count - pos) * sizeof(GameOverride));
+  g_cache.override_count++;
+
+  entry = &g_cache.overrides[pos];
+  memset(entry, 0, sizeof(*entry));
+  copy_str(entry->game_id, sizeof(entry->game_id), game_id);
+  entry->vblank_wait = -1;
+  return entry;
+}
+
+static void clear_overrides(void) {
+  g_overrides_dropped = 0;
+  g_cache.override_count = 0;
+  memset(g_cache.overrides, 0, sizeof(g_cache.overrides));
+}
+
+/**
+ * Load config and overrides from the cache if it was compiled from the
+ * ini as it is now. The whole stat is compared so this works whatever the
+ * SDK calls the mtime field; a spurious mismatch only costs a re-parse.
+ */
+static int cache_read(const SceIoStat *ini_stat, PluginConfig *config) {
+  SceUID fd;
+  int bytes_read;
+
+  fd = sceIoOpen(CONFIG_CACHE_PATH, PSP_O_RDONLY, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  bytes_read = sceIoRead(fd, &g_cache, sizeof(g_cache));
+  sceIoClose(fd);
+
+  if (bytes_read != (int)sizeof(g_cache) ||
+      g_cache.magic != CONFIG_CACHE_MAGIC ||
+      g_cache.version != CONFIG_CACHE_VERSION ||
+      g_cache.size != sizeof(g_cache) ||
+      g_cache.override_count > MAX_GAME_OVERRIDES ||
+      memcmp(&g_cache.ini_stat, ini_stat, sizeof(*ini_stat)) != 0) {
+    clear_overrides();
+    return -1;
+  }
+
+  memcpy(config, &g_cache.config, sizeof(*config));
+  return 0;
+}
+
+/**
+ * Store config and the current override table (g_cache.ini_stat must be
+ * set). Failure is harmless, the ini is parsed again next time.
+ */
+static void cache_write(const PluginConfig *config) {
+  SceUID fd;
+
+  g_cache.magic = CONFIG_CACHE_MAGIC;
+  g_cache.version = CONFIG_CACHE_VERSION;
+  g_cache.size = sizeof(g_cache);
+  memcpy(&g_cache.config, config, sizeof(*config));
+
+  fd = sceIoOpen(CONFIG_CACHE_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC,
+                 0777);
+  if (fd < 0) {
+    return;
+  }
+  if (sceIoWrite(fd, &g_cache, sizeof(g_cache)) != (int)sizeof(g_cache)) {
+    sceIoClose(fd);
+    sceIoRemove(CONFIG_CACHE_PATH);
+    return;
+  }
+  sceIoClose(fd);
+}
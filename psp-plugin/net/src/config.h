@@ -10,6 +10,12 @@
 /* Config file path on memory stick */
 #define CONFIG_PATH "ms0:/SEPLUGINS/pspdrp/psp_drp.ini"
 
+/* Compiled copy of the config, rebuilt whenever the ini changes */
+#define CONFIG_CACHE_PATH "ms0:/SEPLUGINS/pspdrp/config.bin"
+
+/* Per-game override entries kept (GAMEID_vblank_wait, GAMEID_incompatible) */
+#define MAX_GAME_OVERRIDES 64
+
 /* Maximum lengths */
 #define MAX_IP_LENGTH 16
 #define MAX_NAME_LENGTH 32
@@ -61,6 +67,10 @@ typedef struct {
   /* Offline mode - no network, just local usage tracking */
   int offline_mode;
 
+  /* Event-driven detection: re-detect when the module set changes instead
+   * of on every poll_interval_ms (which becomes a slow fallback) */
+  int event_detect;
+
   /* NOTE: USB mode is now handled by the loader (USB_MODE in psp_drp.ini).
    * The loader loads USB plugin directly instead of NET plugin when USB_MODE=1.
    */
@@ -74,13 +84,24 @@ typedef struct {
 void config_set_defaults(PluginConfig *config);
 
 /**
- * Load configuration from file
+ * Load configuration from file. Uses the compiled cache while the ini is
+ * unchanged and recompiles it otherwise.
  *
  * @param config Output configuration
  * @return 0 on success, negative on error
  */
 int config_load(PluginConfig *config);
 
+/**
+ * Load configuration from ini text passed in by the loader, without
+ * touching the Memory Stick
+ *
+ * @param config Output configuration
+ * @param text Contents of psp_drp.ini
+ * @return 0 on success, negative on error
+ */
+int config_load_text(PluginConfig *config, const char *text);
+
 /**
  * Save configuration to file
  *
@@ -91,11 +112,20 @@ int config_save(const PluginConfig *config);
 
 /**
  * Get game-specific vblank wait from config.
- * Looks for GAMEID_vblank_wait = VALUE in the INI file.
+ * Set by GAMEID_vblank_wait = VALUE in the INI file.
  *
  * @param game_id Game ID (e.g., "NPUH10117")
  * @return Vblank count if found, -1 if not found or empty
  */
 int config_get_game_vblank_wait(const char *game_id);
 
+/**
+ * Check whether the INI marks a game incompatible
+ * (GAMEID_incompatible = 1), in addition to the built-in list.
+ *
+ * @param game_id Game ID
+ * @return 1 if incompatible, 0 otherwise
+ */
+int config_is_game_incompatible(const char *game_id);
+
 #endif /* CONFIG_H */
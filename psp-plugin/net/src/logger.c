@@ -0,0 +1,169 @@
+/**
+ * Buffered Log Writer Implementation
+ *
+ * Two fixed buffers are used: loggers append to the active one while the
+ * plugin thread writes the other one out. Swapping happens under a
+ * semaphore, the Memory Stick write does not, so a net_log() call never
+ * waits on file I/O.
+ */
+
+#include <pspiofilemgr.h>
+#include <pspkernel.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "logger.h"
+
+/* Space kept free in every buffer for the "lines dropped" notice */
+#define LOG_DROP_RESERVE 48
+
+static char g_log_buf[2][LOG_BUFFER_SIZE];
+static int g_log_len[2] = {0, 0};
+static int g_log_active = 0;
+static int g_log_flushing = 0;
+static unsigned int g_log_dropped = 0;
+
+static SceUID g_log_sema = -1;
+static SceUID g_log_flush_thread = -1;
+static unsigned int g_log_last_flush = 0;
+
+static int g_log_enabled = 0;
+static const char *g_log_label = NULL;
+
+static void log_lock(void) {
+  if (g_log_sema >= 0) {
+    sceKernelWaitSema(g_log_sema, 1, NULL);
+  }
+}
+
+static void log_unlock(void) {
+  if (g_log_sema >= 0) {
+    sceKernelSignalSema(g_log_sema, 1);
+  }
+}
+
+void net_log_init(const char *label) {
+  g_log_label = label;
+  if (g_log_sema < 0) {
+    g_log_sema = sceKernelCreateSema("PSPDRP_Log", 0, 1, 1, NULL);
+  }
+  g_log_last_flush = sceKernelGetSystemTimeLow();
+}
+
+void net_log_set_enabled(int enabled) { g_log_enabled = enabled; }
+
+void net_log_set_flush_thread(void) {
+  g_log_flush_thread = sceKernelGetThreadId();
+}
+
+void net_log(const char *fmt, ...) {
+  char buf[128];
+  char line[160];
+  va_list args;
+  int len;
+  int need_flush;
+
+  /* Skip if logging is disabled */
+  if (!g_log_enabled) {
+    return;
+  }
+
+  va_start(args, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+
+  if (buf[0] == '\0') {
+    return;
+  }
+
+  /* Leave room for the newline */
+  if (g_log_label != NULL) {
+    snprintf(line, sizeof(line) - 1, "[NET:%s] %s", g_log_label, buf);
+  } else {
+    snprintf(line, sizeof(line) - 1, "[NET] %s", buf);
+  }
+  len = (int)strlen(line);
+  line[len++] = '\n';
+
+  log_lock();
+  {
+    int active = g_log_active;
+    if (g_log_len[active] + len > LOG_BUFFER_SIZE - LOG_DROP_RESERVE) {
+      g_log_dropped++;
+    } else {
+      memcpy(&g_log_buf[active][g_log_len[active]], line, len);
+      g_log_len[active] += len;
+    }
+    need_flush = g_log_len[active] >= LOG_FLUSH_HIGH_WATER;
+  }
+  log_unlock();
+
+  /* Only the plugin thread may touch the Memory Stick */
+  if (need_flush && g_log_flush_thread >= 0 &&
+      sceKernelGetThreadId() == g_log_flush_thread) {
+    net_log_flush();
+  }
+}
+
+void net_log_flush(void) {
+  SceUID fd;
+  int idx;
+  unsigned int dropped;
+
+  log_lock();
+  if (g_log_flushing ||
+      (g_log_len[g_log_active] == 0 && g_log_dropped == 0)) {
+    log_unlock();
+    return;
+  }
+  idx = g_log_active;
+  g_log_active ^= 1;
+  dropped = g_log_dropped;
+  g_log_dropped = 0;
+  g_log_flushing = 1;
+  log_unlock();
+
+  if (dropped > 0) {
+    int n = snprintf(&g_log_buf[idx][g_log_len[idx]], LOG_DROP_RESERVE,
+                     "[NET] %u log lines dropped\n", dropped);
+    if (n > 0 && n < LOG_DROP_RESERVE) {
+      g_log_len[idx] += n;
+    }
+  }
+
+  fd = sceIoOpen(LOG_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_APPEND, 0777);
+  if (fd >= 0) {
+    sceIoWrite(fd, g_log_buf[idx], g_log_len[idx]);
+    sceIoClose(fd);
+  }
+
+  log_lock();
+  g_log_len[idx] = 0;
+  g_log_flushing = 0;
+  log_unlock();
+
+  g_log_last_flush = sceKernelGetSystemTimeLow();
+}
+
+void net_log_poll(void) {
+  int pending = g_log_len[g_log_active];
+
+  if (pending == 0 && g_log_dropped == 0) {
+    return;
+  }
+
+  if (pending >= LOG_FLUSH_HIGH_WATER ||
+      (sceKernelGetSystemTimeLow() - g_log_last_flush) >=
+          LOG_FLUSH_INTERVAL_US) {
+    net_log_flush();
+  }
+}
+
+void net_log_shutdown(void) {
+  net_log_flush();
+  if (g_log_sema >= 0) {
+    sceKernelDeleteSema(g_log_sema);
+    g_log_sema = -1;
+  }
+}
@@ -0,0 +1,65 @@
+/**
+ * Buffered Log Writer
+ *
+ * net_log() formats into a fixed in-RAM buffer instead of touching the
+ * Memory Stick on every call. The plugin thread drains the buffer with a
+ * single sceIoWrite, either on a timer or when the buffer is nearly full.
+ * Lines that do not fit are counted and reported on the next flush instead
+ * of blocking the caller.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#define LOG_PATH "ms0:/psp_drp.log"
+
+/* Size of each of the two log buffers (active + being flushed) */
+#define LOG_BUFFER_SIZE 2048
+
+/* Flush at least this often while lines are pending */
+#define LOG_FLUSH_INTERVAL_US (5 * 1000 * 1000)
+
+/* Flush early once the active buffer is this full */
+#define LOG_FLUSH_HIGH_WATER (LOG_BUFFER_SIZE * 3 / 4)
+
+/**
+ * Initialize the log buffers
+ *
+ * @param label Mode label prefixed to every line (e.g. "GAME"), can be NULL
+ */
+void net_log_init(const char *label);
+
+/**
+ * Enable or disable logging (lines are discarded while disabled)
+ */
+void net_log_set_enabled(int enabled);
+
+/**
+ * Mark the calling thread as the one allowed to write the log file.
+ * net_log() calls from this thread flush inline once the high-water mark
+ * is reached; all other threads only ever append to RAM.
+ */
+void net_log_set_flush_thread(void);
+
+/**
+ * Append a formatted line to the log buffer
+ */
+void net_log(const char *fmt, ...);
+
+/**
+ * Flush if the flush interval has elapsed or the buffer is filling up.
+ * Call once per plugin loop iteration.
+ */
+void net_log_poll(void);
+
+/**
+ * Write all pending lines to the log file now
+ */
+void net_log_flush(void);
+
+/**
+ * Flush pending lines and release the buffer lock
+ */
+void net_log_shutdown(void);
+
+#endif /* LOGGER_H */
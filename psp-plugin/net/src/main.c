@@ -11,14 +11,18 @@
 #include <pspusb.h>
 #include <psputility.h>
 #include <pspwlan.h>
-#include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "config.h"
 #include "discord_rpc.h"
+#include "drp_core.h"
+#include "drp_handoff.h"
 #include "game_detect.h"
+#include "icon_cache.h"
+#include "logger.h"
 #include "network.h"
 #include "usage_tracker.h"
 
@@ -52,6 +56,7 @@ static const char *g_incompatible_games[] = {
 
 /**
  * Check if a game is completely incompatible (plugin should exit).
+ * The built-in list plus GAMEID_incompatible entries from the config.
  */
 static int is_incompatible_game(const char *game_id) {
   int i;
@@ -63,7 +68,7 @@ static int is_incompatible_game(const char *game_id) {
       return 1;
     }
   }
-  return 0;
+  return config_is_game_incompatible(game_id);
 }
 
 /**
@@ -84,8 +89,6 @@ static int should_skip_vblank(const char *game_id) {
 
 PSP_MODULE_INFO("PSPDRP_Net", PSP_MODULE_USER, 1, 0);
 
-#define LOG_PATH "ms0:/psp_drp.log"
-
 #define RPC_START_MAGIC 0x31504352
 #define RPC_START_FLAG_FROM_UI 0x01
 
@@ -95,14 +98,17 @@ typedef struct {
   unsigned int flags;
   char game_id[16];
   char game_title[64];
+  DrpHandoff handoff; /* Only from loaders that probe for us */
 } RpcStartArgs;
 
+/* Start args without the handoff (VSH launcher, older loaders) */
+#define RPC_START_ARGS_BASE_SIZE offsetof(RpcStartArgs, handoff)
+
 /* Plugin configuration */
 static PluginConfig g_config;
 
-/* Current game state */
-static GameInfo g_current_game;
-static int g_game_changed = 0;
+/* Shared main loop state: current game, resends, heartbeats, stats sync */
+static DrpCore g_core;
 
 /* Network state */
 static int g_network_initialized = 0;
@@ -121,77 +127,152 @@ static int g_started_from_ui = 0;
 static char g_startup_game_id[16] = {0};
 static char g_startup_game_title[64] = {0};
 
+/* Config text and detected game from the loader; flags are 0 without one */
+static DrpHandoff g_handoff;
+
 /* Mode label for logs */
 static const char *g_mode_label = "UNK";
 
-/* Heartbeat timing */
-static SceUInt64 g_last_heartbeat = 0;
-static SceUInt64 g_last_game_check = 0;
-static SceUInt64 g_last_game_send = 0;
+/* Connection timing */
 static SceUInt64 g_last_connect_attempt = 0;
+static SceUInt64 g_connect_backoff_us = 0; /* Retry delay, doubles */
+static int g_connecting = 0;               /* WiFi join in progress */
+static uint32_t g_session = 0;             /* Desktop session, see AckPacket */
+static SceUInt64 g_next_init_attempt = 0;
 static int g_init_attempts = 0;
 static int g_connect_attempts = 0;
 static SceUInt64 g_connect_start_us = 0;
 
 #define ICON_BUFFER_SIZE (256 * 1024)
 static uint8_t g_icon_buffer[ICON_BUFFER_SIZE];
-static char g_last_icon_id[10] = {0};
-
-/* Stats sync state */
-static int g_stats_sync_pending = 0;    /* 1 = waiting for response */
-static int g_stats_sync_done = 0;       /* 1 = initial sync complete */
-static SceUInt64 g_last_stats_sync = 0; /* Last sync attempt time */
-#define STATS_SYNC_INTERVAL_US (5 * 60 * 1000 * 1000ULL) /* 5 minutes */
-
-#define HEARTBEAT_INTERVAL_US (30 * 1000 * 1000) /* 30 seconds */
-#define GAME_CHECK_INTERVAL_US (2 * 1000 * 1000) /* 2 seconds */
-#define CONNECT_RETRY_US (5 * 1000 * 1000)       /* 5 seconds */
-
-/* Logging enable flag (set from config after load) */
-static int g_logging_enabled = 0;
-
-void net_log(const char *fmt, ...) {
-  char buf[128];
-  char line[160];
-  va_list args;
-  SceUID fd;
-  int len;
-
-  /* Skip if logging is disabled */
-  if (!g_logging_enabled) {
-    return;
+
+#define CONNECT_RETRY_US (5 * 1000 * 1000)      /* 5 seconds, first retry */
+#define CONNECT_RETRY_MAX_US (60 * 1000 * 1000) /* Backoff limit */
+#define CONNECT_POLL_US (300 * 1000)            /* While joining WiFi */
+#define INIT_RETRY_US (2 * 1000 * 1000)    /* 2 seconds */
+#define WLAN_CHECK_US (1000 * 1000)        /* WLAN switch, while offline */
+
+/* The main loop sleeps until its next deadline or an incoming packet. A
+ * step that is still due after running (a failed send) is retried after
+ * LOOP_RETRY_US. IDLE_MAX_US bounds the sleep so the WLAN switch and log
+ * are still looked at; module_stop waits for this thread in VSH. */
+#define LOOP_RETRY_US (100 * 1000)
+#define IDLE_MAX_US LOG_FLUSH_INTERVAL_US
+#define IDLE_MAX_US_VSH (1000 * 1000)
+
+/**
+ * Start a connection attempt; network_connect() then runs from the main
+ * loop until the WiFi join finishes
+ */
+static void start_connect(SceUInt64 now) {
+  g_last_connect_attempt = now;
+  g_connect_attempts++;
+  net_log("network_connect attempt=%d", g_connect_attempts);
+  if (g_connect_start_us == 0) {
+    g_connect_start_us = now;
+  }
+
+  /* Each retry waits twice as long, until the desktop answers */
+  if (g_connect_backoff_us == 0) {
+    g_connect_backoff_us = CONNECT_RETRY_US;
+  } else if (g_connect_backoff_us < CONNECT_RETRY_MAX_US) {
+    g_connect_backoff_us *= 2;
+    if (g_connect_backoff_us > CONNECT_RETRY_MAX_US) {
+      g_connect_backoff_us = CONNECT_RETRY_MAX_US;
+    }
   }
 
-  va_start(args, fmt);
-  vsnprintf(buf, sizeof(buf), fmt, args);
-  va_end(args);
+  g_connected = 0;
+  g_connecting = 1;
+}
 
-  fd = sceIoOpen(LOG_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_APPEND, 0777);
-  if (fd < 0) {
+/**
+ * Advance a connection attempt started by start_connect()
+ */
+static void poll_connect(void) {
+  int conn_res = network_connect(&g_config);
+
+  if (conn_res == NET_CONNECT_PENDING) {
     return;
   }
 
-  len = (int)strlen(buf);
-  if (len > 0) {
-    if (g_mode_label != NULL) {
-      snprintf(line, sizeof(line), "[NET:%s] %s", g_mode_label, buf);
-      sceIoWrite(fd, line, (int)strlen(line));
-    } else {
-      snprintf(line, sizeof(line), "[NET] %s", buf);
-      sceIoWrite(fd, line, (int)strlen(line));
-    }
-    sceIoWrite(fd, "\n", 1);
+  g_connecting = 0;
+  if (conn_res == 0) {
+    /* The heartbeat is the handshake: its ACK carries the session */
+    drp_core_heartbeat_now(&g_core);
+    g_waiting_for_ack = 1;
+    net_log(g_config.auto_discovery ? "Waiting for discovery"
+                                    : "Waiting for ACK");
+  } else {
+    net_log("network_connect failed: %d", conn_res);
   }
-  sceIoClose(fd);
 }
 
 /**
- * Get current time in microseconds
+ * The desktop answered: reset the connection state
  */
-static SceUInt64 get_time_us(void) {
-  SceKernelSysClock clock;
-  sceKernelGetSystemTime(&clock);
-  return clock.low + ((SceUInt64)clock.hi << 32);
+static void on_connected(void) {
+  g_connected = 1;
+  g_connecting = 0;
+  g_waiting_for_ack = 0;
+  g_connect_start_us = 0;
+  g_connect_backoff_us = 0;
+}
+
+/**
+ * Sleep until the next main loop deadline (or a packet arrives)
+ */
+static void wait_for_next_due(SceUInt64 now) {
+  SceUInt64 due;
+  SceUInt64 max_wait = g_started_from_ui ? IDLE_MAX_US_VSH : IDLE_MAX_US;
+  SceUInt64 wait;
+  int tasks = 0;
+
+  if (!g_started_from_ui) {
+    tasks |= DRP_TASK_DETECT;
+  }
+  /* Nothing to send over while WiFi is still joining */
+  if (g_network_initialized && network_link_up()) {
+    tasks |= DRP_TASK_HEARTBEAT;
+    if (g_connected) {
+      tasks |= DRP_TASK_GAME | DRP_TASK_SYNC;
+    }
+  }
+  due = drp_core_next_due(&g_core, tasks);
+
+  if (!g_network_initialized) {
+    SceUInt64 next_init = g_next_init_attempt;
+    if (next_init < now + WLAN_CHECK_US) {
+      next_init = now + WLAN_CHECK_US;
+    }
+    if (next_init < due) {
+      due = next_init;
+    }
+  } else if (g_connecting) {
+    if (now + CONNECT_POLL_US < due) {
+      due = now + CONNECT_POLL_US;
+    }
+  } else if (!g_connected && !g_config.auto_discovery &&
+             g_last_connect_attempt + g_connect_backoff_us < due) {
+    due = g_last_connect_attempt + g_connect_backoff_us;
+  }
+  if (!g_connected && g_connect_start_us != 0 &&
+      g_config.connect_timeout_s > 0) {
+    SceUInt64 timeout_at =
+        g_connect_start_us + (SceUInt64)g_config.connect_timeout_s * 1000000;
+    if (timeout_at < due) {
+      due = timeout_at;
+    }
+  }
+
+  if (due <= now + LOOP_RETRY_US) {
+    wait = LOOP_RETRY_US;
+  } else if (due - now > max_wait) {
+    wait = max_wait;
+  } else {
+    wait = due - now;
+  }
+  network_wait((uint32_t)wait);
 }
 
 /**
@@ -245,6 +326,102 @@ static int get_game_info(GameInfo *info) {
   return -1;
 }
 
+/*============================================================================
+ * Network transport for the shared core
+ *============================================================================*/
+
+static void net_core_log(const char *msg) { net_log("%s", msg); }
+
+static int net_send_heartbeat(uint64_t now_us,
+                              const HeartbeatMetrics *metrics) {
+  (void)now_us;
+  return network_send_heartbeat(metrics);
+}
+
+static int net_send_stats_request(void) {
+  return network_send_stats_request(usage_get_peer_version(),
+                                    usage_get_sync_version());
+}
+
+/**
+ * Check on the stats response; once complete, merge it and send our side
+ */
+static int net_poll_stats(void) {
+  static char delta_buf[sizeof(StatsDeltaHeader) +
+                        STATS_DELTA_MAX_RECORDS * sizeof(StatsDeltaRecord)];
+  size_t bytes_received = 0;
+
+  int resp = network_poll_stats_response(NULL, delta_buf, sizeof(delta_buf),
+                                         &bytes_received);
+  if (resp == 2) {
+    /* Desktop sent only what changed - merge, then send ours back */
+    int more = (bytes_received >= sizeof(StatsDeltaHeader) &&
+                (((const StatsDeltaHeader *)delta_buf)->flags &
+                 STATS_DELTA_FLAG_MORE));
+    int merged = usage_merge_remote(delta_buf, bytes_received);
+    net_log("Stats delta: %u bytes, %d games updated",
+            (unsigned int)bytes_received, merged);
+    if (merged > 0) {
+      usage_export_json();
+    }
+
+    int delta_len = usage_build_delta(delta_buf, sizeof(delta_buf));
+    if (delta_len > 0) {
+      net_log("Uploading stats delta (%d bytes)", delta_len);
+      network_send_stats_upload(delta_buf, (size_t)delta_len,
+                                usage_get_sync_version());
+      if (((const StatsDeltaHeader *)delta_buf)->flags &
+          STATS_DELTA_FLAG_MORE) {
+        more = 1;
+      }
+    }
+
+    return more ? DRP_SYNC_AGAIN : DRP_SYNC_DONE;
+  }
+
+  if (resp == 1) {
+    /* A pre-delta desktop sent its whole file. That can't be merged into
+     * usage.bin, so neither side changes until the companion is updated */
+    net_log("Stats sync skipped: desktop sent %u bytes of JSON, not a delta",
+            (unsigned int)bytes_received);
+    return DRP_SYNC_DONE;
+  }
+
+  if (resp == 0) {
+    /* Still receiving chunks */
+    return DRP_SYNC_WAITING;
+  }
+
+  if (resp == -2) {
+    /* Incomplete or commit failed - previous file kept */
+    net_log("Stats sync FAILED - data truncated");
+  } else {
+    net_log("Stats response error: %d", resp);
+  }
+  return DRP_SYNC_FAILED;
+}
+
+static const DrpTransport g_net_transport = {
+    .log = net_core_log,
+    .send_game_info = network_send_game_info,
+    .send_heartbeat = net_send_heartbeat,
+    .send_icon = network_send_icon,
+    .poll = network_poll_message,
+    .send_stats_request = net_send_stats_request,
+    .poll_stats = net_poll_stats,
+};
+
+/**
+ * Take the game the loader detected, saving the early probe
+ */
+static void handoff_game(GameInfo *info) {
+  memset(info, 0, sizeof(GameInfo));
+  strncpy(info->game_id, g_handoff.game_id, sizeof(info->game_id) - 1);
+  strncpy(info->title, g_handoff.title, sizeof(info->title) - 1);
+  info->has_icon = (g_handoff.flags & DRP_HANDOFF_ICON) ? 1 : 0;
+  game_detect_seed(info, g_handoff.game_path);
+}
+
 static int plugin_thread(SceSize args, void *argp) {
   (void)args;
   (void)argp;
@@ -252,15 +429,24 @@ static int plugin_thread(SceSize args, void *argp) {
   GameInfo new_game;
   SceUInt64 now;
   char early_game_id[10] = {0};
+  DrpSettings settings;
 
+  /* This thread owns the log file; other threads only append to RAM */
+  net_log_set_flush_thread();
   net_log("Net thread started");
 
-  if (config_load(&g_config) < 0) {
+  if (g_handoff.flags & DRP_HANDOFF_CONFIG) {
+    config_load_text(&g_config, g_handoff.config);
+  } else if (config_load(&g_config) < 0) {
     config_set_defaults(&g_config);
   }
 
   /* Set logging flag from config */
-  g_logging_enabled = g_config.enable_logging;
+  net_log_set_enabled(g_config.enable_logging);
+  if (g_handoff.flags & DRP_HANDOFF_CONFIG) {
+    net_log("Config from loader (%lu bytes)",
+            (unsigned long)g_handoff.config_len);
+  }
 
   net_log("Config: enabled=%d ip=%s port=%d auto=%d icons=%d "
           "poll_ms=%lu hb_ms=%lu update_ms=%lu timeout_s=%lu send_once=%d",
@@ -273,6 +459,7 @@ static int plugin_thread(SceSize args, void *argp) {
 
   if (!g_config.enabled) {
     net_log("Plugin disabled in config");
+    net_log_flush();
     return 0;
   }
 
@@ -285,41 +472,44 @@ static int plugin_thread(SceSize args, void *argp) {
     usage_set_psp_name(g_config.psp_name);
     usage_init();
 
+    SceUInt64 last_save = 0;
+
     /* Get initial game info from loader - if not available, assume XMB */
     if (get_game_info(&new_game) == 0 && new_game.game_id[0] != '\0') {
-      memcpy(&g_current_game, &new_game, sizeof(GameInfo));
       /* Rename XMB module to friendly name */
-      if (strncmp(g_current_game.game_id, "Xmb", 3) == 0 ||
-          strcmp(g_current_game.game_id, "XMB") == 0) {
-        strcpy(g_current_game.game_id, "XMB");
-        strcpy(g_current_game.title, "Browsing XMB");
+      if (strncmp(new_game.game_id, "Xmb", 3) == 0 ||
+          strcmp(new_game.game_id, "XMB") == 0) {
+        strcpy(new_game.game_id, "XMB");
+        strcpy(new_game.title, "Browsing XMB");
       }
     } else {
       /* No game info from loader - assume XMB in offline mode */
-      strcpy(g_current_game.game_id, "XMB");
-      strcpy(g_current_game.title, "Browsing XMB");
-      g_current_game.state = STATE_XMB;
+      strcpy(new_game.game_id, "XMB");
+      strcpy(new_game.title, "Browsing XMB");
+      new_game.state = STATE_XMB;
     }
-    usage_start_session(g_current_game.game_id, g_current_game.title);
-    net_log("Started tracking: %s", g_current_game.title);
+    usage_start_session(new_game.game_id, new_game.title);
+    net_log("Started tracking: %s", new_game.title);
 
     /* Simple loop - just save usage periodically, no game polling */
     while (g_running) {
-      now = get_time_us();
+      now = drp_time_us();
 
-      /* Save periodically (every 30 seconds) */
-      if (now - g_last_heartbeat >= 30 * 1000 * 1000) {
-        g_last_heartbeat = now;
+      /* Checkpoint the session periodically (every 30 seconds) */
+      if (now - last_save >= 30 * 1000 * 1000) {
+        last_save = now;
         usage_save();
       }
 
+      net_log_poll();
       sceKernelDelayThread(1000 * 1000); /* Sleep 1 second */
     }
 
-    /* Cleanup - save final usage */
+    /* Cleanup - record the session and refresh the stats app's JSON */
     usage_end_session();
-    usage_save();
+    usage_export_json();
     net_log("Offline mode ended, usage saved");
+    net_log_flush();
     return 0;
   }
 
@@ -328,15 +518,34 @@ static int plugin_thread(SceSize args, void *argp) {
   game_detect_init();
   usage_init(); /* Initialize usage tracker for WiFi mode too */
 
-  net_log("=== DEBUG: Starting game detection ===");
+  memset(&settings, 0, sizeof(settings));
+  settings.poll_interval_ms = g_config.poll_interval_ms;
+  settings.heartbeat_interval_ms = g_config.heartbeat_interval_ms;
+  settings.game_update_interval_ms = g_config.game_update_interval_ms;
+  settings.event_detect = g_config.event_detect;
+  settings.send_icons = g_config.send_icons;
+  settings.persistent = g_config.send_once;
+  settings.psp_name = g_config.psp_name;
+  drp_core_init(&g_core, &g_net_transport, &settings, g_icon_buffer,
+                ICON_BUFFER_SIZE);
 
   /* Early game detection and vblank wait for ALL games */
   if (!g_started_from_ui) {
     int vblank_count = g_config.vblank_wait; /* Use global config value */
     int game_vblank;
+    int found;
+
+    if (g_handoff.flags & DRP_HANDOFF_GAME) {
+      /* Already probed by the loader; goes out as soon as we connect */
+      handoff_game(&new_game);
+      drp_core_set_game(&g_core, &new_game);
+      found = (new_game.game_id[0] != '\0');
+    } else {
+      found = (game_detect_current(&new_game) == 0 &&
+               new_game.game_id[0] != '\0');
+    }
 
-    net_log("DEBUG: Calling game_detect_current");
-    if (game_detect_current(&new_game) == 0 && new_game.game_id[0] != '\0') {
+    if (found) {
       strncpy(early_game_id, new_game.game_id, sizeof(early_game_id) - 1);
       net_log("Early game detect: %s title=%s", early_game_id, new_game.title);
 
@@ -344,6 +553,7 @@ static int plugin_thread(SceSize args, void *argp) {
       if (is_incompatible_game(early_game_id)) {
         net_log("Game %s is incompatible, exiting plugin thread",
                 early_game_id);
+        net_log_flush();
         return 0;
       }
 
@@ -371,15 +581,13 @@ static int plugin_thread(SceSize args, void *argp) {
       sceKernelDelayThread(delay_ms * 1000);
     } else {
       /* Normal games: use vblank wait */
-      net_log("DEBUG: vblank_wait=%d (~%d seconds)", vblank_count,
+      net_log("Using vblank_wait=%d (~%d seconds)", vblank_count,
               vblank_count / 60);
       wait_for_vblanks(vblank_count);
     }
-    net_log("DEBUG: Wait finished");
+    net_log_flush();
   }
 
-  net_log("=== DEBUG: About to check network ===");
-
   /* Try to initialize/reuse network connection. */
   if (!g_network_initialized && !g_started_from_ui) {
     net_log("=== Checking for existing network connection ===");
@@ -396,19 +604,21 @@ static int plugin_thread(SceSize args, void *argp) {
   }
 
   if (g_started_from_ui) {
-    memset(&g_current_game, 0, sizeof(g_current_game));
-    strcpy(g_current_game.game_id, "XMB");
-    strcpy(g_current_game.title, "Browsing XMB");
-    g_current_game.state = STATE_XMB;
-    g_current_game.start_time = 0;
-    g_current_game.has_icon = 0;
-    g_game_changed = 1;
+    memset(&new_game, 0, sizeof(new_game));
+    strcpy(new_game.game_id, "XMB");
+    strcpy(new_game.title, "Browsing XMB");
+    new_game.state = STATE_XMB;
+    new_game.start_time = 0;
+    new_game.has_icon = 0;
+    drp_core_set_game(&g_core, &new_game);
   }
 
   while (g_running) {
-    now = get_time_us();
+    now = drp_time_us();
+    drp_metrics_wakeup();
 
-    if (!g_network_initialized && sceWlanGetSwitchState() == 1) {
+    if (!g_network_initialized && now >= g_next_init_attempt &&
+        sceWlanGetSwitchState() == 1) {
       g_init_attempts++;
 
       /* Retry with connection attempt */
@@ -417,27 +627,7 @@ static int plugin_thread(SceSize args, void *argp) {
       if (net_res == 0) {
         g_network_initialized = 1;
 
-        g_last_connect_attempt = now;
-        g_connect_attempts++;
-        net_log("network_connect attempt=%d", g_connect_attempts);
-        if (g_connect_start_us == 0) {
-          g_connect_start_us = now;
-        }
-        {
-          int conn_res = network_connect(&g_config);
-          if (conn_res == 0) {
-            g_connected = 0;
-            g_waiting_for_ack = 1;
-            net_log("Waiting for ACK");
-          } else if (conn_res == 1) {
-            g_connected = 0;
-            g_waiting_for_ack = 1;
-            net_log("Waiting for discovery");
-          } else {
-            g_connected = 0;
-            net_log("network_connect failed: %d", conn_res);
-          }
-        }
+        start_connect(now);
       } else {
         net_log("network_init failed: 0x%08X", (unsigned int)net_res);
 
@@ -447,7 +637,7 @@ static int plugin_thread(SceSize args, void *argp) {
           network_force_cleanup();
         }
 
-        sceKernelDelayThread(2000 * 1000);
+        g_next_init_attempt = now + INIT_RETRY_US;
       }
     }
 
@@ -456,130 +646,65 @@ static int plugin_thread(SceSize args, void *argp) {
       network_shutdown();
       g_network_initialized = 0;
       g_connected = 0;
+      g_connecting = 0;
+    }
+
+    /* WiFi join in progress, one step per pass */
+    if (g_network_initialized && g_connecting) {
+      poll_connect();
     }
 
     if (g_network_initialized && g_config.auto_discovery) {
       int found = network_handle_discovery(&g_config);
       if (found > 0) {
-        g_connected = 1;
-        g_waiting_for_ack = 0;
-        g_connect_start_us = 0;
+        on_connected();
         net_log("Discovered %s:%d", g_config.desktop_ip, g_config.port);
 
         /* Trigger initial stats sync on connection */
-        g_stats_sync_pending = 0;
-        g_stats_sync_done = 0;
-        g_last_stats_sync = 0;
+        drp_core_resync(&g_core);
       }
     }
 
-    /* Poll for incoming messages (ACK or icon request) */
+    /* Poll for incoming messages; icon requests and stats responses are
+     * handled by the core */
     if (g_network_initialized) {
-      char requested_game_id[10] = {0};
-      int msg_result = network_poll_message(requested_game_id);
-
-      if (msg_result == 1 && g_waiting_for_ack) {
-        /* ACK received */
-        g_connected = 1;
-        g_waiting_for_ack = 0;
-        g_connect_start_us = 0;
-        net_log("Desktop ACK received (sync_pending=%d)", g_stats_sync_pending);
-
-        /* Trigger initial stats sync on connection (only if not already
-         * syncing) */
-        if (!g_stats_sync_pending) {
-          g_stats_sync_done = 0;
-          g_last_stats_sync = 0;
-          net_log("Stats state reset for initial sync");
-        }
-      } else if (msg_result == 2 && g_connected && g_config.send_icons) {
-        /* Icon request received */
-        net_log("Icon requested for: %s", requested_game_id);
-        uint32_t icon_size = 0;
-        int icon_res = game_detect_get_icon(requested_game_id, g_icon_buffer,
-                                            ICON_BUFFER_SIZE, &icon_size);
-        if (icon_res == 0) {
-          if (network_send_icon(requested_game_id, g_icon_buffer, icon_size) ==
-              0) {
-            net_log("Icon sent on request (%u bytes)", (unsigned int)icon_size);
-          } else {
-            net_log("Icon send failed for request");
-          }
-        } else {
-          net_log("Icon load failed for request: %d", icon_res);
+      int msg_result = drp_core_poll(&g_core);
+
+      if (msg_result == DRP_MSG_ACK) {
+        uint32_t session = network_ack_session();
+        int was_waiting = g_waiting_for_ack;
+
+        if (was_waiting) {
+          /* ACK received */
+          on_connected();
+          net_log("Desktop ACK received (sync_pending=%d)",
+                  g_core.stats_sync_pending);
         }
-      }
 
-      /* Handle stats sync response (msg_result == 3) */
-      if (msg_result == 3 && g_stats_sync_pending) {
-        /* Stats response received - check if streaming is complete */
-        uint64_t remote_last_updated = 0;
-        size_t bytes_received = 0;
-
-        int resp = network_poll_stats_response(&remote_last_updated, NULL, 0,
-                                               &bytes_received);
-        if (resp == 1) {
-          /* Complete and verified - data already written to file by network
-           * layer */
-          net_log("Stats sync complete, %u bytes received",
-                  (unsigned int)bytes_received);
-
-          /* Check if we need to upload local data instead */
-          uint64_t local_last_updated = usage_get_last_updated();
-          if (local_last_updated > remote_last_updated) {
-            /* Local is newer - upload our data */
-            net_log("Local data is newer, uploading");
-            char local_json[4096];
-            int local_len =
-                usage_serialize_json(local_json, sizeof(local_json));
-            if (local_len > 0) {
-              network_send_stats_upload(local_json, (size_t)local_len,
-                                        local_last_updated);
-            }
+        if (session != 0 && session == g_session) {
+          if (was_waiting) {
+            /* Desktop still has our game and sync watermark */
+            net_log("Session %08X resumed", (unsigned int)session);
+          }
+        } else if (was_waiting || session != g_session) {
+          /* New connection or the desktop restarted: it has none of our
+           * state, so send the game again and sync (only if not already
+           * syncing) */
+          net_log("New desktop session %08X", (unsigned int)session);
+          g_session = session;
+          drp_core_resend_game(&g_core);
+          if (!g_core.stats_sync_pending) {
+            drp_core_resync(&g_core);
+            net_log("Stats state reset for initial sync");
           }
-
-          g_stats_sync_pending = 0;
-          g_stats_sync_done = 1;
-          g_last_stats_sync = now;
-        } else if (resp == -2) {
-          /* Truncated - file was deleted, will retry */
-          net_log("Stats sync FAILED - data truncated, will retry");
-          g_stats_sync_pending = 0;
-          /* Don't set g_stats_sync_done so it will retry next interval */
-        } else if (resp == 0) {
-          /* Still receiving chunks */
-        } else {
-          /* Other error */
-          net_log("Stats response error: %d", resp);
-          g_stats_sync_pending = 0;
-          g_stats_sync_done = 1; /* Mark done to prevent immediate retry */
         }
       }
     }
 
     if (g_network_initialized && !g_connected && !g_config.auto_discovery) {
-      if (now - g_last_connect_attempt >= CONNECT_RETRY_US) {
-        g_last_connect_attempt = now;
-        g_connect_attempts++;
-        net_log("network_connect attempt=%d", g_connect_attempts);
-        if (g_connect_start_us == 0) {
-          g_connect_start_us = now;
-        }
-        {
-          int conn_res = network_connect(&g_config);
-          if (conn_res == 0) {
-            g_connected = 0;
-            g_waiting_for_ack = 1;
-            net_log("Waiting for ACK");
-          } else if (conn_res == 1) {
-            g_connected = 0;
-            g_waiting_for_ack = 1;
-            net_log("Waiting for discovery");
-          } else {
-            g_connected = 0;
-            net_log("network_connect failed: %d", conn_res);
-          }
-        }
+      if (!g_connecting &&
+          now - g_last_connect_attempt >= g_connect_backoff_us) {
+        start_connect(now);
       }
     }
 
@@ -601,141 +726,46 @@ static int plugin_thread(SceSize args, void *argp) {
     }
 
     if (!g_started_from_ui) {
-      SceUInt64 game_check_interval_us =
-          (SceUInt64)g_config.poll_interval_ms * 1000;
-      if (game_check_interval_us < 500000) {
-        game_check_interval_us = 500000;
-      }
-      if (now - g_last_game_check >= game_check_interval_us) {
-        g_last_game_check = now;
-        if (game_detect_current(&new_game) == 0) {
-          if (strcmp(new_game.game_id, g_current_game.game_id) != 0 ||
-              new_game.state != g_current_game.state) {
-            memcpy(&g_current_game, &new_game, sizeof(GameInfo));
-            g_game_changed = 1;
-          }
-        }
-      }
+      drp_core_detect(&g_core, now, 0);
     }
 
-    if (g_network_initialized) {
-      {
-        SceUInt64 heartbeat_interval_us =
-            (SceUInt64)g_config.heartbeat_interval_ms * 1000;
-        if (heartbeat_interval_us < 1000000) {
-          heartbeat_interval_us = 1000000;
-        }
-        if (heartbeat_interval_us > 300000000) {
-          heartbeat_interval_us = 300000000;
-        }
-        if (now - g_last_heartbeat >= heartbeat_interval_us) {
-          g_last_heartbeat = now;
-          network_send_heartbeat();
-        }
-      }
-
-      if (g_connected) {
-        int should_send = g_game_changed;
-        if (!should_send && g_config.game_update_interval_ms > 0) {
-          SceUInt64 resend_us =
-              (SceUInt64)g_config.game_update_interval_ms * 1000;
-          if (resend_us < 1000000) {
-            resend_us = 1000000;
-          }
-          if (resend_us > 3600000000ULL) {
-            resend_us = 3600000000ULL;
-          }
-          if (now - g_last_game_send >= resend_us) {
-            should_send = 1;
-          }
-        }
-
-        if (should_send) {
-          int icon_needed = g_game_changed;
-          /* Set persistent flag for send_once mode */
-          g_current_game.persistent = g_config.send_once ? 1 : 0;
-          /* Copy PSP name from config */
-          memcpy(g_current_game.psp_name, g_config.psp_name,
-                 sizeof(g_current_game.psp_name));
-          if (network_send_game_info(&g_current_game) >= 0) {
-            if (icon_needed && g_config.send_icons && g_current_game.has_icon) {
-              if (strncmp(g_last_icon_id, g_current_game.game_id,
-                          sizeof(g_last_icon_id)) != 0) {
-                uint32_t icon_size = 0;
-                int icon_res =
-                    game_detect_get_icon(g_current_game.game_id, g_icon_buffer,
-                                         ICON_BUFFER_SIZE, &icon_size);
-                if (icon_res == 0) {
-                  if (network_send_icon(g_current_game.game_id, g_icon_buffer,
-                                        icon_size) == 0) {
-                    memcpy(g_last_icon_id, g_current_game.game_id,
-                           sizeof(g_last_icon_id));
-                    net_log("Icon sent (%u bytes)", (unsigned int)icon_size);
-                  } else {
-                    net_log("Icon send failed");
-                  }
-                } else {
-                  net_log("Icon load failed: %d", icon_res);
-                }
-              }
-            }
-            g_game_changed = 0;
-            g_last_game_send = now;
-
-            /* Send once mode: after first successful send, shutdown and exit */
-            if (g_config.send_once) {
-              net_log("Send once complete, shutting down network");
-              network_disconnect();
-              network_shutdown();
-              g_network_initialized = 0;
-              g_connected = 0;
-              g_running = 0;
-              break;
-            }
+    /* The heartbeat doubles as the handshake, so it runs once the link is
+     * up; everything else waits for the desktop */
+    if (g_network_initialized && network_link_up()) {
+      drp_core_heartbeat(&g_core, now);
+
+      if (g_connected && drp_core_send_game(&g_core, now) > 0 &&
+          g_config.send_once) {
+        /* Send once mode: after first successful send, shutdown and exit.
+         * No time to wait for the desktop's reply, push the icon */
+        if (g_config.send_icons && g_core.game.has_icon) {
+          uint32_t icon_size = 0;
+          if (game_detect_get_icon(g_core.game.game_id, g_icon_buffer,
+                                   ICON_BUFFER_SIZE, &icon_size) == 0 &&
+              network_send_icon(g_core.game.game_id, g_icon_buffer,
+                                icon_size) == 0) {
+            net_log("Icon sent (%u bytes)", (unsigned int)icon_size);
           }
         }
+        net_log("Send once complete, shutting down network");
+        network_disconnect();
+        network_shutdown();
+        g_network_initialized = 0;
+        g_connected = 0;
+        g_running = 0;
+        break;
       }
 
-      /* Stats sync logic */
-      if (!g_stats_sync_pending) {
-        int should_sync = 0;
-
-        /* Initial sync on connect */
-        if (!g_stats_sync_done && g_last_stats_sync == 0) {
-          should_sync = 1;
-          net_log("Triggering initial stats sync");
-        }
-        /* Periodic sync */
-        else if (g_stats_sync_done &&
-                 (now - g_last_stats_sync >= STATS_SYNC_INTERVAL_US)) {
-          should_sync = 1;
-          net_log("Triggering periodic stats sync");
-        }
-
-        if (should_sync) {
-          int ret = network_send_stats_request();
-          if (ret >= 0) {
-            /* ret > 0 means bytes sent successfully */
-            g_stats_sync_pending = 1;
-            g_last_stats_sync = now;
-            net_log("Stats request sent (%d bytes)", ret);
-          } else {
-            net_log("Stats request failed: %d", ret);
-          }
-        }
-      } else {
-        /* Sync is pending - check for timeout (30 seconds) */
-        if ((now - g_last_stats_sync) > (30 * 1000 * 1000ULL)) {
-          net_log("Stats sync timeout, giving up");
-          g_stats_sync_pending = 0;
-          g_stats_sync_done = 1; /* Mark done to prevent immediate retry */
-        }
+      if (g_connected) {
+        drp_core_sync(&g_core, now);
       }
     }
 
-    sceKernelDelayThread(100 * 1000);
+    net_log_poll();
+    wait_for_next_due(drp_time_us());
   }
 
+  net_log_flush();
   return 0;
 }
 
@@ -747,7 +777,7 @@ int module_start(SceSize args, void *argp) {
   g_startup_game_id[0] = '\0';
   g_startup_game_title[0] = '\0';
 
-  if (argp != NULL && args >= (SceSize)sizeof(RpcStartArgs)) {
+  if (argp != NULL && args >= (SceSize)RPC_START_ARGS_BASE_SIZE) {
     RpcStartArgs *start = (RpcStartArgs *)argp;
     if (start->magic == RPC_START_MAGIC) {
       if (start->profile_id > 0) {
@@ -766,6 +796,16 @@ int module_start(SceSize args, void *argp) {
                 sizeof(g_startup_game_title) - 1);
         g_startup_game_title[sizeof(g_startup_game_title) - 1] = '\0';
       }
+
+      /* argp only lives until module_start returns */
+      if (args >= (SceSize)sizeof(RpcStartArgs) &&
+          DRP_HANDOFF_VALID(&start->handoff)) {
+        memcpy(&g_handoff, &start->handoff, sizeof(g_handoff));
+        g_handoff.game_id[sizeof(g_handoff.game_id) - 1] = '\0';
+        g_handoff.title[sizeof(g_handoff.title) - 1] = '\0';
+        g_handoff.game_path[sizeof(g_handoff.game_path) - 1] = '\0';
+        g_handoff.config[g_handoff.config_len] = '\0';
+      }
     }
   }
 
@@ -775,10 +815,10 @@ int module_start(SceSize args, void *argp) {
   } else {
     g_mode_label = "GAME";
   }
+  net_log_init(g_mode_label);
 
   net_log("module_start called");
-  net_log("BUILD: FEB04-1821 FIX_C89_DECL");
-  if (argp != NULL && args >= (SceSize)sizeof(RpcStartArgs)) {
+  if (argp != NULL && args >= (SceSize)RPC_START_ARGS_BASE_SIZE) {
     RpcStartArgs *start = (RpcStartArgs *)argp;
     if (start->magic == RPC_START_MAGIC) {
       net_log("Start args profile=%d flags=0x%X", g_profile_id, start->flags);
@@ -812,6 +852,7 @@ int module_stop(SceSize args, void *argp) {
 
   if (!g_started_from_ui) {
     net_log("Skipping cleanup in GAME");
+    net_log_flush();
     return 0;
   }
 
@@ -829,5 +870,6 @@ int module_stop(SceSize args, void *argp) {
     g_network_initialized = 0;
   }
 
+  net_log_shutdown();
   return 0;
 }
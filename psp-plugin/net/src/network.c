@@ -15,10 +15,14 @@
 #include <pspwlan.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 #include "discord_rpc.h"
+#include "drp_metrics.h"
+#include "icon_cache.h"
 #include "network.h"
 
 /* Maximum packet size */
@@ -35,6 +39,13 @@ static int g_socket = -1;
 /* Desktop address */
 static struct sockaddr_in g_desktop_addr;
 
+/* Local port of the desktop socket. Fixed, so the desktop sees the same
+ * address after a reconnect and can keep the session. */
+#define LOCAL_PORT 9278
+
+/* Session from the last ACK, 0 if none */
+static uint32_t g_ack_session = 0;
+
 /* Discovery socket */
 static int g_discovery_socket = -1;
 
@@ -44,22 +55,85 @@ static SceUInt64 g_start_time = 0;
 /* Selected profile ID */
 static int g_profile_id = 1;
 
-/* Stats streaming state (write directly to file as received) */
-#define USAGE_LOG_PATH "ms0:/seplugins/pspdrp/usage_log.json"
+/*
+ * WiFi link bring-up, advanced one step per network_connect() call so the
+ * plugin thread never waits on apctl. The profile that last got an IP is
+ * remembered on the Memory Stick and tried when the selected one fails.
+ */
+#define LINK_CACHE_PATH "ms0:/seplugins/pspdrp/link.bin"
+#define LINK_CACHE_MAGIC 0x4B4E494C /* "LINK" */
+#define LINK_SETTLE_US (500 * 1000) /* After the pre-disconnect */
+#define LINK_JOIN_TIMEOUT_US (30 * 1000000ULL)
+
+enum {
+  LINK_DOWN = 0, /* Nothing started */
+  LINK_SETTLE,   /* Disconnected, waiting before sceNetApctlConnect */
+  LINK_JOINING,  /* Waiting for PSP_NET_APCTL_STATE_GOT_IP */
+  LINK_UP        /* Got an IP */
+};
+
+static struct {
+  int state;
+  int profile_id;     /* Profile being joined */
+  int last_good;      /* Profile that last got an IP, 0 if unknown */
+  int use_last_good;  /* Next join tries last_good instead */
+  int apctl_state;    /* For logging state changes */
+  SceUInt64 deadline; /* End of LINK_SETTLE / LINK_JOINING */
+  int cache_loaded;
+} g_link;
+
+typedef struct {
+  uint32_t magic;
+  int32_t profile_id;
+} LinkCache;
+
+/*
+ * Stats response staging. Chunks are reassembled in RAM by index, in any
+ * order, and the StatsDelta stays staged until the caller collects it. The
+ * whole usage_log.json a pre-delta desktop sends is dropped: usage.bin is
+ * the PSP's copy and the tracker exports the JSON from it.
+ */
+#define STATS_STAGE_SIZE (32 * 1024)
+#define STATS_STAGE_MAX_CHUNKS (STATS_STAGE_SIZE / STATS_CHUNK_SIZE)
+
+static uint8_t g_stats_stage[STATS_STAGE_SIZE];
 static struct {
-  SceUID fd;              /* File handle for streaming writes */
-  uint32_t total_bytes;   /* Expected total bytes (from first chunk) */
-  uint32_t bytes_written; /* Actual bytes written so far */
+  uint32_t total_bytes;    /* Expected total bytes (from any chunk) */
+  uint32_t bytes_received; /* Payload bytes staged so far */
   uint16_t total_chunks;
   uint16_t received_chunks;
   uint64_t last_updated;
+  uint8_t have[(STATS_STAGE_MAX_CHUNKS + 7) / 8]; /* Received bitmap */
   int active;
-  int verified; /* 1 if bytes match, 0 if failed */
-} g_stats_stream = {.fd = -1, .active = 0};
+  int complete; /* All chunks in and commit attempted */
+  int verified; /* 1 if committed to file, 0 if failed */
+  int delta;    /* Staged data is a StatsDelta rather than JSON */
+} g_stats_stream;
+
+/*
+ * Messages that arrived while a transfer waited for its TRANSFER_STATUS.
+ * They are handled right away (stats chunks are staged, the desktop address
+ * updated) and their results handed out by network_poll_message before it
+ * reads anything new.
+ */
+#define PENDING_MAX 8
+
+typedef struct {
+  int result;       /* network_poll_message return value */
+  uint32_t session; /* ACK session */
+  char game_id[10]; /* ICON_REQUEST / ICON_HAVE game */
+} PendingMessage;
+
+static PendingMessage g_pending[PENDING_MAX];
+static int g_pending_head = 0;
+static int g_pending_count = 0;
+
+/* 1 once the desktop has answered a poll on this connection, so a lossy
+ * start to a later transfer is not mistaken for an old desktop */
+static int g_transfer_peer_polls = 0;
 
 /* Forward declarations */
-static int connect_to_ap(void);
-static int wait_for_connection(int timeout_seconds);
+static int link_step(void);
 static void copy_str(char *dst, size_t dst_size, const char *src);
 static void ipv4_to_str(uint32_t addr_nbo, char *out, size_t out_size);
 
@@ -104,26 +178,6 @@ static void ipv4_to_str(uint32_t addr_nbo, char *out, size_t out_size) {
   snprintf(out, out_size, "%u.%u.%u.%u", b1, b2, b3, b4);
 }
 
-static uint32_t crc32_calc(const uint8_t *data, uint32_t len) {
-  uint32_t crc = 0xFFFFFFFF;
-  uint32_t i;
-  uint32_t j;
-  if (data == NULL) {
-    return 0;
-  }
-  for (i = 0; i < len; i++) {
-    crc ^= data[i];
-    for (j = 0; j < 8; j++) {
-      if (crc & 1) {
-        crc = (crc >> 1) ^ 0xEDB88320;
-      } else {
-        crc >>= 1;
-      }
-    }
-  }
-  return crc ^ 0xFFFFFFFF;
-}
-
 /**
  * Initialize network subsystem
  */
@@ -194,6 +248,8 @@ void network_set_profile_id(int profile_id) {
  * Shutdown network subsystem
  */
 void network_shutdown(void) {
+  g_link.state = LINK_DOWN;
+
   if (g_socket >= 0) {
     sceNetInetClose(g_socket);
     g_socket = -1;
@@ -250,21 +306,24 @@ void network_force_cleanup(void) {
 int network_connect(const PluginConfig *config) {
   int ret;
 
-  net_log("network_connect begin ip=%s port=%d auto=%d", config->desktop_ip,
+  if (g_link.state != LINK_UP) {
+    ret = link_step();
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  net_log("network_connect sockets ip=%s port=%d auto=%d", config->desktop_ip,
           config->port, config->auto_discovery);
 
-  /* Connect to WiFi access point */
-  ret = connect_to_ap();
-  if (ret < 0) {
-    net_log("connect_to_ap failed: 0x%08X", (unsigned int)ret);
-    return ret;
+  /* A retry reopens the sockets */
+  if (g_socket >= 0) {
+    sceNetInetClose(g_socket);
+    g_socket = -1;
   }
-
-  /* Wait for connection */
-  ret = wait_for_connection(30);
-  if (ret < 0) {
-    net_log("wait_for_connection failed: %d", ret);
-    return ret;
+  if (g_discovery_socket >= 0) {
+    sceNetInetClose(g_discovery_socket);
+    g_discovery_socket = -1;
   }
 
   /* Create UDP socket */
@@ -279,6 +338,18 @@ int network_connect(const PluginConfig *config) {
                                    sizeof(enable));
     net_log("socket broadcast ret=%d", opt);
   }
+  {
+    struct sockaddr_in local_addr;
+    memset(&local_addr, 0, sizeof(local_addr));
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_port = htons(LOCAL_PORT);
+    local_addr.sin_addr.s_addr = INADDR_ANY;
+
+    /* On failure the stack picks a port; only the session is lost */
+    ret = sceNetInetBind(g_socket, (struct sockaddr *)&local_addr,
+                         sizeof(local_addr));
+    net_log("socket bind ret=%d", ret);
+  }
 
   /* Set up desktop address */
   memset(&g_desktop_addr, 0, sizeof(g_desktop_addr));
@@ -325,6 +396,10 @@ int network_connect(const PluginConfig *config) {
  * Disconnect from desktop app
  */
 void network_disconnect(void) {
+  g_link.state = LINK_DOWN;
+  g_pending_count = 0;
+  g_transfer_peer_polls = 0; /* The next desktop may be older */
+
   if (g_socket >= 0) {
     sceNetInetClose(g_socket);
     g_socket = -1;
@@ -339,26 +414,88 @@ void network_disconnect(void) {
 }
 
 /**
- * Poll for incoming messages (ACK or icon request)
- * Returns: 1 = ACK received, 2 = icon request received, 3 = stats response, 0 =
- * nothing If icon request, game_id_out will be filled
+ * Mark the staged stats as a StatsDelta for the usage tracker to merge
  */
-int network_poll_message(char *game_id_out) {
-  uint8_t buffer[MAX_PACKET_SIZE];
-  struct sockaddr_in from_addr;
-  socklen_t from_len = sizeof(from_addr);
-  int ret;
-
-  if (g_socket < 0) {
+static int stats_stage_commit(void) {
+  /* Nothing on the desktop side - keep whatever we have */
+  if (g_stats_stream.total_bytes == 0) {
     return 0;
   }
 
-  ret = sceNetInetRecvfrom(g_socket, buffer, sizeof(buffer), MSG_DONTWAIT,
-                           (struct sockaddr *)&from_addr, &from_len);
-  if (ret <= 0) {
-    return 0;
+  if (g_stats_stream.total_bytes >= sizeof(StatsDeltaHeader) &&
+      memcmp(g_stats_stage, STATS_DELTA_MAGIC, 4) == 0) {
+    g_stats_stream.delta = 1;
+  }
+  return 0;
+}
+
+/**
+ * Stage one stats response chunk, committing once all are in
+ */
+static void stats_stage_chunk(const StatsResponsePacket *response) {
+  uint32_t offset = (uint32_t)response->chunk_index * STATS_CHUNK_SIZE;
+  uint16_t index = response->chunk_index;
+
+  /* A different transfer (or the first chunk of one) starts over */
+  if (!g_stats_stream.active ||
+      g_stats_stream.last_updated != response->last_updated ||
+      g_stats_stream.total_chunks != response->total_chunks ||
+      g_stats_stream.total_bytes != response->total_bytes) {
+    memset(&g_stats_stream, 0, sizeof(g_stats_stream));
+    g_stats_stream.total_bytes = response->total_bytes;
+    g_stats_stream.total_chunks = response->total_chunks;
+    g_stats_stream.last_updated = response->last_updated;
+    g_stats_stream.active = 1;
+    net_log("Stats stream started: total_bytes=%u chunks=%u",
+            response->total_bytes, response->total_chunks);
+
+    if (response->total_bytes > STATS_STAGE_SIZE ||
+        response->total_chunks > STATS_STAGE_MAX_CHUNKS) {
+      net_log("Stats response too large: %u bytes", response->total_bytes);
+      g_stats_stream.complete = 1;
+      return;
+    }
   }
 
+  if (g_stats_stream.complete || index >= g_stats_stream.total_chunks ||
+      (g_stats_stream.have[index >> 3] >> (index & 7)) & 1) {
+    return; /* Done, bogus or duplicate */
+  }
+  if (offset + response->data_length > g_stats_stream.total_bytes) {
+    net_log("Stats chunk %u out of range", (unsigned int)index);
+    return;
+  }
+
+  memcpy(&g_stats_stage[offset], response->json_data, response->data_length);
+  g_stats_stream.have[index >> 3] |= (uint8_t)(1 << (index & 7));
+  g_stats_stream.received_chunks++;
+  g_stats_stream.bytes_received += response->data_length;
+
+  if (g_stats_stream.received_chunks < g_stats_stream.total_chunks) {
+    return;
+  }
+
+  /* All chunks in - verify and write the file once */
+  g_stats_stream.complete = 1;
+  if (g_stats_stream.bytes_received != g_stats_stream.total_bytes) {
+    net_log("Stats TRUNCATED: got %u expected %u",
+            g_stats_stream.bytes_received, g_stats_stream.total_bytes);
+    return;
+  }
+  if (stats_stage_commit() == 0) {
+    g_stats_stream.verified = 1;
+    net_log("Stats verified: %u bytes", g_stats_stream.bytes_received);
+  }
+}
+
+/**
+ * Handle one received packet
+ *
+ * @return network_poll_message's result for it
+ */
+static int handle_packet(const uint8_t *buffer, int ret,
+                         const struct sockaddr_in *from_addr,
+                         char *game_id_out) {
   if (ret < (int)sizeof(PacketHeader)) {
     return 0;
   }
@@ -369,17 +506,23 @@ int network_poll_message(char *game_id_out) {
 
   /* Handle based on message type */
   if (buffer[4] == MSG_ACK) {
+    g_ack_session = 0;
+    if (ret >= (int)(sizeof(PacketHeader) + sizeof(AckPacket))) {
+      AckPacket ack;
+      memcpy(&ack, buffer + sizeof(PacketHeader), sizeof(ack));
+      g_ack_session = ack.session;
+    }
     g_desktop_addr.sin_family = AF_INET;
-    g_desktop_addr.sin_addr = from_addr.sin_addr;
-    g_desktop_addr.sin_port = from_addr.sin_port;
+    g_desktop_addr.sin_addr = from_addr->sin_addr;
+    g_desktop_addr.sin_port = from_addr->sin_port;
     return 1;
   }
 
   if (buffer[4] == MSG_ICON_REQUEST) {
     if (ret >= (int)(sizeof(PacketHeader) + sizeof(IconRequestPacket))) {
       if (game_id_out != NULL) {
-        IconRequestPacket *request =
-            (IconRequestPacket *)(buffer + sizeof(PacketHeader));
+        const IconRequestPacket *request =
+            (const IconRequestPacket *)(buffer + sizeof(PacketHeader));
         copy_str(game_id_out, 10, request->game_id);
         net_log("Icon request received for: %s", game_id_out);
       }
@@ -387,6 +530,17 @@ int network_poll_message(char *game_id_out) {
     }
   }
 
+  if (buffer[4] == MSG_ICON_HAVE) {
+    if (ret >= (int)(sizeof(PacketHeader) + sizeof(IconHavePacket))) {
+      if (game_id_out != NULL) {
+        const IconHavePacket *have =
+            (const IconHavePacket *)(buffer + sizeof(PacketHeader));
+        copy_str(game_id_out, 10, have->game_id);
+      }
+      return 4;
+    }
+  }
+
   /* Stats response received - stream directly to file */
   if (buffer[4] == MSG_STATS_RESPONSE) {
     /* Fixed header size: total_bytes(4) + last_updated(8) + chunk_index(2) +
@@ -400,8 +554,8 @@ int network_poll_message(char *game_id_out) {
       return 0; /* Invalid packet, don't claim we received it */
     }
 
-    StatsResponsePacket *response =
-        (StatsResponsePacket *)(buffer + sizeof(PacketHeader));
+    const StatsResponsePacket *response =
+        (const StatsResponsePacket *)(buffer + sizeof(PacketHeader));
 
     /* Now we can safely read data_length and check total size */
     int expected_size =
@@ -411,57 +565,8 @@ int network_poll_message(char *game_id_out) {
       return 0; /* Incomplete packet */
     }
 
-    /* Packet is valid, process it */
-
-    /* First chunk - open file for writing */
-    if (response->chunk_index == 0 || !g_stats_stream.active) {
-      /* Close any previous file if still open */
-      if (g_stats_stream.fd >= 0) {
-        sceIoClose(g_stats_stream.fd);
-      }
-      /* Open file for writing (truncate) */
-      g_stats_stream.fd = sceIoOpen(
-          USAGE_LOG_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC, 0777);
-      g_stats_stream.total_bytes = response->total_bytes;
-      g_stats_stream.bytes_written = 0;
-      g_stats_stream.total_chunks = response->total_chunks;
-      g_stats_stream.received_chunks = 0;
-      g_stats_stream.last_updated = response->last_updated;
-      g_stats_stream.verified = 0;
-      g_stats_stream.active = (g_stats_stream.fd >= 0) ? 1 : 0;
-      net_log("Stats stream started: total_bytes=%u chunks=%u",
-              response->total_bytes, response->total_chunks);
-    }
-
-    /* Write chunk data directly to file */
-    if (g_stats_stream.fd >= 0 && response->data_length > 0 &&
-        response->chunk_index == g_stats_stream.received_chunks) {
-      int written = sceIoWrite(g_stats_stream.fd, response->json_data,
-                               response->data_length);
-      if (written > 0) {
-        g_stats_stream.bytes_written += written;
-      }
-      g_stats_stream.received_chunks++;
-    }
-
-    /* Last chunk - close file and verify */
-    if (g_stats_stream.received_chunks >= g_stats_stream.total_chunks &&
-        g_stats_stream.fd >= 0) {
-      sceIoClose(g_stats_stream.fd);
-      g_stats_stream.fd = -1;
-
-      /* Verify byte count matches */
-      if (g_stats_stream.bytes_written == g_stats_stream.total_bytes) {
-        g_stats_stream.verified = 1;
-        net_log("Stats verified: %u bytes", g_stats_stream.bytes_written);
-      } else {
-        /* Truncated - delete corrupt file */
-        g_stats_stream.verified = 0;
-        sceIoRemove(USAGE_LOG_PATH);
-        net_log("Stats TRUNCATED: got %u expected %u",
-                g_stats_stream.bytes_written, g_stats_stream.total_bytes);
-      }
-    }
+    /* Packet is valid, stage it */
+    stats_stage_chunk(response);
 
     return 3;
   }
@@ -469,6 +574,103 @@ int network_poll_message(char *game_id_out) {
   return 0;
 }
 
+/**
+ * Queue a message received during a transfer for network_poll_message
+ */
+static void pending_push(int result, const char *game_id) {
+  PendingMessage *msg;
+
+  if (g_pending_count == PENDING_MAX) {
+    net_log("Pending queue full, message %d dropped", result);
+    return;
+  }
+
+  msg = &g_pending[(g_pending_head + g_pending_count) % PENDING_MAX];
+  msg->result = result;
+  msg->session = g_ack_session;
+  copy_str(msg->game_id, sizeof(msg->game_id), game_id);
+  g_pending_count++;
+}
+
+/**
+ * Poll for incoming messages (ACK or icon request)
+ * Returns: 1 = ACK received, 2 = icon request received, 3 = stats response,
+ * 4 = icon have, 0 = nothing. For icon request/have, game_id_out is filled
+ */
+int network_poll_message(char *game_id_out) {
+  uint8_t buffer[MAX_PACKET_SIZE];
+  struct sockaddr_in from_addr;
+  socklen_t from_len = sizeof(from_addr);
+  int ret;
+
+  if (g_pending_count > 0) {
+    PendingMessage *msg = &g_pending[g_pending_head];
+
+    g_pending_head = (g_pending_head + 1) % PENDING_MAX;
+    g_pending_count--;
+    if (msg->result == 1) {
+      g_ack_session = msg->session;
+    }
+    if (game_id_out != NULL) {
+      copy_str(game_id_out, 10, msg->game_id);
+    }
+    return msg->result;
+  }
+
+  if (g_socket < 0) {
+    return 0;
+  }
+
+  ret = sceNetInetRecvfrom(g_socket, buffer, sizeof(buffer), MSG_DONTWAIT,
+                           (struct sockaddr *)&from_addr, &from_len);
+  if (ret <= 0) {
+    return 0;
+  }
+  drp_metrics_rx((uint32_t)ret);
+
+  return handle_packet(buffer, ret, &from_addr, game_id_out);
+}
+
+int network_wait(uint32_t timeout_us) {
+  fd_set readfds;
+  struct timeval tv;
+  int max_fd = -1;
+  int ret;
+
+  if (g_pending_count > 0) {
+    return 1;
+  }
+
+  FD_ZERO(&readfds);
+  if (g_socket >= 0) {
+    FD_SET(g_socket, &readfds);
+    max_fd = g_socket;
+  }
+  if (g_discovery_socket >= 0) {
+    FD_SET(g_discovery_socket, &readfds);
+    if (g_discovery_socket > max_fd) {
+      max_fd = g_discovery_socket;
+    }
+  }
+
+  if (max_fd < 0) {
+    sceKernelDelayThread(timeout_us);
+    return 0;
+  }
+
+  tv.tv_sec = timeout_us / 1000000;
+  tv.tv_usec = timeout_us % 1000000;
+  ret = sceNetInetSelect(max_fd + 1, &readfds, NULL, NULL, &tv);
+  if (ret < 0) {
+    /* Socket closed under us or select unsupported - fall back to a tick */
+    sceKernelDelayThread(timeout_us < 100 * 1000 ? timeout_us : 100 * 1000);
+    return 0;
+  }
+  return ret > 0 ? 1 : 0;
+}
+
+uint32_t network_ack_session(void) { return g_ack_session; }
+
 /* Legacy wrapper for ACK polling */
 int network_poll_ack(void) {
   char game_id[10];
@@ -531,105 +733,158 @@ int network_show_profile_selector(void) {
     return -1;
   }
 
-  if (wait_for_connection(30) < 0) {
-    return -1;
+  /* The dialog started the join; network_connect() waits for the IP */
+  g_link.state = LINK_JOINING;
+  g_link.deadline = get_time_us() + LINK_JOIN_TIMEOUT_US;
+  return 0;
+}
+
+static void link_cache_load(void) {
+  LinkCache cache;
+  SceUID fd;
+
+  g_link.cache_loaded = 1;
+  fd = sceIoOpen(LINK_CACHE_PATH, PSP_O_RDONLY, 0);
+  if (fd < 0) {
+    return;
+  }
+  if (sceIoRead(fd, &cache, sizeof(cache)) == (int)sizeof(cache) &&
+      cache.magic == LINK_CACHE_MAGIC && cache.profile_id > 0) {
+    g_link.last_good = cache.profile_id;
+    net_log("link: last good profile=%d", g_link.last_good);
   }
+  sceIoClose(fd);
+}
 
-  return 0;
+static void link_cache_save(int profile_id) {
+  LinkCache cache;
+  SceUID fd;
+
+  if (profile_id <= 0 || profile_id == g_link.last_good) {
+    return;
+  }
+  g_link.last_good = profile_id;
+
+  cache.magic = LINK_CACHE_MAGIC;
+  cache.profile_id = profile_id;
+  fd = sceIoOpen(LINK_CACHE_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC,
+                 0777);
+  if (fd >= 0) {
+    sceIoWrite(fd, &cache, sizeof(cache));
+    sceIoClose(fd);
+  }
 }
 
 /**
- * Connect to WiFi access point
+ * Advance the WiFi bring-up by one step
+ *
+ * If the network is already connected or in the process of connecting (by
+ * the game), that connection is reused instead of disconnecting and
+ * reconnecting.
  *
- * This function handles network connection with care to not interfere with
- * game connections. If the network is already connected or in the process
- * of connecting (by the game), we reuse that connection instead of
- * disconnecting and reconnecting.
+ * @return 0 once the PSP has an IP, NET_CONNECT_PENDING while joining,
+ * negative on error
  */
-static int connect_to_ap(void) {
+static int link_step(void) {
+  SceUInt64 now = get_time_us();
   int ret;
   int state = 0;
 
-  net_log("connect_to_ap begin");
+  if (!g_link.cache_loaded) {
+    link_cache_load();
+  }
 
-  /* Check current network state */
-  ret = sceNetApctlGetState(&state);
-  net_log("connect_to_ap state ret=%d state=%d", ret, state);
+  switch (g_link.state) {
+  case LINK_DOWN:
+    ret = sceNetApctlGetState(&state);
+    net_log("link: state ret=%d state=%d", ret, state);
+
+    if (ret == 0) {
+      /* Already have an IP - fully connected, reuse this connection */
+      if (state == PSP_NET_APCTL_STATE_GOT_IP) {
+        net_log("link: already connected, reusing");
+        g_link.state = LINK_UP;
+        return 0;
+      }
 
-  if (ret == 0) {
-    /* Already have an IP - fully connected, reuse this connection */
-    if (state == PSP_NET_APCTL_STATE_GOT_IP) {
-      net_log("connect_to_ap: already connected, reusing");
-      return 0;
+      /* Network state > 0 means the game is connecting or connected
+       * States: 0=disconnected, 1=scanning, 2=joining, 3=getting IP, 4=got
+       * IP. For states 1-3, let the game's connection attempt complete */
+      if (state > 0) {
+        net_log("link: game connecting (state=%d), waiting for it", state);
+        g_link.profile_id = 0;
+        g_link.apctl_state = state;
+        g_link.state = LINK_JOINING;
+        g_link.deadline = now + LINK_JOIN_TIMEOUT_US;
+        return NET_CONNECT_PENDING;
+      }
     }
 
-    /* Network state > 0 means the game is connecting or connected
-     * States: 0=disconnected, 1=scanning, 2=joining, 3=getting IP, 4=got IP
-     * For states 1-3, let the game's connection attempt complete */
-    if (state > 0) {
-      net_log("connect_to_ap: game connecting (state=%d), waiting for it",
-              state);
-      return 0; /* Let wait_for_connection handle it */
+    /* Only disconnect and reconnect if truly disconnected or in error state.
+     * Give apctl a moment after the disconnect before joining. */
+    ret = sceNetApctlDisconnect();
+    net_log("link: pre-disconnect ret=0x%08X", (unsigned int)ret);
+    g_link.state = LINK_SETTLE;
+    g_link.deadline = now + LINK_SETTLE_US;
+    return NET_CONNECT_PENDING;
+
+  case LINK_SETTLE:
+    if (now < g_link.deadline) {
+      return NET_CONNECT_PENDING;
     }
-  }
-
-  /* Only disconnect and reconnect if truly disconnected or in error state */
-  net_log("connect_to_ap: disconnected, initiating connection");
-
-  /* Ensure clean state before connecting */
-  {
-    int disc = sceNetApctlDisconnect();
-    net_log("connect_to_ap pre-disconnect ret=0x%08X", (unsigned int)disc);
-    sceKernelDelayThread(500 * 1000);
-  }
-
-  /* Try to connect to configured profile */
-  ret = sceNetApctlConnect(g_profile_id);
-  net_log("connect_to_ap connect ret=0x%08X profile=%d", (unsigned int)ret,
-          g_profile_id);
-
-  if (ret < 0) {
-    return ret;
-  }
-
-  return 0;
-}
-
-/**
- * Wait for network connection
- */
-static int wait_for_connection(int timeout_seconds) {
-  int state = PSP_NET_APCTL_STATE_DISCONNECTED;
-  int timeout = timeout_seconds * 4; /* 300ms intervals */
-  int last_state = -1;
 
-  net_log("wait_for_connection timeout=%d", timeout_seconds);
+    g_link.profile_id = g_profile_id;
+    if (g_link.use_last_good && g_link.last_good > 0) {
+      g_link.profile_id = g_link.last_good;
+    }
+    ret = sceNetApctlConnect(g_link.profile_id);
+    net_log("link: connect ret=0x%08X profile=%d", (unsigned int)ret,
+            g_link.profile_id);
+    if (ret < 0) {
+      g_link.state = LINK_DOWN;
+      return ret;
+    }
+    g_link.apctl_state = -1;
+    g_link.state = LINK_JOINING;
+    g_link.deadline = now + LINK_JOIN_TIMEOUT_US;
+    return NET_CONNECT_PENDING;
 
-  while (timeout > 0) {
+  case LINK_JOINING:
     if (sceNetApctlGetState(&state) < 0) {
+      g_link.state = LINK_DOWN;
       return -1;
     }
-
-    if (state != last_state) {
+    if (state != g_link.apctl_state) {
       net_log("apctl state=%d", state);
-      last_state = state;
+      g_link.apctl_state = state;
     }
 
     if (state == PSP_NET_APCTL_STATE_GOT_IP) {
+      g_link.state = LINK_UP;
+      g_link.use_last_good = 0;
+      link_cache_save(g_link.profile_id);
       return 0;
     }
 
-    sceKernelDelayThread(300 * 1000);
-    timeout--;
-  }
+    if (now < g_link.deadline) {
+      return NET_CONNECT_PENDING;
+    }
 
-  net_log("wait_for_connection timeout");
-  {
-    int disc = sceNetApctlDisconnect();
-    net_log("wait_for_connection disconnect ret=0x%08X", (unsigned int)disc);
-  }
+    net_log("link: join timeout");
+    ret = sceNetApctlDisconnect();
+    net_log("link: disconnect ret=0x%08X", (unsigned int)ret);
+    g_link.state = LINK_DOWN;
 
-  return -1; /* Timeout */
+    /* Alternate with the last profile that worked */
+    if (g_link.last_good > 0 && g_link.last_good != g_profile_id) {
+      g_link.use_last_good = !g_link.use_last_good;
+    }
+    return -1; /* Timeout */
+
+  case LINK_UP:
+  default:
+    return 0;
+  }
 }
 
 /**
@@ -665,6 +920,7 @@ static int send_packet(uint8_t type, const void *payload, size_t payload_size) {
   ret = sceNetInetSendto(g_socket, buffer, total_size, 0,
                          (struct sockaddr *)&g_desktop_addr,
                          sizeof(g_desktop_addr));
+  drp_metrics_tx(ret, (uint32_t)total_size);
   if (ret < 0) {
     net_log("send_packet type=%d failed: %d", type, ret);
   }
@@ -672,14 +928,25 @@ static int send_packet(uint8_t type, const void *payload, size_t payload_size) {
 }
 
 /**
- * Send heartbeat packet
+ * Check whether the link is up and the socket open
  */
-int network_send_heartbeat(void) {
-  HeartbeatPacket packet;
+int network_link_up(void) {
+  return g_link.state == LINK_UP && g_socket >= 0;
+}
+
+/**
+ * Send heartbeat packet, followed by the metrics extension
+ */
+int network_send_heartbeat(const HeartbeatMetrics *metrics) {
+  struct {
+    HeartbeatPacket heartbeat;
+    HeartbeatMetrics metrics;
+  } __attribute__((packed)) packet;
   SceUInt64 now = get_time_us();
 
-  packet.uptime_seconds = (now - g_start_time) / 1000000;
-  packet.wifi_strength = 100; /* TODO: Get actual signal strength */
+  packet.heartbeat.uptime_seconds = (now - g_start_time) / 1000000;
+  packet.heartbeat.wifi_strength = 100; /* TODO: Get actual signal strength */
+  memcpy(&packet.metrics, metrics, sizeof(packet.metrics));
 
   return send_packet(MSG_HEARTBEAT, &packet, sizeof(packet));
 }
@@ -699,19 +966,314 @@ int network_send_game_info(const GameInfo *info) {
   packet.persistent = info->persistent;
   copy_str(packet.psp_name, sizeof(packet.psp_name), info->psp_name);
 
+  /* Advertise the icon by CRC so the desktop can skip the transfer */
+  if (info->has_icon) {
+    IconCacheEntry cached;
+    if (icon_cache_lookup(info->game_id, &cached) == 0) {
+      packet.icon_crc32 = cached.icon_crc32;
+      packet.icon_size = cached.icon_size;
+    }
+  }
+
   return send_packet(MSG_GAME_INFO, &packet, sizeof(packet));
 }
 
+/*============================================================================
+ * Reliable Chunked Transfer
+ *
+ * Icons and stats uploads are sent as a window of chunks followed by a
+ * MSG_TRANSFER_POLL. The desktop answers with a MSG_TRANSFER_STATUS bitmap
+ * of the chunks it is still missing, and only those are sent again. The
+ * window grows while rounds come back clean and halves on loss; chunks in
+ * a window are spread over the measured round-trip time instead of a fixed
+ * sleep.
+ *============================================================================*/
+
+/* Initial / minimum / maximum chunks per round */
+#define TRANSFER_WINDOW_INIT 8
+#define TRANSFER_WINDOW_MIN 2
+#define TRANSFER_WINDOW_MAX 32
+
+/* Round-trip estimate before the first sample, and status-wait bounds */
+#define TRANSFER_RTT_INIT_US (30 * 1000)
+#define TRANSFER_RTO_MIN_US (100 * 1000)
+#define TRANSFER_RTO_MAX_US (1000 * 1000)
+
+/* Never pause longer than this between two chunks of a window */
+#define TRANSFER_PACE_MAX_US (5 * 1000)
+
+/* Give up after this many polls in a row go unanswered (each one waits
+ * twice as long as the one before). A desktop that has never answered one
+ * is taken to predate MSG_TRANSFER_POLL instead. */
+#define TRANSFER_MAX_TIMEOUTS 6
+
+/* Smoothed RTT carried across transfers, the link rarely changes between */
+static SceUInt64 g_transfer_srtt_us = TRANSFER_RTT_INIT_US;
+
+/* Sends chunk `index` of a transfer */
+typedef int (*TransferChunkFn)(const void *ctx, uint16_t index);
+
+static int chunk_missing(const uint8_t *bitmap, uint16_t index) {
+  return (bitmap[index >> 3] >> (index & 7)) & 1;
+}
+
+/**
+ * Wait for the TRANSFER_STATUS answering a poll. Anything else received
+ * meanwhile is handled as usual and queued for network_poll_message.
+ *
+ * @return 1 if a matching status was received, 0 on timeout
+ */
+static int wait_transfer_status(const TransferPollPacket *poll,
+                                TransferStatusPacket *status,
+                                SceUInt64 timeout_us) {
+  uint8_t buffer[MAX_PACKET_SIZE];
+  struct sockaddr_in from_addr;
+  socklen_t from_len;
+  SceUInt64 deadline = get_time_us() + timeout_us;
+  SceUInt64 now;
+  int ret;
+
+  while ((now = get_time_us()) < deadline) {
+    from_len = sizeof(from_addr);
+    ret = sceNetInetRecvfrom(g_socket, buffer, sizeof(buffer), MSG_DONTWAIT,
+                             (struct sockaddr *)&from_addr, &from_len);
+    if (ret <= 0) {
+      /* Sleep until something arrives or the status is overdue */
+      fd_set readfds;
+      struct timeval tv;
+      SceUInt64 left = deadline - now;
+
+      FD_ZERO(&readfds);
+      FD_SET(g_socket, &readfds);
+      tv.tv_sec = left / 1000000;
+      tv.tv_usec = left % 1000000;
+      if (sceNetInetSelect(g_socket + 1, &readfds, NULL, NULL, &tv) < 0) {
+        sceKernelDelayThread(1000);
+      }
+      continue;
+    }
+    drp_metrics_rx((uint32_t)ret);
+
+    if (ret >= (int)(sizeof(PacketHeader) + sizeof(TransferStatusPacket)) &&
+        memcmp(buffer, PROTOCOL_MAGIC, 4) == 0 &&
+        buffer[4] == MSG_TRANSFER_STATUS) {
+      memcpy(status, buffer + sizeof(PacketHeader), sizeof(*status));
+      if (status->kind == poll->kind &&
+          status->total_chunks == poll->total_chunks &&
+          strncmp(status->id, poll->id, sizeof(status->id)) == 0) {
+        return 1;
+      }
+      continue; /* Stale status of an earlier transfer */
+    }
+
+    {
+      char game_id[10] = {0};
+      int result = handle_packet(buffer, ret, &from_addr, game_id);
+      if (result != 0) {
+        pending_push(result, game_id);
+      }
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Send each chunk still marked in `missing` (every chunk if NULL) once,
+ * 10 ms apart and without polling: uploads to desktops that predate
+ * MSG_TRANSFER_POLL, and transfers larger than TRANSFER_MAX_CHUNKS.
+ * Chunks below `sent_before` already went out once.
+ *
+ * @return 0 once all were sent, negative if a send failed
+ */
+static int transfer_send_unpaced(uint16_t total_chunks,
+                                 TransferChunkFn send_chunk, const void *ctx,
+                                 const uint8_t *missing,
+                                 uint32_t sent_before) {
+  uint32_t i;
+  int ret;
+
+  for (i = 0; i < total_chunks; i++) {
+    if (missing != NULL && !chunk_missing(missing, (uint16_t)i)) {
+      continue;
+    }
+    ret = send_chunk(ctx, (uint16_t)i);
+    if (ret < 0) {
+      return ret;
+    }
+    if (i < sent_before) {
+      drp_metrics_retransmit();
+    }
+    sceKernelDelayThread(10 * 1000);
+  }
+
+  return 0;
+}
+
+/**
+ * Send `total_chunks` chunks reliably. Above TRANSFER_MAX_CHUNKS the status
+ * bitmap cannot describe the transfer, so it goes out unpaced instead.
+ *
+ * @return 0 once the desktop has every chunk, negative on error
+ */
+static int transfer_send(uint8_t kind, const char *id, uint64_t tag,
+                         uint16_t total_chunks, TransferChunkFn send_chunk,
+                         const void *ctx) {
+  uint8_t missing[TRANSFER_MAX_CHUNKS / 8];
+  TransferPollPacket poll;
+  TransferStatusPacket status;
+  int window = TRANSFER_WINDOW_INIT;
+  int timeouts = 0;
+  uint16_t outstanding = total_chunks;
+  uint16_t cursor = 0;
+  uint32_t chunk_sends = 0; /* The first total_chunks are the first pass */
+  uint16_t i;
+  int ret;
+
+  if (total_chunks == 0) {
+    return -1;
+  }
+  if (total_chunks > TRANSFER_MAX_CHUNKS) {
+    net_log("transfer: kind=%d has %u chunks, sending unpaced", kind,
+            (unsigned int)total_chunks);
+    return transfer_send_unpaced(total_chunks, send_chunk, ctx, NULL, 0);
+  }
+
+  memset(missing, 0, sizeof(missing));
+  for (i = 0; i < total_chunks; i++) {
+    missing[i >> 3] |= (uint8_t)(1 << (i & 7));
+  }
+
+  memset(&poll, 0, sizeof(poll));
+  poll.kind = kind;
+  copy_str(poll.id, sizeof(poll.id), id);
+  poll.total_chunks = total_chunks;
+  poll.tag = tag;
+
+  while (outstanding > 0) {
+    SceUInt64 pace_us = g_transfer_srtt_us / (2 * window);
+    SceUInt64 rto_us = 2 * g_transfer_srtt_us + 20 * 1000;
+    SceUInt64 poll_sent;
+    int sent = 0;
+    int scanned;
+
+    if (pace_us > TRANSFER_PACE_MAX_US) {
+      pace_us = TRANSFER_PACE_MAX_US;
+    }
+    if (rto_us < TRANSFER_RTO_MIN_US) {
+      rto_us = TRANSFER_RTO_MIN_US;
+    }
+    rto_us <<= timeouts; /* Back off while polls go unanswered */
+    if (rto_us > TRANSFER_RTO_MAX_US) {
+      rto_us = TRANSFER_RTO_MAX_US;
+    }
+
+    /* Next window of missing chunks, continuing where the last one ended */
+    for (scanned = 0; scanned < total_chunks && sent < window; scanned++) {
+      uint16_t index = cursor;
+      cursor = (uint16_t)((cursor + 1) % total_chunks);
+      if (!chunk_missing(missing, index)) {
+        continue;
+      }
+      ret = send_chunk(ctx, index);
+      if (ret < 0) {
+        return ret;
+      }
+      if (++chunk_sends > total_chunks) {
+        drp_metrics_retransmit();
+      }
+      sent++;
+      if (pace_us >= 500 && sent < window) {
+        sceKernelDelayThread((SceUInt)pace_us);
+      }
+    }
+
+    ret = send_packet(MSG_TRANSFER_POLL, &poll, sizeof(poll));
+    if (ret < 0) {
+      return ret;
+    }
+    poll_sent = get_time_us();
+
+    if (!wait_transfer_status(&poll, &status, rto_us)) {
+      timeouts++;
+      window = (window / 2 > TRANSFER_WINDOW_MIN) ? window / 2
+                                                   : TRANSFER_WINDOW_MIN;
+      if (!g_transfer_peer_polls && timeouts >= TRANSFER_MAX_TIMEOUTS) {
+        /* Desktop predates MSG_TRANSFER_POLL: send the rest best-effort */
+        net_log("transfer: no status from desktop, sending unpaced");
+        return transfer_send_unpaced(total_chunks, send_chunk, ctx, missing,
+                                     chunk_sends);
+      }
+      if (timeouts >= TRANSFER_MAX_TIMEOUTS) {
+        net_log("transfer: kind=%d gave up, %u/%u chunks missing", kind,
+                (unsigned int)outstanding, (unsigned int)total_chunks);
+        return -3;
+      }
+      continue;
+    }
+
+    /* Round-trip sample, smoothed like TCP's SRTT (gain 1/8) */
+    {
+      SceUInt64 sample = get_time_us() - poll_sent;
+      g_transfer_srtt_us = (7 * g_transfer_srtt_us + sample) / 8;
+    }
+    g_transfer_peer_polls = 1;
+    timeouts = 0;
+
+    {
+      uint16_t before = outstanding;
+      memcpy(missing, status.missing, sizeof(missing));
+      outstanding = 0;
+      for (i = 0; i < total_chunks; i++) {
+        outstanding += chunk_missing(missing, i);
+      }
+
+      /* Anything sent this round still missing means it was lost */
+      if (outstanding > 0 && before - outstanding < sent) {
+        window = (window / 2 > TRANSFER_WINDOW_MIN) ? window / 2
+                                                     : TRANSFER_WINDOW_MIN;
+      } else if (window < TRANSFER_WINDOW_MAX) {
+        window = (window * 2 < TRANSFER_WINDOW_MAX) ? window * 2
+                                                     : TRANSFER_WINDOW_MAX;
+      }
+    }
+  }
+
+  return 0;
+}
+
+typedef struct {
+  const char *game_id;
+  const uint8_t *data;
+  uint32_t size;
+} IconTransfer;
+
+static int send_icon_chunk(const void *ctx, uint16_t index) {
+  const IconTransfer *t = (const IconTransfer *)ctx;
+  IconChunkPacket chunk;
+  uint32_t offset = (uint32_t)index * ICON_CHUNK_SIZE;
+  uint32_t remaining = t->size - offset;
+
+  memset(&chunk, 0, sizeof(chunk));
+  copy_str(chunk.game_id, sizeof(chunk.game_id), t->game_id);
+  chunk.chunk_index = index;
+  chunk.total_chunks = (t->size + ICON_CHUNK_SIZE - 1) / ICON_CHUNK_SIZE;
+  chunk.data_length =
+      (remaining > ICON_CHUNK_SIZE) ? ICON_CHUNK_SIZE : remaining;
+  memcpy(chunk.data, t->data + offset, chunk.data_length);
+
+  return send_packet(MSG_ICON_CHUNK, &chunk,
+                     sizeof(chunk) - ICON_CHUNK_SIZE + chunk.data_length);
+}
+
 /**
  * Send icon data (chunked)
  */
 int network_send_icon(const char *game_id, const uint8_t *icon_data,
                       uint32_t icon_size) {
-  IconChunkPacket chunk;
+  IconTransfer transfer;
   IconEndPacket end;
   uint16_t total_chunks;
-  uint16_t chunk_index;
-  uint32_t offset = 0;
   uint32_t crc32;
   int ret;
 
@@ -723,31 +1285,16 @@ int network_send_icon(const char *game_id, const uint8_t *icon_data,
   total_chunks = (icon_size + ICON_CHUNK_SIZE - 1) / ICON_CHUNK_SIZE;
 
   /* Calculate CRC32 */
-  crc32 = crc32_calc(icon_data, icon_size);
-
-  /* Send chunks */
-  for (chunk_index = 0; chunk_index < total_chunks; chunk_index++) {
-    memset(&chunk, 0, sizeof(chunk));
-    copy_str(chunk.game_id, sizeof(chunk.game_id), game_id);
-    chunk.chunk_index = chunk_index;
-    chunk.total_chunks = total_chunks;
+  crc32 = icon_cache_crc32(icon_data, icon_size);
 
-    /* Calculate chunk size */
-    uint32_t remaining = icon_size - offset;
-    chunk.data_length =
-        (remaining > ICON_CHUNK_SIZE) ? ICON_CHUNK_SIZE : remaining;
-
-    memcpy(chunk.data, icon_data + offset, chunk.data_length);
-    offset += chunk.data_length;
-
-    ret = send_packet(MSG_ICON_CHUNK, &chunk,
-                      sizeof(chunk) - ICON_CHUNK_SIZE + chunk.data_length);
-    if (ret < 0) {
-      return ret;
-    }
+  transfer.game_id = game_id;
+  transfer.data = icon_data;
+  transfer.size = icon_size;
 
-    /* Small delay between chunks to avoid flooding */
-    sceKernelDelayThread(10 * 1000); /* 10ms */
+  ret = transfer_send(TRANSFER_KIND_ICON, game_id, crc32, total_chunks,
+                      send_icon_chunk, &transfer);
+  if (ret < 0) {
+    return ret;
   }
 
   /* Send end marker */
@@ -849,9 +1396,37 @@ int network_handle_discovery(PluginConfig *config) {
 /**
  * Send stats request to desktop
  */
-int network_send_stats_request(void) {
-  /* Stats request is just a header with type MSG_STATS_REQUEST, no payload */
-  return send_packet(MSG_STATS_REQUEST, NULL, 0);
+int network_send_stats_request(uint32_t since_version, uint32_t psp_version) {
+  StatsRequestPacket packet;
+
+  packet.since_version = since_version;
+  packet.psp_version = psp_version;
+  return send_packet(MSG_STATS_REQUEST, &packet, sizeof(packet));
+}
+
+typedef struct {
+  const char *data;
+  size_t len;
+  uint64_t last_updated;
+} StatsTransfer;
+
+static int send_stats_chunk(const void *ctx, uint16_t index) {
+  const StatsTransfer *t = (const StatsTransfer *)ctx;
+  StatsUploadPacket packet;
+  size_t offset = (size_t)index * STATS_CHUNK_SIZE;
+  size_t remaining = t->len - offset;
+
+  memset(&packet, 0, sizeof(packet));
+  packet.last_updated = t->last_updated;
+  packet.chunk_index = index;
+  packet.total_chunks = (t->len + STATS_CHUNK_SIZE - 1) / STATS_CHUNK_SIZE;
+  packet.data_length =
+      (remaining > STATS_CHUNK_SIZE) ? STATS_CHUNK_SIZE : remaining;
+  memcpy(packet.json_data, t->data + offset, packet.data_length);
+
+  /* Send only the header + actual data, not the full buffer */
+  return send_packet(MSG_STATS_UPLOAD, &packet,
+                     sizeof(packet) - STATS_CHUNK_SIZE + packet.data_length);
 }
 
 /**
@@ -859,11 +1434,8 @@ int network_send_stats_request(void) {
  */
 int network_send_stats_upload(const char *json_data, size_t json_len,
                               uint64_t last_updated) {
-  StatsUploadPacket packet;
+  StatsTransfer transfer;
   uint16_t total_chunks;
-  uint16_t chunk_index;
-  size_t offset = 0;
-  int ret;
 
   if (json_data == NULL || json_len == 0) {
     return -1;
@@ -872,76 +1444,55 @@ int network_send_stats_upload(const char *json_data, size_t json_len,
   /* Calculate total chunks */
   total_chunks = (json_len + STATS_CHUNK_SIZE - 1) / STATS_CHUNK_SIZE;
 
-  /* Send chunks */
-  for (chunk_index = 0; chunk_index < total_chunks; chunk_index++) {
-    memset(&packet, 0, sizeof(packet));
-    packet.last_updated = last_updated;
-    packet.chunk_index = chunk_index;
-    packet.total_chunks = total_chunks;
-
-    /* Calculate chunk size */
-    size_t remaining = json_len - offset;
-    packet.data_length =
-        (remaining > STATS_CHUNK_SIZE) ? STATS_CHUNK_SIZE : remaining;
-
-    memcpy(packet.json_data, json_data + offset, packet.data_length);
-    offset += packet.data_length;
+  transfer.data = json_data;
+  transfer.len = json_len;
+  transfer.last_updated = last_updated;
 
-    /* Send only the header + actual data, not the full buffer */
-    size_t packet_size = sizeof(packet) - STATS_CHUNK_SIZE + packet.data_length;
-    ret = send_packet(MSG_STATS_UPLOAD, &packet, packet_size);
-    if (ret < 0) {
-      return ret;
-    }
-
-    /* Small delay between chunks */
-    sceKernelDelayThread(10 * 1000); /* 10ms */
-  }
-
-  return 0;
+  return transfer_send(TRANSFER_KIND_STATS, "", last_updated, total_chunks,
+                       send_stats_chunk, &transfer);
 }
 
 /**
  * Check for stats response from desktop
  * This function checks if streaming is complete
- * Returns: 1 = complete verified, -2 = truncated, 0 = still receiving, -1 = no
- * data
+ * Returns: 1 = complete but not a delta (ignored), 2 = delta copied to
+ * json_buffer, -2 = truncated, 0 = still receiving, -1 = no data
  */
 int network_poll_stats_response(uint64_t *last_updated_out, char *json_buffer,
                                 size_t buffer_size,
                                 size_t *bytes_received_out) {
-  /* Unused now - data written directly to file */
-  (void)json_buffer;
-  (void)buffer_size;
+  int verified;
 
   /* Check if we have any data streaming */
-  if (!g_stats_stream.active && g_stats_stream.total_chunks == 0) {
+  if (!g_stats_stream.active) {
     return -1; /* No data received yet */
   }
 
-  /* Check if complete (all chunks received) */
-  if (g_stats_stream.received_chunks >= g_stats_stream.total_chunks &&
-      g_stats_stream.total_chunks > 0) {
-    if (last_updated_out != NULL) {
-      *last_updated_out = g_stats_stream.last_updated;
-    }
-    if (bytes_received_out != NULL) {
-      *bytes_received_out = g_stats_stream.bytes_written;
-    }
+  if (!g_stats_stream.complete) {
+    return 0; /* Still receiving */
+  }
 
-    int verified = g_stats_stream.verified;
+  if (last_updated_out != NULL) {
+    *last_updated_out = g_stats_stream.last_updated;
+  }
+  if (bytes_received_out != NULL) {
+    *bytes_received_out = g_stats_stream.bytes_received;
+  }
 
-    /* Reset state */
-    g_stats_stream.active = 0;
-    g_stats_stream.total_chunks = 0;
-    g_stats_stream.received_chunks = 0;
+  verified = g_stats_stream.verified;
 
-    if (verified) {
-      return 1; /* Complete and verified */
-    } else {
-      return -2; /* Truncated - file deleted */
+  /* Reset state */
+  g_stats_stream.active = 0;
+
+  if (verified && g_stats_stream.delta) {
+    if (json_buffer == NULL || buffer_size < g_stats_stream.total_bytes) {
+      net_log("Stats delta too large for caller: %u bytes",
+              g_stats_stream.total_bytes);
+      return -2;
     }
+    memcpy(json_buffer, g_stats_stage, g_stats_stream.total_bytes);
+    return 2;
   }
 
-  return 0; /* Still receiving */
+  return verified ? 1 : -2;
 }
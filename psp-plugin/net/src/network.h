@@ -7,6 +7,7 @@
 
 #include "config.h"
 #include "discord_rpc.h"
+#include "drp_metrics.h"
 
 /**
  * Initialize network subsystem
@@ -27,11 +28,18 @@ void network_set_profile_id(int profile_id);
  */
 void network_shutdown(void);
 
+/* network_connect() still bringing up WiFi - call it again */
+#define NET_CONNECT_PENDING 1
+
 /**
  * Connect to desktop companion app
  *
+ * Non-blocking: each call advances the WiFi join by one step and returns
+ * NET_CONNECT_PENDING until the PSP has an IP. The sockets are opened by
+ * the call that finds it up.
+ *
  * @param config Plugin configuration
- * @return 0 on success, 1 if waiting for discovery, negative on error
+ * @return 0 on success, NET_CONNECT_PENDING while joining, negative on error
  */
 int network_connect(const PluginConfig *config);
 
@@ -40,12 +48,21 @@ int network_connect(const PluginConfig *config);
  */
 void network_disconnect(void);
 
+/**
+ * Check whether the WiFi link is up and the socket is open, i.e. whether
+ * sends can go anywhere
+ *
+ * @return 1 if up, 0 while down or joining
+ */
+int network_link_up(void);
+
 /**
  * Send heartbeat packet
  *
+ * @param metrics Metrics extension appended to the heartbeat
  * @return 0 on success, negative on error
  */
-int network_send_heartbeat(void);
+int network_send_heartbeat(const HeartbeatMetrics *metrics);
 
 /**
  * Send game info update
@@ -69,6 +86,8 @@ int network_send_icon(const char *game_id, const uint8_t *icon_data,
 /**
  * Show WiFi profile selector UI and connect
  *
+ * The join the dialog starts is finished by network_connect().
+ *
  * @return 0 on success, negative on error or cancel
  */
 int network_show_profile_selector(void);
@@ -86,14 +105,32 @@ void net_log(const char *fmt, ...);
 int network_poll_ack(void);
 
 /**
- * Poll for incoming messages (ACK or icon request)
+ * Poll for incoming messages (ACK, icon request/have, stats response)
  *
  * @param game_id_out Buffer to receive requested game ID (10 bytes), can be
  * NULL
- * @return 1 if ACK received, 2 if icon request received, 0 if nothing
+ * @return 1 if ACK received, 2 if icon request received, 3 if stats response
+ * chunk received, 4 if the desktop already has the advertised icon, 0 if
+ * nothing
  */
 int network_poll_message(char *game_id_out);
 
+/**
+ * Session carried by the last ACK (see AckPacket)
+ *
+ * @return Session ID, 0 if the desktop sent none
+ */
+uint32_t network_ack_session(void);
+
+/**
+ * Sleep until a packet is waiting on the desktop or discovery socket, or
+ * until the timeout passes. Without an open socket this just sleeps.
+ *
+ * @param timeout_us Longest wait in microseconds
+ * @return 1 if a packet is waiting, 0 on timeout
+ */
+int network_wait(uint32_t timeout_us);
+
 /**
  * Check for icon request from desktop
  *
@@ -110,18 +147,22 @@ void network_force_cleanup(void);
 
 /**
  * Send stats request to desktop
- * This asks the desktop for its usage data and last_updated timestamp
+ * This asks the desktop for the games it changed after since_version. An
+ * older desktop ignores the versions and sends its whole usage_log.json,
+ * which network_poll_stats_response drops.
  *
+ * @param since_version Highest desktop sync_version already merged
+ * @param psp_version PSP's own sync_version
  * @return 0 on success, negative on error
  */
-int network_send_stats_request(void);
+int network_send_stats_request(uint32_t since_version, uint32_t psp_version);
 
 /**
  * Send local usage stats to desktop (chunked)
  *
- * @param json_data Serialized usage data JSON
- * @param json_len Length of JSON data
- * @param last_updated Local last_updated timestamp
+ * @param json_data Serialized usage data JSON or StatsDelta
+ * @param json_len Length of the data
+ * @param last_updated Local last_updated timestamp (sync_version for deltas)
  * @return 0 on success, negative on error
  */
 int network_send_stats_upload(const char *json_data, size_t json_len,
@@ -129,13 +170,16 @@ int network_send_stats_upload(const char *json_data, size_t json_len,
 
 /**
  * Check for stats response from desktop
- * Call this after sending stats request to receive desktop's data
+ * Call this after sending stats request to receive desktop's data.
+ * A StatsDelta is copied to json_buffer for the caller to merge; a full
+ * JSON response from a pre-delta desktop is discarded.
  *
  * @param last_updated_out Receives desktop's last_updated timestamp
- * @param json_buffer Buffer to receive JSON data (accumulated across chunks)
+ * @param json_buffer Buffer to receive a StatsDelta, can be NULL
  * @param buffer_size Size of json_buffer
- * @param bytes_received_out Receives total bytes written to json_buffer
- * @return 1 if complete response received, 0 if partial/none, negative on error
+ * @param bytes_received_out Receives total bytes received
+ * @return 1 if a JSON response was dropped, 2 if delta copied to json_buffer,
+ *         0 if partial/none, negative on error
  */
 int network_poll_stats_response(uint64_t *last_updated_out, char *json_buffer,
                                 size_t buffer_size, size_t *bytes_received_out);
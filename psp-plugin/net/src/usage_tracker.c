@@ -1,21 +1,40 @@
 /**
  * Local Usage Tracker Implementation
  *
- * Tracks game play sessions and writes usage.json for the PSP Stats App.
+ * Tracks game play sessions in a fixed-record store on the Memory Stick.
+ * Each game lives at a fixed offset, so a playtime update rewrites just that
+ * record plus the header. The running session is checkpointed in the header
+ * and folded into its game on the next load if the PSP went down before the
+ * session ended. usage_log.json is only exported for the PSP Stats App and
+ * the desktop; the store is never rebuilt from it except on first run.
+ *
+ * Game records are held in slabs of USAGE_SLAB_GAMES taken from the user
+ * partition as needed. A game's index never changes once assigned: it is
+ * both its position in the slabs and its record number in the store.
  */
 
 #include <pspiofilemgr.h>
 #include <pspkernel.h>
 #include <psprtc.h>
+#include <pspsysmem.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "discord_rpc.h"
 #include "usage_tracker.h"
 
 /* External logging function from main.c */
 extern void net_log(const char *fmt, ...);
 
+/* Marks a free ring slot / an empty hash bucket */
+#define DAILY_FREE 0xFFFFFFFF
+#define INDEX_EMPTY 0xFFFFFFFF
+
+/* Smallest hash index; it doubles whenever it gets half full */
+#define INDEX_MIN_SIZE 64
+
 /* Current session state */
 static struct {
   int active;
@@ -24,7 +43,7 @@ static struct {
   uint64_t start_tick;
 } g_current_session;
 
-/* Loaded usage data */
+/* Loaded usage totals */
 static UsageData g_usage_data;
 static int g_data_loaded = 0;
 
@@ -34,6 +53,37 @@ static uint32_t g_tick_resolution = 1000000;
 /* PSP name for JSON output (set via usage_set_psp_name) */
 static char g_psp_name[32] = "PSP";
 
+/* Highest PSP sync_version the desktop reported as merged (not persisted -
+ * refreshed by every delta the desktop sends) */
+static uint32_t g_peer_ack = 0;
+
+/* Header of the on-disk store, kept in sync with g_usage_data */
+static UsageStoreHeader g_store_header;
+
+/* 0 if the store did not fit in memory - writing would then clobber records
+ * that were never read */
+static int g_store_ok = 1;
+
+/* Game slabs and the table pointing at them */
+typedef struct {
+  SceUID uid;
+  GameUsage *games;
+} UsageSlab;
+
+static UsageSlab *g_slabs = NULL;
+static SceUID g_slabs_uid = -1;
+static uint32_t g_slab_count = 0;
+static uint32_t g_slab_capacity = 0;
+
+/* Open-addressing hash index: game_id -> game index */
+static uint32_t *g_index = NULL;
+static SceUID g_index_uid = -1;
+static uint32_t g_index_size = 0;
+
+/* Shared per-day playtime ring, allocated on first use */
+static UsageDailyEntry *g_daily = NULL;
+static SceUID g_daily_uid = -1;
+
 /* Helper: safe string copy */
 static void copy_str(char *dst, size_t dst_size, const char *src) {
   size_t len;
@@ -61,35 +111,436 @@ static uint64_t get_tick(void) {
 static void get_current_time_string(char *buffer, size_t size) {
   ScePspDateTime rtc_time;
   if (sceRtcGetCurrentClockLocalTime(&rtc_time) >= 0) {
-    snprintf(buffer, size, "%04d-%02d-%02d %02d:%02d:%02d", rtc_time.year,
-             rtc_time.month, rtc_time.day, rtc_time.hour, rtc_time.minute,
-             rtc_time.second);
+    /* Bounded so a bad clock can't make the string longer than 19 */
+    snprintf(buffer, size, "%04d-%02d-%02d %02d:%02d:%02d",
+             rtc_time.year % 10000, rtc_time.month % 100, rtc_time.day % 100,
+             rtc_time.hour % 100, rtc_time.minute % 100,
+             rtc_time.second % 100);
   } else {
     buffer[0] = '\0';
   }
 }
 
-/* Helper: find or create game entry */
-static GameUsage *find_or_create_game(const char *game_id) {
+/*============================================================================
+ * Game Table
+ *============================================================================*/
+
+/* Allocate zeroed memory from the user partition */
+static void *pool_alloc(const char *name, uint32_t size, SceUID *uid) {
+  void *block;
+
+  *uid = sceKernelAllocPartitionMemory(PSP_MEMORY_PARTITION_USER, name,
+                                       PSP_SMEM_Low, size, NULL);
+  if (*uid < 0) {
+    net_log("Usage: out of memory for %s (%u bytes)", name, size);
+    return NULL;
+  }
+  block = sceKernelGetBlockHeadAddr(*uid);
+  memset(block, 0, size);
+  return block;
+}
+
+static void pool_free(SceUID *uid) {
+  if (*uid >= 0) {
+    sceKernelFreePartitionMemory(*uid);
+    *uid = -1;
+  }
+}
+
+static GameUsage *game_at(uint32_t index) {
+  return &g_slabs[index / USAGE_SLAB_GAMES].games[index % USAGE_SLAB_GAMES];
+}
+
+/* FNV-1a over the game ID */
+static uint32_t hash_id(const char *game_id) {
+  uint32_t hash = 2166136261u;
+  while (*game_id) {
+    hash = (hash ^ (uint8_t)*game_id++) * 16777619u;
+  }
+  return hash;
+}
+
+static void index_insert(uint32_t index) {
+  uint32_t mask = g_index_size - 1;
+  uint32_t slot = hash_id(game_at(index)->game_id) & mask;
+
+  while (g_index[slot] != INDEX_EMPTY) {
+    slot = (slot + 1) & mask;
+  }
+  g_index[slot] = index;
+}
+
+/* Size the index for at least twice the given game count and re-insert
+ * every loaded game */
+static int index_rebuild(uint32_t games) {
+  uint32_t size = INDEX_MIN_SIZE;
+  uint32_t *index;
+  SceUID uid;
   uint32_t i;
 
-  /* Search for existing entry */
+  while (size < games * 2) {
+    size *= 2;
+  }
+
+  if (size != g_index_size) {
+    index = (uint32_t *)pool_alloc("UsageIndex", size * sizeof(uint32_t),
+                                   &uid);
+    if (index == NULL) {
+      return -1;
+    }
+    pool_free(&g_index_uid);
+    g_index = index;
+    g_index_uid = uid;
+    g_index_size = size;
+  }
+
+  memset(g_index, 0xFF, g_index_size * sizeof(uint32_t));
   for (i = 0; i < g_usage_data.total_games; i++) {
-    if (strcmp(g_usage_data.games[i].game_id, game_id) == 0) {
-      return &g_usage_data.games[i];
+    index_insert(i);
+  }
+  return 0;
+}
+
+/* Make room for one more game, adding a slab if the last one is full */
+static int reserve_game(void) {
+  uint32_t games = g_usage_data.total_games + 1;
+
+  if (games > g_slab_count * USAGE_SLAB_GAMES) {
+    if (g_slab_count == g_slab_capacity) {
+      /* Grow the slab table by doubling; slabs themselves never move */
+      uint32_t capacity = g_slab_capacity ? g_slab_capacity * 2 : 4;
+      SceUID uid;
+      UsageSlab *slabs = (UsageSlab *)pool_alloc(
+          "UsageSlabs", capacity * sizeof(UsageSlab), &uid);
+      if (slabs == NULL) {
+        return -1;
+      }
+      if (g_slab_count > 0) {
+        memcpy(slabs, g_slabs, g_slab_count * sizeof(UsageSlab));
+      }
+      pool_free(&g_slabs_uid);
+      g_slabs = slabs;
+      g_slabs_uid = uid;
+      g_slab_capacity = capacity;
+    }
+
+    g_slabs[g_slab_count].games = (GameUsage *)pool_alloc(
+        "UsageSlab", USAGE_SLAB_GAMES * sizeof(GameUsage),
+        &g_slabs[g_slab_count].uid);
+    if (g_slabs[g_slab_count].games == NULL) {
+      return -1;
     }
+    g_slab_count++;
+  }
+
+  if (games * 2 > g_index_size) {
+    return index_rebuild(games);
+  }
+  return 0;
+}
+
+/* Helper: find a game by ID, -1 if not tracked */
+static int find_game(const char *game_id) {
+  uint32_t mask;
+  uint32_t slot;
+
+  if (g_index_size == 0) {
+    return -1;
+  }
+
+  mask = g_index_size - 1;
+  slot = hash_id(game_id) & mask;
+  while (g_index[slot] != INDEX_EMPTY) {
+    if (strcmp(game_at(g_index[slot])->game_id, game_id) == 0) {
+      return (int)g_index[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+  return -1;
+}
+
+/* Helper: find or create game entry, -1 if out of memory */
+static int find_or_create_game(const char *game_id) {
+  int index = find_game(game_id);
+  GameUsage *game;
+
+  if (index >= 0) {
+    return index;
+  }
+  if (reserve_game() < 0) {
+    return -1;
+  }
+
+  index = (int)g_usage_data.total_games++;
+  game = game_at((uint32_t)index);
+  memset(game, 0, sizeof(GameUsage));
+  copy_str(game->game_id, sizeof(game->game_id), game_id);
+  index_insert((uint32_t)index);
+  return index;
+}
+
+static int ensure_daily(void) {
+  if (g_daily != NULL) {
+    return 0;
+  }
+  g_daily = (UsageDailyEntry *)pool_alloc(
+      "UsageDaily", USAGE_DAILY_RING_SIZE * sizeof(UsageDailyEntry),
+      &g_daily_uid);
+  if (g_daily == NULL) {
+    return -1;
+  }
+  memset(g_daily, 0xFF, USAGE_DAILY_RING_SIZE * sizeof(UsageDailyEntry));
+  return 0;
+}
+
+/*============================================================================
+ * Record Store
+ *============================================================================*/
+
+/* Write bytes at an offset of the store without truncating it */
+static int store_write_at(uint32_t offset, const void *data, uint32_t size) {
+  SceUID fd;
+  int written = -1;
+
+  if (!g_store_ok) {
+    return -1;
+  }
+
+  fd = sceIoOpen(USAGE_STORE_PATH, PSP_O_WRONLY | PSP_O_CREAT, 0777);
+  if (fd < 0) {
+    return -1;
+  }
+  if (sceIoLseek32(fd, (int)offset, PSP_SEEK_SET) == (int)offset) {
+    written = sceIoWrite(fd, data, size);
+  }
+  sceIoClose(fd);
+
+  return (written == (int)size) ? 0 : -1;
+}
+
+static void store_sync_header(void) {
+  memcpy(g_store_header.magic, USAGE_STORE_MAGIC, 4);
+  g_store_header.version = USAGE_STORE_VERSION;
+  g_store_header.record_size = sizeof(GameUsage);
+  g_store_header.count = g_usage_data.total_games;
+  g_store_header.sync_version = g_usage_data.sync_version;
+  g_store_header.peer_version = g_usage_data.peer_version;
+}
+
+static int store_write_header(void) {
+  store_sync_header();
+  return store_write_at(0, &g_store_header, sizeof(g_store_header));
+}
+
+static int store_write_record(uint32_t index) {
+  return store_write_at(USAGE_STORE_RECORDS_OFFSET + index * sizeof(GameUsage),
+                        game_at(index), sizeof(GameUsage));
+}
+
+/* Rewrite one game's record. The record goes first, so a header that
+ * already counts it never points at a record that was not written. */
+static int store_write_game(uint32_t index) {
+  if (store_write_record(index) < 0) {
+    return -1;
+  }
+  return store_write_header();
+}
+
+/* Write the whole store from scratch (first run only) */
+static int store_write_all(void) {
+  SceUID fd;
+  uint32_t i;
+  int bytes;
+  int ok;
+
+  if (!g_store_ok || ensure_daily() < 0) {
+    return -1;
+  }
+
+  store_sync_header();
+  fd = sceIoOpen(USAGE_STORE_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC,
+                 0777);
+  if (fd < 0) {
+    return -1;
+  }
+  ok = (sceIoWrite(fd, &g_store_header, sizeof(g_store_header)) ==
+        sizeof(g_store_header));
+  if (ok) {
+    bytes = (int)(USAGE_DAILY_RING_SIZE * sizeof(UsageDailyEntry));
+    ok = (sceIoWrite(fd, g_daily, bytes) == bytes);
+  }
+  for (i = 0; ok && i < g_slab_count; i++) {
+    uint32_t games = g_usage_data.total_games - i * USAGE_SLAB_GAMES;
+    if (games > USAGE_SLAB_GAMES) {
+      games = USAGE_SLAB_GAMES;
+    }
+    bytes = (int)(games * sizeof(GameUsage));
+    ok = (sceIoWrite(fd, g_slabs[i].games, bytes) == bytes);
+  }
+  sceIoClose(fd);
+
+  return ok ? 0 : -1;
+}
+
+/**
+ * Load the store into memory
+ * @return 0 on success, -1 if missing or unusable, -2 if out of memory
+ */
+static int load_store(void) {
+  SceUID fd;
+  uint32_t count;
+  uint32_t i;
+  int bytes;
+  int ret = -1;
+
+  fd = sceIoOpen(USAGE_STORE_PATH, PSP_O_RDONLY, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (sceIoRead(fd, &g_store_header, sizeof(g_store_header)) !=
+          sizeof(g_store_header) ||
+      memcmp(g_store_header.magic, USAGE_STORE_MAGIC, 4) != 0 ||
+      g_store_header.version != USAGE_STORE_VERSION ||
+      g_store_header.record_size != sizeof(GameUsage)) {
+    goto out;
+  }
+  count = g_store_header.count;
+
+  if (ensure_daily() < 0) {
+    ret = -2;
+    goto out;
+  }
+  bytes = (int)(USAGE_DAILY_RING_SIZE * sizeof(UsageDailyEntry));
+  if (sceIoRead(fd, g_daily, bytes) != bytes) {
+    goto out;
+  }
+
+  /* A slab at a time, straight into slab memory */
+  while (g_usage_data.total_games < count) {
+    uint32_t games = count - g_usage_data.total_games;
+    if (games > USAGE_SLAB_GAMES) {
+      games = USAGE_SLAB_GAMES;
+    }
+    if (reserve_game() < 0) {
+      ret = -2;
+      goto out;
+    }
+    bytes = (int)(games * sizeof(GameUsage));
+    if (sceIoRead(fd, game_at(g_usage_data.total_games), bytes) != bytes) {
+      goto out;
+    }
+    g_usage_data.total_games += games;
+  }
+  ret = 0;
+
+out:
+  sceIoClose(fd);
+
+  if (ret == 0 && index_rebuild(g_usage_data.total_games) < 0) {
+    ret = -2;
+  }
+  if (ret < 0) {
+    /* Forget the partial load; the slabs stay around for reuse */
+    g_usage_data.total_games = 0;
+    if (g_index != NULL) {
+      memset(g_index, 0xFF, g_index_size * sizeof(uint32_t));
+    }
+    if (g_daily != NULL) {
+      memset(g_daily, 0xFF, USAGE_DAILY_RING_SIZE * sizeof(UsageDailyEntry));
+    }
+    memset(&g_store_header, 0, sizeof(g_store_header));
+    return ret;
+  }
+
+  g_usage_data.sync_version = g_store_header.sync_version;
+  g_usage_data.peer_version = g_store_header.peer_version;
+  if (g_store_header.daily_head >= USAGE_DAILY_RING_SIZE) {
+    g_store_header.daily_head = 0;
+  }
+  for (i = 0; i < USAGE_DAILY_RING_SIZE; i++) {
+    if (g_daily[i].game != DAILY_FREE && g_daily[i].game >= count) {
+      g_daily[i].game = DAILY_FREE;
+    }
+    g_daily[i].date[sizeof(g_daily[i].date) - 1] = '\0';
+  }
+  for (i = 0; i < g_usage_data.total_games; i++) {
+    GameUsage *game = game_at(i);
+    game->game_id[sizeof(game->game_id) - 1] = '\0';
+    game->title[sizeof(game->title) - 1] = '\0';
+    g_usage_data.total_playtime += game->total_seconds;
+  }
+  return 0;
+}
+
+/**
+ * Credit playtime to a game's ring slot for today, taking the oldest slot
+ * if it has none yet. Only the slot is written; the caller writes the
+ * header, which carries the new ring head.
+ */
+static void add_daily(uint32_t index, uint32_t seconds) {
+  ScePspDateTime rtc_time;
+  char today[12];
+  uint32_t slot;
+  uint32_t i;
+
+  if (seconds == 0 || ensure_daily() < 0 ||
+      sceRtcGetCurrentClockLocalTime(&rtc_time) < 0) {
+    return;
+  }
+  snprintf(today, sizeof(today), "%04d-%02d-%02d", rtc_time.year % 10000,
+           rtc_time.month % 100, rtc_time.day % 100);
+
+  slot = USAGE_DAILY_RING_SIZE;
+  for (i = 0; i < USAGE_DAILY_RING_SIZE; i++) {
+    if (g_daily[i].game == index && strcmp(g_daily[i].date, today) == 0) {
+      slot = i;
+      break;
+    }
+  }
+
+  if (slot == USAGE_DAILY_RING_SIZE) {
+    slot = g_store_header.daily_head;
+    g_store_header.daily_head = (slot + 1) % USAGE_DAILY_RING_SIZE;
+    g_daily[slot].game = index;
+    copy_str(g_daily[slot].date, sizeof(g_daily[slot].date), today);
+    g_daily[slot].seconds = 0;
+  }
+  g_daily[slot].seconds += seconds;
+
+  store_write_at(USAGE_STORE_RING_OFFSET + slot * sizeof(UsageDailyEntry),
+                 &g_daily[slot], sizeof(UsageDailyEntry));
+}
+
+/* Fold a session checkpointed by usage_save() that never ended */
+static void recover_checkpoint(void) {
+  int index;
+
+  if (g_store_header.session_seconds == 0) {
+    return;
   }
 
-  /* Create new entry if space available */
-  if (g_usage_data.total_games < MAX_TRACKED_GAMES) {
-    GameUsage *game = &g_usage_data.games[g_usage_data.total_games];
-    memset(game, 0, sizeof(GameUsage));
-    copy_str(game->game_id, sizeof(game->game_id), game_id);
-    g_usage_data.total_games++;
-    return game;
+  g_store_header.session_game_id[sizeof(g_store_header.session_game_id) - 1] =
+      '\0';
+  index = find_or_create_game(g_store_header.session_game_id);
+  if (index >= 0) {
+    GameUsage *game = game_at((uint32_t)index);
+    game->total_seconds += g_store_header.session_seconds;
+    game->session_count++;
+    game->sync_version = ++g_usage_data.sync_version;
+    g_usage_data.total_playtime += g_store_header.session_seconds;
+    add_daily((uint32_t)index, g_store_header.session_seconds);
+    net_log("Usage: recovered %lu s of unfinished session for %s",
+            (unsigned long)g_store_header.session_seconds, game->game_id);
   }
 
-  return NULL; /* Full */
+  g_store_header.session_seconds = 0;
+  g_store_header.session_game_id[0] = '\0';
+  if (index >= 0) {
+    store_write_game((uint32_t)index);
+  } else {
+    store_write_header();
+  }
 }
 
 /* Parse a simple JSON number after a key */
@@ -130,16 +581,16 @@ static void parse_json_string(const char *json, const char *key, char *out,
   }
 }
 
-/* Load usage data from JSON file */
-static void load_usage_json(void) {
+/* Import usage data from a usage_log.json written before the record store
+ * existed */
+static void import_legacy_json(void) {
   SceUID fd;
   static char buffer[8192];
   int bytes_read;
   const char *games_start, *games_end;
   const char *p;
   int depth;
-
-  memset(&g_usage_data, 0, sizeof(g_usage_data));
+  uint32_t i;
 
   fd = sceIoOpen(USAGE_JSON_PATH, PSP_O_RDONLY, 0);
   if (fd < 0) {
@@ -184,11 +635,13 @@ static void load_usage_json(void) {
 
   /* Walk each "GAMEID:N":{ ... } entry inside the games object */
   p = games_start;
-  while (p < games_end && g_usage_data.total_games < MAX_TRACKED_GAMES) {
+  while (p < games_end) {
     const char *obj_start, *obj_end;
     int obj_depth;
+    int index;
     GameUsage *game;
     char game_json[1024];
+    char game_id[16];
     size_t obj_len;
 
     /* Locate next game-object opening brace within bounds */
@@ -217,23 +670,45 @@ static void load_usage_json(void) {
       obj_len = sizeof(game_json) - 1;
     memcpy(game_json, obj_start, obj_len);
     game_json[obj_len] = '\0';
+    p = obj_end + 1;
 
-    game = &g_usage_data.games[g_usage_data.total_games];
-    memset(game, 0, sizeof(GameUsage));
+    parse_json_string(game_json, "game_id", game_id, sizeof(game_id));
+    if (game_id[0] == '\0') {
+      continue;
+    }
+    index = find_or_create_game(game_id);
+    if (index < 0) {
+      break; /* Out of memory */
+    }
 
-    parse_json_string(game_json, "game_id", game->game_id,
-                      sizeof(game->game_id));
+    game = game_at((uint32_t)index);
     parse_json_string(game_json, "title", game->title, sizeof(game->title));
     game->total_seconds = parse_json_number(game_json, "total_seconds");
     game->session_count =
         (uint32_t)parse_json_number(game_json, "session_count");
+    game->sync_version = (uint32_t)parse_json_number(game_json, "sync_version");
 
-    if (game->game_id[0] != '\0') {
-      g_usage_data.total_playtime += game->total_seconds;
-      g_usage_data.total_games++;
+    g_usage_data.total_playtime += game->total_seconds;
+    if (game->sync_version > g_usage_data.sync_version) {
+      g_usage_data.sync_version = game->sync_version;
     }
+  }
 
-    p = obj_end + 1;
+  /* Sync counters live after the games object */
+  if (parse_json_number(games_end, "psp_sync_version") >
+      g_usage_data.sync_version) {
+    g_usage_data.sync_version =
+        (uint32_t)parse_json_number(games_end, "psp_sync_version");
+  }
+  g_usage_data.peer_version =
+      (uint32_t)parse_json_number(games_end, "peer_version");
+
+  /* Games from before delta sync have no version - stamp them so the
+   * desktop gets them once */
+  for (i = 0; i < g_usage_data.total_games; i++) {
+    if (game_at(i)->sync_version == 0) {
+      game_at(i)->sync_version = ++g_usage_data.sync_version;
+    }
   }
 
   g_data_loaded = 1;
@@ -243,13 +718,30 @@ static void load_usage_json(void) {
  * Initialize the usage tracker
  */
 void usage_init(void) {
+  int ret;
+
   memset(&g_current_session, 0, sizeof(g_current_session));
   /* Tick resolution is 1000000 (microseconds) since we use
    * sceKernelGetSystemTime */
   g_tick_resolution = 1000000;
 
   if (!g_data_loaded) {
-    load_usage_json();
+    ret = load_store();
+    if (ret == 0) {
+      g_data_loaded = 1;
+      recover_checkpoint();
+    } else if (ret == -2) {
+      /* Never write over records that could not be read */
+      net_log("Usage: store does not fit in memory, not saving usage");
+      g_store_ok = 0;
+      g_data_loaded = 1;
+    } else {
+      /* First run: carry over whatever the old JSON file had */
+      import_legacy_json();
+      if (g_usage_data.total_games > 0) {
+        store_write_all();
+      }
+    }
   }
 }
 
@@ -288,7 +780,7 @@ void usage_start_session(const char *game_id, const char *title) {
  */
 void usage_end_session(void) {
   uint64_t elapsed_ticks, elapsed_seconds;
-  GameUsage *game;
+  int index = -1;
 
   if (!g_current_session.active) {
     return;
@@ -300,108 +792,196 @@ void usage_end_session(void) {
 
   /* Only count sessions >= 1 second */
   if (elapsed_seconds >= 1) {
-    game = find_or_create_game(g_current_session.game_id);
-    if (game) {
+    index = find_or_create_game(g_current_session.game_id);
+    if (index >= 0) {
+      GameUsage *game = game_at((uint32_t)index);
       /* Update title if different */
       if (g_current_session.title[0] != '\0') {
         copy_str(game->title, sizeof(game->title), g_current_session.title);
       }
       game->total_seconds += elapsed_seconds;
       game->session_count++;
+      game->sync_version = ++g_usage_data.sync_version;
       g_usage_data.total_playtime += elapsed_seconds;
+      add_daily((uint32_t)index, (uint32_t)elapsed_seconds);
     }
   }
 
+  /* The session is now part of its record - drop the checkpoint with it */
+  g_store_header.session_seconds = 0;
+  g_store_header.session_game_id[0] = '\0';
+  if (index >= 0) {
+    store_write_game((uint32_t)index);
+  } else {
+    store_write_header();
+  }
+
   g_current_session.active = 0;
   g_current_session.game_id[0] = '\0';
   g_current_session.title[0] = '\0';
 }
 
 /**
- * Save usage data to JSON file
- * Format matches desktop companion:
- * {"psps":{"PSP Name":{"psp_name":"PSP Name","games":{"GAMEID:1":{...}}}}}
+ * Checkpoint the running session into the store header
  */
 void usage_save(void) {
-  SceUID fd;
-  static char
-      buffer[4096]; /* Static buffer - need more space for nested format */
-  int len, i;
-  int first_game = 1;
-  uint64_t elapsed_ticks;
   uint64_t elapsed_seconds;
-  uint64_t current_session_seconds;
   GameUsage *game;
-  const char *current_game_id;
-  uint64_t game_seconds;
-  uint32_t game_sessions;
-  char last_played_str[24]; /* "YYYY-MM-DD HH:MM:SS" */
+  int index;
 
-  /* Get current time for last_played */
-  get_current_time_string(last_played_str, sizeof(last_played_str));
+  if (!g_current_session.active) {
+    return;
+  }
 
-  /* Calculate current session time (if active) */
-  current_session_seconds = 0;
-  current_game_id = NULL;
-  if (g_current_session.active) {
-    elapsed_ticks = get_tick() - g_current_session.start_tick;
-    elapsed_seconds = elapsed_ticks / g_tick_resolution;
-    if (elapsed_seconds >= 1) {
-      current_session_seconds = elapsed_seconds;
-      current_game_id = g_current_session.game_id;
-
-      /* Make sure the game entry exists with title */
-      game = find_or_create_game(g_current_session.game_id);
-      if (game && g_current_session.title[0] != '\0') {
-        copy_str(game->title, sizeof(game->title), g_current_session.title);
-      }
-    }
+  elapsed_seconds = (get_tick() - g_current_session.start_tick) /
+                    g_tick_resolution;
+  if (elapsed_seconds < 1) {
+    return;
   }
 
-  /* Build JSON in desktop companion format */
-  len = snprintf(buffer, sizeof(buffer),
-                 "{\"psps\":{\"%s\":{\"psp_name\":\"%s\",\"games\":{",
-                 g_psp_name, g_psp_name);
+  /* Give the game its record up front so the checkpoint can name it */
+  index = find_or_create_game(g_current_session.game_id);
+  if (index < 0) {
+    return;
+  }
+  game = game_at((uint32_t)index);
+  if (g_current_session.title[0] != '\0' &&
+      strncmp(game->title, g_current_session.title, sizeof(game->title)) !=
+          0) {
+    copy_str(game->title, sizeof(game->title), g_current_session.title);
+    store_write_game((uint32_t)index);
+  }
+
+  copy_str(g_store_header.session_game_id,
+           sizeof(g_store_header.session_game_id), game->game_id);
+  g_store_header.session_seconds = (uint32_t)elapsed_seconds;
+  store_write_header();
+}
+
+/* Buffered file output for the JSON export; flushes whenever the next
+ * piece would not fit */
+typedef struct {
+  SceUID fd;
+  int len;
+  int ok;
+  char buf[1024];
+} JsonOut;
 
-  for (i = 0;
-       i < (int)g_usage_data.total_games && len < (int)sizeof(buffer) - 300;
-       i++) {
-    game = &g_usage_data.games[i];
-    game_seconds = game->total_seconds;
-    game_sessions = game->session_count;
+static void json_flush(JsonOut *out) {
+  if (out->ok && out->len > 0) {
+    out->ok = (sceIoWrite(out->fd, out->buf, out->len) == out->len);
+  }
+  out->len = 0;
+}
 
-    /* Add current session time to the matching game */
-    if (current_game_id && strcmp(game->game_id, current_game_id) == 0) {
-      game_seconds += current_session_seconds;
-      game_sessions += 1; /* Count current session */
+static void json_printf(JsonOut *out, const char *fmt, ...) {
+  va_list args;
+  int room = (int)sizeof(out->buf) - out->len;
+  int n;
+
+  va_start(args, fmt);
+  n = vsnprintf(out->buf + out->len, room, fmt, args);
+  va_end(args);
+
+  if (n >= room) {
+    /* Didn't fit - flush and format again into the empty buffer */
+    json_flush(out);
+    va_start(args, fmt);
+    n = vsnprintf(out->buf, sizeof(out->buf), fmt, args);
+    va_end(args);
+    if (n >= (int)sizeof(out->buf)) {
+      n = sizeof(out->buf) - 1;
     }
+  }
+  if (n > 0) {
+    out->len += n;
+  }
+}
 
-    /* Key is "game_id:session_count" like desktop */
-    len += snprintf(buffer + len, sizeof(buffer) - len,
-                    "%s\"%s:%lu\":{\"game_id\":\"%s\",\"title\":\"%s\","
-                    "\"total_seconds\":%llu,\"first_played\":\"\","
-                    "\"last_played\":\"%s\",\"session_count\":%lu,"
-                    "\"play_dates\":[],\"daily_playtime\":{}}",
-                    first_game ? "" : ",", game->game_id,
-                    (unsigned long)game_sessions, game->game_id, game->title,
-                    (unsigned long long)game_seconds, last_played_str,
-                    (unsigned long)game_sessions);
-    first_game = 0;
+/* Emit a game's days from the shared ring, as dates or "date":seconds */
+static void json_daily(JsonOut *out, uint32_t index, int with_seconds) {
+  uint32_t i;
+  int first = 1;
+
+  for (i = 0; g_daily != NULL && i < USAGE_DAILY_RING_SIZE; i++) {
+    if (g_daily[i].game != index) {
+      continue;
+    }
+    if (with_seconds) {
+      json_printf(out, "%s\"%s\":%lu", first ? "" : ",", g_daily[i].date,
+                  (unsigned long)g_daily[i].seconds);
+    } else {
+      json_printf(out, "%s\"%s\"", first ? "" : ",", g_daily[i].date);
+    }
+    first = 0;
+  }
+}
+
+/**
+ * Export usage data to usage_log.json
+ * Format matches desktop companion:
+ * {"psps":{"PSP Name":{"psp_name":"PSP Name","games":{"GAMEID:1":{...}}}}}
+ * Written through a small buffer, so the number of games is not limited by
+ * the buffer size.
+ */
+int usage_export_json(void) {
+  static JsonOut out;
+  uint32_t i;
+  const GameUsage *game;
+  char last_played_str[24]; /* "YYYY-MM-DD HH:MM:SS" */
+
+  /* Exporting a partial load would overwrite the real history */
+  if (!g_store_ok) {
+    return -1;
   }
 
-  len += snprintf(buffer + len, sizeof(buffer) - len,
-                  "}}},\"last_updated\":null}");
+  /* Get current time for last_played */
+  get_current_time_string(last_played_str, sizeof(last_played_str));
 
   /* Small delay before file I/O to let XMB settle */
   sceKernelDelayThread(10 * 1000); /* 10ms */
 
-  /* Write to file */
-  fd = sceIoOpen(USAGE_JSON_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC,
-                 0777);
-  if (fd >= 0) {
-    sceIoWrite(fd, buffer, len);
-    sceIoClose(fd);
+  out.fd = sceIoOpen(USAGE_JSON_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC,
+                     0777);
+  if (out.fd < 0) {
+    return -1;
   }
+  out.len = 0;
+  out.ok = 1;
+
+  /* Build JSON in desktop companion format */
+  json_printf(&out, "{\"psps\":{\"%s\":{\"psp_name\":\"%s\",\"games\":{",
+              g_psp_name, g_psp_name);
+
+  for (i = 0; i < g_usage_data.total_games && out.ok; i++) {
+    game = game_at(i);
+
+    /* Key is "game_id:session_count" like desktop */
+    json_printf(&out,
+                "%s\"%s:%lu\":{\"game_id\":\"%s\",\"title\":\"%s\","
+                "\"total_seconds\":%llu,\"first_played\":\"\","
+                "\"last_played\":\"%s\",\"session_count\":%lu,"
+                "\"sync_version\":%lu,\"play_dates\":[",
+                i == 0 ? "" : ",", game->game_id,
+                (unsigned long)game->session_count, game->game_id, game->title,
+                (unsigned long long)game->total_seconds, last_played_str,
+                (unsigned long)game->session_count,
+                (unsigned long)game->sync_version);
+    json_daily(&out, i, 0);
+    json_printf(&out, "],\"daily_playtime\":{");
+    json_daily(&out, i, 1);
+    json_printf(&out, "}}");
+  }
+
+  json_printf(&out,
+              "}}},\"last_updated\":null,\"psp_sync_version\":%lu,"
+              "\"peer_version\":%lu}",
+              (unsigned long)g_usage_data.sync_version,
+              (unsigned long)g_usage_data.peer_version);
+  json_flush(&out);
+  sceIoClose(out.fd);
+
+  return out.ok ? 0 : -1;
 }
 
 /**
@@ -415,44 +995,225 @@ int usage_has_active_session(void) { return g_current_session.active; }
 uint64_t usage_get_last_updated(void) { return g_usage_data.last_updated; }
 
 /**
- * Get pointer to the in-memory usage data
+ * Get pointer to the in-memory usage totals
  */
 const UsageData *usage_get_data(void) { return &g_usage_data; }
 
 /**
- * Merge remote usage data into local (stub - not needed for basic offline)
+ * Get a tracked game by index
  */
-int usage_merge_remote(const char *json_data, size_t len) {
-  (void)json_data;
-  (void)len;
-  return 0;
+const GameUsage *usage_get_game(uint32_t index) {
+  if (index >= g_usage_data.total_games) {
+    return NULL;
+  }
+  return game_at(index);
 }
 
 /**
- * Serialize usage data to JSON string
+ * Get the local sync_version
  */
-int usage_serialize_json(char *buffer, size_t buffer_size) {
-  int len, i;
-  int first_game = 1;
+uint32_t usage_get_sync_version(void) { return g_usage_data.sync_version; }
+
+/**
+ * Get the highest desktop sync_version merged so far
+ */
+uint32_t usage_get_peer_version(void) { return g_usage_data.peer_version; }
+
+/**
+ * Merge a StatsDelta from the desktop into local data
+ */
+int usage_merge_remote(const char *data, size_t len) {
+  StatsDeltaHeader header;
+  StatsDeltaRecord record;
   GameUsage *game;
+  uint32_t i;
+  int index;
+  int changed = 0;
+  int dirty;
+
+  if (data == NULL || len < sizeof(header)) {
+    return -1;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, STATS_DELTA_MAGIC, 4) != 0 ||
+      len < sizeof(header) + (size_t)header.count * sizeof(record)) {
+    return -1;
+  }
+
+  for (i = 0; i < header.count; i++) {
+    /* Records are packed and may be unaligned - copy before use */
+    memcpy(&record, data + sizeof(header) + i * sizeof(record),
+           sizeof(record));
+    record.game_id[sizeof(record.game_id) - 1] = '\0';
+    record.title[sizeof(record.title) - 1] = '\0';
+    if (record.game_id[0] == '\0') {
+      continue;
+    }
+
+    index = find_or_create_game(record.game_id);
+    if (index < 0) {
+      continue; /* Out of memory */
+    }
+    game = game_at((uint32_t)index);
+
+    /* High-water-mark: take higher values */
+    dirty = 0;
+    if (record.total_seconds > game->total_seconds) {
+      g_usage_data.total_playtime += record.total_seconds - game->total_seconds;
+      game->total_seconds = record.total_seconds;
+      changed++;
+      dirty = 1;
+    }
+    if (record.session_count > game->session_count) {
+      game->session_count = record.session_count;
+      dirty = 1;
+    }
+    if (game->title[0] == '\0') {
+      copy_str(game->title, sizeof(game->title),
+               record.title[0] != '\0' ? record.title : record.game_id);
+      dirty = 1;
+    }
+
+    if (dirty) {
+      store_write_record((uint32_t)index);
+    }
+  }
+
+  g_usage_data.peer_version = header.version;
+  g_peer_ack = header.ack;
+  store_write_header();
+  return changed;
+}
+
+/* Count games whose last change is in (after, upto] */
+static uint32_t count_changed(uint32_t after, uint32_t upto) {
+  uint32_t count = 0;
+  uint32_t i;
+
+  for (i = 0; i < g_usage_data.total_games; i++) {
+    uint32_t version = game_at(i)->sync_version;
+    if (version > after && version <= upto) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * Build a StatsDelta of the games changed since the desktop's last ack
+ */
+int usage_build_delta(char *buffer, size_t buffer_size) {
+  StatsDeltaHeader header;
+  StatsDeltaRecord record;
+  size_t len = sizeof(header);
+  uint32_t ack = g_peer_ack;
+  uint32_t upto = g_usage_data.sync_version;
+  uint32_t capacity;
+  uint32_t i;
+
+  if (buffer == NULL || buffer_size < sizeof(header) + sizeof(record)) {
+    return -1;
+  }
+
+  /* An ack from the future means our data was reset - resend everything */
+  if (ack > upto) {
+    ack = 0;
+  }
+
+  capacity = (buffer_size - sizeof(header)) / sizeof(record);
+  if (capacity > STATS_DELTA_MAX_RECORDS) {
+    capacity = STATS_DELTA_MAX_RECORDS;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, STATS_DELTA_MAGIC, 4);
+  header.ack = g_usage_data.peer_version;
+
+  /* Too many changes for one delta: send the oldest, up to the highest
+   * version that still fits. Each change has its own version, so the
+   * search always finds at least one. */
+  if (count_changed(ack, upto) > capacity) {
+    uint32_t lo = ack + 1;
+    uint32_t hi = upto;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo + 1) / 2;
+      if (count_changed(ack, mid) <= capacity) {
+        lo = mid;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    upto = lo;
+    header.flags |= STATS_DELTA_FLAG_MORE;
+  }
+  header.version = upto;
+
+  for (i = 0; i < g_usage_data.total_games; i++) {
+    const GameUsage *game = game_at(i);
+    if (game->sync_version <= ack || game->sync_version > upto) {
+      continue;
+    }
+    memset(&record, 0, sizeof(record));
+    copy_str(record.game_id, sizeof(record.game_id), game->game_id);
+    copy_str(record.title, sizeof(record.title), game->title);
+    record.total_seconds = game->total_seconds;
+    record.session_count = game->session_count;
+    record.version = game->sync_version;
+    memcpy(buffer + len, &record, sizeof(record));
+    len += sizeof(record);
+    header.count++;
+  }
+
+  if (header.count == 0) {
+    return 0;
+  }
+  memcpy(buffer, &header, sizeof(header));
+  return (int)len;
+}
+
+/**
+ * Serialize usage data to JSON string. Games that do not fit are left out;
+ * the output is always closed off as valid JSON.
+ */
+int usage_serialize_json(char *buffer, size_t buffer_size) {
+  size_t room;
+  size_t len;
+  uint32_t i;
+  int n;
+  const GameUsage *game;
+
+  /* Keep room for the closing "]}" */
+  if (buffer == NULL || buffer_size < 3) {
+    return -1;
+  }
+  room = buffer_size - 2;
+
+  n = snprintf(buffer, room,
+               "{\"total_games\":%lu,\"total_playtime\":%llu,\"games\":[",
+               (unsigned long)g_usage_data.total_games,
+               (unsigned long long)g_usage_data.total_playtime);
+  if (n < 0 || (size_t)n >= room) {
+    return -1;
+  }
+  len = (size_t)n;
+
+  for (i = 0; i < g_usage_data.total_games; i++) {
+    game = game_at(i);
+    n = snprintf(buffer + len, room - len,
+                 "%s{\"title\":\"%s\",\"game_id\":\"%s\",\"seconds\":%llu,"
+                 "\"sessions\":%lu}",
+                 i == 0 ? "" : ",", game->title, game->game_id,
+                 (unsigned long long)game->total_seconds,
+                 (unsigned long)game->session_count);
+    if (n < 0 || (size_t)n >= room - len) {
+      /* The cut-off entry is overwritten below */
+      net_log("Usage: JSON holds %lu of %lu games", (unsigned long)i,
+              (unsigned long)g_usage_data.total_games);
+      break;
+    }
+    len += (size_t)n;
+  }
 
-  len = snprintf(buffer, buffer_size,
-                 "{\"total_games\":%lu,\"total_playtime\":%llu,\"games\":[",
-                 (unsigned long)g_usage_data.total_games,
-                 (unsigned long long)g_usage_data.total_playtime);
-
-  for (i = 0; i < (int)g_usage_data.total_games && len < (int)buffer_size - 200;
-       i++) {
-    game = &g_usage_data.games[i];
-    len += snprintf(buffer + len, buffer_size - len,
-                    "%s{\"title\":\"%s\",\"game_id\":\"%s\",\"seconds\":%llu,"
-                    "\"sessions\":%lu}",
-                    first_game ? "" : ",", game->title, game->game_id,
-                    (unsigned long long)game->total_seconds,
-                    (unsigned long)game->session_count);
-    first_game = 0;
-  }
-
-  len += snprintf(buffer + len, buffer_size - len, "]}");
-  return len;
+  memcpy(buffer + len, "]}", 3);
+  return (int)(len + 2);
 }
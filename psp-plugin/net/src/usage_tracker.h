@@ -1,46 +1,84 @@
 /**
  * Local Usage Tracker
  *
- * Tracks game play sessions and writes usage.json for the PSP Stats App.
- * Only active when offline_mode=1 in the config.
+ * Tracks game play sessions in a fixed-record store on the Memory Stick and
+ * exports usage_log.json for the PSP Stats App. Sessions are only tracked
+ * when offline_mode=1 in the config.
+ *
+ * In RAM, games live in slabs allocated from the user partition as the
+ * library grows, found through a hash index on game_id. Per-day playtime for
+ * all games shares one ring, so the oldest days are dropped first no matter
+ * which game they belong to.
+ *
+ * Store layout (usage.bin):
+ *   UsageStoreHeader
+ *   UsageDailyEntry[USAGE_DAILY_RING_SIZE]  (the ring, slot by slot)
+ *   GameUsage records; game i lives at USAGE_STORE_RECORDS_OFFSET +
+ *   i * sizeof(GameUsage)
  */
 
 #ifndef USAGE_TRACKER_H
 #define USAGE_TRACKER_H
 
+#include <stddef.h>
 #include <stdint.h>
 
-/* Maximum game entries to track */
-#define MAX_TRACKED_GAMES 50
-
 /* Maximum game title length */
 #define MAX_GAME_TITLE 128
 
-/* Maximum daily playtime entries per game (about 1 month of history) */
-#define MAX_DAILY_ENTRIES 30
+/* Games per slab allocated from the user partition */
+#define USAGE_SLAB_GAMES 32
+
+/* Per-day playtime entries kept for all games together */
+#define USAGE_DAILY_RING_SIZE 256
 
 /* Path to usage_log.json on memory stick (matches Desktop Companion) */
 #define USAGE_JSON_PATH "ms0:/SEPLUGINS/pspdrp/usage_log.json"
 
+/* Path to the record store */
+#define USAGE_STORE_PATH "ms0:/SEPLUGINS/pspdrp/usage.bin"
+
+#define USAGE_STORE_MAGIC "PDUS"
+#define USAGE_STORE_VERSION 2
+
 /**
- * Per-day playtime entry
+ * Per-day playtime entry (one ring slot)
  */
 typedef struct {
+  uint32_t game;    /* Index of the game, 0xFFFFFFFF if the slot is free */
   char date[12];    /* Date in YYYY-MM-DD format */
   uint32_t seconds; /* Playtime in seconds for this day */
-} DailyPlaytime;
+} __attribute__((packed)) UsageDailyEntry;
 
 /**
- * Single game's usage data
+ * Single game's usage data (also the on-disk record)
  */
 typedef struct {
-  char game_id[16];                       /* Game ID (e.g., "NPUH10117") */
-  char title[MAX_GAME_TITLE];             /* Game title */
-  uint64_t total_seconds;                 /* Total play time in seconds */
-  uint32_t session_count;                 /* Number of play sessions */
-  uint32_t daily_count;                   /* Number of daily entries */
-  DailyPlaytime daily[MAX_DAILY_ENTRIES]; /* Per-day playtime */
-} GameUsage;
+  char game_id[16];           /* Game ID (e.g., "NPUH10117") */
+  char title[MAX_GAME_TITLE]; /* Game title */
+  uint64_t total_seconds;     /* Total play time in seconds */
+  uint32_t session_count;     /* Number of play sessions */
+  uint32_t sync_version;      /* sync_version of the last change */
+} __attribute__((packed)) GameUsage;
+
+/**
+ * Store file header
+ */
+typedef struct {
+  char magic[4];            /* USAGE_STORE_MAGIC */
+  uint16_t version;         /* USAGE_STORE_VERSION */
+  uint16_t record_size;     /* sizeof(GameUsage) the store was written with */
+  uint32_t count;           /* Number of game records */
+  uint32_t sync_version;    /* UsageData::sync_version */
+  uint32_t peer_version;    /* UsageData::peer_version */
+  uint32_t session_seconds; /* Checkpoint of the running session, 0 if none */
+  char session_game_id[16]; /* Game the checkpoint belongs to */
+  uint32_t daily_head;      /* Next ring slot to write */
+} __attribute__((packed)) UsageStoreHeader;
+
+#define USAGE_STORE_RING_OFFSET sizeof(UsageStoreHeader)
+#define USAGE_STORE_RECORDS_OFFSET                                             \
+  (USAGE_STORE_RING_OFFSET + USAGE_DAILY_RING_SIZE * sizeof(UsageDailyEntry))
 
 /**
  * Overall usage data structure
@@ -49,12 +87,13 @@ typedef struct {
   uint32_t total_games;    /* Number of unique games played */
   uint64_t total_playtime; /* Total playtime across all games */
   uint64_t last_updated;   /* Unix timestamp of last modification */
-  GameUsage games[MAX_TRACKED_GAMES];
+  uint32_t sync_version;   /* Bumped on every local change */
+  uint32_t peer_version;   /* Highest desktop sync_version merged */
 } UsageData;
 
 /**
  * Initialize the usage tracker
- * Loads existing usage.json if present
+ * Loads the record store, importing usage_log.json on first run
  */
 void usage_init(void);
 
@@ -73,11 +112,17 @@ void usage_start_session(const char *game_id, const char *title);
 void usage_end_session(void);
 
 /**
- * Force save usage data to disk
- * Called periodically and on shutdown
+ * Checkpoint the running session to disk (header write only)
+ * Called periodically so a crash loses at most one interval
  */
 void usage_save(void);
 
+/**
+ * Export usage data to usage_log.json for the stats app and desktop
+ * @return 0 on success, -1 on error
+ */
+int usage_export_json(void);
+
 /**
  * Set PSP name for JSON output
  * @param name PSP name to use in the JSON file
@@ -97,20 +142,47 @@ int usage_has_active_session(void);
 uint64_t usage_get_last_updated(void);
 
 /**
- * Get pointer to the in-memory usage data
- * Used for serialization during sync
+ * Get pointer to the in-memory usage totals
  * @return Pointer to UsageData (read-only)
  */
 const UsageData *usage_get_data(void);
 
 /**
- * Merge remote usage data into local
- * Uses high-water-mark strategy (higher values win)
- * @param json_data JSON string containing remote usage data
- * @param len Length of JSON string
- * @return 0 on success, -1 on error
+ * Get a tracked game by index
+ * @param index 0 .. total_games - 1
+ * @return Pointer to the game (read-only), NULL if out of range
+ */
+const GameUsage *usage_get_game(uint32_t index);
+
+/**
+ * Get the local sync_version (for stats requests)
+ */
+uint32_t usage_get_sync_version(void);
+
+/**
+ * Get the highest desktop sync_version merged so far (for stats requests)
+ */
+uint32_t usage_get_peer_version(void);
+
+/**
+ * Merge a StatsDelta from the desktop into local data
+ * Uses high-water-mark strategy (higher values win). Merged values are not
+ * treated as local changes, so they are not echoed back in the next delta.
+ * @param data StatsDelta received in a stats response
+ * @param len Length of data
+ * @return Number of games changed, or -1 if the delta is malformed
+ */
+int usage_merge_remote(const char *data, size_t len);
+
+/**
+ * Build a StatsDelta of the games changed since the desktop's last ack
+ * (taken from the most recent usage_merge_remote). If not everything fits,
+ * the oldest changes are sent and STATS_DELTA_FLAG_MORE is set.
+ * @param buffer Output buffer
+ * @param buffer_size Size of output buffer
+ * @return Bytes written, 0 if the desktop is up to date, -1 on error
  */
-int usage_merge_remote(const char *json_data, size_t len);
+int usage_build_delta(char *buffer, size_t buffer_size);
 
 /**
  * Serialize usage data to JSON string
@@ -13,6 +13,10 @@
 static void trim_whitespace(char *str);
 static int parse_bool(const char *value);
 static void parse_line(const char *line, UsbPluginConfig *config);
+static void parse_text(const char *text, int len, UsbPluginConfig *config);
+
+/* ini text handed over by the loader (usb_config_load_text), NULL if none */
+static const char *g_config_text = NULL;
 
 /* Simple atoi replacement for kernel mode (no libc) */
 static int parse_int(const char *str) {
@@ -55,6 +59,7 @@ void usb_config_set_defaults(UsbPluginConfig *config) {
   config->send_icons = 1;
   config->vblank_wait = 300; /* ~5 seconds at 60fps */
   config->send_once = 0;
+  config->event_detect = 1;
 }
 
 /**
@@ -63,9 +68,7 @@ void usb_config_set_defaults(UsbPluginConfig *config) {
 int usb_config_load(UsbPluginConfig *config) {
   SceUID fd;
   char buffer[2048];
-  char line[128];
   int bytes_read;
-  int i, j;
 
   /* Set defaults first */
   usb_config_set_defaults(config);
@@ -86,11 +89,31 @@ int usb_config_load(UsbPluginConfig *config) {
   }
 
   buffer[bytes_read] = '\0';
+  parse_text(buffer, bytes_read, config);
+
+  return 0;
+}
+
+/**
+ * Load configuration from ini text already in memory
+ */
+int usb_config_load_text(UsbPluginConfig *config, const char *text) {
+  usb_config_set_defaults(config);
+  parse_text(text, (int)strlen(text), config);
+  g_config_text = text;
+  return 0;
+}
+
+/**
+ * Parse ini text line by line into config
+ */
+static void parse_text(const char *text, int len, UsbPluginConfig *config) {
+  char line[128];
+  int i, j;
 
-  /* Parse line by line */
   j = 0;
-  for (i = 0; i <= bytes_read; i++) {
-    if (buffer[i] == '\n' || buffer[i] == '\r' || buffer[i] == '\0') {
+  for (i = 0; i <= len; i++) {
+    if (text[i] == '\n' || text[i] == '\r' || text[i] == '\0') {
       line[j] = '\0';
       if (j > 0) {
         parse_line(line, config);
@@ -98,15 +121,13 @@ int usb_config_load(UsbPluginConfig *config) {
       j = 0;
 
       /* Skip \r\n sequences */
-      if (buffer[i] == '\r' && buffer[i + 1] == '\n') {
+      if (text[i] == '\r' && text[i + 1] == '\n') {
         i++;
       }
     } else if (j < (int)sizeof(line) - 1) {
-      line[j++] = buffer[i];
+      line[j++] = text[i];
     }
   }
-
-  return 0;
 }
 
 /**
@@ -185,6 +206,8 @@ static void parse_line(const char *line, UsbPluginConfig *config) {
     }
   } else if (strcmp(key, "send_once") == 0) {
     config->send_once = parse_bool(value);
+  } else if (strcmp(key, "event_detect") == 0) {
+    config->event_detect = parse_bool(value);
   }
 }
 
@@ -232,6 +255,7 @@ int usb_config_get_game_vblank_wait(const char *game_id,
                                     uint32_t default_wait) {
   SceUID fd;
   char buffer[2048];
+  const char *text = buffer;
   char search_key[32];
   int bytes_read;
   int i, j;
@@ -245,27 +269,32 @@ int usb_config_get_game_vblank_wait(const char *game_id,
   search_key[sizeof(search_key) - 13] = '\0';
   strcat(search_key, "_vblank_wait");
 
-  /* Open config file */
-  fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
-  if (fd < 0) {
-    return (int)default_wait;
-  }
+  if (g_config_text != NULL) {
+    text = g_config_text;
+    bytes_read = (int)strlen(text);
+  } else {
+    /* Open config file */
+    fd = sceIoOpen(CONFIG_PATH, PSP_O_RDONLY, 0);
+    if (fd < 0) {
+      return (int)default_wait;
+    }
 
-  /* Read entire file */
-  bytes_read = sceIoRead(fd, buffer, sizeof(buffer) - 1);
-  sceIoClose(fd);
+    /* Read entire file */
+    bytes_read = sceIoRead(fd, buffer, sizeof(buffer) - 1);
+    sceIoClose(fd);
 
-  if (bytes_read <= 0) {
-    return (int)default_wait;
-  }
+    if (bytes_read <= 0) {
+      return (int)default_wait;
+    }
 
-  buffer[bytes_read] = '\0';
+    buffer[bytes_read] = '\0';
+  }
 
   /* Simple line-by-line search */
   char line[128];
   j = 0;
   for (i = 0; i <= bytes_read; i++) {
-    if (buffer[i] == '\n' || buffer[i] == '\r' || buffer[i] == '\0') {
+    if (text[i] == '\n' || text[i] == '\r' || text[i] == '\0') {
       line[j] = '\0';
       if (j > 0) {
         /* Check if this line starts with our search key */
@@ -288,11 +317,11 @@ int usb_config_get_game_vblank_wait(const char *game_id,
         }
       }
       j = 0;
-      if (buffer[i] == '\r' && buffer[i + 1] == '\n') {
+      if (text[i] == '\r' && buffer[i + 1] == '\n') {
         i++;
       }
     } else if (j < (int)sizeof(line) - 1) {
-      line[j++] = buffer[i];
+      line[j++] = text[i];
     }
   }
 
@@ -44,6 +44,10 @@ typedef struct {
 
   /* Send once mode: send update then exit */
   int send_once;
+
+  /* Event-driven detection via a module start handler; poll_interval_ms
+   * becomes a slow fallback */
+  int event_detect;
 } UsbPluginConfig;
 
 /* Per-game vblank wait override */
@@ -60,4 +64,12 @@ void usb_config_set_defaults(UsbPluginConfig *config);
  */
 int usb_config_load(UsbPluginConfig *config);
 
+/**
+ * Load configuration from ini text passed in by the loader, without
+ * touching the Memory Stick. Per-game lookups use the same text.
+ * @param text Contents of psp_drp.ini (must stay valid)
+ * @return 0 on success, negative on error
+ */
+int usb_config_load_text(UsbPluginConfig *config, const char *text);
+
 #endif /* USB_CONFIG_H */
@@ -8,13 +8,17 @@
 #include <pspsdk.h>
 #include <pspusb.h>
 #include <pspusbbus.h>
+#include <stddef.h>
 #include <string.h>
 
 /* NOTE: usage_tracker requires stdlib functions not available in kernel mode
  * Stats sync is disabled in USB mode for now */
 /* #include "../../net/src/usage_tracker.h" */
 #include "config.h"
+#include "drp_core.h"
+#include "drp_handoff.h"
 #include "game_detect.h"
+#include "module_events.h"
 #include "usb_driver.h"
 #include "usb_protocol.h"
 
@@ -33,30 +37,31 @@ typedef struct {
   uint32_t magic;
   char game_id[16];
   char game_title[64];
+  DrpHandoff handoff; /* Config text and game path, newer loaders only */
 } UsbStartupArgs;
 
+/* Startup args without the handoff */
+#define USB_STARTUP_ARGS_BASE_SIZE offsetof(UsbStartupArgs, handoff)
+
 /* Thread state */
 static volatile int g_running = 0;
 static SceUID g_thread_id = -1;
-static char g_last_game_id[16] = {0};
 static char g_startup_game_id[16] = {0};    /* Game ID from loader */
 static char g_startup_game_title[64] = {0}; /* Game title from loader */
-static uint32_t g_game_start_time = 0;
-static uint32_t g_last_heartbeat = 0;
-static uint32_t g_last_game_update = 0; /* For game_update_interval_ms */
+static DrpHandoff g_handoff; /* Loader handoff, flags 0 without one */
+
+/* Shared main loop state: current game, resends, heartbeats, stats sync */
+static DrpCore g_core;
+
+/* Icon scratch buffer, max 32KB icon */
+#define ICON_BUFFER_SIZE 32768
+static uint8_t g_icon_buffer[ICON_BUFFER_SIZE];
 
 /* Configuration */
 static UsbPluginConfig g_config;
 int g_logging_enabled =
     0; /* Controls USB_LOG output (extern in usb_driver.h) */
 
-/* Stats sync state (sync protocol only - no local usage tracking in USB mode)
- */
-static int g_stats_sync_pending = 0;   /* 1 = waiting for response */
-static int g_stats_sync_done = 0;      /* 1 = initial sync complete */
-static uint32_t g_last_stats_sync = 0; /* Last sync attempt time (seconds) */
-#define STATS_SYNC_INTERVAL_S (5 * 60) /* 5 minutes */
-
 /*============================================================================
  * Helpers
  *============================================================================*/
@@ -65,16 +70,18 @@ static uint32_t g_last_stats_sync = 0; /* Last sync attempt time (seconds) */
 #define USAGE_JSON_PATH "ms0:/SEPLUGINS/pspdrp/usage_log.json"
 
 /**
- * Read local last_updated timestamp from usage.json (kernel-safe)
- * Uses only PSP kernel I/O - no stdlib required
- * @return timestamp or 0 if file doesn't exist or can't be parsed
+ * Read a top-level number from usage.json (kernel-safe)
+ * Uses only PSP kernel I/O - no stdlib required. Only the start of the file
+ * is scanned, so this finds fields the desktop writes first.
+ * @param key Field name without quotes
+ * @return value or 0 if file doesn't exist or can't be parsed
  */
-static uint64_t read_local_timestamp(void) {
+static uint64_t read_local_number(const char *key) {
   SceUID fd;
-  char buf[512]; /* Small buffer - we only need the last_updated field */
+  char buf[512]; /* Small buffer - we only need one field */
   int bytes_read;
   char *pos;
-  uint64_t timestamp = 0;
+  uint64_t value = 0;
 
   fd = sceIoOpen(USAGE_JSON_PATH, PSP_O_RDONLY, 0);
   if (fd < 0) {
@@ -89,20 +96,25 @@ static uint64_t read_local_timestamp(void) {
   }
   buf[bytes_read] = '\0';
 
-  /* Simple search for "last_updated": - no stdlib string functions needed */
+  /* Simple search for "key": - no stdlib string functions needed */
   pos = buf;
   while (*pos) {
-    if (pos[0] == 'l' && pos[1] == 'a' && pos[2] == 's' && pos[3] == 't' &&
-        pos[4] == '_' && pos[5] == 'u' && pos[6] == 'p' && pos[7] == 'd' &&
-        pos[8] == 'a' && pos[9] == 't' && pos[10] == 'e' && pos[11] == 'd') {
-      /* Found "last_updated" - skip to the number */
-      pos += 12;
-      while (*pos && (*pos == '"' || *pos == ':' || *pos == ' ')) {
+    int i = 0;
+    if (*pos == '"') {
+      while (key[i] && pos[1 + i] == key[i]) {
+        i++;
+      }
+    }
+    if (*pos == '"' && key[i] == '\0' && pos[1 + i] == '"') {
+      /* Found the key - skip to the number */
+      pos += 2 + i;
+      while (*pos && (*pos == ':' || *pos == ' ' || *pos == '\n' ||
+                      *pos == '\r' || *pos == '\t')) {
         pos++;
       }
       /* Parse the number manually */
       while (*pos >= '0' && *pos <= '9') {
-        timestamp = timestamp * 10 + (*pos - '0');
+        value = value * 10 + (*pos - '0');
         pos++;
       }
       break;
@@ -110,7 +122,7 @@ static uint64_t read_local_timestamp(void) {
     pos++;
   }
 
-  return timestamp;
+  return value;
 }
 
 /**
@@ -151,20 +163,109 @@ static void wait_for_vblanks(int count) {
   }
 }
 
+/*============================================================================
+ * USB transport for the shared core
+ *============================================================================*/
+
+static void usb_core_log(const char *msg) {
+  if (g_logging_enabled) {
+    usb_log_str(msg);
+  }
+}
+
+static int usb_core_send_game_info(const GameInfo *game) {
+  return usb_send_game_info(game->game_id, game->title, game->state,
+                            game->has_icon, game->start_time,
+                            game->persistent, game->psp_name);
+}
+
+static int usb_core_send_heartbeat(uint64_t now_us,
+                                   const HeartbeatMetrics *metrics) {
+  /* 100% battery placeholder */
+  return usb_send_heartbeat((uint32_t)(now_us / 1000000), 100, metrics);
+}
+
+static int usb_core_poll(char *game_id_out) {
+  switch (usb_poll_message(game_id_out)) {
+  case 0:
+    return DRP_MSG_NONE;
+  case USB_PKT_ACK:
+    return DRP_MSG_ACK;
+  case USB_PKT_ICON_REQUEST:
+    return DRP_MSG_ICON_REQUEST;
+  case USB_PKT_STATS_RESPONSE:
+    return DRP_MSG_STATS_RESPONSE;
+  default:
+    return DRP_MSG_OTHER;
+  }
+}
+
+static int usb_core_send_stats_request(void) {
+  /* Tell the desktop which snapshot we hold so it can skip resending an
+   * unchanged usage.json */
+  uint64_t local_ts = read_local_number("last_updated");
+  uint32_t local_version = (uint32_t)read_local_number("sync_version");
+
+  return usb_send_stats_request(local_ts, local_version);
+}
+
+/**
+ * Check on the stats response (staged in RAM, then committed to file in one
+ * write)
+ */
+static int usb_core_poll_stats(void) {
+  uint64_t remote_ts = 0;
+  size_t bytes_received = 0;
+  int resp = usb_poll_stats_response(&remote_ts, NULL, 0, &bytes_received);
+
+  if (resp == 1) {
+    /* Response complete and verified */
+    USB_LOG_ERR("Bytes received", (int)bytes_received);
+    return DRP_SYNC_DONE;
+  }
+  if (resp == 0 || resp == -1) {
+    /* Still receiving chunks (-1 = nothing staged yet) */
+    return DRP_SYNC_WAITING;
+  }
+
+  if (resp == -2) {
+    /* Incomplete or commit failed - previous file kept */
+    USB_LOG("Stats sync FAILED - data truncated");
+    USB_LOG_ERR("Bytes received", (int)bytes_received);
+  } else {
+    USB_LOG_ERR("Stats response error", resp);
+  }
+  return DRP_SYNC_FAILED;
+}
+
+static const DrpTransport g_usb_transport = {
+    .log = usb_core_log,
+    .send_game_info = usb_core_send_game_info,
+    .send_heartbeat = usb_core_send_heartbeat,
+    .send_icon = usb_send_icon,
+    .poll = usb_core_poll,
+    .send_stats_request = usb_core_send_stats_request,
+    .poll_stats = usb_core_poll_stats,
+};
+
 /*============================================================================
  * Main Thread - Game Detection and USB Sending
  *============================================================================*/
 
 static int usb_main_thread(SceSize args, void *argp) {
   GameInfo game;
-  uint32_t last_poll = 0;
-  uint32_t now;
+  DrpSettings settings;
+  uint64_t now;
   int connected_logged = 0;
   int loop_count = 0;
+  uint32_t seen_generation = 0;
+  int msg;
 
   (void)args;
   (void)argp;
 
+  /* This thread owns the log file; callbacks only append to RAM */
+  usb_log_set_flush_thread();
   USB_LOG("USB thread started");
 
   /* Initialize game detection */
@@ -176,73 +277,63 @@ static int usb_main_thread(SceSize args, void *argp) {
   USB_LOG("Usage tracker initialized");
   */
 
-  /* If loader passed a game ID, send it immediately */
+  memset(&settings, 0, sizeof(settings));
+  settings.poll_interval_ms = g_config.poll_interval_ms;
+  settings.heartbeat_interval_ms = g_config.heartbeat_interval_ms;
+  settings.game_update_interval_ms = g_config.game_update_interval_ms;
+  settings.event_detect = g_config.event_detect;
+  settings.send_icons = g_config.send_icons;
+  settings.persistent = g_config.send_once;
+  settings.psp_name = g_config.psp_name;
+  drp_core_init(&g_core, &g_usb_transport, &settings, g_icon_buffer,
+                ICON_BUFFER_SIZE);
+
+  /* The loader's game (or the XMB) goes out as soon as the host is up */
+  memset(&game, 0, sizeof(game));
   if (g_startup_game_id[0] != '\0') {
-    USB_LOG("Sending game ID from loader immediately");
-
-    /* Wait for USB connection first */
-    int connect_wait = 0;
-    while (!usb_driver_is_connected() && connect_wait < 50) {
-      sceKernelDelayThread(100 * 1000); /* 100ms */
-      connect_wait++;
-    }
-
-    if (usb_driver_is_connected()) {
-      USB_LOG("Host connected, waiting for stabilization...");
-
-      /* Wait for connection to stabilize - desktop needs time to re-establish
-       */
-      sceKernelDelayThread(2000 * 1000); /* 2 seconds */
-
-      USB_LOG("Sending startup game info");
-      strncpy(g_last_game_id, g_startup_game_id, sizeof(g_last_game_id) - 1);
-      g_game_start_time = sceKernelGetSystemTimeLow() / 1000000;
-
-      /* Use actual title if available, otherwise fall back to game ID */
-      const char *title = (g_startup_game_title[0] != '\0')
-                              ? g_startup_game_title
-                              : g_startup_game_id;
-
-      int ret = usb_send_game_info(g_startup_game_id, title, 1,
-                                   1, /* state = 1 (playing), has_icon = 1 */
-                                   g_game_start_time, 0, g_config.psp_name);
-
-      if (ret >= 0) {
-        USB_LOG("Sent startup game info successfully");
-        g_last_game_update = sceKernelGetSystemTimeLow() / 1000000;
-      } else {
-        USB_LOG_ERR("Failed to send startup game info", ret);
+    USB_LOG("Sending game ID from loader");
+    strncpy(game.game_id, g_startup_game_id, sizeof(game.game_id) - 1);
+
+    /* Use actual title if available, otherwise fall back to game ID */
+    strncpy(game.title,
+            (g_startup_game_title[0] != '\0') ? g_startup_game_title
+                                               : g_startup_game_id,
+            sizeof(game.title) - 1);
+    game.state = STATE_GAME;
+    game.has_icon = 1;
+
+    /* With the loader's game path icons load without a probe */
+    if (g_handoff.flags & DRP_HANDOFF_GAME) {
+      if (g_handoff.title[0] != '\0') {
+        /* Full length; the startup args title stops at 63 characters */
+        strncpy(game.title, g_handoff.title, sizeof(game.title) - 1);
       }
-    } else {
-      USB_LOG("USB not connected, can't send startup game");
+      game.has_icon = (g_handoff.flags & DRP_HANDOFF_ICON) ? 1 : 0;
+      game_detect_seed(&game, g_handoff.game_path);
     }
   } else {
     /* No game ID from loader = launched from XMB, assume XMB mode */
     USB_LOG("No game ID from loader, assuming XMB mode");
-    strcpy(g_startup_game_id, "XMB");
-    strcpy(g_startup_game_title, "Browsing XMB");
-    strncpy(g_last_game_id, "XMB", sizeof(g_last_game_id) - 1);
-    g_game_start_time = sceKernelGetSystemTimeLow() / 1000000;
+    strcpy(game.game_id, "XMB");
+    strcpy(game.title, "Browsing XMB");
+    game.state = STATE_XMB;
+  }
+  game.start_time = (uint32_t)(drp_time_us() / 1000000);
+  drp_core_set_game(&g_core, &game);
 
-    /* Wait for USB connection to send XMB info */
+  /* Wait for USB connection first */
+  {
     int connect_wait = 0;
     while (!usb_driver_is_connected() && connect_wait < 50) {
-      sceKernelDelayThread(100 * 1000);
+      sceKernelDelayThread(100 * 1000); /* 100ms */
       connect_wait++;
     }
-
-    if (usb_driver_is_connected()) {
-      sceKernelDelayThread(2000 * 1000); /* Wait for stabilization */
-      int ret = usb_send_game_info("XMB", "Browsing XMB", 0,
-                                   0, /* state = 0, has_icon = 0 */
-                                   g_game_start_time, 0, g_config.psp_name);
-      if (ret >= 0) {
-        USB_LOG("Sent XMB info successfully");
-        g_last_game_update = sceKernelGetSystemTimeLow() / 1000000;
-      } else {
-        USB_LOG_ERR("Failed to send XMB info", ret);
-      }
-    }
+  }
+  if (usb_driver_is_connected()) {
+    /* Wait for connection to stabilize - desktop needs time to re-establish
+     */
+    USB_LOG("Host connected, waiting for stabilization...");
+    sceKernelDelayThread(2000 * 1000); /* 2 seconds */
   }
 
   while (g_running) {
@@ -253,8 +344,8 @@ static int usb_main_thread(SceSize args, void *argp) {
       USB_LOG("Thread loop iteration");
     }
 
-    /* Get current time in seconds */
-    now = sceKernelGetSystemTimeLow() / 1000000;
+    now = drp_time_us();
+    drp_metrics_wakeup();
 
     /* Check USB connection */
     if (!usb_driver_is_connected()) {
@@ -263,6 +354,7 @@ static int usb_main_thread(SceSize args, void *argp) {
         USB_LOG("Host disconnected");
         connected_logged = 0;
       }
+      usb_log_poll();
       sceKernelDelayThread(500 * 1000); /* 500ms */
       continue;
     }
@@ -271,179 +363,54 @@ static int usb_main_thread(SceSize args, void *argp) {
       USB_LOG("Host connected, starting game detection");
       connected_logged = 1;
 
-      /* Reset stats sync state on new connection */
-      g_stats_sync_pending = 0;
-      g_stats_sync_done = 0;
-      g_last_stats_sync = 0;
+      /* Sync stats again on new connection */
+      drp_core_resync(&g_core);
     }
 
-    /* Poll for game changes */
-    if ((now - last_poll) >= (g_config.poll_interval_ms / 1000)) {
-      last_poll = now;
-      USB_LOG("Polling for game...");
-
-      memset(&game, 0, sizeof(game));
-      int detect_ret = game_detect_current(&game);
-
-      if (detect_ret == 0 && game.game_id[0] != '\0') {
-        /* Normalize XMB detection (like net plugin does) */
-        if (strncmp(game.game_id, "Xmb", 3) == 0 ||
-            strcmp(game.game_id, "XMB") == 0 ||
-            strncmp(game.game_id, "SystemCon", 9) == 0 ||
-            strcmp(game.game_id, "SystemControl") == 0) {
-          strcpy(game.game_id, "XMB");
-          strcpy(game.title, "Browsing XMB");
-        }
+    /* Poll for game changes; module start/stop forces detection, the
+     * interval is only a fallback */
+    {
+      int hint = 0;
 
-        /* Check if game changed */
-        if (strcmp(g_last_game_id, game.game_id) != 0) {
-          USB_LOG("Game changed, sending info");
-
-          /* Update tracking */
-          strncpy(g_last_game_id, game.game_id, sizeof(g_last_game_id) - 1);
-          g_game_start_time = game.start_time;
-
-          /* Send game info */
-          int ret = usb_send_game_info(game.game_id, game.title, game.state,
-                                       game.has_icon, game.start_time,
-                                       0, /* not persistent */
-                                       g_config.psp_name);
-
-          if (ret >= 0) {
-            USB_LOG("Sent game info successfully");
-            g_last_game_update = now;
-
-            /* send_once mode: send one update then exit */
-            if (g_config.send_once) {
-              USB_LOG("send_once mode: update sent, exiting");
-              sceKernelDelayThread(1000 *
-                                   1000); /* 1 second for data to flush */
-              g_running = 0;
-            }
-          } else {
-            USB_LOG_ERR("Failed to send game info", ret);
-          }
-        } else {
-          /* Game unchanged - check for periodic resend */
-          if (g_config.game_update_interval_ms > 0 &&
-              (now - g_last_game_update) >=
-                  (g_config.game_update_interval_ms / 1000)) {
-            USB_LOG("Periodic game update resend");
-            int ret = usb_send_game_info(game.game_id, game.title, game.state,
-                                         game.has_icon, game.start_time, 0,
-                                         g_config.psp_name);
-            if (ret >= 0) {
-              g_last_game_update = now;
-            }
-          }
-        }
-      } else {
-        /* Detection failed - log on first failure */
-        static int detection_failed_logged = 0;
-        if (!detection_failed_logged) {
-          if (detect_ret != 0) {
-            USB_LOG_ERR("Game detection returned error", detect_ret);
-          } else {
-            USB_LOG("Game detection returned empty game_id");
-          }
-          detection_failed_logged = 1;
+      if (g_config.event_detect) {
+        uint32_t generation = usb_modevents_generation();
+        if (generation != seen_generation) {
+          seen_generation = generation;
+          hint = 1;
         }
       }
+      drp_core_detect(&g_core, now, hint);
     }
 
-    /* Send heartbeat */
-    if ((now - g_last_heartbeat) >= (g_config.heartbeat_interval_ms / 1000)) {
-      g_last_heartbeat = now;
-      usb_send_heartbeat(now, 100); /* 100% battery placeholder */
+    if (drp_core_send_game(&g_core, now) > 0 && g_config.send_once) {
+      /* send_once mode: send one update then exit */
+      USB_LOG("send_once mode: update sent, exiting");
+      sceKernelDelayThread(1000 * 1000); /* 1 second for data to flush */
+      g_running = 0;
+      break;
     }
 
-    /* Poll for incoming messages from desktop (icons, stats responses, etc) */
-    /* This MUST run every iteration to receive stats response packets! */
-    char requested_game_id[10] = {0};
-    int msg = usb_poll_message(requested_game_id);
-
-    /* Handle icon requests if enabled */
-    if (g_config.send_icons && msg == USB_PKT_ICON_REQUEST &&
-        requested_game_id[0] != '\0') {
-      USB_LOG("Icon requested, sending...");
-      /* Use game_detect_get_icon to get icon data into buffer */
-      static uint8_t icon_buffer[32768]; /* Max 32KB icon */
-      uint32_t icon_size = 0;
-      int ret = game_detect_get_icon(requested_game_id, icon_buffer,
-                                     sizeof(icon_buffer), &icon_size);
-      if (ret == 0 && icon_size > 0) {
-        ret = usb_send_icon(requested_game_id, icon_buffer, icon_size);
-        if (ret >= 0) {
-          USB_LOG("Icon sent successfully");
-        } else {
-          USB_LOG_ERR("Failed to send icon", ret);
-        }
-      } else {
-        USB_LOG_ERR("Failed to get icon data", ret);
-      }
-    }
+    drp_core_heartbeat(&g_core, now);
 
-    /* Stats sync logic - USB mode just syncs with Desktop (no local tracking)
-     */
-    if (!g_stats_sync_pending) {
-      /* Check if we should initiate a sync */
-      int should_sync = 0;
-
-      /* Initial sync on first connection */
-      if (!g_stats_sync_done && g_last_stats_sync == 0) {
-        should_sync = 1;
-        USB_LOG("Triggering initial stats sync");
-      }
-      /* Periodic sync every STATS_SYNC_INTERVAL_S seconds */
-      else if (g_stats_sync_done &&
-               (now - g_last_stats_sync >= STATS_SYNC_INTERVAL_S)) {
-        should_sync = 1;
-        USB_LOG("Triggering periodic stats sync");
-      }
+    /* Poll for incoming messages from desktop (icons, stats responses, etc)
+     * This MUST run every iteration to receive stats response packets! */
+    msg = drp_core_poll(&g_core);
 
-      if (should_sync) {
-        /* Read local timestamp from usage.json (if exists) */
-        uint64_t local_ts = read_local_timestamp();
-        int ret = usb_send_stats_request(local_ts);
-        if (ret >= 0) {
-          /* ret > 0 means bytes sent successfully */
-          g_stats_sync_pending = 1;
-          g_last_stats_sync = now;
-          USB_LOG("Stats request sent");
-        } else {
-          USB_LOG_ERR("Stats request failed", ret);
-        }
-      }
-    } else {
-      /* Poll for stats response from Desktop (data streamed directly to file)
-       */
-      uint64_t remote_ts = 0;
-      size_t bytes_received = 0;
-
-      int resp = usb_poll_stats_response(&remote_ts, NULL, 0, &bytes_received);
-      if (resp == 1) {
-        /* Response complete and verified */
-        USB_LOG("Stats sync complete");
-        USB_LOG_ERR("Bytes received", (int)bytes_received);
-        g_stats_sync_pending = 0;
-        g_stats_sync_done = 1;
-      } else if (resp == -2) {
-        /* Truncated - verification failed, file deleted */
-        USB_LOG("Stats sync FAILED - data truncated, will retry");
-        USB_LOG_ERR("Bytes received", (int)bytes_received);
-        g_stats_sync_pending = 0;
-        /* Don't set g_stats_sync_done so it will retry next interval */
-      } else if (resp < 0 && resp != -1) {
-        /* Other error (but -1 means still waiting) */
-        USB_LOG_ERR("Stats response error", resp);
-        g_stats_sync_pending = 0;
-      }
-      /* resp == 0 means still receiving chunks - continue waiting */
-    }
+    drp_core_sync(&g_core, now);
+
+    usb_log_poll();
 
-    /* Sleep - faster when stats pending to catch incoming chunks */
-    if (g_stats_sync_pending) {
+    /* Sleep - faster when stats pending to catch incoming chunks. More
+     * packets may already be buffered behind this one, so don't sleep at
+     * all after handling one. */
+    if (msg != DRP_MSG_NONE) {
+      /* Next packet right away */
+    } else if (g_core.stats_sync_pending) {
       sceKernelDelayThread(10 * 1000); /* 10ms when waiting for stats */
+    } else if (g_config.event_detect) {
+      /* Idle longer, but wake immediately when a module starts or a
+       * packet comes in */
+      usb_modevents_wait(500 * 1000);
     } else {
       USB_LOG("Thread sleeping...");
       sceKernelDelayThread(100 * 1000); /* 100ms normally */
@@ -451,6 +418,7 @@ static int usb_main_thread(SceSize args, void *argp) {
   }
 
   USB_LOG("USB thread exiting");
+  usb_log_flush();
   return 0;
 }
 
@@ -461,38 +429,60 @@ static int usb_main_thread(SceSize args, void *argp) {
 int module_start(SceSize args, void *argp) {
   int ret;
 
-  /* Load config from INI file first (before any logging) */
-  usb_config_load(&g_config);
-  g_logging_enabled = g_config.enable_logging;
-
-  USB_LOG("USB module starting...");
-
-  /* Check if plugin is enabled */
-  if (!g_config.enabled) {
-    USB_LOG("Plugin disabled in config, exiting");
-    return 1; /* Non-zero = don't keep module loaded */
-  }
-
-  /* Check for startup args with game info from loader */
+  /* Check for startup args with game info from loader. Logged below
+   * once the config says whether logging is on. */
   g_startup_game_id[0] = '\0';
   g_startup_game_title[0] = '\0';
-  if (args >= sizeof(UsbStartupArgs) && argp != NULL) {
+  if (args >= USB_STARTUP_ARGS_BASE_SIZE && argp != NULL) {
     UsbStartupArgs *startup = (UsbStartupArgs *)argp;
     if (startup->magic == USB_STARTUP_MAGIC) {
       strncpy(g_startup_game_id, startup->game_id,
               sizeof(g_startup_game_id) - 1);
       g_startup_game_id[sizeof(g_startup_game_id) - 1] = '\0';
-      USB_LOG("Received game ID from loader");
 
       if (startup->game_title[0] != '\0') {
         strncpy(g_startup_game_title, startup->game_title,
                 sizeof(g_startup_game_title) - 1);
         g_startup_game_title[sizeof(g_startup_game_title) - 1] = '\0';
-        USB_LOG("Received game title from loader");
+      }
+
+      /* argp only lives until module_start returns */
+      if (args >= sizeof(UsbStartupArgs) &&
+          DRP_HANDOFF_VALID(&startup->handoff)) {
+        memcpy(&g_handoff, &startup->handoff, sizeof(g_handoff));
+        g_handoff.title[sizeof(g_handoff.title) - 1] = '\0';
+        g_handoff.game_path[sizeof(g_handoff.game_path) - 1] = '\0';
+        g_handoff.config[g_handoff.config_len] = '\0';
       }
     }
   }
 
+  /* Load config before any logging, from the loader's copy if it sent one */
+  if (g_handoff.flags & DRP_HANDOFF_CONFIG) {
+    usb_config_load_text(&g_config, g_handoff.config);
+  } else {
+    usb_config_load(&g_config);
+  }
+  g_logging_enabled = g_config.enable_logging;
+
+  USB_LOG("USB module starting...");
+  if (g_handoff.flags & DRP_HANDOFF_CONFIG) {
+    USB_LOG("Config received from loader");
+  }
+  if (g_startup_game_id[0] != '\0') {
+    USB_LOG("Received game ID from loader");
+  }
+  if (g_startup_game_title[0] != '\0') {
+    USB_LOG("Received game title from loader");
+  }
+
+  /* Check if plugin is enabled */
+  if (!g_config.enabled) {
+    USB_LOG("Plugin disabled in config, exiting");
+    usb_log_flush();
+    return 1; /* Non-zero = don't keep module loaded */
+  }
+
   USB_LOG("Config loaded, starting USB driver");
 
   /* Vblank wait before USB init (per-game override if available) */
@@ -515,6 +505,7 @@ int module_start(SceSize args, void *argp) {
   ret = usb_driver_init();
   if (ret < 0) {
     USB_LOG_ERR("USB driver init failed", ret);
+    usb_log_flush();
     return 1;
   }
 
@@ -523,9 +514,19 @@ int module_start(SceSize args, void *argp) {
   if (ret < 0) {
     USB_LOG_ERR("USB driver start failed", ret);
     usb_driver_shutdown();
+    usb_log_flush();
     return 1;
   }
 
+  /* Wake the thread on module starts instead of polling */
+  if (g_config.event_detect) {
+    ret = usb_modevents_init();
+    if (ret < 0) {
+      USB_LOG_ERR("Module events unavailable, polling instead", ret);
+      g_config.event_detect = 0;
+    }
+  }
+
   /* Create and start main thread */
   g_running = 1;
   g_thread_id = sceKernelCreateThread(
@@ -542,6 +543,7 @@ int module_start(SceSize args, void *argp) {
   }
 
   USB_LOG("USB module started");
+  usb_log_flush();
   return 0;
 }
 
@@ -559,9 +561,12 @@ int module_stop(SceSize args, void *argp) {
     g_thread_id = -1;
   }
 
+  usb_modevents_shutdown();
+
   /* Shutdown USB */
   usb_driver_shutdown();
 
   USB_LOG("USB module stopped");
+  usb_log_flush();
   return 0;
 }
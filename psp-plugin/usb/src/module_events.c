@@ -0,0 +1,98 @@
+/**
+ * Module Start Events Implementation
+ *
+ * Uses SystemControl's sctrlHENSetStartModuleHandler (stub in
+ * systemctrl.S). The handler runs in the context of whoever is loading the
+ * module, so it only bumps a counter and sets an event flag - all the real
+ * work happens later on the USB thread.
+ */
+
+#include <pspkernel.h>
+#include <string.h>
+
+#include "module_events.h"
+#include "usb_driver.h"
+
+/* Event flag bits: set by the handler, and by usb_modevents_wake */
+#define MODEVT_STARTED 0x0001
+#define MODEVT_WAKE 0x0002
+
+/* SystemControl API - handler receives a SceModule2 we never look inside */
+typedef int (*StartModuleHandler)(void *module);
+StartModuleHandler sctrlHENSetStartModuleHandler(StartModuleHandler handler);
+
+static StartModuleHandler g_prev_handler = NULL;
+static SceUID g_modevt_flag = -1;
+static volatile uint32_t g_generation = 0;
+static int g_installed = 0;
+
+/**
+ * Called by SystemControl before every module start
+ */
+static int on_module_start(void *module) {
+  g_generation++;
+  if (g_modevt_flag >= 0) {
+    sceKernelSetEventFlag(g_modevt_flag, MODEVT_STARTED);
+  }
+
+  /* Keep other plugins' handlers working */
+  if (g_prev_handler != NULL) {
+    return g_prev_handler(module);
+  }
+  return 0;
+}
+
+int usb_modevents_init(void) {
+  if (g_installed) {
+    return 0;
+  }
+
+  g_modevt_flag = sceKernelCreateEventFlag("PSPDRP_ModEvt", 0, 0, NULL);
+  if (g_modevt_flag < 0) {
+    USB_LOG_ERR("Failed to create module event flag", g_modevt_flag);
+    return g_modevt_flag;
+  }
+
+  g_prev_handler = sctrlHENSetStartModuleHandler(on_module_start);
+  g_installed = 1;
+
+  USB_LOG("Module start handler installed");
+  return 0;
+}
+
+void usb_modevents_shutdown(void) {
+  if (g_installed) {
+    sctrlHENSetStartModuleHandler(g_prev_handler);
+    g_prev_handler = NULL;
+    g_installed = 0;
+  }
+
+  if (g_modevt_flag >= 0) {
+    sceKernelDeleteEventFlag(g_modevt_flag);
+    g_modevt_flag = -1;
+  }
+}
+
+uint32_t usb_modevents_generation(void) { return g_generation; }
+
+void usb_modevents_wake(void) {
+  if (g_modevt_flag >= 0) {
+    sceKernelSetEventFlag(g_modevt_flag, MODEVT_WAKE);
+  }
+}
+
+int usb_modevents_wait(uint32_t timeout_us) {
+  SceUInt timeout = timeout_us;
+  u32 bits = 0;
+  int ret;
+
+  if (g_modevt_flag < 0) {
+    sceKernelDelayThread(timeout_us);
+    return 0;
+  }
+
+  ret = sceKernelWaitEventFlag(g_modevt_flag, MODEVT_STARTED | MODEVT_WAKE,
+                               PSP_EVENT_WAITOR | PSP_EVENT_WAITCLEAR, &bits,
+                               &timeout);
+  return (ret >= 0) ? 1 : 0;
+}
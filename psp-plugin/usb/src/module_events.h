@@ -0,0 +1,46 @@
+/**
+ * Module Start Events (Kernel)
+ *
+ * Hooks the CFW start-module handler so the USB thread is woken as soon as
+ * a module starts, instead of polling for game changes on a fixed timer.
+ */
+
+#ifndef MODULE_EVENTS_H
+#define MODULE_EVENTS_H
+
+#include <stdint.h>
+
+/**
+ * Install the start-module handler (chains any previously installed one)
+ *
+ * @return 0 on success, negative on error
+ */
+int usb_modevents_init(void);
+
+/**
+ * Restore the previous start-module handler and free the event flag
+ */
+void usb_modevents_shutdown(void);
+
+/**
+ * Number of module starts seen since init. Compare against a saved value
+ * to find out whether detection needs to run.
+ */
+uint32_t usb_modevents_generation(void);
+
+/**
+ * Wake a thread in usb_modevents_wait without counting a module start.
+ * Safe to call from interrupt context (USB transfer callbacks).
+ */
+void usb_modevents_wake(void);
+
+/**
+ * Sleep until a module starts, usb_modevents_wake is called or the timeout
+ * expires. Falls back to a plain delay when the handler is not installed.
+ *
+ * @param timeout_us Maximum wait in microseconds
+ * @return 1 if woken early, 0 on timeout
+ */
+int usb_modevents_wait(uint32_t timeout_us);
+
+#endif /* MODULE_EVENTS_H */
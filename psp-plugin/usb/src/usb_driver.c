@@ -6,35 +6,73 @@
  * communication with the desktop companion.
  */
 
+#include <pspintrman.h>
 #include <pspkernel.h>
 #include <pspusb.h>
 #include <pspusbbus.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "drp_metrics.h"
+#include "module_events.h"
 #include "usb_driver.h"
+#include "usb_protocol.h"
 
-/* Debug logging - writes to log file on memory stick */
-#define USB_LOG_FILE "ms0:/psp_drp.log"
+/*
+ * Debug logging - lines are collected in RAM and written to the memory stick
+ * in batches by the USB thread (see usb_log_poll). Nothing here touches the
+ * memory stick directly, so the attach/detach callbacks can log safely.
+ */
+
+/* Space kept free in every buffer for the "lines dropped" notice */
+#define USB_LOG_DROP_RESERVE 40
+
+static char g_log_buf[2][USB_LOG_BUFFER_SIZE];
+static int g_log_len[2] = {0, 0};
+static int g_log_active = 0;
+static int g_log_flushing = 0;
+static unsigned int g_log_dropped = 0;
+static SceUID g_log_flush_thread = -1;
+static unsigned int g_log_last_flush = 0;
+
+/* Append raw bytes to the active buffer (interrupt-safe) */
+static void usb_log_append(const char *data, int len) {
+  int intr;
+  int active;
+  int need_flush;
+
+  intr = sceKernelCpuSuspendIntr();
+  active = g_log_active;
+  if (g_log_len[active] + len > USB_LOG_BUFFER_SIZE - USB_LOG_DROP_RESERVE) {
+    g_log_dropped++;
+  } else {
+    memcpy(&g_log_buf[active][g_log_len[active]], data, len);
+    g_log_len[active] += len;
+  }
+  need_flush = g_log_len[active] >= USB_LOG_FLUSH_HIGH_WATER;
+  sceKernelCpuResumeIntr(intr);
+
+  /* Only the USB thread writes the log file on its own */
+  if (need_flush && g_log_flush_thread >= 0 &&
+      sceKernelGetThreadId() == g_log_flush_thread) {
+    usb_log_flush();
+  }
+}
 
 /* Log function implementations - declarations in usb_driver.h */
 void usb_log_str(const char *msg) {
-  SceUID fd;
-  int len = 0;
+  char buf[128];
+  int i = 0;
   const char *p = msg;
-  while (*p++)
-    len++;
 
-  fd = sceIoOpen(USB_LOG_FILE, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_APPEND, 0777);
-  if (fd >= 0) {
-    sceIoWrite(fd, msg, len);
-    sceIoWrite(fd, "\n", 1);
-    sceIoClose(fd);
-  }
+  while (*p && i < (int)sizeof(buf) - 1)
+    buf[i++] = *p++;
+  buf[i++] = '\n';
+
+  usb_log_append(buf, i);
 }
 
 void usb_log_hex(const char *prefix, int val) {
-  SceUID fd;
   char buf[64];
   int i = 0;
   const char *p = prefix;
@@ -54,11 +92,74 @@ void usb_log_hex(const char *prefix, int val) {
   buf[i++] = hex[val & 0xF];
   buf[i++] = '\n';
 
+  usb_log_append(buf, i);
+}
+
+void usb_log_set_flush_thread(void) {
+  g_log_flush_thread = sceKernelGetThreadId();
+}
+
+void usb_log_flush(void) {
+  SceUID fd;
+  int intr;
+  int idx;
+  unsigned int dropped;
+
+  intr = sceKernelCpuSuspendIntr();
+  if (g_log_flushing ||
+      (g_log_len[g_log_active] == 0 && g_log_dropped == 0)) {
+    sceKernelCpuResumeIntr(intr);
+    return;
+  }
+  idx = g_log_active;
+  g_log_active ^= 1;
+  dropped = g_log_dropped;
+  g_log_dropped = 0;
+  g_log_flushing = 1;
+  sceKernelCpuResumeIntr(intr);
+
+  if (dropped > 0) {
+    /* No snprintf in kernel libc - build "[USB] dropped lines 0x..." */
+    const char *msg = "[USB] dropped lines 0x";
+    const char *hex = "0123456789ABCDEF";
+    char *out = &g_log_buf[idx][g_log_len[idx]];
+    int n = 0;
+    int shift;
+
+    while (*msg)
+      out[n++] = *msg++;
+    for (shift = 28; shift >= 0; shift -= 4)
+      out[n++] = hex[(dropped >> shift) & 0xF];
+    out[n++] = '\n';
+    g_log_len[idx] += n;
+  }
+
   fd = sceIoOpen(USB_LOG_FILE, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_APPEND, 0777);
   if (fd >= 0) {
-    sceIoWrite(fd, buf, i);
+    sceIoWrite(fd, g_log_buf[idx], g_log_len[idx]);
     sceIoClose(fd);
   }
+
+  intr = sceKernelCpuSuspendIntr();
+  g_log_len[idx] = 0;
+  g_log_flushing = 0;
+  sceKernelCpuResumeIntr(intr);
+
+  g_log_last_flush = sceKernelGetSystemTimeLow();
+}
+
+void usb_log_poll(void) {
+  int pending = g_log_len[g_log_active];
+
+  if (pending == 0 && g_log_dropped == 0) {
+    return;
+  }
+
+  if (pending >= USB_LOG_FLUSH_HIGH_WATER ||
+      (sceKernelGetSystemTimeLow() - g_log_last_flush) >=
+          USB_LOG_FLUSH_INTERVAL_US) {
+    usb_log_flush();
+  }
 }
 
 /* Note: USB_LOG and USB_LOG_ERR macros are now defined in usb_driver.h */
@@ -232,9 +333,36 @@ static UsbDriverState g_state = USB_STATE_UNINITIALIZED;
 static struct UsbdDeviceReq g_bulkin_req;
 static struct UsbdDeviceReq g_bulkout_req;
 
-/* Transfer buffers (aligned for DMA) */
-static u8 g_sendbuf[USB_MAX_PACKET_SIZE] __attribute__((aligned(64)));
-static u8 g_recvbuf[USB_MAX_PACKET_SIZE] __attribute__((aligned(64)));
+/*
+ * Bulk pipeline. Sends are queued in USB_TX_SLOTS buffers and drained in
+ * order from the bulk IN completion callback; one of USB_RX_SLOTS receive
+ * buffers is always posted on bulk OUT, so packets from the desktop land
+ * while the USB thread is busy elsewhere. The callbacks run in interrupt
+ * context, so the thread side updates the queues with interrupts suspended.
+ */
+typedef struct {
+  u8 data[USB_MAX_FRAME_SIZE] __attribute__((aligned(64))); /* DMA */
+  int len;
+} UsbSlot;
+
+static UsbSlot g_tx[USB_TX_SLOTS];
+static int g_tx_tail = 0;  /* Oldest queued slot (in flight if busy) */
+static int g_tx_count = 0; /* Queued slots */
+static int g_tx_busy = 0;  /* Request submitted for g_tx[g_tx_tail] */
+
+static UsbSlot g_rx[USB_RX_SLOTS];
+static int g_rx_tail = 0;   /* Oldest received slot */
+static int g_rx_count = 0;  /* Received slots not yet read */
+static int g_rx_posted = 0; /* Request posted for the slot after them */
+
+/* Receive request size. A v1 desktop sends exact 512-byte packets with no
+ * zero-length packet, which would never complete a larger request, so
+ * requests stay at one max packet until the desktop flags a packet with
+ * USB_FLAG_FRAMES. */
+static int g_rx_size = USB_MAX_PACKET_SIZE;
+
+/* 1 while the pipeline has been used on the current connection */
+static int g_pipe_live = 0;
 
 /*============================================================================
  * USB Driver Callbacks
@@ -385,22 +513,147 @@ static struct UsbDriver g_usb_driver = {
  * Transfer Callbacks
  *============================================================================*/
 
+static int bulkin_done_cb(struct UsbdDeviceReq *req, int arg1, int arg2);
+static int bulkout_done_cb(struct UsbdDeviceReq *req, int arg1, int arg2);
+
+/* Submit the oldest queued send unless one is in flight (interrupts off) */
+static void tx_submit(void) {
+  UsbSlot *slot;
+  int ret;
+
+  if (g_tx_busy || g_tx_count == 0) {
+    return;
+  }
+
+  slot = &g_tx[g_tx_tail];
+  memset(&g_bulkin_req, 0, sizeof(g_bulkin_req));
+  g_bulkin_req.endp = &g_endpoints[1]; /* Bulk IN */
+  g_bulkin_req.data = slot->data;
+  g_bulkin_req.size = slot->len;
+  g_bulkin_req.func = bulkin_done_cb;
+
+  ret = sceUsbbdReqSend(&g_bulkin_req);
+  if (ret < 0) {
+    /* Drop it rather than retry forever from the callback */
+    USB_LOG_ERR("Bulk send submit failed", ret);
+    g_tx_tail = (g_tx_tail + 1) % USB_TX_SLOTS;
+    g_tx_count--;
+    return;
+  }
+  g_tx_busy = 1;
+}
+
+/* Post a receive into the next free slot unless one is posted (interrupts
+ * off). With every slot full it stays unposted until the thread reads. */
+static void rx_post(void) {
+  UsbSlot *slot;
+  int ret;
+
+  if (g_rx_posted || g_rx_count == USB_RX_SLOTS) {
+    return;
+  }
+
+  slot = &g_rx[(g_rx_tail + g_rx_count) % USB_RX_SLOTS];
+  sceKernelDcacheInvalidateRange(slot->data, g_rx_size);
+
+  memset(&g_bulkout_req, 0, sizeof(g_bulkout_req));
+  g_bulkout_req.endp = &g_endpoints[2]; /* Bulk OUT */
+  g_bulkout_req.data = slot->data;
+  g_bulkout_req.size = g_rx_size;
+  g_bulkout_req.func = bulkout_done_cb;
+
+  ret = sceUsbbdReqRecv(&g_bulkout_req);
+  if (ret < 0) {
+    USB_LOG_ERR("Bulk recv submit failed", ret);
+    return;
+  }
+  g_rx_posted = 1;
+}
+
 static int bulkin_done_cb(struct UsbdDeviceReq *req, int arg1, int arg2) {
-  (void)req;
   (void)arg1;
   (void)arg2;
+
+  if (g_tx_busy) {
+    if (req->retcode != 0) {
+      USB_LOG_ERR("Bulk send failed", req->retcode);
+    }
+    g_tx_busy = 0;
+    g_tx_tail = (g_tx_tail + 1) % USB_TX_SLOTS;
+    g_tx_count--;
+    tx_submit();
+  }
   sceKernelSetEventFlag(g_trans_event, USB_TRANS_BULKIN_DONE);
   return 0;
 }
 
 static int bulkout_done_cb(struct UsbdDeviceReq *req, int arg1, int arg2) {
-  (void)req;
   (void)arg1;
   (void)arg2;
+
+  if (!g_rx_posted) {
+    return 0; /* Cancelled by a pipeline reset */
+  }
+  g_rx_posted = 0;
+
+  /* On an error (cable pulled, cancelled) the thread reposts next read */
+  if (req->retcode == 0) {
+    if (req->recvsize > 0) {
+      UsbSlot *slot = &g_rx[(g_rx_tail + g_rx_count) % USB_RX_SLOTS];
+      const UsbPacketHeader *header = (const UsbPacketHeader *)slot->data;
+
+      slot->len = req->recvsize;
+      g_rx_count++;
+
+      /* Switch before reposting so the next request can take a frame */
+      if (req->recvsize >= (int)sizeof(UsbPacketHeader) &&
+          header->magic == USB_PACKET_MAGIC &&
+          (header->flags & USB_FLAG_FRAMES)) {
+        g_rx_size = USB_MAX_FRAME_SIZE;
+      }
+
+      /* Don't leave it queued behind an idle wait */
+      usb_modevents_wake();
+    }
+    rx_post();
+  }
   sceKernelSetEventFlag(g_trans_event, USB_TRANS_BULKOUT_DONE);
   return 0;
 }
 
+/* Cancel everything in flight and empty both queues */
+static void pipeline_reset(void) {
+  int intr;
+
+  sceUsbbdReqCancelAll(&g_endpoints[1]);
+  sceUsbbdReqCancelAll(&g_endpoints[2]);
+
+  intr = sceKernelCpuSuspendIntr();
+  g_tx_tail = 0;
+  g_tx_count = 0;
+  g_tx_busy = 0;
+  g_rx_tail = 0;
+  g_rx_count = 0;
+  g_rx_posted = 0;
+  g_rx_size = USB_MAX_PACKET_SIZE; /* The next desktop may be v1 */
+  g_pipe_live = 0;
+  sceKernelCpuResumeIntr(intr);
+}
+
+/* Check the link; a dropped connection resets the pipeline once */
+static int pipeline_connected(void) {
+  /* Check connection using sceUsbGetState since attach callback may not fire */
+  if (sceUsbGetState() & 0x0020) {
+    g_pipe_live = 1;
+    return 1;
+  }
+  if (g_pipe_live) {
+    USB_LOG("Connection lost, resetting bulk pipeline");
+    pipeline_reset();
+  }
+  return 0;
+}
+
 /*============================================================================
  * Public API Implementation
  *============================================================================*/
@@ -477,6 +730,7 @@ void usb_driver_stop(void) {
 
   USB_LOG("Stopping USB...");
 
+  pipeline_reset();
   sceUsbDeactivate(DRIVER_PID);
   sceUsbStop(DRIVER_NAME, 0, 0);
   sceUsbStop(PSP_USBBUS_DRIVERNAME, 0, 0);
@@ -512,103 +766,114 @@ int usb_driver_is_connected(void) {
 
 UsbDriverState usb_driver_get_state(void) { return g_state; }
 
+int usb_driver_peer_frames(void) { return g_rx_size == USB_MAX_FRAME_SIZE; }
+
 /*============================================================================
  * Bulk Transfer Functions
  *============================================================================*/
 
 int usb_bulk_send(const void *data, int len) {
   u32 result;
+  SceUInt timeout;
+  UsbSlot *slot;
+  int intr;
+  int full;
   int ret;
 
-  /* Check connection using sceUsbGetState since attach callback may not fire */
-  if (!(sceUsbGetState() & 0x0020)) {
+  if (!pipeline_connected()) {
     return -1;
   }
 
-  if (len > USB_MAX_PACKET_SIZE) {
-    len = USB_MAX_PACKET_SIZE;
+  if (len > USB_MAX_FRAME_SIZE - 1) {
+    len = USB_MAX_FRAME_SIZE - 1;
   }
 
-  memcpy(g_sendbuf, data, len);
-  sceKernelDcacheWritebackRange(g_sendbuf, len);
-
-  sceKernelClearEventFlag(g_trans_event, ~USB_TRANS_BULKIN_DONE);
-
-  memset(&g_bulkin_req, 0, sizeof(g_bulkin_req));
-  g_bulkin_req.endp = &g_endpoints[1]; /* Bulk IN */
-  g_bulkin_req.data = g_sendbuf;
-  g_bulkin_req.size = len;
-  g_bulkin_req.func = bulkin_done_cb;
-
-  ret = sceUsbbdReqSend(&g_bulkin_req);
-  if (ret < 0) {
-    USB_LOG_ERR("Bulk send submit failed", ret);
-    return ret;
+  /* Wait for a free slot. The flag is cleared before looking so a
+   * completion in between still wakes the wait. */
+  for (;;) {
+    sceKernelClearEventFlag(g_trans_event, ~USB_TRANS_BULKIN_DONE);
+    intr = sceKernelCpuSuspendIntr();
+    full = (g_tx_count == USB_TX_SLOTS);
+    sceKernelCpuResumeIntr(intr);
+    if (!full) {
+      break;
+    }
+
+    timeout = USB_TX_TIMEOUT_US;
+    ret = sceKernelWaitEventFlag(g_trans_event, USB_TRANS_BULKIN_DONE,
+                                 PSP_EVENT_WAITOR | PSP_EVENT_WAITCLEAR,
+                                 &result, &timeout);
+    if (ret < 0) {
+      USB_LOG_ERR("Bulk send wait failed", ret);
+      return ret;
+    }
   }
 
-  ret = sceKernelWaitEventFlag(g_trans_event, USB_TRANS_BULKIN_DONE,
-                               PSP_EVENT_WAITOR | PSP_EVENT_WAITCLEAR, &result,
-                               NULL);
-  if (ret < 0) {
-    USB_LOG_ERR("Bulk send wait failed", ret);
-    return ret;
+  /* Only this thread queues, and the callback never touches a free slot */
+  slot = &g_tx[(g_tx_tail + g_tx_count) % USB_TX_SLOTS];
+  memcpy(slot->data, data, len);
+  if ((len & 63) == 0) {
+    slot->data[len++] = 0; /* Never end on a full packet */
   }
+  slot->len = len;
+  sceKernelDcacheWritebackRange(slot->data, len);
+
+  intr = sceKernelCpuSuspendIntr();
+  g_tx_count++;
+  tx_submit();
+  sceKernelCpuResumeIntr(intr);
 
   return len;
 }
 
 int usb_bulk_recv(void *data, int maxlen) {
-  u32 result;
-  int ret;
-  u32 upper_size;
+  UsbSlot *slot;
+  int intr;
+  int len;
 
-  /* Check connection using sceUsbGetState since attach callback may not fire */
-  if (!(sceUsbGetState() & 0x0020)) {
+  if (!pipeline_connected()) {
     return -1;
   }
 
-  if (maxlen > USB_MAX_PACKET_SIZE) {
-    maxlen = USB_MAX_PACKET_SIZE;
-  }
-
-  upper_size = (maxlen + 0x3F) & 0xFFFFFFC0;
-  sceKernelDcacheInvalidateRange(g_recvbuf, upper_size);
-
-  sceKernelClearEventFlag(g_trans_event, ~USB_TRANS_BULKOUT_DONE);
-
-  memset(&g_bulkout_req, 0, sizeof(g_bulkout_req));
-  g_bulkout_req.endp = &g_endpoints[2]; /* Bulk OUT */
-  g_bulkout_req.data = g_recvbuf;
-  g_bulkout_req.size = maxlen;
-  g_bulkout_req.func = bulkout_done_cb;
-
-  ret = sceUsbbdReqRecv(&g_bulkout_req);
-  if (ret < 0) {
-    USB_LOG_ERR("Bulk recv submit failed", ret);
-    return ret;
+  intr = sceKernelCpuSuspendIntr();
+  rx_post();
+  len = g_rx_count;
+  sceKernelCpuResumeIntr(intr);
+  if (len == 0) {
+    return 0;
   }
 
-  ret = sceKernelWaitEventFlag(g_trans_event, USB_TRANS_BULKOUT_DONE,
-                               PSP_EVENT_WAITOR | PSP_EVENT_WAITCLEAR, &result,
-                               NULL);
-  if (ret < 0) {
-    USB_LOG_ERR("Bulk recv wait failed", ret);
-    return ret;
+  /* The callback only fills slots past the ones counted */
+  slot = &g_rx[g_rx_tail];
+  len = slot->len;
+  if (len > maxlen) {
+    len = maxlen;
   }
+  memcpy(data, slot->data, len);
 
-  if (g_bulkout_req.retcode == 0 && g_bulkout_req.recvsize > 0) {
-    memcpy(data, g_recvbuf, g_bulkout_req.recvsize);
-    return g_bulkout_req.recvsize;
-  }
+  intr = sceKernelCpuSuspendIntr();
+  g_rx_tail = (g_rx_tail + 1) % USB_RX_SLOTS;
+  g_rx_count--;
+  rx_post(); /* In case every slot was full */
+  sceKernelCpuResumeIntr(intr);
 
-  return -1;
+  return len;
 }
 
 int usb_driver_send(const void *data, int len) {
-  return usb_bulk_send(data, len);
+  int ret = usb_bulk_send(data, len);
+
+  drp_metrics_tx(ret, (uint32_t)len);
+  return ret;
 }
 
 int usb_driver_receive(void *data, int len, int timeout_ms) {
+  int ret;
+
   (void)timeout_ms;
-  return usb_bulk_recv(data, len);
+  ret = usb_bulk_recv(data, len);
+  if (ret > 0) {
+    drp_metrics_rx((uint32_t)ret);
+  }
+  return ret;
 }
@@ -17,10 +17,36 @@
 /* USB log file path */
 #define USB_LOG_FILE "ms0:/psp_drp.log"
 
+/* Each of the two RAM log buffers (active + being flushed) */
+#define USB_LOG_BUFFER_SIZE 2048
+
+/* Flush pending lines at least this often */
+#define USB_LOG_FLUSH_INTERVAL_US (5 * 1000 * 1000)
+
+/* Flush early once the active buffer is this full */
+#define USB_LOG_FLUSH_HIGH_WATER (USB_LOG_BUFFER_SIZE * 3 / 4)
+
 /* Logging function declarations (implemented in usb_driver.c) */
 void usb_log_str(const char *msg);
 void usb_log_hex(const char *prefix, int val);
 
+/**
+ * Mark the calling thread as the log writer. Lines logged from it trigger
+ * an inline flush at the high-water mark; other contexts only buffer.
+ */
+void usb_log_set_flush_thread(void);
+
+/**
+ * Write all buffered log lines to USB_LOG_FILE in one sceIoWrite
+ */
+void usb_log_flush(void);
+
+/**
+ * Flush if the interval elapsed or the buffer is filling up.
+ * Called once per USB thread loop iteration.
+ */
+void usb_log_poll(void);
+
 /* Logging flag - set by main.c from config */
 extern int g_logging_enabled;
 
@@ -50,6 +76,17 @@ extern int g_logging_enabled;
 /* Max packet size for bulk transfers (high-speed) */
 #define USB_MAX_PACKET_SIZE 512
 
+/* Largest single bulk request (one v2 frame); the USB stack splits it into
+ * max-packet-size transactions */
+#define USB_MAX_FRAME_SIZE 4096
+
+/* Bulk pipeline depth: queued sends and buffered receives */
+#define USB_TX_SLOTS 4
+#define USB_RX_SLOTS 4
+
+/* Longest usb_bulk_send waits for a free send slot */
+#define USB_TX_TIMEOUT_US (1000 * 1000)
+
 /* USB Driver States */
 typedef enum {
   USB_STATE_UNINITIALIZED = 0,
@@ -100,20 +137,33 @@ int usb_driver_is_connected(void);
 UsbDriverState usb_driver_get_state(void);
 
 /**
- * Send raw data over USB bulk IN endpoint
+ * Check whether the desktop has flagged a packet with USB_FLAG_FRAMES on
+ * this connection (receives are posted as full frames from then on)
+ *
+ * @return 1 if v2 frames may be sent, 0 otherwise
+ */
+int usb_driver_peer_frames(void);
+
+/**
+ * Queue raw data for the USB bulk IN endpoint (up to USB_MAX_FRAME_SIZE)
+ * Returns once the data is queued; only waits (up to USB_TX_TIMEOUT_US)
+ * while all USB_TX_SLOTS are in use. A length that is a multiple of 64 gets
+ * one zero byte appended so the transfer always ends in a short packet and
+ * the host never merges it with the next one.
  *
  * @param data Data to send
  * @param len Length of data
- * @return Bytes sent on success, negative on error
+ * @return Bytes queued on success, negative on error
  */
 int usb_bulk_send(const void *data, int len);
 
 /**
- * Receive raw data from USB bulk OUT endpoint
+ * Take the oldest packet received on the USB bulk OUT endpoint
+ * Never blocks; a receive is kept posted in the background.
  *
  * @param data Buffer for received data
  * @param maxlen Maximum bytes to receive
- * @return Bytes received on success, negative on error
+ * @return Bytes received, 0 if nothing has arrived, negative on error
  */
 int usb_bulk_recv(void *data, int maxlen);
 
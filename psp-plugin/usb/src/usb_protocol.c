@@ -11,25 +11,296 @@
 /* NOTE: Stats sync disabled in USB kernel mode - stdlib functions not available
  */
 
+#include "icon_cache.h"
 #include "usb_driver.h"
 #include "usb_protocol.h"
 
 /*============================================================================
- * Stats Streaming State (write chunks directly to file as received)
+ * Stats Response Staging
+ * Chunks are reassembled in RAM by index and the file is only replaced once
+ * all of them are in: one write to a temp file, then a rename. A delta
+ * response leaves the file alone.
  *============================================================================*/
 
 #define USAGE_LOG_PATH "ms0:/seplugins/pspdrp/usage_log.json"
+#define USAGE_LOG_TMP_PATH "ms0:/seplugins/pspdrp/usage_log.tmp"
+#define STATS_STAGE_SIZE (16 * 1024)
+#define STATS_STAGE_MAX_CHUNKS                                                 \
+  ((STATS_STAGE_SIZE + USB_STATS_CHUNK_SIZE - 1) / USB_STATS_CHUNK_SIZE)
 
+static uint8_t g_stats_stage[STATS_STAGE_SIZE];
 static struct {
-  SceUID fd;              /* File handle for streaming writes */
-  uint32_t total_bytes;   /* Expected total bytes (from first chunk) */
-  uint32_t bytes_written; /* Actual bytes written so far */
+  uint32_t total_bytes;    /* Expected total bytes (from any chunk) */
+  uint32_t bytes_received; /* Payload bytes staged so far */
   uint16_t total_chunks;
   uint16_t received_chunks;
   uint64_t last_updated;
+  uint8_t have[(STATS_STAGE_MAX_CHUNKS + 7) / 8]; /* Received bitmap */
   int active;
-  int verified; /* 1 if bytes match, 0 if failed */
-} g_stats_stream = {.fd = -1, .active = 0};
+  int complete; /* All chunks in and commit attempted */
+  int verified; /* 1 if committed to file, 0 if failed */
+} g_stats_stream;
+
+/**
+ * Write the staged stats to a temp file in one go and swap it in
+ */
+static int stats_stage_commit(void) {
+  SceUID fd;
+  int written;
+
+  /* Nothing on the desktop side - keep whatever we have */
+  if (g_stats_stream.total_bytes == 0) {
+    return 0;
+  }
+
+  /* Desktop says our copy is current */
+  if (g_stats_stream.total_bytes >= 4 &&
+      strncmp((const char *)g_stats_stage, USB_STATS_DELTA_MAGIC, 4) == 0) {
+    return 0;
+  }
+
+  fd = sceIoOpen(USAGE_LOG_TMP_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC,
+                 0777);
+  if (fd < 0) {
+    return -1;
+  }
+  written = sceIoWrite(fd, g_stats_stage, g_stats_stream.total_bytes);
+  sceIoClose(fd);
+
+  if (written != (int)g_stats_stream.total_bytes) {
+    sceIoRemove(USAGE_LOG_TMP_PATH);
+    return -1;
+  }
+
+  /* FAT rename won't replace an existing file */
+  sceIoRemove(USAGE_LOG_PATH);
+  return (sceIoRename(USAGE_LOG_TMP_PATH, USAGE_LOG_PATH) < 0) ? -1 : 0;
+}
+
+/**
+ * Stage one piece of a stats response, committing once all are in. v1
+ * chunks and v2 frames both land here; index is the piece number and
+ * offset where its data goes.
+ */
+static void stats_stage_piece(uint64_t last_updated, uint32_t total_bytes,
+                              uint16_t total_chunks, uint16_t index,
+                              uint32_t offset, const uint8_t *data,
+                              uint32_t length) {
+  /* A different transfer (or the first piece of one) starts over */
+  if (!g_stats_stream.active || g_stats_stream.last_updated != last_updated ||
+      g_stats_stream.total_chunks != total_chunks ||
+      g_stats_stream.total_bytes != total_bytes) {
+    memset(&g_stats_stream, 0, sizeof(g_stats_stream));
+    g_stats_stream.total_bytes = total_bytes;
+    g_stats_stream.total_chunks = total_chunks;
+    g_stats_stream.last_updated = last_updated;
+    g_stats_stream.active = 1;
+
+    if (total_bytes > STATS_STAGE_SIZE ||
+        total_chunks > STATS_STAGE_MAX_CHUNKS) {
+      USB_LOG_ERR("Stats response too large", (int)total_bytes);
+      g_stats_stream.complete = 1;
+      return;
+    }
+  }
+
+  if (g_stats_stream.complete || index >= g_stats_stream.total_chunks ||
+      offset > g_stats_stream.total_bytes ||
+      length > g_stats_stream.total_bytes - offset ||
+      (g_stats_stream.have[index >> 3] >> (index & 7)) & 1) {
+    return; /* Done, bogus or duplicate */
+  }
+
+  memcpy(&g_stats_stage[offset], data, length);
+  g_stats_stream.have[index >> 3] |= (uint8_t)(1 << (index & 7));
+  g_stats_stream.received_chunks++;
+  g_stats_stream.bytes_received += length;
+
+  if (g_stats_stream.received_chunks < g_stats_stream.total_chunks) {
+    return;
+  }
+
+  /* All pieces in - verify and write the file once */
+  g_stats_stream.complete = 1;
+  if (g_stats_stream.bytes_received == g_stats_stream.total_bytes &&
+      stats_stage_commit() == 0) {
+    g_stats_stream.verified = 1;
+  }
+}
+
+/* v1 response chunk (USB_STATS_CHUNK_SIZE bytes each) */
+static void stats_stage_chunk(const UsbStatsResponsePacket *resp) {
+  if (resp->data_length > USB_STATS_CHUNK_SIZE) {
+    return;
+  }
+  stats_stage_piece(resp->last_updated, resp->total_bytes, resp->total_chunks,
+                    resp->chunk_index,
+                    (uint32_t)resp->chunk_index * USB_STATS_CHUNK_SIZE,
+                    resp->data, resp->data_length);
+}
+
+/* v2 response frame (USB_FRAME_DATA_SIZE bytes each) */
+static void stats_stage_frame(const UsbFrameHeader *frame, int frame_len) {
+  uint32_t length;
+  uint32_t chunks;
+
+  if (frame->header.length < USB_FRAME_FIELDS_SIZE ||
+      frame->header.length > frame_len - sizeof(UsbPacketHeader) ||
+      frame->offset % USB_FRAME_DATA_SIZE != 0) {
+    return;
+  }
+  length = frame->header.length - USB_FRAME_FIELDS_SIZE;
+  chunks = (frame->total_size + USB_FRAME_DATA_SIZE - 1) / USB_FRAME_DATA_SIZE;
+  if (length > USB_FRAME_DATA_SIZE || chunks > 0xFFFF) {
+    return;
+  }
+
+  stats_stage_piece(frame->tag, frame->total_size, (uint16_t)chunks,
+                    (uint16_t)(frame->offset / USB_FRAME_DATA_SIZE),
+                    frame->offset, (const uint8_t *)(frame + 1), length);
+}
+
+/**
+ * Send a transfer as v2 frames, one bulk request each. The driver queues
+ * them, so this only waits while its send slots are full.
+ */
+static int send_frames(uint8_t type, const char *id, const uint8_t *data,
+                       uint32_t size, uint64_t tag) {
+  static uint8_t frame_buf[USB_MAX_FRAME];
+  UsbFrameHeader *frame = (UsbFrameHeader *)frame_buf;
+  uint32_t offset = 0;
+  uint32_t length;
+  int ret;
+
+  while (offset < size) {
+    length = size - offset;
+    if (length > USB_FRAME_DATA_SIZE) {
+      length = USB_FRAME_DATA_SIZE;
+    }
+
+    memset(frame, 0, sizeof(UsbFrameHeader));
+    frame->header.magic = USB_PACKET_MAGIC;
+    frame->header.type = type;
+    frame->header.flags = USB_FLAG_FRAMES;
+    frame->header.length = (uint16_t)(USB_FRAME_FIELDS_SIZE + length);
+    if (id) {
+      strncpy(frame->id, id, sizeof(frame->id) - 1);
+    }
+    frame->total_size = size;
+    frame->offset = offset;
+    frame->tag = tag;
+    memcpy(frame + 1, data + offset, length);
+
+    ret = usb_driver_send(frame_buf, (int)(sizeof(UsbFrameHeader) + length));
+    if (ret < 0) {
+      return ret;
+    }
+    offset += length;
+  }
+
+  return 0;
+}
+
+/**
+ * Send an icon as v1 chunks for a desktop that has not advertised frames
+ */
+static int send_icon_chunks(const char *game_id, const uint8_t *icon_data,
+                            uint32_t icon_size) {
+  UsbIconChunkPacket pkt;
+  uint32_t offset = 0;
+  int chunk_num = 0;
+  int total_chunks;
+  int ret;
+
+  if (icon_size > 0xFFFF) {
+    return -3; /* Does not fit the v1 total_size field */
+  }
+
+  total_chunks = (icon_size + USB_ICON_CHUNK_SIZE - 1) / USB_ICON_CHUNK_SIZE;
+  if (total_chunks > 255) {
+    return -3;
+  }
+
+  while (offset < icon_size) {
+    uint32_t chunk_size = icon_size - offset;
+    if (chunk_size > USB_ICON_CHUNK_SIZE) {
+      chunk_size = USB_ICON_CHUNK_SIZE;
+    }
+
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.header.magic = USB_PACKET_MAGIC;
+    pkt.header.type = USB_PKT_ICON_CHUNK;
+    pkt.header.length = sizeof(pkt) - sizeof(UsbPacketHeader);
+    if (game_id) {
+      strncpy(pkt.game_id, game_id, sizeof(pkt.game_id) - 1);
+    }
+    pkt.total_size = (uint16_t)icon_size;
+    pkt.chunk_offset = (uint16_t)offset;
+    pkt.chunk_size = (uint16_t)chunk_size;
+    pkt.chunk_num = (uint8_t)chunk_num;
+    pkt.total_chunks = (uint8_t)total_chunks;
+    memcpy(pkt.data, icon_data + offset, chunk_size);
+
+    ret = usb_driver_send(&pkt, sizeof(pkt));
+    if (ret < 0) {
+      return ret;
+    }
+
+    sceKernelDelayThread(5 * 1000); /* 5ms between chunks */
+
+    offset += chunk_size;
+    chunk_num++;
+  }
+
+  return 0;
+}
+
+/**
+ * Send a stats upload as v1 chunks for a desktop that has not advertised
+ * frames
+ */
+static int send_stats_chunks(const char *json_data, size_t json_len,
+                             uint64_t last_updated) {
+  UsbStatsUploadPacket pkt;
+  size_t offset = 0;
+  int chunk_num = 0;
+  int total_chunks;
+  int ret;
+
+  total_chunks = (json_len + USB_STATS_CHUNK_SIZE - 1) / USB_STATS_CHUNK_SIZE;
+  if (total_chunks > 65535) {
+    return -3;
+  }
+
+  while (offset < json_len) {
+    size_t chunk_size = json_len - offset;
+    if (chunk_size > USB_STATS_CHUNK_SIZE) {
+      chunk_size = USB_STATS_CHUNK_SIZE;
+    }
+
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.header.magic = USB_PACKET_MAGIC;
+    pkt.header.type = USB_PKT_STATS_UPLOAD;
+    pkt.header.length = sizeof(pkt) - sizeof(UsbPacketHeader);
+    pkt.last_updated = last_updated;
+    pkt.chunk_index = (uint16_t)chunk_num;
+    pkt.total_chunks = (uint16_t)total_chunks;
+    pkt.data_length = (uint16_t)chunk_size;
+    memcpy(pkt.data, json_data + offset, chunk_size);
+
+    ret = usb_driver_send(&pkt, sizeof(pkt));
+    if (ret < 0) {
+      return ret;
+    }
+
+    sceKernelDelayThread(10 * 1000); /* 10ms between chunks */
+
+    offset += chunk_size;
+    chunk_num++;
+  }
+
+  return 0;
+}
 
 /*============================================================================
  * Protocol Implementation
@@ -66,10 +337,21 @@ int usb_send_game_info(const char *game_id, const char *title, int state,
     strncpy(pkt.psp_name, psp_name, sizeof(pkt.psp_name) - 1);
   }
 
+  /* Advertise the icon by CRC so the desktop can skip the transfer */
+  if (has_icon && game_id) {
+    IconCacheEntry cached;
+    if (icon_cache_lookup(game_id, &cached) == 0 &&
+        cached.icon_size <= 0xFFFF) {
+      pkt.icon_crc32 = cached.icon_crc32;
+      pkt.icon_size = (uint16_t)cached.icon_size;
+    }
+  }
+
   return usb_driver_send(&pkt, sizeof(pkt));
 }
 
-int usb_send_heartbeat(uint32_t uptime, uint8_t battery) {
+int usb_send_heartbeat(uint32_t uptime, uint8_t battery,
+                       const HeartbeatMetrics *metrics) {
   UsbHeartbeatPacket pkt;
 
   if (!usb_driver_is_connected()) {
@@ -83,12 +365,13 @@ int usb_send_heartbeat(uint32_t uptime, uint8_t battery) {
   pkt.header.length = sizeof(pkt) - sizeof(UsbPacketHeader);
   pkt.uptime = uptime;
   pkt.battery = battery;
+  memcpy(&pkt.metrics, metrics, sizeof(pkt.metrics));
 
   return usb_driver_send(&pkt, sizeof(pkt));
 }
 
 int usb_poll_message(char *game_id_out) {
-  uint8_t buf[USB_MAX_PACKET];
+  static uint8_t buf[USB_MAX_FRAME]; /* Too big for the thread stack */
   int ret;
   UsbPacketHeader *hdr;
 
@@ -96,7 +379,7 @@ int usb_poll_message(char *game_id_out) {
     return 0;
   }
 
-  /* Non-blocking receive - returns immediately if no data */
+  /* Non-blocking receive - takes a packet the driver already buffered */
   ret = usb_driver_receive(buf, sizeof(buf), 0);
   if (ret <= 0) {
     return 0;
@@ -124,37 +407,11 @@ int usb_poll_message(char *game_id_out) {
     return USB_PKT_ICON_REQUEST;
 
   case USB_PKT_STATS_RESPONSE:
-    /* Stats response received - stream directly to file */
+    /* Stats response received - stage it in RAM */
     if (ret >= (int)sizeof(UsbStatsResponsePacket)) {
       UsbStatsResponsePacket *resp = (UsbStatsResponsePacket *)buf;
 
-      /* First chunk - open file for writing */
-      if (resp->chunk_index == 0 || !g_stats_stream.active) {
-        /* Close any previous file if still open */
-        if (g_stats_stream.fd >= 0) {
-          sceIoClose(g_stats_stream.fd);
-        }
-        /* Open file for writing (truncate) */
-        g_stats_stream.fd = sceIoOpen(
-            USAGE_LOG_PATH, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC, 0777);
-        g_stats_stream.total_bytes = resp->total_bytes;
-        g_stats_stream.bytes_written = 0;
-        g_stats_stream.total_chunks = resp->total_chunks;
-        g_stats_stream.received_chunks = 0;
-        g_stats_stream.last_updated = resp->last_updated;
-        g_stats_stream.verified = 0;
-        g_stats_stream.active = (g_stats_stream.fd >= 0) ? 1 : 0;
-      }
-
-      /* Write chunk data directly to file */
-      if (g_stats_stream.fd >= 0 && resp->data_length > 0) {
-        int written =
-            sceIoWrite(g_stats_stream.fd, resp->data, resp->data_length);
-        if (written > 0) {
-          g_stats_stream.bytes_written += written;
-        }
-        g_stats_stream.received_chunks++;
-      }
+      stats_stage_chunk(resp);
 
       /* Send ACK for this chunk so desktop knows to send next */
       {
@@ -165,22 +422,21 @@ int usb_poll_message(char *game_id_out) {
         ack.length = 0;
         usb_driver_send(&ack, sizeof(ack));
       }
+    }
+    return USB_PKT_STATS_RESPONSE;
 
-      /* Last chunk - close file and verify */
-      if (g_stats_stream.received_chunks >= g_stats_stream.total_chunks &&
-          g_stats_stream.fd >= 0) {
-        sceIoClose(g_stats_stream.fd);
-        g_stats_stream.fd = -1;
-
-        /* Verify byte count matches */
-        if (g_stats_stream.bytes_written == g_stats_stream.total_bytes) {
-          g_stats_stream.verified = 1;
-        } else {
-          /* Truncated - delete corrupt file */
-          g_stats_stream.verified = 0;
-          sceIoRemove(USAGE_LOG_PATH);
-        }
-      }
+  case USB_PKT_STATS_RESPONSE_FRAME:
+    if (ret >= (int)sizeof(UsbFrameHeader)) {
+      UsbPacketHeader ack;
+
+      stats_stage_frame((const UsbFrameHeader *)buf, ret);
+
+      /* ACK each frame, same as v1 chunks */
+      memset(&ack, 0, sizeof(ack));
+      ack.magic = USB_PACKET_MAGIC;
+      ack.type = USB_PKT_ACK;
+      ack.flags = USB_FLAG_FRAMES;
+      usb_driver_send(&ack, sizeof(ack));
     }
     return USB_PKT_STATS_RESPONSE;
 
@@ -191,68 +447,21 @@ int usb_poll_message(char *game_id_out) {
 
 int usb_send_icon(const char *game_id, const uint8_t *icon_data,
                   uint32_t icon_size) {
-  UsbIconChunkPacket pkt;
-  int chunk_num = 0;
-  int total_chunks;
-  uint32_t offset = 0;
-  int chunk_size;
-  int ret;
-
   if (!usb_driver_is_connected()) {
     return -1;
   }
 
-  if (!icon_data || icon_size == 0 || icon_size > 65535) {
-    return -2; /* Invalid data or too large */
-  }
-
-  /* Calculate total chunks needed */
-  total_chunks = (icon_size + USB_ICON_CHUNK_SIZE - 1) / USB_ICON_CHUNK_SIZE;
-  if (total_chunks > 255) {
-    return -3; /* Too many chunks */
+  if (!icon_data || icon_size == 0) {
+    return -2; /* Invalid data */
   }
 
-  /* Send icon in chunks */
-  while (offset < icon_size) {
-    chunk_size = icon_size - offset;
-    if (chunk_size > USB_ICON_CHUNK_SIZE) {
-      chunk_size = USB_ICON_CHUNK_SIZE;
-    }
-
-    memset(&pkt, 0, sizeof(pkt));
-
-    /* Header */
-    pkt.header.magic = USB_PACKET_MAGIC;
-    pkt.header.type = USB_PKT_ICON_CHUNK;
-    pkt.header.length = sizeof(pkt) - sizeof(UsbPacketHeader);
-
-    /* Chunk info */
-    if (game_id) {
-      strncpy(pkt.game_id, game_id, sizeof(pkt.game_id) - 1);
-    }
-    pkt.total_size = (uint16_t)icon_size;
-    pkt.chunk_offset = (uint16_t)offset;
-    pkt.chunk_size = (uint16_t)chunk_size;
-    pkt.chunk_num = (uint8_t)chunk_num;
-    pkt.total_chunks = (uint8_t)total_chunks;
-
-    /* Copy chunk data */
-    memcpy(pkt.data, icon_data + offset, chunk_size);
-
-    /* Send this chunk */
-    ret = usb_driver_send(&pkt, sizeof(pkt));
-    if (ret < 0) {
-      return ret;
-    }
-
-    /* Small delay between chunks to avoid overwhelming USB */
-    sceKernelDelayThread(5 * 1000); /* 5ms */
-
-    offset += chunk_size;
-    chunk_num++;
+  if (usb_driver_peer_frames()) {
+    /* The CRC lets the desktop check the reassembled icon */
+    return send_frames(USB_PKT_ICON_FRAME, game_id, icon_data, icon_size,
+                       icon_cache_crc32(icon_data, icon_size));
   }
 
-  return 0;
+  return send_icon_chunks(game_id, icon_data, icon_size);
 }
 
 /*============================================================================
@@ -260,7 +469,7 @@ int usb_send_icon(const char *game_id, const uint8_t *icon_data,
  * Note: g_stats_buffer is defined at top of file for use by usb_poll_message
  *============================================================================*/
 
-int usb_send_stats_request(uint64_t local_timestamp) {
+int usb_send_stats_request(uint64_t local_timestamp, uint32_t since_version) {
   UsbStatsRequestPacket pkt;
 
   if (!usb_driver_is_connected()) {
@@ -270,20 +479,18 @@ int usb_send_stats_request(uint64_t local_timestamp) {
   memset(&pkt, 0, sizeof(pkt));
   pkt.header.magic = USB_PACKET_MAGIC;
   pkt.header.type = USB_PKT_STATS_REQUEST;
+  if (usb_driver_peer_frames()) {
+    pkt.header.flags = USB_FLAG_FRAMES; /* Desktop may answer in frames */
+  }
   pkt.header.length = sizeof(pkt) - sizeof(UsbPacketHeader);
   pkt.local_timestamp = local_timestamp;
+  pkt.since_version = since_version;
 
   return usb_driver_send(&pkt, sizeof(pkt));
 }
 
 int usb_send_stats_upload(const char *json_data, size_t json_len,
                           uint64_t last_updated) {
-  UsbStatsUploadPacket pkt;
-  size_t offset = 0;
-  int chunk_num = 0;
-  int total_chunks;
-  int ret;
-
   if (!usb_driver_is_connected()) {
     return -1;
   }
@@ -292,48 +499,23 @@ int usb_send_stats_upload(const char *json_data, size_t json_len,
     return -2;
   }
 
-  total_chunks = (json_len + USB_STATS_CHUNK_SIZE - 1) / USB_STATS_CHUNK_SIZE;
-  if (total_chunks > 65535) {
-    return -3;
-  }
-
-  while (offset < json_len) {
-    size_t chunk_size = json_len - offset;
-    if (chunk_size > USB_STATS_CHUNK_SIZE) {
-      chunk_size = USB_STATS_CHUNK_SIZE;
-    }
-
-    memset(&pkt, 0, sizeof(pkt));
-    pkt.header.magic = USB_PACKET_MAGIC;
-    pkt.header.type = USB_PKT_STATS_UPLOAD;
-    pkt.header.length = sizeof(pkt) - sizeof(UsbPacketHeader);
-    pkt.last_updated = last_updated;
-    pkt.chunk_index = (uint16_t)chunk_num;
-    pkt.total_chunks = (uint16_t)total_chunks;
-    pkt.data_length = (uint16_t)chunk_size;
-    memcpy(pkt.data, json_data + offset, chunk_size);
-
-    ret = usb_driver_send(&pkt, sizeof(pkt));
-    if (ret < 0) {
-      return ret;
-    }
-
-    sceKernelDelayThread(10 * 1000); /* 10ms between chunks */
-
-    offset += chunk_size;
-    chunk_num++;
+  if (usb_driver_peer_frames()) {
+    return send_frames(USB_PKT_STATS_UPLOAD_FRAME, NULL,
+                       (const uint8_t *)json_data, (uint32_t)json_len,
+                       last_updated);
   }
 
-  return 0;
+  return send_stats_chunks(json_data, json_len, last_updated);
 }
 
 int usb_poll_stats_response(uint64_t *remote_last_updated, char *json_buffer,
                             size_t buffer_size, size_t *json_len_out) {
   /*
-   * With streaming, data is written directly to file as chunks arrive.
-   * This function just checks if streaming is complete.
-   * The caller doesn't need the buffer since data is already on disk.
+   * Chunks are staged in RAM and committed to file once complete.
+   * This function just checks if that has happened.
    */
+  int verified;
+
   (void)json_buffer;
   (void)buffer_size;
 
@@ -346,20 +528,16 @@ int usb_poll_stats_response(uint64_t *remote_last_updated, char *json_buffer,
     return -1; /* No data received yet */
   }
 
-  /* Check if complete (all chunks received and file closed) */
-  if (g_stats_stream.received_chunks >= g_stats_stream.total_chunks) {
-    *remote_last_updated = g_stats_stream.last_updated;
-    *json_len_out = g_stats_stream.bytes_written;
+  if (!g_stats_stream.complete) {
+    return 0; /* Still receiving chunks */
+  }
 
-    int verified = g_stats_stream.verified;
-    g_stats_stream.active = 0;
+  *remote_last_updated = g_stats_stream.last_updated;
+  *json_len_out = g_stats_stream.bytes_received;
 
-    if (verified) {
-      return 1; /* Complete and verified */
-    } else {
-      return -2; /* Truncated - file deleted */
-    }
-  }
+  verified = g_stats_stream.verified;
+  g_stats_stream.active = 0;
 
-  return 0; /* Still receiving chunks */
+  /* On failure the previous usage_log.json is still intact */
+  return verified ? 1 : -2;
 }
@@ -10,6 +10,8 @@
 
 #include <stdint.h>
 
+#include "drp_metrics.h"
+
 /* Packet magic - "PSPD" = 0x50535044 (same as desktop companion) */
 #define USB_PACKET_MAGIC 0x50535044
 
@@ -19,9 +21,15 @@
 #define USB_PKT_ICON_CHUNK 0x03
 #define USB_PKT_STATS_REQUEST 0x05
 #define USB_PKT_STATS_UPLOAD 0x06
+#define USB_PKT_ICON_FRAME 0x08
+#define USB_PKT_STATS_UPLOAD_FRAME 0x09
 #define USB_PKT_ACK 0x10
 #define USB_PKT_ICON_REQUEST 0x11
 #define USB_PKT_STATS_RESPONSE 0x12
+#define USB_PKT_STATS_RESPONSE_FRAME 0x15
+
+/* UsbPacketHeader flags */
+#define USB_FLAG_FRAMES 0x01 /* Sender understands v2 frames */
 
 /* Maximum packet size for bulk transfers */
 #define USB_MAX_PACKET 512
@@ -32,6 +40,17 @@
 /* Stats chunk maximum data size */
 #define USB_STATS_CHUNK_SIZE 480
 
+/* Largest v2 frame, header included (one bulk request) */
+#define USB_MAX_FRAME 4096
+
+/* Data bytes in every v2 frame but the last of a transfer */
+#define USB_FRAME_DATA_SIZE 4000
+
+/* A stats response starting with this magic is a delta, not JSON. USB mode
+ * has no local tracker, so the desktop only sends an empty one, meaning
+ * "usage_log.json is already current" */
+#define USB_STATS_DELTA_MAGIC "PSDL"
+
 /* PSP state values */
 #define USB_STATE_XMB 0
 #define USB_STATE_GAME 1
@@ -44,9 +63,9 @@
 
 /* Packet header (8 bytes) */
 typedef struct {
-  uint32_t magic; /* USB_PACKET_MAGIC */
-  uint8_t type;   /* Packet type */
-  uint8_t reserved;
+  uint32_t magic;  /* USB_PACKET_MAGIC */
+  uint8_t type;    /* Packet type */
+  uint8_t flags;   /* USB_FLAG_* (0 from older plugins) */
   uint16_t length; /* Payload length (not including header) */
 } __attribute__((packed)) UsbPacketHeader;
 
@@ -60,15 +79,19 @@ typedef struct {
   uint32_t start_time; /* Unix timestamp */
   uint8_t persistent;  /* Keep presence after disconnect */
   char psp_name[32];   /* PSP name */
-  uint8_t padding[7];  /* Padding to 128 bytes */
+  uint32_t icon_crc32; /* CRC32 of ICON0.PNG (0 if not known yet) */
+  uint16_t icon_size;  /* Icon size in bytes (0 if not known yet) */
+  uint8_t padding[1];  /* Padding to 128 bytes */
 } __attribute__((packed)) UsbGameInfoPacket;
 
-/* Heartbeat packet (16 bytes) */
+/* Heartbeat packet (16 bytes, then the metrics extension; older plugins
+ * send the 16 bytes only) */
 typedef struct {
   UsbPacketHeader header;
   uint32_t uptime; /* Uptime in seconds */
   uint8_t battery; /* Battery percent */
   uint8_t padding[3];
+  HeartbeatMetrics metrics;
 } __attribute__((packed)) UsbHeartbeatPacket;
 
 /* ACK packet (8 bytes - just header) */
@@ -93,10 +116,12 @@ typedef struct {
   uint8_t data[USB_ICON_CHUNK_SIZE]; /* Chunk data */
 } __attribute__((packed)) UsbIconChunkPacket;
 
-/* Stats request packet (16 bytes) */
+/* Stats request packet (24 bytes) */
 typedef struct {
   UsbPacketHeader header;
   uint64_t local_timestamp; /* PSP's last_updated timestamp */
+  uint32_t since_version;   /* sync_version of the local usage_log.json */
+  uint32_t psp_version;     /* Local sync_version (always 0 in USB mode) */
 } __attribute__((packed)) UsbStatsRequestPacket;
 
 /* Stats upload packet (512 bytes max) */
@@ -120,6 +145,23 @@ typedef struct {
   uint8_t data[USB_STATS_CHUNK_SIZE]; /* JSON chunk data */
 } __attribute__((packed)) UsbStatsResponsePacket;
 
+/*
+ * v2 frame (36 byte header + data). One frame carries up to
+ * USB_FRAME_DATA_SIZE bytes of an icon or stats transfer at a 32-bit
+ * offset and is sent as a single bulk request. header.length counts the
+ * frame fields after the header plus the data.
+ */
+typedef struct {
+  UsbPacketHeader header;
+  char id[10];         /* Game ID for icons, empty for stats */
+  uint16_t reserved;
+  uint32_t total_size; /* Size of the whole transfer */
+  uint32_t offset;     /* Offset of this frame's data in the transfer */
+  uint64_t tag;        /* Icons: CRC32 of the icon; stats: last_updated */
+} __attribute__((packed)) UsbFrameHeader;
+
+#define USB_FRAME_FIELDS_SIZE (sizeof(UsbFrameHeader) - sizeof(UsbPacketHeader))
+
 /*============================================================================
  * Protocol Functions
  *============================================================================*/
@@ -135,6 +177,9 @@ typedef struct {
  * @param persistent Keep presence after disconnect
  * @param psp_name PSP name from config
  * @return 0 on success, negative on error
+ *
+ * If the icon is in the icon cache, its CRC32 and size are included so the
+ * desktop only requests it when it doesn't already have that exact icon.
  */
 int usb_send_game_info(const char *game_id, const char *title, int state,
                        int has_icon, uint32_t start_time, int persistent,
@@ -145,9 +190,11 @@ int usb_send_game_info(const char *game_id, const char *title, int state,
  *
  * @param uptime Uptime in seconds
  * @param battery Battery percentage
+ * @param metrics Metrics extension sent along
  * @return 0 on success, negative on error
  */
-int usb_send_heartbeat(uint32_t uptime, uint8_t battery);
+int usb_send_heartbeat(uint32_t uptime, uint8_t battery,
+                       const HeartbeatMetrics *metrics);
 
 /**
  * Poll for incoming message from desktop
@@ -158,7 +205,7 @@ int usb_send_heartbeat(uint32_t uptime, uint8_t battery);
 int usb_poll_message(char *game_id_out);
 
 /**
- * Send icon data to desktop
+ * Send icon data to desktop as v2 frames
  *
  * @param game_id Game ID the icon belongs to
  * @param icon_data Pointer to PNG icon data
@@ -172,16 +219,17 @@ int usb_send_icon(const char *game_id, const uint8_t *icon_data,
  * Send stats request to desktop
  *
  * @param local_timestamp PSP's last_updated timestamp
+ * @param since_version sync_version of the local usage_log.json (0 if none)
  * @return 0 on success, negative on error
  */
-int usb_send_stats_request(uint64_t local_timestamp);
+int usb_send_stats_request(uint64_t local_timestamp, uint32_t since_version);
 
 /**
- * Send stats upload to desktop (chunked)
+ * Send stats upload to desktop as v2 frames
  *
- * @param json_data JSON data to send
- * @param json_len Length of JSON data
- * @param last_updated PSP's last_updated timestamp
+ * @param json_data JSON data or stats delta to send
+ * @param json_len Length of the data
+ * @param last_updated PSP's last_updated timestamp (sync_version for deltas)
  * @return 0 on success, negative on error
  */
 int usb_send_stats_upload(const char *json_data, size_t json_len,
@@ -78,6 +78,8 @@ enum DataSource {
 /// Application state
 struct AppState {
     stats: StatsData,
+    /// Display strings for stats, kept in step with it
+    display: ui::DisplayRows,
     scroll_offset: usize,
     should_exit: bool,
     status_message: String,
@@ -90,6 +92,7 @@ struct AppState {
 impl AppState {
     fn new(stats: StatsData) -> Self {
         Self {
+            display: ui::DisplayRows::new(&stats),
             stats,
             scroll_offset: 0,
             should_exit: false,
@@ -147,22 +150,13 @@ impl AppState {
     
     /// Get count of visible games (all in selector mode, non-hidden otherwise)
     fn get_visible_game_count(&self) -> usize {
-        if self.selector_mode {
-            self.stats.games.len()
-        } else {
-            self.stats.games.iter().filter(|g| !g.hidden).count()
-        }
+        self.display.visible_len(self.selector_mode)
     }
     
     /// Get the game at the selected index (in the visible list)
     fn get_selected_game(&self) -> Option<&crate::stats::GameStats> {
-        if self.selector_mode {
-            self.stats.games.get(self.selected_index)
-        } else {
-            self.stats.games.iter()
-                .filter(|g| !g.hidden)
-                .nth(self.selected_index)
-        }
+        self.display.game_index(self.selector_mode, self.selected_index)
+            .and_then(|i| self.stats.games.get(i))
     }
     
     /// Toggle hidden status for the selected game
@@ -175,6 +169,7 @@ impl AppState {
             let new_hidden = !game.hidden;
             let game_key = game.game_key.clone();
             game.hidden = new_hidden;
+            self.display.set_hidden(self.selected_index, new_hidden);
             
             // Update the JSON file
             crate::config::update_game_hidden(&game_key, new_hidden)
@@ -198,7 +193,7 @@ fn load_stats() -> (StatsData, DataSource) {
     if config.offline_mode {
         log("load_stats: OFFLINE MODE - using local cache only");
         if let Some(json) = load_usage_json() {
-            let stats = parse_usage_json(&json);
+            let stats = parse_usage_json(json.as_bytes());
             if !stats.games.is_empty() {
                 log(&format!("load_stats: local cache has {} games", stats.games.len()));
                 return (stats, DataSource::Local);
@@ -212,7 +207,7 @@ fn load_stats() -> (StatsData, DataSource) {
     log("load_stats: checking local cache");
     let cached_stats = if let Some(json) = load_usage_json() {
         log("load_stats: found local cache, parsing");
-        let stats = parse_usage_json(&json);
+        let stats = parse_usage_json(json.as_bytes());
         if !stats.games.is_empty() {
             log(&format!("load_stats: cache has {} games", stats.games.len()));
             Some(stats)
@@ -341,7 +336,11 @@ fn load_stats() -> (StatsData, DataSource) {
 }
 
 /// Handle D-pad input for scrolling and selector mode
-fn handle_input(state: &mut AppState) {
+/// Returns true if the screen needs a redraw
+fn handle_input(state: &mut AppState) -> bool {
+    let before = (state.scroll_offset, state.selector_mode, state.selected_index);
+    let mut changed = false;
+    
     unsafe {
         // Read controller state
         let mut pad_data: psp::sys::SceCtrlData = core::mem::zeroed();
@@ -357,6 +356,7 @@ fn handle_input(state: &mut AppState) {
             // X button - toggle hidden status on selected entry
             if pad_data.buttons.contains(psp::sys::CtrlButtons::CROSS) {
                 if state.toggle_selected_hidden() {
+                    changed = true;
                     // Update status message
                     if let Some(game) = state.get_selected_game() {
                         state.status_message = if game.hidden {
@@ -386,8 +386,12 @@ fn handle_input(state: &mut AppState) {
         }
         
         // Simple debounce - wait a bit between inputs
-        psp::sys::sceKernelDelayThread(100_000); // 100ms
+        if !pad_data.buttons.is_empty() {
+            psp::sys::sceKernelDelayThread(100_000); // 100ms
+        }
     }
+    
+    changed || before != (state.scroll_offset, state.selector_mode, state.selected_index)
 }
 
 
@@ -429,17 +433,20 @@ fn psp_main() {
     let mut terminal = Terminal::new(backend).unwrap();
     log("psp_main: terminal created");
     
-    // Main loop
+    // Main loop - the stats only change on input, so idle frames draw nothing
     log("psp_main: entering main loop");
+    let mut redraw = true;
     loop {
         // Render UI
-        terminal.draw(|frame| {
-            ui::render_stats(frame, &app_state.stats, app_state.scroll_offset, 
-                app_state.selector_mode, app_state.selected_index);
-        }).unwrap();
+        if redraw {
+            terminal.draw(|frame| {
+                ui::render_stats(frame, &app_state.display, app_state.scroll_offset, 
+                    app_state.selector_mode, app_state.selected_index);
+            }).unwrap();
+        }
         
         // Handle input
-        handle_input(&mut app_state);
+        redraw = handle_input(&mut app_state);
         
         if app_state.should_exit {
             break;
@@ -37,6 +37,19 @@ const MAGIC: &[u8; 4] = b"PSPR";
 const MSG_TYPE_STATS_REQUEST: u8 = 0x05;
 const MSG_TYPE_STATS_RESPONSE: u8 = 0x12;
 
+/// STATS_RESPONSE header:
+/// [MAGIC:4][TYPE:1][total_bytes:4][last_updated:8][chunk_idx:2][total_chunks:2][data_len:2]
+const STATS_HEADER_SIZE: usize = 23;
+
+/// Data bytes in every STATS_RESPONSE chunk but the last (desktop CHUNK_DATA_SIZE)
+const STATS_CHUNK_SIZE: usize = 1024;
+
+/// Largest response accepted, bounding the up-front allocation
+const MAX_STATS_BYTES: usize = 1024 * 1024;
+
+/// Receive timeouts in a row before giving up on missing chunks
+const MAX_STATS_TIMEOUTS: u32 = 3;
+
 /// Known return codes (matching C plugin)
 const NET_MODULE_ALREADY_LOADED: i32 = 0x80110F01_u32 as i32;
 const NET_ALREADY_INITIALIZED: i32 = 0x80410003_u32 as i32;
@@ -287,19 +300,24 @@ impl NetworkManager {
     }
     
     /// Receive stats response from companion
-    /// Returns the JSON data if successful
+    /// Returns the JSON data if every chunk arrived
+    ///
+    /// The buffer is allocated once from the header's total_bytes and each
+    /// chunk is copied to its offset, so chunks may arrive in any order.
     pub fn receive_stats_response(&self) -> Option<Vec<u8>> {
         if self.socket < 0 {
             return None;
         }
         
         let mut buffer = [0u8; 2048];
-        let mut json_data = Vec::new();
-        let mut expected_chunks: u16 = 0;
-        let mut received_chunks: u16 = 0;
+        let mut json_data: Vec<u8> = Vec::new();
+        let mut have_chunk: Vec<bool> = Vec::new();
+        let mut total_chunks: usize = 0;
+        let mut received_chunks: usize = 0;
+        let mut timeouts = 0;
         
-        // Try to receive chunks (with timeout handled by socket)
-        for _ in 0..10 {  // Max 10 chunks
+        // Chunks are received until all are in (with timeout handled by socket)
+        while timeouts < MAX_STATS_TIMEOUTS {
             let mut from_addr: sockaddr = unsafe { core::mem::zeroed() };
             let mut from_len: socklen_t = 16;
             
@@ -314,13 +332,12 @@ impl NetworkManager {
                 )
             };
             
-            if received < 5 {
+            if received < STATS_HEADER_SIZE as i32 {
                 // Timeout or error
-                if received_chunks > 0 && received_chunks >= expected_chunks {
-                    break;  // We got all chunks
-                }
+                timeouts += 1;
                 continue;
             }
+            timeouts = 0;
             
             let data = &buffer[..received as usize];
             
@@ -329,36 +346,41 @@ impl NetworkManager {
                 continue;
             }
             
-            // Parse stats response header
-            // Format: [MAGIC:4][TYPE:1][total_games:2][total_playtime:8][chunk_idx:2][total_chunks:2][data_len:2][json...]
-            if data.len() < 21 {
-                continue;
-            }
-            
-            let chunk_idx = u16::from_le_bytes([data[15], data[16]]);
-            let total_chunks = u16::from_le_bytes([data[17], data[18]]);
-            let data_len = u16::from_le_bytes([data[19], data[20]]) as usize;
+            let total_bytes = u32::from_le_bytes([data[5], data[6], data[7], data[8]]) as usize;
+            let chunk_idx = u16::from_le_bytes([data[17], data[18]]) as usize;
+            let chunks = u16::from_le_bytes([data[19], data[20]]) as usize;
+            let data_len = u16::from_le_bytes([data[21], data[22]]) as usize;
             
-            if expected_chunks == 0 {
-                expected_chunks = total_chunks;
+            if total_chunks == 0 {
+                if total_bytes > MAX_STATS_BYTES || chunks == 0 {
+                    return None;
+                }
+                total_chunks = chunks;
+                json_data = alloc::vec![0u8; total_bytes];
+                have_chunk = alloc::vec![false; total_chunks];
             }
             
-            // Extract JSON chunk
-            if data.len() >= 21 + data_len {
-                json_data.extend_from_slice(&data[21..21 + data_len]);
-                received_chunks += 1;
+            // Copy the chunk to its place, once
+            let offset = chunk_idx * STATS_CHUNK_SIZE;
+            if chunks != total_chunks
+                || chunk_idx >= total_chunks
+                || have_chunk[chunk_idx]
+                || data.len() < STATS_HEADER_SIZE + data_len
+                || offset + data_len > json_data.len()
+            {
+                continue;
             }
+            json_data[offset..offset + data_len]
+                .copy_from_slice(&data[STATS_HEADER_SIZE..STATS_HEADER_SIZE + data_len]);
+            have_chunk[chunk_idx] = true;
+            received_chunks += 1;
             
-            if received_chunks >= expected_chunks {
-                break;
+            if received_chunks == total_chunks {
+                return Some(json_data);
             }
         }
         
-        if json_data.is_empty() {
-            None
-        } else {
-            Some(json_data)
-        }
+        None
     }
     
     /// Fetch stats from companion
@@ -378,8 +400,7 @@ impl NetworkManager {
         let json_data = self.receive_stats_response()?;
         
         // Parse JSON
-        let json_str = core::str::from_utf8(&json_data).ok()?;
-        Some(parse_usage_json(json_str))
+        Some(parse_usage_json(&json_data))
     }
     
     /// Fetch stats from companion, returning both parsed stats and raw JSON bytes
@@ -399,8 +420,7 @@ impl NetworkManager {
         let json_data = self.receive_stats_response()?;
         
         // Parse JSON
-        let json_str = core::str::from_utf8(&json_data).ok()?;
-        let stats = parse_usage_json(json_str);
+        let stats = parse_usage_json(&json_data);
         
         Some((stats, json_data))
     }
@@ -54,186 +54,308 @@ impl Default for StatsData {
     }
 }
 
-/// Simple string extraction helper for JSON parsing
-fn extract_string_value(json: &str, key: &str) -> Option<String> {
-    let search = alloc::format!("\"{}\":", key);
-    let start = json.find(&search)?;
-    let after_key = &json[start + search.len()..];
-    
-    // Skip whitespace
-    let trimmed = after_key.trim_start();
-    
-    if trimmed.starts_with('"') {
-        // String value
-        let content = &trimmed[1..];
-        let end = content.find('"')?;
-        Some(String::from(&content[..end]))
-    } else {
-        None
-    }
+/// Rough bytes per game entry in usage.json (play_dates and daily_playtime
+/// included), used to size the games vector up front
+const BYTES_PER_GAME_ESTIMATE: usize = 256;
+
+/// Objects nested deeper than this are skipped without looking for games
+const MAX_DEPTH: usize = 8;
+
+/// Single-pass reader over the usage.json bytes. Strings are returned as
+/// slices of the input; nothing is allocated until a game is stored.
+struct Scanner<'a> {
+    json: &'a [u8],
+    pos: usize,
 }
 
-/// Simple number extraction helper for JSON parsing
-fn extract_number_value(json: &str, key: &str) -> Option<u64> {
-    let search = alloc::format!("\"{}\":", key);
-    let start = json.find(&search)?;
-    let after_key = &json[start + search.len()..];
-    
-    // Skip whitespace
-    let trimmed = after_key.trim_start();
-    
-    // Parse number
-    let mut num_str = String::new();
-    for c in trimmed.chars() {
-        if c.is_ascii_digit() {
-            num_str.push(c);
-        } else {
-            break;
+impl<'a> Scanner<'a> {
+    fn new(json: &'a [u8]) -> Self {
+        Self { json, pos: 0 }
+    }
+
+    fn peek(&self) -> Option<u8> {
+        self.json.get(self.pos).copied()
+    }
+
+    fn skip_ws(&mut self) {
+        while let Some(b' ') | Some(b'\t') | Some(b'\r') | Some(b'\n') = self.peek() {
+            self.pos += 1;
         }
     }
-    
-    num_str.parse().ok()
-}
 
-/// Simple boolean extraction helper for JSON parsing
-fn extract_bool_value(json: &str, key: &str) -> Option<bool> {
-    let search = alloc::format!("\"{}\":", key);
-    let start = json.find(&search)?;
-    let after_key = &json[start + search.len()..];
-    
-    // Skip whitespace
-    let trimmed = after_key.trim_start();
-    
-    if trimmed.starts_with("true") {
-        Some(true)
-    } else if trimmed.starts_with("false") {
-        Some(false)
-    } else {
-        None
+    /// Consume `b` (after whitespace) if it is next
+    fn eat(&mut self, b: u8) -> bool {
+        self.skip_ws();
+        if self.peek() == Some(b) {
+            self.pos += 1;
+            true
+        } else {
+            false
+        }
     }
-}
 
-/// Parse a single game entry from JSON
-/// Supports both old format (total_seconds, session_count) and new network format (seconds, sessions)
-fn parse_game_entry(json: &str, game_key: String) -> Option<GameStats> {
-    let title = extract_string_value(json, "title")?;
-    let game_id = extract_string_value(json, "game_id").unwrap_or_default();
-    
-    // Try new format first (seconds, sessions), then old format (total_seconds, session_count)
-    let total_seconds = extract_number_value(json, "seconds")
-        .or_else(|| extract_number_value(json, "total_seconds"))
-        .unwrap_or(0);
-    let session_count = extract_number_value(json, "sessions")
-        .or_else(|| extract_number_value(json, "session_count"))
-        .unwrap_or(0) as u32;
-    let last_played = extract_string_value(json, "last_played").unwrap_or_default();
-    let hidden = extract_bool_value(json, "hidden").unwrap_or(false);
-    
-    Some(GameStats {
-        title,
-        game_id,
-        game_key,
-        total_seconds,
-        session_count,
-        last_played,
-        hidden,
-    })
-}
+    /// Raw contents of the string at the cursor, escapes left in place
+    fn string(&mut self) -> Option<&'a [u8]> {
+        if !self.eat(b'"') {
+            return None;
+        }
+        let start = self.pos;
+        loop {
+            match self.peek()? {
+                b'"' => break,
+                b'\\' => self.pos += 2,
+                _ => self.pos += 1,
+            }
+        }
+        let raw = self.json.get(start..self.pos)?;
+        self.pos += 1;
+        Some(raw)
+    }
 
-/// Parse usage.json content into StatsData
-pub fn parse_usage_json(json: &str) -> StatsData {
-    let mut stats = StatsData::default();
-    
-    // Find all game entries by looking for "title": patterns
-    // This is a simple approach that works for our specific JSON format
-    let mut search_start = 0;
-    
-    while let Some(title_pos) = json[search_start..].find("\"title\":") {
-        let abs_pos = search_start + title_pos;
-        
-        // Find the enclosing braces for this game object
-        // Look backwards for the opening brace
-        let mut brace_count = 0;
-        let mut obj_start = abs_pos;
-        for (i, c) in json[..abs_pos].chars().rev().enumerate() {
-            match c {
-                '}' => brace_count += 1,
-                '{' => {
-                    if brace_count == 0 {
-                        obj_start = abs_pos - i - 1;
-                        break;
-                    }
-                    brace_count -= 1;
-                }
-                _ => {}
+    /// Integer part of the number at the cursor; fraction and exponent are
+    /// skipped, negative values read as 0
+    fn number(&mut self) -> Option<u64> {
+        let negative = self.peek() == Some(b'-');
+        if negative {
+            self.pos += 1;
+        }
+        let start = self.pos;
+        let mut value: u64 = 0;
+        while let Some(c) = self.peek() {
+            if !c.is_ascii_digit() {
+                break;
             }
+            value = value.saturating_mul(10).saturating_add((c - b'0') as u64);
+            self.pos += 1;
+        }
+        if self.pos == start {
+            return None;
         }
-        
-        // Extract game_key by looking for the quoted key before the opening brace
-        // Format is: "GAMEID:1": { ... }
-        let game_key = extract_game_key(&json[..obj_start]);
-        
-        // Find the closing brace
-        let mut brace_count = 1;
-        let mut obj_end = abs_pos;
-        for (i, c) in json[obj_start + 1..].chars().enumerate() {
-            match c {
-                '{' => brace_count += 1,
-                '}' => {
-                    brace_count -= 1;
-                    if brace_count == 0 {
-                        obj_end = obj_start + 1 + i + 1;
-                        break;
+        while let Some(b'.') | Some(b'e') | Some(b'E') | Some(b'+') | Some(b'-')
+        | Some(b'0'..=b'9') = self.peek()
+        {
+            self.pos += 1;
+        }
+        Some(if negative { 0 } else { value })
+    }
+
+    /// true, false or null
+    fn literal(&mut self) -> Option<Option<bool>> {
+        let rest = self.json.get(self.pos..)?;
+        let (value, len) = if rest.starts_with(b"true") {
+            (Some(true), 4)
+        } else if rest.starts_with(b"false") {
+            (Some(false), 5)
+        } else if rest.starts_with(b"null") {
+            (None, 4)
+        } else {
+            return None;
+        };
+        self.pos += len;
+        Some(value)
+    }
+
+    /// Step over any value
+    fn skip_value(&mut self) -> Option<()> {
+        self.skip_ws();
+        match self.peek()? {
+            b'"' => {
+                self.string()?;
+            }
+            b'{' | b'[' => {
+                // Strings are stepped over whole, so brackets in them don't count
+                let mut depth = 0usize;
+                loop {
+                    match self.peek()? {
+                        b'"' => {
+                            self.string()?;
+                            continue;
+                        }
+                        b'{' | b'[' => depth += 1,
+                        b'}' | b']' => {
+                            depth -= 1;
+                            if depth == 0 {
+                                self.pos += 1;
+                                break;
+                            }
+                        }
+                        _ => {}
                     }
+                    self.pos += 1;
                 }
-                _ => {}
             }
+            b't' | b'f' | b'n' => {
+                self.literal()?;
+            }
+            _ => {
+                self.number()?;
+            }
+        }
+        Some(())
+    }
+}
+
+/// Fields of one object, as slices of the input
+/// Supports both old format (total_seconds, session_count) and new network format
+/// (seconds, sessions)
+#[derive(Default)]
+struct GameFields<'a> {
+    title: Option<&'a [u8]>,
+    game_id: Option<&'a [u8]>,
+    last_played: Option<&'a [u8]>,
+    seconds: Option<u64>,
+    total_seconds: Option<u64>,
+    sessions: Option<u64>,
+    session_count: Option<u64>,
+    hidden: bool,
+}
+
+impl<'a> GameFields<'a> {
+    /// Turn the fields into a game if the object had a non-empty title
+    fn into_game(self, game_key: &[u8]) -> Option<GameStats> {
+        let title = self.title.filter(|t| !t.is_empty())?;
+        Some(GameStats {
+            title: json_string(title),
+            game_id: self.game_id.map(json_string).unwrap_or_default(),
+            game_key: json_string(game_key),
+            // Prefer the new format, then the old one
+            total_seconds: self.seconds.or(self.total_seconds).unwrap_or(0),
+            session_count: self.sessions.or(self.session_count).unwrap_or(0) as u32,
+            last_played: self.last_played.map(json_string).unwrap_or_default(),
+            hidden: self.hidden,
+        })
+    }
+}
+
+/// Owned copy of a raw JSON string, unescaping only if it has escapes
+fn json_string(raw: &[u8]) -> String {
+    if !raw.contains(&b'\\') {
+        return String::from_utf8_lossy(raw).into_owned();
+    }
+
+    let mut out = Vec::with_capacity(raw.len());
+    let mut i = 0;
+    while i < raw.len() {
+        let c = raw[i];
+        i += 1;
+        if c != b'\\' || i >= raw.len() {
+            out.push(c);
+            continue;
         }
-        
-        // Parse the game object
-        let game_json = &json[obj_start..obj_end];
-        if let Some(game) = parse_game_entry(game_json, game_key) {
-            // Skip empty titles
-            if !game.title.is_empty() {
-                stats.total_playtime += game.total_seconds;
-                stats.total_sessions += game.session_count;
-                stats.games.push(game);
+        let escaped = raw[i];
+        i += 1;
+        match escaped {
+            b'n' => out.push(b'\n'),
+            b't' => out.push(b'\t'),
+            b'r' => out.push(b'\r'),
+            b'b' => out.push(0x08),
+            b'f' => out.push(0x0c),
+            b'u' => {
+                // BMP only; surrogate pairs come out as U+FFFD
+                let code = raw
+                    .get(i..i + 4)
+                    .and_then(|hex| core::str::from_utf8(hex).ok())
+                    .and_then(|hex| u32::from_str_radix(hex, 16).ok());
+                i += 4;
+                let ch = code.and_then(char::from_u32).unwrap_or('\u{FFFD}');
+                let mut utf8 = [0u8; 4];
+                out.extend_from_slice(ch.encode_utf8(&mut utf8).as_bytes());
             }
+            other => out.push(other),
         }
-        
-        search_start = obj_end;
     }
-    
-    // Sort games by playtime (descending)
-    stats.games.sort_by(|a, b| b.total_seconds.cmp(&a.total_seconds));
-    
-    stats
+    String::from_utf8_lossy(&out).into_owned()
 }
 
-/// Extract the game key (e.g., "UCUS98712:1") from before the opening brace
-fn extract_game_key(before_brace: &str) -> String {
-    // Look for pattern: "KEY": at the end of the string
-    // Work backwards to find the last colon, then find the quoted key before it
-    let trimmed = before_brace.trim_end();
-    
-    // Should end with a colon (after the key, before the {)
-    if !trimmed.ends_with(':') {
-        return String::new();
+/// Parse the object at the cursor. An object with a "title" is a game,
+/// stored under the key it sits at; objects inside it are searched too.
+fn parse_object<'a>(
+    scanner: &mut Scanner<'a>,
+    key: &'a [u8],
+    depth: usize,
+    stats: &mut StatsData,
+) -> Option<()> {
+    if !scanner.eat(b'{') {
+        return None;
     }
-    
-    // Find the closing quote of the key
-    let before_colon = &trimmed[..trimmed.len()-1].trim_end();
-    if !before_colon.ends_with('"') {
-        return String::new();
+
+    let mut fields = GameFields::default();
+    if !scanner.eat(b'}') {
+        loop {
+            let field = scanner.string()?;
+            if !scanner.eat(b':') {
+                return None;
+            }
+            scanner.skip_ws();
+
+            match scanner.peek()? {
+                b'{' if depth < MAX_DEPTH => parse_object(scanner, field, depth + 1, stats)?,
+                b'"' => {
+                    let value = scanner.string()?;
+                    match field {
+                        b"title" => fields.title = Some(value),
+                        b"game_id" => fields.game_id = Some(value),
+                        b"last_played" => fields.last_played = Some(value),
+                        _ => {}
+                    }
+                }
+                b'-' | b'0'..=b'9' => {
+                    let value = scanner.number()?;
+                    match field {
+                        b"seconds" => fields.seconds = Some(value),
+                        b"total_seconds" => fields.total_seconds = Some(value),
+                        b"sessions" => fields.sessions = Some(value),
+                        b"session_count" => fields.session_count = Some(value),
+                        _ => {}
+                    }
+                }
+                b't' | b'f' | b'n' => {
+                    if let Some(value) = scanner.literal()? {
+                        if field == b"hidden" {
+                            fields.hidden = value;
+                        }
+                    }
+                }
+                _ => scanner.skip_value()?,
+            }
+
+            if scanner.eat(b',') {
+                continue;
+            }
+            if scanner.eat(b'}') {
+                break;
+            }
+            return None;
+        }
     }
-    
-    // Find the opening quote of the key
-    let key_end = before_colon.len() - 1;
-    if let Some(key_start) = before_colon[..key_end].rfind('"') {
-        String::from(&before_colon[key_start + 1..key_end])
-    } else {
-        String::new()
+
+    if let Some(game) = fields.into_game(key) {
+        stats.total_playtime += game.total_seconds;
+        stats.total_sessions += game.session_count;
+        stats.games.push(game);
     }
+    Some(())
+}
+
+/// Parse usage.json content into StatsData
+///
+/// One pass over the bytes: every object with a "title" becomes a game.
+/// A truncated or malformed document keeps the games read before the error.
+pub fn parse_usage_json(json: &[u8]) -> StatsData {
+    let mut stats = StatsData::default();
+    stats.games = Vec::with_capacity(json.len() / BYTES_PER_GAME_ESTIMATE + 1);
+
+    let mut scanner = Scanner::new(json);
+    let _ = parse_object(&mut scanner, b"", 0, &mut stats);
+
+    // Sort games by playtime (descending); unstable sort needs no buffer
+    stats.games.sort_unstable_by(|a, b| {
+        b.total_seconds
+            .cmp(&a.total_seconds)
+            .then_with(|| a.title.cmp(&b.title))
+    });
+
+    stats
 }
 
 /// Format duration as human-readable string (e.g., "12h 34m 56s")
@@ -18,8 +18,125 @@ use ratatui::{
 
 use crate::stats::{format_duration, format_duration_short, StatsData};
 
+/// Padding source for fixed-width columns (sliced, never allocated)
+const SPACES: &str = "                                                                ";
+
+/// Bar graph fill, sliced to the bar length ("█" is 3 bytes)
+const BAR: &str = "████████████████████████████████████████████████████████████████";
+
+/// One game's display strings, formatted once per stats load
+struct GameRow {
+    title: String,
+    title_chars: usize,
+    total_seconds: u64,
+    /// format_duration, right-aligned to the playtime column
+    playtime: String,
+    /// format_duration_short with a leading space, for the bar graph
+    playtime_short: String,
+    /// "(N plays)"
+    sessions: String,
+    hidden: bool,
+}
+
+impl GameRow {
+    fn new(game: &crate::stats::GameStats) -> Self {
+        Self {
+            title: game.title.clone(),
+            title_chars: game.title.chars().count(),
+            total_seconds: game.total_seconds,
+            playtime: format!("{:>10}", format_duration(game.total_seconds)),
+            playtime_short: format!(" {}", format_duration_short(game.total_seconds)),
+            sessions: format!(
+                "({} {})",
+                game.session_count,
+                if game.session_count == 1 { "play" } else { "plays" }
+            ),
+            hidden: game.hidden,
+        }
+    }
+}
+
+/// Display rows for the stats screen, one per entry of `StatsData::games`
+/// in the same order. Built when the stats are loaded and patched when a
+/// game is hidden, so a frame only slices strings for the rows on screen.
+pub struct DisplayRows {
+    rows: Vec<GameRow>,
+    /// Indices into rows of the games shown outside selector mode
+    shown: Vec<usize>,
+    total_games: String,
+    shown_games: String,
+    hidden_games: String,
+    total_sessions: String,
+    total_playtime: String,
+}
+
+impl DisplayRows {
+    pub fn new(stats: &StatsData) -> Self {
+        let mut display = Self {
+            rows: stats.games.iter().map(GameRow::new).collect(),
+            shown: Vec::with_capacity(stats.games.len()),
+            total_games: format!("{} games", stats.games.len()),
+            shown_games: String::new(),
+            hidden_games: String::new(),
+            total_sessions: format!("{} sessions", stats.total_sessions),
+            total_playtime: format_duration(stats.total_playtime),
+        };
+        display.update_shown();
+        display
+    }
+
+    /// Mark a game (index into `StatsData::games`) hidden or shown
+    pub fn set_hidden(&mut self, game_index: usize, hidden: bool) {
+        if let Some(row) = self.rows.get_mut(game_index) {
+            row.hidden = hidden;
+            self.update_shown();
+        }
+    }
+
+    /// Number of rows in the list for the given mode
+    pub fn visible_len(&self, selector_mode: bool) -> usize {
+        if selector_mode {
+            self.rows.len()
+        } else {
+            self.shown.len()
+        }
+    }
+
+    /// Position in the list -> index into `StatsData::games`
+    pub fn game_index(&self, selector_mode: bool, position: usize) -> Option<usize> {
+        if selector_mode {
+            if position < self.rows.len() { Some(position) } else { None }
+        } else {
+            self.shown.get(position).copied()
+        }
+    }
+
+    fn update_shown(&mut self) {
+        self.shown.clear();
+        self.shown.extend(self.rows.iter().enumerate().filter(|(_, r)| !r.hidden).map(|(i, _)| i));
+        self.shown_games = format!("{} games", self.shown.len());
+        self.hidden_games = format!("{} hidden", self.rows.len() - self.shown.len());
+    }
+}
+
+/// Title cut to `width` characters: the slice, whether it was cut, and its
+/// character count
+fn fit_title(row: &GameRow, width: usize, ellipsis: usize) -> (&str, bool, usize) {
+    if row.title_chars <= width {
+        return (&row.title, false, row.title_chars);
+    }
+    let keep = width.saturating_sub(ellipsis);
+    let end = row.title.char_indices().nth(keep).map(|(i, _)| i).unwrap_or(row.title.len());
+    (&row.title[..end], true, keep)
+}
+
+/// `n` spaces of padding
+fn pad(n: usize) -> &'static str {
+    &SPACES[..n.min(SPACES.len())]
+}
+
 /// Main stats rendering function
-pub fn render_stats(frame: &mut Frame, stats: &StatsData, scroll_offset: usize, 
+pub fn render_stats(frame: &mut Frame, stats: &DisplayRows, scroll_offset: usize, 
                     selector_mode: bool, selected_index: usize) {
     let area = frame.area();
     
@@ -56,33 +173,26 @@ pub fn render_stats(frame: &mut Frame, stats: &StatsData, scroll_offset: usize,
 }
 
 /// Render stats header with summary info
-fn render_header(frame: &mut Frame, area: Rect, stats: &StatsData, selector_mode: bool) {
-    let visible_games: usize = if selector_mode {
-        stats.games.len()
-    } else {
-        stats.games.iter().filter(|g| !g.hidden).count()
-    };
-    let hidden_count = stats.games.iter().filter(|g| g.hidden).count();
-    
+fn render_header(frame: &mut Frame, area: Rect, stats: &DisplayRows, selector_mode: bool) {
     let header_content = if selector_mode {
         Line::from(vec![
             Span::styled(" [SELECTOR MODE] ", Style::default().fg(Color::Black).bg(Color::Yellow).bold()),
             Span::styled("  ", Style::default()),
-            Span::styled(format!("{} games", stats.games.len()), Style::default().fg(Color::Cyan)),
+            Span::styled(stats.total_games.as_str(), Style::default().fg(Color::Cyan)),
             Span::styled("  |  ", Style::default().fg(Color::DarkGray)),
-            Span::styled(format!("{} hidden", hidden_count), Style::default().fg(Color::Red)),
+            Span::styled(stats.hidden_games.as_str(), Style::default().fg(Color::Red)),
         ])
     } else {
         Line::from(vec![
             Span::styled(" # ", Style::default().fg(Color::Magenta)),
             Span::styled("GAME STATISTICS", Style::default().fg(Color::White).bold()),
             Span::styled("  |  ", Style::default().fg(Color::DarkGray)),
-            Span::styled(format!("{} games", visible_games), Style::default().fg(Color::Cyan)),
+            Span::styled(stats.shown_games.as_str(), Style::default().fg(Color::Cyan)),
             Span::styled("  |  ", Style::default().fg(Color::DarkGray)),
-            Span::styled(format!("{} sessions", stats.total_sessions), Style::default().fg(Color::Yellow)),
+            Span::styled(stats.total_sessions.as_str(), Style::default().fg(Color::Yellow)),
             Span::styled("  |  ", Style::default().fg(Color::DarkGray)),
             Span::styled("Total: ", Style::default().fg(Color::DarkGray)),
-            Span::styled(format_duration(stats.total_playtime), Style::default().fg(Color::Green).bold()),
+            Span::styled(stats.total_playtime.as_str(), Style::default().fg(Color::Green).bold()),
         ])
     };
 
@@ -98,7 +208,7 @@ fn render_header(frame: &mut Frame, area: Rect, stats: &StatsData, selector_mode
 }
 
 /// Render horizontal bar graph of top games
-fn render_bar_graph(frame: &mut Frame, area: Rect, stats: &StatsData, selector_mode: bool) {
+fn render_bar_graph(frame: &mut Frame, area: Rect, stats: &DisplayRows, selector_mode: bool) {
     let block = Block::default()
         .title(Span::styled(" Top Games ", Style::default().fg(Color::Yellow).bold()))
         .title_alignment(Alignment::Left)
@@ -108,14 +218,8 @@ fn render_bar_graph(frame: &mut Frame, area: Rect, stats: &StatsData, selector_m
     let inner = block.inner(area);
     frame.render_widget(block, area);
 
-    // Filter games based on mode
-    let visible_games: Vec<_> = if selector_mode {
-        stats.games.iter().collect()
-    } else {
-        stats.games.iter().filter(|g| !g.hidden).collect()
-    };
-
-    if visible_games.is_empty() {
+    let count = stats.visible_len(selector_mode).min(inner.height as usize);
+    if count == 0 {
         let empty_msg = Paragraph::new(Span::styled("No data", Style::default().fg(Color::DarkGray).italic()))
             .alignment(Alignment::Center);
         frame.render_widget(empty_msg, inner);
@@ -128,12 +232,11 @@ fn render_bar_graph(frame: &mut Frame, area: Rect, stats: &StatsData, selector_m
     // Calculate bar width based on available space
     let bar_area_width = inner.width.saturating_sub(title_width as u16 + 6) as usize;
 
-    // Get max playtime for scaling
-    let max_seconds = visible_games.iter()
-        .map(|g| g.total_seconds)
-        .max()
-        .unwrap_or(1)
-        .max(1) as f64;
+    // Rows are sorted by playtime, so the first one scales the bars
+    let rows = (0..count)
+        .filter_map(|i| stats.game_index(selector_mode, i))
+        .map(|i| &stats.rows[i]);
+    let max_seconds = rows.clone().next().map(|r| r.total_seconds).unwrap_or(1).max(1);
 
     // Bar colors
     let bar_colors = [
@@ -144,46 +247,38 @@ fn render_bar_graph(frame: &mut Frame, area: Rect, stats: &StatsData, selector_m
         Color::Blue,
     ];
 
-    let lines: Vec<Line> = visible_games.iter()
-        .take(inner.height as usize)
+    let lines: Vec<Line> = rows
         .enumerate()
-        .map(|(i, game)| {
-            // Truncate title if needed
-            let display_title = if game.title.chars().count() > title_width {
-                let truncated: String = game.title.chars().take(title_width - 2).collect();
-                format!("{}..", truncated)
-            } else {
-                format!("{:<width$}", game.title, width = title_width)
-            };
-            
-            // Add hidden indicator
-            let title = if game.hidden {
-                format!("[H] {}", &display_title[..display_title.len().saturating_sub(4)])
+        .map(|(i, row)| {
+            // Add hidden indicator, keeping the column width
+            let (prefix, width) = if row.hidden {
+                ("[H] ", title_width - 4)
             } else {
-                display_title
+                ("", title_width)
             };
+            let (title, cut, chars) = fit_title(row, width, 2);
 
             // Calculate bar length
-            let ratio = game.total_seconds as f64 / max_seconds;
-            let bar_len = ((ratio * bar_area_width as f64) as usize).max(1);
-            
-            // Create bar
-            let bar: String = "█".repeat(bar_len);
-            
-            // Format time
-            let time = format_duration_short(game.total_seconds);
+            let bar_len = ((row.total_seconds as u128 * bar_area_width as u128
+                / max_seconds as u128) as usize)
+                .max(1)
+                .min(BAR.len() / 3);
 
-            let color = if game.hidden {
+            let color = if row.hidden {
                 Color::DarkGray  // Dim color for hidden games
             } else {
                 bar_colors[i % bar_colors.len()]
             };
+            let title_style = Style::default()
+                .fg(if row.hidden { Color::DarkGray } else { Color::White });
             
             Line::from(vec![
-                Span::styled(title, Style::default().fg(if game.hidden { Color::DarkGray } else { Color::White })),
+                Span::styled(prefix, title_style),
+                Span::styled(title, title_style),
+                Span::styled(if cut { ".." } else { pad(width - chars) }, title_style),
                 Span::styled(" ", Style::default()),
-                Span::styled(bar, Style::default().fg(color)),
-                Span::styled(format!(" {}", time), Style::default().fg(Color::DarkGray)),
+                Span::styled(&BAR[..bar_len * 3], Style::default().fg(color)),
+                Span::styled(row.playtime_short.as_str(), Style::default().fg(Color::DarkGray)),
             ])
         })
         .collect();
@@ -193,7 +288,7 @@ fn render_bar_graph(frame: &mut Frame, area: Rect, stats: &StatsData, selector_m
 }
 
 /// Render the scrollable game list
-fn render_game_list(frame: &mut Frame, area: Rect, stats: &StatsData, scroll_offset: usize,
+fn render_game_list(frame: &mut Frame, area: Rect, stats: &DisplayRows, scroll_offset: usize,
                     selector_mode: bool, selected_index: usize) {
     let title = if selector_mode {
         " Select Game (X to toggle hide) "
@@ -210,14 +305,8 @@ fn render_game_list(frame: &mut Frame, area: Rect, stats: &StatsData, scroll_off
     let inner = block.inner(area);
     frame.render_widget(block, area);
 
-    // Filter games based on mode
-    let visible_games: Vec<(usize, &crate::stats::GameStats)> = if selector_mode {
-        stats.games.iter().enumerate().collect()
-    } else {
-        stats.games.iter().enumerate().filter(|(_, g)| !g.hidden).collect()
-    };
-
-    if visible_games.is_empty() {
+    let count = stats.visible_len(selector_mode);
+    if count == 0 {
         let empty_msg = Paragraph::new(Text::from(vec![
             Line::from(""),
             Line::from(Span::styled("No games played yet!", Style::default().fg(Color::DarkGray).italic())),
@@ -236,17 +325,19 @@ fn render_game_list(frame: &mut Frame, area: Rect, stats: &StatsData, scroll_off
     let fixed_width = rank_width + playtime_width + sessions_width + hidden_width + 4;
     let title_width = available_width.saturating_sub(fixed_width).max(10);
 
-    // Create list items
-    let items: Vec<ListItem> = visible_games
-        .iter()
-        .enumerate()
-        .skip(scroll_offset)
-        .take(inner.height as usize)
-        .map(|(display_idx, (original_idx, game))| {
+    // Create list items for the rows on screen only
+    let first = scroll_offset.min(count);
+    let last = (first + inner.height as usize).min(count);
+    let items: Vec<ListItem> = (first..last)
+        .filter_map(|display_idx| {
+            stats.game_index(selector_mode, display_idx).map(|i| (display_idx, i))
+        })
+        .map(|(display_idx, original_idx)| {
+            let row = &stats.rows[original_idx];
             let rank = display_idx + 1;
             
             // Check if this is the selected item
-            let is_selected = selector_mode && *original_idx == selected_index;
+            let is_selected = selector_mode && original_idx == selected_index;
             
             let rank_color = if is_selected {
                 Color::White
@@ -260,32 +351,19 @@ fn render_game_list(frame: &mut Frame, area: Rect, stats: &StatsData, scroll_off
             };
 
             // Truncate title if needed
-            let display_title = if game.title.len() > title_width {
-                format!("{}...", &game.title[..title_width.saturating_sub(3)])
-            } else {
-                game.title.clone()
-            };
-
-            // Format playtime
-            let playtime = format_duration(game.total_seconds);
-
-            // Format session count
-            let sessions = format!(
-                "({} {})",
-                game.session_count,
-                if game.session_count == 1 { "play" } else { "plays" }
-            );
+            let (title, cut, chars) = fit_title(row, title_width, 3);
+            let title_pad = chars + if cut { 3 } else { 0 };
 
             // Build content with optional hidden indicator and selection highlight
             let title_style = if is_selected {
                 Style::default().fg(Color::Black).bg(Color::Yellow).bold()
-            } else if game.hidden {
+            } else if row.hidden {
                 Style::default().fg(Color::DarkGray)
             } else {
                 Style::default().fg(Color::White).bold()
             };
             
-            let hidden_indicator = if selector_mode && game.hidden {
+            let hidden_indicator = if selector_mode && row.hidden {
                 Span::styled("[H]", Style::default().fg(Color::Red))
             } else if selector_mode {
                 Span::styled("   ", Style::default())
@@ -297,11 +375,13 @@ fn render_game_list(frame: &mut Frame, area: Rect, stats: &StatsData, scroll_off
                 Span::styled(format!("{:>2}.", rank), Style::default().fg(rank_color)),
                 hidden_indicator,
                 Span::styled(" ", Style::default()),
-                Span::styled(format!("{:<width$}", display_title, width = title_width), title_style),
+                Span::styled(title, title_style),
+                Span::styled(if cut { "..." } else { "" }, title_style),
+                Span::styled(pad(title_width.saturating_sub(title_pad)), title_style),
                 Span::styled(" ", Style::default()),
-                Span::styled(format!("{:>10}", playtime), Style::default().fg(if game.hidden { Color::DarkGray } else { Color::Green })),
+                Span::styled(row.playtime.as_str(), Style::default().fg(if row.hidden { Color::DarkGray } else { Color::Green })),
                 Span::styled(" ", Style::default()),
-                Span::styled(sessions, Style::default().fg(if game.hidden { Color::DarkGray } else { Color::Cyan })),
+                Span::styled(row.sessions.as_str(), Style::default().fg(if row.hidden { Color::DarkGray } else { Color::Cyan })),
             ]);
             ListItem::new(content)
         })